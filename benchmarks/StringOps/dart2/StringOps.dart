@@ -0,0 +1,127 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Benchmarks for string equality, splitting, case conversion and searching
+// on one-byte and two-byte strings.
+//
+// Each benchmark is run for short strings (names ending in `.10`) and long
+// strings (`.1000`). The benchmarks are normalized on the number of code
+// units processed to make the input sizes comparable.
+
+import 'package:benchmark_harness/benchmark_harness.dart';
+
+const int totalCodeUnits = 100000;
+
+String makeText(int length, bool twoByte) {
+  final words = twoByte
+      ? ['lorem', 'ipsum', 'dolor', 'sit', 'amet', 'αβγ']
+      : ['lorem', 'ipsum', 'dolor', 'sit', 'amet', 'consectetur'];
+  final buffer = StringBuffer();
+  for (int i = 0; buffer.length < length; i++) {
+    buffer.write(words[i % words.length]);
+    buffer.write(' ');
+  }
+  return buffer.toString().substring(0, length);
+}
+
+abstract class StringBenchmark extends BenchmarkBase {
+  final int length;
+  final bool twoByte;
+  final List<String> inputs = [];
+  final List<String> others = [];
+  int count = 0;
+
+  StringBenchmark(String name, this.length, this.twoByte)
+      : super('StringOps.$name.${twoByte ? "TwoByte" : "OneByte"}.$length');
+
+  void setup() {
+    if (inputs.isNotEmpty) return;
+    final text = makeText(length, twoByte);
+    for (int i = 0; i < totalCodeUnits ~/ length; i++) {
+      // Distinct but equal strings, so that equality has to compare contents.
+      inputs.add(String.fromCharCodes(text.codeUnits));
+      others.add(String.fromCharCodes(text.codeUnits));
+    }
+  }
+
+  void teardown() {
+    if (count < 0) throw 'Unreachable: $count';
+  }
+}
+
+class Equality extends StringBenchmark {
+  Equality(int length, bool twoByte) : super('Equality', length, twoByte);
+
+  void run() {
+    for (int i = 0; i < inputs.length; i++) {
+      if (inputs[i] == others[i]) count++;
+    }
+  }
+}
+
+class Split extends StringBenchmark {
+  Split(int length, bool twoByte) : super('Split', length, twoByte);
+
+  void run() {
+    for (int i = 0; i < inputs.length; i++) {
+      count += inputs[i].split(' ').length;
+    }
+  }
+}
+
+class ToUpperCase extends StringBenchmark {
+  ToUpperCase(int length, bool twoByte) : super('ToUpperCase', length, twoByte);
+
+  void run() {
+    for (int i = 0; i < inputs.length; i++) {
+      count += inputs[i].toUpperCase().length;
+    }
+  }
+}
+
+class ToLowerCase extends StringBenchmark {
+  final List<String> upperInputs = [];
+
+  ToLowerCase(int length, bool twoByte) : super('ToLowerCase', length, twoByte);
+
+  void setup() {
+    super.setup();
+    if (upperInputs.isNotEmpty) return;
+    upperInputs.addAll(inputs.map((s) => s.toUpperCase()));
+  }
+
+  void run() {
+    for (int i = 0; i < upperInputs.length; i++) {
+      count += upperInputs[i].toLowerCase().length;
+    }
+  }
+}
+
+class IndexOf extends StringBenchmark {
+  IndexOf(int length, bool twoByte) : super('IndexOf', length, twoByte);
+
+  void run() {
+    for (int i = 0; i < inputs.length; i++) {
+      count += inputs[i].indexOf('x');
+    }
+  }
+}
+
+List<StringBenchmark> makeBenchmarks(int length) => [
+      for (final twoByte in [false, true]) ...[
+        Equality(length, twoByte),
+        Split(length, twoByte),
+        ToUpperCase(length, twoByte),
+        ToLowerCase(length, twoByte),
+        IndexOf(length, twoByte),
+      ]
+    ];
+
+main() {
+  final benchmarks = [...makeBenchmarks(10), ...makeBenchmarks(1000)];
+
+  for (final benchmark in benchmarks) {
+    benchmark.report();
+  }
+}
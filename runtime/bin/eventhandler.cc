@@ -11,6 +11,7 @@
 #include "bin/thread.h"
 
 #include "include/dart_api.h"
+#include "platform/utils.h"
 
 namespace dart {
 namespace bin {
@@ -58,6 +59,14 @@ void TimeoutQueue::UpdateTimeout(Dart_Port port, int64_t timeout) {
 static EventHandler* event_handler = NULL;
 static Monitor* shutdown_monitor = NULL;
 
+intptr_t EventHandler::num_threads_ = 1;
+bool EventHandler::use_io_uring_ = false;
+
+void EventHandler::set_num_threads(intptr_t value) {
+  num_threads_ = dart::Utils::Minimum(
+      dart::Utils::Maximum(value, static_cast<intptr_t>(1)), kMaxThreads);
+}
+
 void EventHandler::Start() {
   // Initialize global socket registry.
   ListeningSocketRegistry::Initialize();
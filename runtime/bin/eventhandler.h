@@ -643,10 +643,30 @@ class EventHandler {
 
   static void SendFromNative(intptr_t id, Dart_Port port, int64_t data);
 
+  /**
+   * Number of event-loop threads to use, set before Start and clamped to
+   * [1, kMaxThreads]. Implementations that do not shard their event loop
+   * always use one thread.
+   */
+  static const intptr_t kMaxThreads = 64;
+  static intptr_t num_threads() { return num_threads_; }
+  static void set_num_threads(intptr_t value);
+
+  /**
+   * Whether to perform socket and file I/O through io_uring, set before
+   * Start. Implementations without io_uring support, and kernels lacking it,
+   * use their regular event loop instead.
+   */
+  static bool use_io_uring() { return use_io_uring_; }
+  static void set_use_io_uring(bool value) { use_io_uring_ = value; }
+
  private:
   friend class EventHandlerImplementation;
   EventHandlerImplementation delegate_;
 
+  static intptr_t num_threads_;
+  static bool use_io_uring_;
+
   DISALLOW_COPY_AND_ASSIGN(EventHandler);
 };
 
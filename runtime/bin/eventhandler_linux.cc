@@ -68,8 +68,8 @@ static void AddToEpollInstance(intptr_t epoll_fd_, DescriptorInfo* di) {
   }
 }
 
-EventHandlerImplementation::EventHandlerImplementation()
-    : socket_map_(&SimpleHashMap::SamePointerValue, 16) {
+EventLoopShard::EventLoopShard(EventHandlerImplementation* owner)
+    : owner_(owner), socket_map_(&SimpleHashMap::SamePointerValue, 16) {
   intptr_t result;
   result = NO_RETRY_EXPECTED(pipe(interrupt_fds_));
   if (result != 0) {
@@ -117,6 +117,17 @@ EventHandlerImplementation::EventHandlerImplementation()
     FATAL2("Failed adding timerfd fd(%i) to epoll instance: %i", timer_fd_,
            errno);
   }
+  ring_ = EventHandler::use_io_uring() ? IOUring::Create() : NULL;
+  if (ring_ != NULL) {
+    // Completions are signalled on the ring file descriptor.
+    event.events = EPOLLIN;
+    event.data.fd = ring_->fd();
+    status = NO_RETRY_EXPECTED(
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, ring_->fd(), &event));
+    if (status == -1) {
+      FATAL1("Failed adding io_uring fd to epoll instance: %i", errno);
+    }
+  }
 }
 
 static void DeleteDescriptorInfo(void* info) {
@@ -125,17 +136,27 @@ static void DeleteDescriptorInfo(void* info) {
   delete di;
 }
 
-EventHandlerImplementation::~EventHandlerImplementation() {
+EventLoopShard::~EventLoopShard() {
   socket_map_.Clear(DeleteDescriptorInfo);
+  delete ring_;
   close(epoll_fd_);
   close(timer_fd_);
   close(interrupt_fds_[0]);
   close(interrupt_fds_[1]);
 }
 
-void EventHandlerImplementation::UpdateEpollInstance(intptr_t old_mask,
-                                                     DescriptorInfo* di) {
+void EventLoopShard::UpdateEpollInstance(intptr_t old_mask,
+                                         DescriptorInfo* di) {
   intptr_t new_mask = di->Mask();
+  if (di->io_uring_socket() != NULL) {
+    // The socket is not polled. Completions are turned into events instead,
+    // which are delivered as soon as the mask allows.
+    if (new_mask != 0) {
+      di->io_uring_socket()->Start();
+      DeliverIOUringEvents(di);
+    }
+    return;
+  }
   if ((old_mask != 0) && (new_mask == 0)) {
     RemoveFromEpollInstance(epoll_fd_, di);
   } else if ((old_mask == 0) && (new_mask != 0)) {
@@ -147,9 +168,9 @@ void EventHandlerImplementation::UpdateEpollInstance(intptr_t old_mask,
   }
 }
 
-DescriptorInfo* EventHandlerImplementation::GetDescriptorInfo(
-    intptr_t fd,
-    bool is_listening) {
+DescriptorInfo* EventLoopShard::GetDescriptorInfo(Socket* socket,
+                                                  bool is_listening) {
+  const intptr_t fd = socket->fd();
   ASSERT(fd >= 0);
   SimpleHashMap::Entry* entry = socket_map_.Lookup(
       GetHashmapKeyFromFd(fd), GetHashmapHashFromFd(fd), true);
@@ -163,15 +184,18 @@ DescriptorInfo* EventHandlerImplementation::GetDescriptorInfo(
     } else {
       di = new DescriptorInfoSingle(fd);
     }
+    if (socket->io_uring_socket() != NULL) {
+      di->set_io_uring_socket(socket->io_uring_socket());
+    }
     entry->value = di;
   }
   ASSERT(fd == di->fd());
   return di;
 }
 
-void EventHandlerImplementation::WakeupHandler(intptr_t id,
-                                               Dart_Port dart_port,
-                                               int64_t data) {
+void EventLoopShard::WakeupHandler(intptr_t id,
+                                   Dart_Port dart_port,
+                                   int64_t data) {
   InterruptMessage msg;
   msg.id = id;
   msg.dart_port = dart_port;
@@ -190,7 +214,7 @@ void EventHandlerImplementation::WakeupHandler(intptr_t id,
   }
 }
 
-void EventHandlerImplementation::HandleInterruptFd() {
+void EventLoopShard::HandleInterruptFd() {
   const intptr_t MAX_MESSAGES = kInterruptMessageSize;
   InterruptMessage msg[MAX_MESSAGES];
   ssize_t bytes = TEMP_FAILURE_RETRY_NO_SIGNAL_BLOCKER(
@@ -209,15 +233,20 @@ void EventHandlerImplementation::HandleInterruptFd() {
         continue;
       }
       DescriptorInfo* di =
-          GetDescriptorInfo(socket->fd(), IS_LISTENING_SOCKET(msg[i].data));
+          GetDescriptorInfo(socket, IS_LISTENING_SOCKET(msg[i].data));
       if (IS_COMMAND(msg[i].data, kShutdownReadCommand)) {
         ASSERT(!di->IsListeningSocket());
         // Close the socket for reading.
         VOID_NO_RETRY_EXPECTED(shutdown(di->fd(), SHUT_RD));
       } else if (IS_COMMAND(msg[i].data, kShutdownWriteCommand)) {
         ASSERT(!di->IsListeningSocket());
-        // Close the socket for writing.
-        VOID_NO_RETRY_EXPECTED(shutdown(di->fd(), SHUT_WR));
+        // Close the socket for writing, after the data written so far when
+        // that is still being sent through io_uring.
+        if (di->io_uring_socket() != NULL) {
+          di->io_uring_socket()->ShutdownWrite();
+        } else {
+          VOID_NO_RETRY_EXPECTED(shutdown(di->fd(), SHUT_WR));
+        }
       } else if (IS_COMMAND(msg[i].data, kCloseCommand)) {
         // Close the socket and free system resources and move on to next
         // message.
@@ -276,7 +305,7 @@ void EventHandlerImplementation::HandleInterruptFd() {
   }
 }
 
-void EventHandlerImplementation::UpdateTimerFd() {
+void EventLoopShard::UpdateTimerFd() {
   struct itimerspec it;
   memset(&it, 0, sizeof(it));
   if (timeout_queue_.HasTimeout()) {
@@ -320,8 +349,7 @@ static void PrintEventMask(intptr_t fd, intptr_t events) {
 }
 #endif
 
-intptr_t EventHandlerImplementation::GetPollEvents(intptr_t events,
-                                                   DescriptorInfo* di) {
+intptr_t EventLoopShard::GetPollEvents(intptr_t events, DescriptorInfo* di) {
 #ifdef DEBUG_POLL
   PrintEventMask(di->fd(), events);
 #endif
@@ -342,12 +370,80 @@ intptr_t EventHandlerImplementation::GetPollEvents(intptr_t events,
   return event_mask;
 }
 
-void EventHandlerImplementation::HandleEvents(struct epoll_event* events,
-                                              int size) {
+void EventLoopShard::HandleCompletions() {
+  uint64_t user_data;
+  int32_t result;
+  while (ring_->NextCompletion(&user_data, &result)) {
+    if (user_data == 0) {
+      // The completion of a cancellation.
+      continue;
+    }
+    IOUringOperation* operation =
+        reinterpret_cast<IOUringOperation*>(user_data);
+    IOUringSocket* socket = operation->socket();
+    if (socket == NULL) {
+      static_cast<IOUringFileRequest*>(operation)->Complete(result);
+      continue;
+    }
+    // Every operation in flight holds a reference to its socket.
+    RefCntReleaseScope<IOUringSocket> rs(socket);
+    const intptr_t events = socket->Complete(operation, result);
+    const intptr_t fd = socket->fd();
+    if ((events == 0) || (fd < 0)) {
+      continue;
+    }
+    SimpleHashMap::Entry* entry = socket_map_.Lookup(
+        GetHashmapKeyFromFd(fd), GetHashmapHashFromFd(fd), false);
+    if (entry == NULL) {
+      continue;
+    }
+    DescriptorInfo* di = reinterpret_cast<DescriptorInfo*>(entry->value);
+    if (di->io_uring_socket() == socket) {
+      di->AddIOUringEvents(events);
+      DeliverIOUringEvents(di);
+    }
+  }
+}
+
+// Delivers the pending io_uring events of 'di' as epoll would have reported
+// them: one event per token, to the ports that have tokens left.
+void EventLoopShard::DeliverIOUringEvents(DescriptorInfo* di) {
+  if (di->IsListeningSocket()) {
+    intptr_t connections = di->io_uring_events();
+    while ((connections > 0) && (di->Mask() != 0)) {
+      Dart_Port port = di->NextNotifyDartPort(1 << kInEvent);
+      ASSERT(port != 0);
+      DartUtils::PostInt32(port, 1 << kInEvent);
+      connections--;
+    }
+    di->set_io_uring_events(connections);
+    return;
+  }
+  while (di->Mask() != 0) {
+    const intptr_t events = di->io_uring_events();
+    if ((events & (1 << kErrorEvent)) != 0) {
+      di->set_io_uring_events(events & ~(1 << kErrorEvent));
+      di->NotifyAllDartPorts(1 << kErrorEvent);
+      continue;
+    }
+    const intptr_t ready = events & (di->Mask() | (1 << kCloseEvent));
+    if (ready == 0) {
+      break;
+    }
+    di->set_io_uring_events(events & ~ready);
+    Dart_Port port = di->NextNotifyDartPort(ready);
+    ASSERT(port != 0);
+    DartUtils::PostInt32(port, ready);
+  }
+}
+
+void EventLoopShard::HandleEvents(struct epoll_event* events, int size) {
   bool interrupt_seen = false;
   for (int i = 0; i < size; i++) {
     if (events[i].data.ptr == NULL) {
       interrupt_seen = true;
+    } else if ((ring_ != NULL) && (events[i].data.fd == ring_->fd())) {
+      HandleCompletions();
     } else if (events[i].data.fd == timer_fd_) {
       int64_t val;
       VOID_TEMP_FAILURE_RETRY_NO_SIGNAL_BLOCKER(
@@ -378,61 +474,129 @@ void EventHandlerImplementation::HandleEvents(struct epoll_event* events,
     // the current events.
     HandleInterruptFd();
   }
+  if (ring_ != NULL) {
+    // Submit the operations queued while handling the events.
+    ring_->Submit();
+  }
 }
 
-void EventHandlerImplementation::Poll(uword args) {
+void EventLoopShard::Poll(uword args) {
   ThreadSignalBlocker signal_blocker(SIGPROF);
   static const intptr_t kMaxEvents = 16;
   struct epoll_event events[kMaxEvents];
-  EventHandler* handler = reinterpret_cast<EventHandler*>(args);
-  EventHandlerImplementation* handler_impl = &handler->delegate_;
-  ASSERT(handler_impl != NULL);
+  EventLoopShard* shard = reinterpret_cast<EventLoopShard*>(args);
+  ASSERT(shard != NULL);
 
-  while (!handler_impl->shutdown_) {
+  while (!shard->shutdown_) {
     intptr_t result = TEMP_FAILURE_RETRY_NO_SIGNAL_BLOCKER(
-        epoll_wait(handler_impl->epoll_fd_, events, kMaxEvents, -1));
+        epoll_wait(shard->epoll_fd_, events, kMaxEvents, -1));
     ASSERT(EAGAIN == EWOULDBLOCK);
     if (result <= 0) {
       if (errno != EWOULDBLOCK) {
         perror("Poll failed");
       }
     } else {
-      handler_impl->HandleEvents(events, result);
+      shard->HandleEvents(events, result);
     }
   }
-  DEBUG_ASSERT(ReferenceCounted<Socket>::instances() == 0);
-  handler->NotifyShutdownDone();
+  shard->owner_->ShardDone();
 }
 
-void EventHandlerImplementation::Start(EventHandler* handler) {
-  int result =
-      Thread::Start("dart:io EventHandler", &EventHandlerImplementation::Poll,
-                    reinterpret_cast<uword>(handler));
+void EventLoopShard::Start() {
+  int result = Thread::Start("dart:io EventHandler", &EventLoopShard::Poll,
+                             reinterpret_cast<uword>(this));
   if (result != 0) {
     FATAL1("Failed to start event handler thread %d", result);
   }
 }
 
-void EventHandlerImplementation::Shutdown() {
-  SendData(kShutdownId, 0, 0);
-}
-
-void EventHandlerImplementation::SendData(intptr_t id,
-                                          Dart_Port dart_port,
-                                          int64_t data) {
+void EventLoopShard::SendData(intptr_t id, Dart_Port dart_port, int64_t data) {
   WakeupHandler(id, dart_port, data);
 }
 
-void* EventHandlerImplementation::GetHashmapKeyFromFd(intptr_t fd) {
+void* EventLoopShard::GetHashmapKeyFromFd(intptr_t fd) {
   // The hashmap does not support keys with value 0.
   return reinterpret_cast<void*>(fd + 1);
 }
 
-uint32_t EventHandlerImplementation::GetHashmapHashFromFd(intptr_t fd) {
+uint32_t EventLoopShard::GetHashmapHashFromFd(intptr_t fd) {
   // The hashmap does not support keys with value 0.
   return dart::Utils::WordHash(fd + 1);
 }
 
+EventHandlerImplementation::EventHandlerImplementation()
+    : handler_(NULL),
+      num_shards_(EventHandler::num_threads()),
+      shards_(new EventLoopShard*[num_shards_]),
+      running_shards_(0) {
+  for (intptr_t i = 0; i < num_shards_; i++) {
+    shards_[i] = new EventLoopShard(this);
+  }
+}
+
+EventHandlerImplementation::~EventHandlerImplementation() {
+  for (intptr_t i = 0; i < num_shards_; i++) {
+    delete shards_[i];
+  }
+  delete[] shards_;
+}
+
+// Commands for a socket go to the shard owning its file descriptor, and timer
+// updates to the shard owning the isolate's timer port, so that each
+// descriptor map and timeout queue is only touched by its own thread. A file
+// descriptor number is only reused after the owning shard closed it, so the
+// mapping stays consistent.
+intptr_t EventHandlerImplementation::ShardIndexFor(intptr_t fd) {
+  const intptr_t num_shards = EventHandler::num_threads();
+  if (num_shards == 1 || fd < 0) {
+    return 0;
+  }
+  return Utils::WordHash(fd + 1) % num_shards;
+}
+
+EventLoopShard* EventHandlerImplementation::ShardFor(
+    intptr_t id,
+    Dart_Port dart_port) const {
+  if (num_shards_ == 1) {
+    return shards_[0];
+  }
+  if (id == kTimerId) {
+    return shards_[Utils::WordHash(static_cast<intptr_t>(dart_port)) %
+                   num_shards_];
+  }
+  // The shard was assigned when the socket was created, so the descriptor,
+  // which the owning shard may be closing, is not read here.
+  Socket* socket = reinterpret_cast<Socket*>(id);
+  return shards_[socket->event_loop_shard()];
+}
+
+void EventHandlerImplementation::ShardDone() {
+  if (running_shards_.fetch_sub(1) == 1) {
+    DEBUG_ASSERT(ReferenceCounted<Socket>::instances() == 0);
+    handler_->NotifyShutdownDone();
+  }
+}
+
+void EventHandlerImplementation::Start(EventHandler* handler) {
+  handler_ = handler;
+  running_shards_ = num_shards_;
+  for (intptr_t i = 0; i < num_shards_; i++) {
+    shards_[i]->Start();
+  }
+}
+
+void EventHandlerImplementation::Shutdown() {
+  for (intptr_t i = 0; i < num_shards_; i++) {
+    shards_[i]->SendData(kShutdownId, 0, 0);
+  }
+}
+
+void EventHandlerImplementation::SendData(intptr_t id,
+                                          Dart_Port dart_port,
+                                          int64_t data) {
+  ShardFor(id, dart_port)->SendData(id, dart_port, data);
+}
+
 }  // namespace bin
 }  // namespace dart
 
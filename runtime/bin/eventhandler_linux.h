@@ -14,26 +14,62 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <atomic>
+
+#include "bin/io_uring_linux.h"
 #include "platform/hashmap.h"
 #include "platform/signal_blocker.h"
 
 namespace dart {
 namespace bin {
 
+class Socket;
+
 class DescriptorInfo : public DescriptorInfoBase {
  public:
-  explicit DescriptorInfo(intptr_t fd) : DescriptorInfoBase(fd) {}
+  explicit DescriptorInfo(intptr_t fd)
+      : DescriptorInfoBase(fd), io_uring_socket_(NULL), io_uring_events_(0) {}
 
   virtual ~DescriptorInfo() {}
 
   intptr_t GetPollEvents();
 
   virtual void Close() {
-    close(fd_);
+    if (io_uring_socket_ != NULL) {
+      io_uring_socket_->Close();
+      io_uring_socket_->Release();
+      io_uring_socket_ = NULL;
+    } else {
+      close(fd_);
+    }
     fd_ = -1;
   }
 
+  // The socket performing the I/O of this descriptor through io_uring, or
+  // NULL if it is polled with epoll.
+  IOUringSocket* io_uring_socket() const { return io_uring_socket_; }
+  void set_io_uring_socket(IOUringSocket* socket) {
+    ASSERT(io_uring_socket_ == NULL);
+    socket->Retain();
+    io_uring_socket_ = socket;
+  }
+
+  // Events reported by io_uring completions and not yet delivered to a Dart
+  // port. For a listening socket, the number of pending connections.
+  intptr_t io_uring_events() const { return io_uring_events_; }
+  void set_io_uring_events(intptr_t events) { io_uring_events_ = events; }
+  void AddIOUringEvents(intptr_t events) {
+    if (IsListeningSocket()) {
+      io_uring_events_++;
+    } else {
+      io_uring_events_ |= events;
+    }
+  }
+
  private:
+  IOUringSocket* io_uring_socket_;
+  intptr_t io_uring_events_;
+
   DISALLOW_COPY_AND_ASSIGN(DescriptorInfo);
 };
 
@@ -58,22 +94,31 @@ class DescriptorInfoMultiple
   DISALLOW_COPY_AND_ASSIGN(DescriptorInfoMultiple);
 };
 
-class EventHandlerImplementation {
+class EventHandlerImplementation;
+
+// One event-loop thread with its own epoll instance, timer and descriptor
+// map. Every descriptor and every timer port is owned by exactly one shard,
+// see EventHandlerImplementation::ShardFor.
+class EventLoopShard {
  public:
-  EventHandlerImplementation();
-  ~EventHandlerImplementation();
+  explicit EventLoopShard(EventHandlerImplementation* owner);
+  ~EventLoopShard();
 
   void UpdateEpollInstance(intptr_t old_mask, DescriptorInfo* di);
 
-  // Gets the socket data structure for a given file
-  // descriptor. Creates a new one if one is not found.
-  DescriptorInfo* GetDescriptorInfo(intptr_t fd, bool is_listening);
+  // Gets the socket data structure for the file descriptor of a given
+  // socket. Creates a new one if one is not found.
+  DescriptorInfo* GetDescriptorInfo(Socket* socket, bool is_listening);
   void SendData(intptr_t id, Dart_Port dart_port, int64_t data);
-  void Start(EventHandler* handler);
-  void Shutdown();
+  void Start();
+
+  // The io_uring instance of this shard, or NULL if io_uring is not used.
+  IOUring* ring() const { return ring_; }
 
  private:
   void HandleEvents(struct epoll_event* events, int size);
+  void HandleCompletions();
+  void DeliverIOUringEvents(DescriptorInfo* di);
   static void Poll(uword args);
   void WakeupHandler(intptr_t id, Dart_Port dart_port, int64_t data);
   void HandleInterruptFd();
@@ -83,12 +128,46 @@ class EventHandlerImplementation {
   static void* GetHashmapKeyFromFd(intptr_t fd);
   static uint32_t GetHashmapHashFromFd(intptr_t fd);
 
+  EventHandlerImplementation* owner_;
   SimpleHashMap socket_map_;
   TimeoutQueue timeout_queue_;
   bool shutdown_;
   int interrupt_fds_[2];
   int epoll_fd_;
   int timer_fd_;
+  IOUring* ring_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventLoopShard);
+};
+
+class EventHandlerImplementation {
+ public:
+  EventHandlerImplementation();
+  ~EventHandlerImplementation();
+
+  void SendData(intptr_t id, Dart_Port dart_port, int64_t data);
+  void Start(EventHandler* handler);
+  void Shutdown();
+
+  // Index of the shard that owns the socket with file descriptor 'fd'.
+  static intptr_t ShardIndexFor(intptr_t fd);
+
+  // The io_uring instance of the shard owning 'fd', or NULL if io_uring is
+  // not used.
+  IOUring* RingFor(intptr_t fd) const {
+    return shards_[ShardIndexFor(fd)]->ring();
+  }
+
+ private:
+  friend class EventLoopShard;
+
+  EventLoopShard* ShardFor(intptr_t id, Dart_Port dart_port) const;
+  void ShardDone();
+
+  EventHandler* handler_;
+  intptr_t num_shards_;
+  EventLoopShard** shards_;
+  std::atomic<intptr_t> running_shards_;
 
   DISALLOW_COPY_AND_ASSIGN(EventHandlerImplementation);
 };
@@ -20,6 +20,10 @@
 #include "platform/globals.h"
 #include "platform/utils.h"
 
+#if defined(HOST_OS_LINUX)
+#include "bin/io_uring_linux.h"
+#endif
+
 namespace dart {
 namespace bin {
 
@@ -68,6 +72,17 @@ void FUNCTION_NAME(IOService_NewServicePort)(Dart_NativeArguments args) {
   }
 }
 
+void FUNCTION_NAME(IOService_Submit)(Dart_NativeArguments args) {
+#if defined(HOST_OS_LINUX)
+  // File reads and writes are performed by the event handler through
+  // io_uring when it is in use, instead of by an IO service thread.
+  const bool submitted = IOUringFileRequest::Submit(args);
+#else
+  const bool submitted = false;
+#endif
+  Dart_SetBooleanReturnValue(args, submitted);
+}
+
 }  // namespace bin
 }  // namespace dart
 
@@ -0,0 +1,935 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/globals.h"
+#if defined(HOST_OS_LINUX)
+
+#include "bin/io_uring_linux.h"
+
+#include <errno.h>        // NOLINT
+#include <poll.h>         // NOLINT
+#include <sched.h>        // NOLINT
+#include <stdlib.h>       // NOLINT
+#include <string.h>       // NOLINT
+#include <sys/mman.h>     // NOLINT
+#include <sys/socket.h>   // NOLINT
+#include <sys/syscall.h>  // NOLINT
+#include <unistd.h>       // NOLINT
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>  // NOLINT
+#endif
+#endif
+
+#include "bin/dartutils.h"
+#include "bin/eventhandler.h"
+#include "bin/file.h"
+#include "bin/io_buffer.h"
+#include "bin/lockers.h"
+#include "bin/utils.h"
+#include "platform/signal_blocker.h"
+#include "platform/utils.h"
+
+#if defined(DART_IO_SECURE_SOCKET_DISABLED)
+#include "bin/io_service_no_ssl.h"
+#else
+#include "bin/io_service.h"
+#endif
+
+// IORING_FEAT_RW_CUR_POS was added together with the probe interface and the
+// non-vectored read, write, send and receive operations, so it identifies
+// headers that have everything used below.
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define SUPPORTS_IO_URING 1
+#endif
+
+namespace dart {
+namespace bin {
+
+#if defined(SUPPORTS_IO_URING)
+
+// Submission queue size. Operations are submitted after every batch of
+// events, so this only bounds the size of a batch.
+static const uint32_t kSubmissionEntries = 256;
+
+// Completion queue size. Completions that do not fit are held by the kernel
+// until there is room (IORING_FEAT_NODROP).
+static const uint32_t kCompletionEntries = 4096;
+
+static int IOUringSetup(uint32_t entries, struct io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int IOUringEnter(int fd,
+                        uint32_t to_submit,
+                        uint32_t min_complete,
+                        uint32_t flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 NULL, 0);
+}
+
+static bool SupportsOperations(int ring_fd) {
+  static const uint8_t kOperations[] = {
+      IORING_OP_RECV,         IORING_OP_SEND, IORING_OP_ACCEPT,
+      IORING_OP_POLL_ADD,     IORING_OP_READ, IORING_OP_WRITE,
+      IORING_OP_ASYNC_CANCEL,
+  };
+  const intptr_t kMaxOps = 256;
+  const size_t size = sizeof(struct io_uring_probe) +
+                      kMaxOps * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe* probe =
+      reinterpret_cast<struct io_uring_probe*>(calloc(1, size));
+  if (probe == NULL) {
+    return false;
+  }
+  bool supported = syscall(__NR_io_uring_register, ring_fd,
+                           IORING_REGISTER_PROBE, probe, kMaxOps) == 0;
+  const size_t kOperationCount = sizeof(kOperations) / sizeof(kOperations[0]);
+  for (size_t i = 0; supported && (i < kOperationCount); i++) {
+    const uint8_t op = kOperations[i];
+    supported = (op <= probe->last_op) &&
+                ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0);
+  }
+  free(probe);
+  return supported;
+}
+
+IOUring* IOUring::Create() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = kCompletionEntries;
+  int ring_fd = IOUringSetup(kSubmissionEntries, &params);
+  if (ring_fd < 0) {
+    // ENOSYS on kernels before 5.1, EPERM when disabled by seccomp or sysctl.
+    return NULL;
+  }
+  const uint32_t kRequiredFeatures =
+      IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+  if (((params.features & kRequiredFeatures) != kRequiredFeatures) ||
+      !SupportsOperations(ring_fd)) {
+    close(ring_fd);
+    return NULL;
+  }
+  IOUring* ring = new IOUring(ring_fd, params.sq_entries, params.cq_entries);
+  if (!ring->Map(&params)) {
+    delete ring;
+    return NULL;
+  }
+  return ring;
+}
+
+IOUring::IOUring(int ring_fd, uint32_t sq_entries, uint32_t cq_entries)
+    : ring_fd_(ring_fd),
+      sq_entries_(sq_entries),
+      cq_entries_(cq_entries),
+      ring_(MAP_FAILED),
+      ring_size_(0),
+      sqes_(MAP_FAILED),
+      sq_head_(NULL),
+      sq_tail_(NULL),
+      sq_mask_(NULL),
+      sq_flags_(NULL),
+      sq_array_(NULL),
+      cq_head_(NULL),
+      cq_tail_(NULL),
+      cq_mask_(NULL),
+      cqes_(NULL),
+      local_tail_(0) {}
+
+IOUring::~IOUring() {
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sq_entries_ * sizeof(struct io_uring_sqe));
+  }
+  if (ring_ != MAP_FAILED) {
+    munmap(ring_, ring_size_);
+  }
+  // Closing the ring cancels the operations still in flight.
+  close(ring_fd_);
+}
+
+bool IOUring::Map(const void* raw_params) {
+  const struct io_uring_params* params =
+      reinterpret_cast<const struct io_uring_params*>(raw_params);
+  // With IORING_FEAT_SINGLE_MMAP both rings share one mapping.
+  const size_t sq_size = params->sq_off.array + sq_entries_ * sizeof(uint32_t);
+  const size_t cq_size =
+      params->cq_off.cqes + cq_entries_ * sizeof(struct io_uring_cqe);
+  ring_size_ = sq_size > cq_size ? sq_size : cq_size;
+  ring_ = mmap(NULL, ring_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (ring_ == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = mmap(NULL, sq_entries_ * sizeof(struct io_uring_sqe),
+               PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+               IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    return false;
+  }
+  uint8_t* base = reinterpret_cast<uint8_t*>(ring_);
+  sq_head_ = reinterpret_cast<uint32_t*>(base + params->sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t*>(base + params->sq_off.tail);
+  sq_mask_ = reinterpret_cast<uint32_t*>(base + params->sq_off.ring_mask);
+  sq_flags_ = reinterpret_cast<uint32_t*>(base + params->sq_off.flags);
+  sq_array_ = reinterpret_cast<uint32_t*>(base + params->sq_off.array);
+  cq_head_ = reinterpret_cast<uint32_t*>(base + params->cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(base + params->cq_off.tail);
+  cq_mask_ = reinterpret_cast<uint32_t*>(base + params->cq_off.ring_mask);
+  cqes_ = base + params->cq_off.cqes;
+  local_tail_ = *sq_tail_;
+  return true;
+}
+
+void* IOUring::NextEntry(uint8_t opcode, intptr_t fd, uint64_t user_data) {
+  while (local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) ==
+         sq_entries_) {
+    // The queue is full of entries the kernel has not consumed yet.
+    if (!SubmitLocked()) {
+      sched_yield();
+    }
+  }
+  const uint32_t index = local_tail_ & *sq_mask_;
+  struct io_uring_sqe* sqe =
+      reinterpret_cast<struct io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  local_tail_++;
+  return sqe;
+}
+
+void IOUring::Recv(intptr_t fd,
+                   void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_RECV, fd, user_data));
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = length;
+}
+
+void IOUring::Send(intptr_t fd,
+                   const void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_SEND, fd, user_data));
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = length;
+  sqe->msg_flags = MSG_NOSIGNAL;
+}
+
+void IOUring::Accept(intptr_t fd, uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_ACCEPT, fd, user_data));
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+}
+
+void IOUring::PollAdd(intptr_t fd, uint32_t events, uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_POLL_ADD, fd, user_data));
+  sqe->poll_events = events;
+}
+
+void IOUring::Read(intptr_t fd,
+                   void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_READ, fd, user_data));
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = length;
+  sqe->off = static_cast<uint64_t>(-1);
+}
+
+void IOUring::Write(intptr_t fd,
+                    const void* buffer,
+                    intptr_t length,
+                    uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_WRITE, fd, user_data));
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = length;
+  sqe->off = static_cast<uint64_t>(-1);
+}
+
+void IOUring::Cancel(uint64_t user_data) {
+  MutexLocker ml(&mutex_);
+  struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(
+      NextEntry(IORING_OP_ASYNC_CANCEL, -1, 0));
+  sqe->addr = user_data;
+}
+
+void IOUring::Submit() {
+  MutexLocker ml(&mutex_);
+  SubmitLocked();
+}
+
+bool IOUring::SubmitLocked() {
+  const uint32_t to_submit =
+      local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (to_submit == 0) {
+    return true;
+  }
+  __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+  // Also called from Dart threads, which do not block SIGPROF.
+  int result = TEMP_FAILURE_RETRY(IOUringEnter(ring_fd_, to_submit, 0, 0));
+  if (result < 0) {
+    // EBUSY while completions wait for room in the completion queue, and
+    // EAGAIN when the kernel is out of memory. The entries stay queued, and
+    // are submitted again once the owning shard has consumed completions.
+    if ((errno == EBUSY) || (errno == EAGAIN)) {
+      return false;
+    }
+    FATAL1("io_uring_enter failed: %i", errno);
+  }
+  return true;
+}
+
+bool IOUring::NextCompletion(uint64_t* user_data, int32_t* result) {
+  const uint32_t head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+#if defined(IORING_SQ_CQ_OVERFLOW)
+    if ((__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) &
+         IORING_SQ_CQ_OVERFLOW) == 0) {
+      return false;
+    }
+    // Completions that did not fit are moved into the queue when the kernel
+    // is entered.
+    VOID_TEMP_FAILURE_RETRY_NO_SIGNAL_BLOCKER(
+        IOUringEnter(ring_fd_, 0, 0, IORING_ENTER_GETEVENTS));
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+#else
+    return false;
+#endif
+  }
+  const struct io_uring_cqe* cqe =
+      reinterpret_cast<const struct io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+  *user_data = cqe->user_data;
+  *result = cqe->res;
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+#else  // defined(SUPPORTS_IO_URING)
+
+IOUring* IOUring::Create() {
+  return NULL;
+}
+
+IOUring::~IOUring() {
+  UNREACHABLE();
+}
+
+void IOUring::Recv(intptr_t fd,
+                   void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Send(intptr_t fd,
+                   const void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Accept(intptr_t fd, uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::PollAdd(intptr_t fd, uint32_t events, uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Read(intptr_t fd,
+                   void* buffer,
+                   intptr_t length,
+                   uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Write(intptr_t fd,
+                    const void* buffer,
+                    intptr_t length,
+                    uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Cancel(uint64_t user_data) {
+  UNREACHABLE();
+}
+
+void IOUring::Submit() {
+  UNREACHABLE();
+}
+
+bool IOUring::NextCompletion(uint64_t* user_data, int32_t* result) {
+  UNREACHABLE();
+  return false;
+}
+
+#endif  // defined(SUPPORTS_IO_URING)
+
+IOUringSocket::IOUringSocket(IOUring* ring, intptr_t fd, bool is_listening)
+    : ReferenceCounted(),
+      ring_(ring),
+      fd_(fd),
+      is_listening_(is_listening),
+      started_(false),
+      closing_(false),
+      shutdown_write_pending_(false),
+      error_(0),
+      connect_(IOUringOperation::kConnect, this),
+      connect_pending_(false),
+      recv_(IOUringOperation::kRecv, this),
+      recv_buffer_(NULL),
+      recv_offset_(0),
+      recv_length_(0),
+      recv_pending_(false),
+      eof_(false),
+      send_(IOUringOperation::kSend, this),
+      send_buffer_(NULL),
+      send_offset_(0),
+      send_length_(0),
+      send_pending_(false),
+      send_waiting_(false),
+      accept_(IOUringOperation::kAccept, this),
+      accepted_head_(0),
+      accepted_count_(0),
+      accept_pending_(false) {}
+
+IOUringSocket::~IOUringSocket() {
+  for (intptr_t i = 0; i < accepted_count_; i++) {
+    close(accepted_[(accepted_head_ + i) % kMaxAccepted]);
+  }
+  free(recv_buffer_);
+  free(send_buffer_);
+}
+
+intptr_t IOUringSocket::Available() {
+  MutexLocker ml(&mutex_);
+  return recv_length_ - recv_offset_;
+}
+
+intptr_t IOUringSocket::Read(void* buffer, intptr_t length) {
+  MutexLocker ml(&mutex_);
+  const intptr_t count = Utils::Minimum(length, recv_length_ - recv_offset_);
+  if (count == 0) {
+    return 0;
+  }
+  memmove(buffer, recv_buffer_ + recv_offset_, count);
+  recv_offset_ += count;
+  if (recv_offset_ == recv_length_) {
+    // Receive more once the buffer has been drained.
+    QueueRecvLocked();
+    ring_->Submit();
+  }
+  return count;
+}
+
+intptr_t IOUringSocket::Write(void* const* buffers,
+                              const intptr_t* lengths,
+                              intptr_t count) {
+  MutexLocker ml(&mutex_);
+  if (error_ != 0) {
+    errno = error_;
+    return -1;
+  }
+  if (send_pending_ || closing_) {
+    send_waiting_ = true;
+    return 0;
+  }
+  if (send_buffer_ == NULL) {
+    send_buffer_ = reinterpret_cast<uint8_t*>(malloc(kBufferSize));
+    if (send_buffer_ == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+  }
+  intptr_t written = 0;
+  bool complete = true;
+  for (intptr_t i = 0; i < count; i++) {
+    const intptr_t bytes = Utils::Minimum(lengths[i], kBufferSize - written);
+    memmove(send_buffer_ + written, buffers[i], bytes);
+    written += bytes;
+    if (bytes < lengths[i]) {
+      complete = false;
+      break;
+    }
+  }
+  if (written == 0) {
+    return 0;
+  }
+  send_offset_ = 0;
+  send_length_ = written;
+  send_waiting_ = !complete;
+  QueueSendLocked();
+  ring_->Submit();
+  return written;
+}
+
+intptr_t IOUringSocket::Accept() {
+  MutexLocker ml(&mutex_);
+  intptr_t fd = -1;
+  if (accepted_count_ > 0) {
+    fd = accepted_[accepted_head_];
+    accepted_head_ = (accepted_head_ + 1) % kMaxAccepted;
+    accepted_count_--;
+  }
+  if (!accept_pending_) {
+    // Accepting paused because the queue was full or an accept failed.
+    QueueAcceptLocked();
+    ring_->Submit();
+  }
+  return fd;
+}
+
+int IOUringSocket::error() {
+  MutexLocker ml(&mutex_);
+  return error_;
+}
+
+void IOUringSocket::Start() {
+  MutexLocker ml(&mutex_);
+  if (started_ || closing_) {
+    return;
+  }
+  started_ = true;
+  if (is_listening_) {
+    QueueAcceptLocked();
+  } else {
+    // Like epoll, report the first kOutEvent once the connection has been
+    // established. Receiving starts then.
+    connect_pending_ = true;
+    Retain();
+    ring_->PollAdd(fd_, POLLOUT, connect_.user_data());
+  }
+}
+
+void IOUringSocket::QueueRecvLocked() {
+  if (closing_ || eof_ || (error_ != 0) || recv_pending_) {
+    return;
+  }
+  if (recv_buffer_ == NULL) {
+    recv_buffer_ = reinterpret_cast<uint8_t*>(malloc(kBufferSize));
+    if (recv_buffer_ == NULL) {
+      OUT_OF_MEMORY();
+    }
+  }
+  recv_offset_ = 0;
+  recv_length_ = 0;
+  recv_pending_ = true;
+  IssueLocked(&recv_);
+}
+
+void IOUringSocket::QueueSendLocked() {
+  ASSERT(!send_pending_ && (send_offset_ < send_length_));
+  send_pending_ = true;
+  IssueLocked(&send_);
+}
+
+void IOUringSocket::QueueAcceptLocked() {
+  if (!started_ || closing_ || accept_pending_ ||
+      (accepted_count_ == kMaxAccepted)) {
+    return;
+  }
+  accept_pending_ = true;
+  IssueLocked(&accept_);
+}
+
+void IOUringSocket::IssueLocked(IOUringOperation* operation) {
+  operation->set_polling(false);
+  Retain();
+  switch (operation->kind()) {
+    case IOUringOperation::kRecv:
+      ring_->Recv(fd_, recv_buffer_, kBufferSize, operation->user_data());
+      break;
+    case IOUringOperation::kSend:
+      ring_->Send(fd_, send_buffer_ + send_offset_, send_length_ - send_offset_,
+                  operation->user_data());
+      break;
+    case IOUringOperation::kAccept:
+      ring_->Accept(fd_, operation->user_data());
+      break;
+    default:
+      UNREACHABLE();
+  }
+}
+
+void IOUringSocket::PollLocked(IOUringOperation* operation, uint32_t events) {
+  operation->set_polling(true);
+  Retain();
+  ring_->PollAdd(fd_, events, operation->user_data());
+}
+
+intptr_t IOUringSocket::Complete(IOUringOperation* operation, int32_t result) {
+  MutexLocker ml(&mutex_);
+  switch (operation->kind()) {
+    case IOUringOperation::kConnect:
+      connect_pending_ = false;
+      if (closing_ || (result == -ECANCELED)) {
+        return 0;
+      }
+      if (result < 0) {
+        SetErrorLocked(-result);
+        return 1 << kErrorEvent;
+      }
+      if ((result & POLLERR) != 0) {
+        // The Dart side reads the error with SO_ERROR, as with epoll.
+        return 1 << kErrorEvent;
+      }
+      QueueRecvLocked();
+      return 1 << kOutEvent;
+    case IOUringOperation::kRecv:
+      if (closing_ || (result == -ECANCELED)) {
+        recv_pending_ = false;
+        return 0;
+      }
+      if (operation->polling()) {
+        // Ready, or failed. Either way the receive reports it.
+        IssueLocked(operation);
+        return 0;
+      }
+      if (result == -EAGAIN) {
+        PollLocked(operation, POLLIN);
+        return 0;
+      }
+      recv_pending_ = false;
+      if (result > 0) {
+        recv_length_ = result;
+        return 1 << kInEvent;
+      }
+      if (result == 0) {
+        eof_ = true;
+        return 1 << kCloseEvent;
+      }
+      SetErrorLocked(-result);
+      return 1 << kErrorEvent;
+    case IOUringOperation::kSend:
+      return CompleteSendLocked(operation, result);
+    case IOUringOperation::kAccept:
+      if (closing_ || (result == -ECANCELED)) {
+        if (!operation->polling() && (result >= 0)) {
+          close(result);
+        }
+        accept_pending_ = false;
+        return 0;
+      }
+      if (operation->polling()) {
+        IssueLocked(operation);
+        return 0;
+      }
+      if (result == -EAGAIN) {
+        PollLocked(operation, POLLIN);
+        return 0;
+      }
+      accept_pending_ = false;
+      if (result >= 0) {
+        accepted_[(accepted_head_ + accepted_count_) % kMaxAccepted] = result;
+        accepted_count_++;
+        QueueAcceptLocked();
+      }
+      // A failure is reported as a connection too. Accept then finds none,
+      // and accepts again, like an accept after a level-triggered epoll
+      // event.
+      return 1 << kInEvent;
+    default:
+      UNREACHABLE();
+      return 0;
+  }
+}
+
+intptr_t IOUringSocket::CompleteSendLocked(IOUringOperation* operation,
+                                           int32_t result) {
+  // Sends are not cancelled on close, so that the data the Dart side has
+  // written is sent before the file descriptor is closed.
+  if (operation->polling()) {
+    IssueLocked(operation);
+    return 0;
+  }
+  if (result == -EAGAIN) {
+    PollLocked(operation, POLLOUT);
+    return 0;
+  }
+  if (result > 0) {
+    send_offset_ += result;
+    if (send_offset_ < send_length_) {
+      IssueLocked(operation);
+      return 0;
+    }
+  } else if (result < 0) {
+    SetErrorLocked(-result);
+  }
+  send_pending_ = false;
+  if (closing_) {
+    CloseFdLocked();
+    return 0;
+  }
+  if (shutdown_write_pending_) {
+    shutdown_write_pending_ = false;
+    VOID_NO_RETRY_EXPECTED(shutdown(fd_, SHUT_WR));
+  }
+  if (send_waiting_) {
+    // The Dart side writes again, or sees the error, on this event.
+    send_waiting_ = false;
+    return 1 << kOutEvent;
+  }
+  return 0;
+}
+
+void IOUringSocket::SetErrorLocked(int error) {
+  if (error_ == 0) {
+    error_ = error;
+  }
+}
+
+void IOUringSocket::ShutdownWrite() {
+  MutexLocker ml(&mutex_);
+  if (send_pending_) {
+    shutdown_write_pending_ = true;
+  } else {
+    VOID_NO_RETRY_EXPECTED(shutdown(fd_, SHUT_WR));
+  }
+}
+
+void IOUringSocket::Close() {
+  MutexLocker ml(&mutex_);
+  ASSERT(!closing_);
+  closing_ = true;
+  if (connect_pending_) {
+    ring_->Cancel(connect_.user_data());
+  }
+  if (recv_pending_) {
+    ring_->Cancel(recv_.user_data());
+  }
+  if (accept_pending_) {
+    ring_->Cancel(accept_.user_data());
+  }
+  while (accepted_count_ > 0) {
+    close(accepted_[accepted_head_]);
+    accepted_head_ = (accepted_head_ + 1) % kMaxAccepted;
+    accepted_count_--;
+  }
+  if (!send_pending_) {
+    CloseFdLocked();
+  }
+}
+
+void IOUringSocket::CloseFdLocked() {
+  ASSERT(fd_ >= 0);
+  close(fd_);
+  fd_ = -1;
+}
+
+bool IOUringFileRequest::Submit(Dart_NativeArguments args) {
+  Kind kind;
+  switch (DartUtils::GetIntptrValue(Dart_GetNativeArgument(args, 2))) {
+    case IOService::kFileReadRequest:
+      kind = kFileRead;
+      break;
+    case IOService::kFileReadIntoRequest:
+      kind = kFileReadInto;
+      break;
+    case IOService::kFileWriteFromRequest:
+      kind = kFileWrite;
+      break;
+    default:
+      return false;
+  }
+  EventHandlerImplementation* event_handler = EventHandler::delegate();
+  Dart_Handle data = Dart_GetNativeArgument(args, 3);
+  File* file = reinterpret_cast<File*>(
+      DartUtils::GetIntptrValue(Dart_ListGetAt(data, 0)));
+  if ((event_handler == NULL) || (file == NULL) || file->IsClosed()) {
+    return false;
+  }
+  IOUring* ring = event_handler->RingFor(file->GetFD());
+  if (ring == NULL) {
+    return false;
+  }
+  uint8_t* buffer;
+  intptr_t length;
+  if (kind == kFileWrite) {
+    // Lists other than Uint8List and Int8List need the conversion done by
+    // File::WriteFromRequest.
+    Dart_Handle buffer_obj = Dart_ListGetAt(data, 1);
+    const Dart_TypedData_Type type = Dart_GetTypeOfTypedData(buffer_obj);
+    if ((type != Dart_TypedData_kUint8) && (type != Dart_TypedData_kInt8)) {
+      return false;
+    }
+    const intptr_t start = DartUtils::GetIntptrValue(Dart_ListGetAt(data, 2));
+    const intptr_t end = DartUtils::GetIntptrValue(Dart_ListGetAt(data, 3));
+    length = end - start;
+    if ((length <= 0) || (length > kMaxInt32)) {
+      return false;
+    }
+    buffer = reinterpret_cast<uint8_t*>(malloc(length));
+    if (buffer == NULL) {
+      return false;
+    }
+    Dart_TypedData_Type actual_type;
+    void* bytes;
+    intptr_t bytes_length;
+    Dart_Handle result = Dart_TypedDataAcquireData(buffer_obj, &actual_type,
+                                                   &bytes, &bytes_length);
+    if (Dart_IsError(result)) {
+      free(buffer);
+      Dart_PropagateError(result);
+    }
+    ASSERT(end <= bytes_length);
+    memmove(buffer, reinterpret_cast<uint8_t*>(bytes) + start, length);
+    Dart_TypedDataReleaseData(buffer_obj);
+  } else {
+    length = DartUtils::GetIntptrValue(Dart_ListGetAt(data, 1));
+    if ((length <= 0) || (length > kMaxInt32)) {
+      return false;
+    }
+    buffer = IOBuffer::Allocate(length);
+    if (buffer == NULL) {
+      return false;
+    }
+  }
+  Dart_Port reply_port;
+  Dart_Handle result =
+      Dart_SendPortGetId(Dart_GetNativeArgument(args, 1), &reply_port);
+  if (Dart_IsError(result)) {
+    free(buffer);
+    Dart_PropagateError(result);
+  }
+  const int32_t id = DartUtils::GetIntptrValue(Dart_GetNativeArgument(args, 0));
+  // The request takes over the reference to the file that the Dart side
+  // retained for the IO service.
+  IOUringFileRequest* request = new IOUringFileRequest(
+      kind, ring, file, reply_port, id, buffer, length);
+  request->Queue();
+  ring->Submit();
+  return true;
+}
+
+IOUringFileRequest::IOUringFileRequest(Kind kind,
+                                       IOUring* ring,
+                                       File* file,
+                                       Dart_Port reply_port,
+                                       int32_t id,
+                                       uint8_t* buffer,
+                                       intptr_t length)
+    : IOUringOperation(kind, NULL),
+      ring_(ring),
+      file_(file),
+      reply_port_(reply_port),
+      id_(id),
+      buffer_(buffer),
+      length_(length),
+      done_(0) {}
+
+IOUringFileRequest::~IOUringFileRequest() {
+  free(buffer_);
+  file_->Release();
+}
+
+void IOUringFileRequest::Queue() {
+  const intptr_t fd = file_->GetFD();
+  if (kind() == kFileWrite) {
+    ring_->Write(fd, buffer_ + done_, length_ - done_, user_data());
+  } else {
+    ring_->Read(fd, buffer_, length_, user_data());
+  }
+}
+
+void IOUringFileRequest::Complete(int32_t result) {
+  if ((kind() == kFileWrite) && (result > 0) && (done_ + result < length_)) {
+    // Write the rest, as File::WriteFully does.
+    done_ += result;
+    Queue();
+    return;
+  }
+  if (result < 0) {
+    OSError os_error;
+    os_error.SetCodeAndMessage(OSError::kSystem, -result);
+    Dart_CObject error_code;
+    error_code.type = Dart_CObject_kInt32;
+    error_code.value.as_int32 = CObject::kOSError;
+    Dart_CObject os_error_code;
+    os_error_code.type = Dart_CObject_kInt32;
+    os_error_code.value.as_int32 = os_error.code();
+    Dart_CObject os_error_message;
+    os_error_message.type = Dart_CObject_kString;
+    os_error_message.value.as_string = const_cast<char*>(os_error.message());
+    Dart_CObject* values[] = {&error_code, &os_error_code, &os_error_message};
+    Dart_CObject response;
+    response.type = Dart_CObject_kArray;
+    response.value.as_array.length = sizeof(values) / sizeof(values[0]);
+    response.value.as_array.values = values;
+    Reply(&response);
+  } else if (kind() == kFileWrite) {
+    Dart_CObject response;
+    response.type = Dart_CObject_kInt64;
+    response.value.as_int64 = done_ + result;
+    Reply(&response);
+  } else {
+    Dart_CObject success;
+    success.type = Dart_CObject_kInt32;
+    success.value.as_int32 = CObject::kSuccess;
+    Dart_CObject bytes_read;
+    bytes_read.type = Dart_CObject_kInt64;
+    bytes_read.value.as_int64 = result;
+    Dart_CObject data;
+    data.type = Dart_CObject_kExternalTypedData;
+    data.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+    data.value.as_external_typed_data.length = result;
+    data.value.as_external_typed_data.data = buffer_;
+    data.value.as_external_typed_data.peer = buffer_;
+    data.value.as_external_typed_data.callback = IOBuffer::Finalizer;
+    // The same responses as File::ReadRequest and File::ReadIntoRequest.
+    Dart_CObject* read_values[] = {&success, &data};
+    Dart_CObject* read_into_values[] = {&success, &bytes_read, &data};
+    Dart_CObject response;
+    response.type = Dart_CObject_kArray;
+    if (kind() == kFileRead) {
+      response.value.as_array.length =
+          sizeof(read_values) / sizeof(read_values[0]);
+      response.value.as_array.values = read_values;
+    } else {
+      response.value.as_array.length =
+          sizeof(read_into_values) / sizeof(read_into_values[0]);
+      response.value.as_array.values = read_into_values;
+    }
+    if (Reply(&response)) {
+      // The buffer is now owned by the message.
+      buffer_ = NULL;
+    }
+  }
+  delete this;
+}
+
+bool IOUringFileRequest::Reply(Dart_CObject* response) {
+  Dart_CObject id;
+  id.type = Dart_CObject_kInt32;
+  id.value.as_int32 = id_;
+  Dart_CObject* values[] = {&id, response};
+  Dart_CObject message;
+  message.type = Dart_CObject_kArray;
+  message.value.as_array.length = sizeof(values) / sizeof(values[0]);
+  message.value.as_array.values = values;
+  return Dart_PostCObject(reply_port_, &message);
+}
+
+}  // namespace bin
+}  // namespace dart
+
+#endif  // defined(HOST_OS_LINUX)
@@ -0,0 +1,270 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_BIN_IO_URING_LINUX_H_
+#define RUNTIME_BIN_IO_URING_LINUX_H_
+
+#include "bin/builtin.h"
+#include "bin/reference_counting.h"
+#include "bin/thread.h"
+#include "include/dart_native_api.h"
+#include "platform/globals.h"
+
+namespace dart {
+namespace bin {
+
+class File;
+class IOUringSocket;
+
+// An io_uring submission and completion queue pair, owned by one event loop
+// shard.
+//
+// Operations may be queued and submitted from any thread. Completions are
+// only consumed by the owning shard, which polls fd() for them.
+class IOUring {
+ public:
+  // Returns NULL if the kernel does not support io_uring or one of the
+  // operations used here. Callers should then use epoll and direct system
+  // calls.
+  static IOUring* Create();
+
+  ~IOUring();
+
+  intptr_t fd() const { return ring_fd_; }
+
+  // Queue an operation. 'user_data' is reported back with its result by
+  // NextCompletion. Nothing is started before the next Submit.
+  void Recv(intptr_t fd, void* buffer, intptr_t length, uint64_t user_data);
+  void Send(intptr_t fd,
+            const void* buffer,
+            intptr_t length,
+            uint64_t user_data);
+  void Accept(intptr_t fd, uint64_t user_data);
+  void PollAdd(intptr_t fd, uint32_t events, uint64_t user_data);
+  // Read and Write use and update the current file position.
+  void Read(intptr_t fd, void* buffer, intptr_t length, uint64_t user_data);
+  void Write(intptr_t fd,
+             const void* buffer,
+             intptr_t length,
+             uint64_t user_data);
+  // Cancels the operation queued with 'user_data'. Its completion reports
+  // -ECANCELED, unless it completed before it could be cancelled. The
+  // cancellation itself completes with a user_data of 0.
+  void Cancel(uint64_t user_data);
+
+  // Submits the queued operations without waiting for any of them.
+  void Submit();
+
+  // Pops one completion. Returns false when there are none left. Only
+  // called by the owning shard.
+  bool NextCompletion(uint64_t* user_data, int32_t* result);
+
+ private:
+  IOUring(int ring_fd, uint32_t sq_entries, uint32_t cq_entries);
+
+  bool Map(const void* params);
+  void* NextEntry(uint8_t opcode, intptr_t fd, uint64_t user_data);
+  bool SubmitLocked();
+
+  int ring_fd_;
+  uint32_t sq_entries_;
+  uint32_t cq_entries_;
+
+  // Shared ring memory.
+  void* ring_;
+  size_t ring_size_;
+  void* sqes_;
+  uint32_t* sq_head_;
+  uint32_t* sq_tail_;
+  uint32_t* sq_mask_;
+  uint32_t* sq_flags_;
+  uint32_t* sq_array_;
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t* cq_mask_;
+  void* cqes_;
+
+  // Guards the submission queue.
+  Mutex mutex_;
+  uint32_t local_tail_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUring);
+};
+
+// An operation in flight on an IOUring. Its address is the user_data of its
+// queue entries.
+class IOUringOperation {
+ public:
+  enum Kind {
+    kRecv,
+    kSend,
+    kAccept,
+    kConnect,
+    kFileRead,
+    kFileReadInto,
+    kFileWrite,
+  };
+
+  IOUringOperation(Kind kind, IOUringSocket* socket)
+      : kind_(kind), socket_(socket), polling_(false) {}
+
+  Kind kind() const { return kind_; }
+
+  // The socket of a socket operation, or NULL for a file operation.
+  IOUringSocket* socket() const { return socket_; }
+
+  // Whether the entry in flight is a poll for readiness, queued because the
+  // operation itself found the socket not ready.
+  bool polling() const { return polling_; }
+  void set_polling(bool value) { polling_ = value; }
+
+  uint64_t user_data() { return reinterpret_cast<uint64_t>(this); }
+
+ private:
+  Kind kind_;
+  IOUringSocket* socket_;
+  bool polling_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUringOperation);
+};
+
+// A connected or listening stream socket whose reads, writes and accepts are
+// performed through the IOUring of the event loop shard owning it.
+//
+// The Dart thread reads from a receive buffer, writes into a send buffer and
+// takes accepted connections from a queue. The shard refills and drains them
+// from the completions and turns those into the events that epoll would have
+// reported, see EventLoopShard::DeliverIOUringEvents.
+class IOUringSocket : public ReferenceCounted<IOUringSocket> {
+ public:
+  IOUringSocket(IOUring* ring, intptr_t fd, bool is_listening);
+
+  intptr_t fd() const { return fd_; }
+
+  // Called from the Dart thread. These have the semantics of the
+  // non-blocking system calls they replace: Read and Write return 0 rather
+  // than blocking, and Write returns -1 with errno set for an error
+  // reported by an earlier send or receive. Accept returns -1 if no
+  // connection is pending.
+  intptr_t Available();
+  intptr_t Read(void* buffer, intptr_t length);
+  intptr_t Write(void* const* buffers, const intptr_t* lengths, intptr_t count);
+  intptr_t Accept();
+  // The error reported by a completion, or 0.
+  int error();
+
+  // Called from the owning shard.
+  //
+  // Starts waiting for the connection to be established, or for incoming
+  // connections. Later calls do nothing.
+  void Start();
+  // Handles the completion of 'operation', and returns the events to report
+  // for it. For a listening socket, each kInEvent stands for a connection.
+  intptr_t Complete(IOUringOperation* operation, int32_t result);
+  void ShutdownWrite();
+  // Cancels the operations in flight and closes the file descriptor, which
+  // is deferred until a pending send has completed.
+  void Close();
+
+ private:
+  ~IOUringSocket();
+
+  // Buffer size for receives and sends.
+  static const intptr_t kBufferSize = 64 * KB;
+  // Number of accepted connections queued before accepting pauses.
+  static const intptr_t kMaxAccepted = 16;
+
+  void QueueRecvLocked();
+  void QueueSendLocked();
+  void QueueAcceptLocked();
+  // Queues 'operation' itself, or a poll for 'events' to retry it after.
+  void IssueLocked(IOUringOperation* operation);
+  void PollLocked(IOUringOperation* operation, uint32_t events);
+  intptr_t CompleteSendLocked(IOUringOperation* operation, int32_t result);
+  void SetErrorLocked(int error);
+  void CloseFdLocked();
+
+  Mutex mutex_;
+  IOUring* ring_;
+  intptr_t fd_;
+  bool is_listening_;
+  bool started_;
+  bool closing_;
+  bool shutdown_write_pending_;
+  // The first error reported by a completion.
+  int error_;
+
+  IOUringOperation connect_;
+  bool connect_pending_;
+
+  IOUringOperation recv_;
+  uint8_t* recv_buffer_;
+  intptr_t recv_offset_;
+  intptr_t recv_length_;
+  bool recv_pending_;
+  bool eof_;
+
+  IOUringOperation send_;
+  uint8_t* send_buffer_;
+  intptr_t send_offset_;
+  intptr_t send_length_;
+  bool send_pending_;
+  // Set when a write returned less than asked for, so that a kOutEvent is
+  // reported once the pending send completes.
+  bool send_waiting_;
+
+  IOUringOperation accept_;
+  intptr_t accepted_[kMaxAccepted];
+  intptr_t accepted_head_;
+  intptr_t accepted_count_;
+  bool accept_pending_;
+
+  friend class ReferenceCounted<IOUringSocket>;
+  DISALLOW_COPY_AND_ASSIGN(IOUringSocket);
+};
+
+// A read or write of a RandomAccessFile requested through the IO service,
+// performed by an IOUring instead of an IO service thread. It replies with
+// the same response as the matching File::*Request.
+class IOUringFileRequest : public IOUringOperation {
+ public:
+  // Queues and submits the request made by the native arguments of
+  // _IOService._submit. Returns false, leaving the request to the IO service
+  // thread, when io_uring is not in use or the request is not one of the
+  // above.
+  static bool Submit(Dart_NativeArguments args);
+
+  // Handles the completion. Deletes the request unless it was resubmitted
+  // to write the rest of a short write.
+  void Complete(int32_t result);
+
+ private:
+  IOUringFileRequest(Kind kind,
+                     IOUring* ring,
+                     File* file,
+                     Dart_Port reply_port,
+                     int32_t id,
+                     uint8_t* buffer,
+                     intptr_t length);
+  ~IOUringFileRequest();
+
+  void Queue();
+  // Posts [id, response] to the reply port. Returns whether it was posted.
+  bool Reply(Dart_CObject* response);
+
+  IOUring* ring_;
+  File* file_;
+  Dart_Port reply_port_;
+  int32_t id_;
+  uint8_t* buffer_;
+  intptr_t length_;
+  intptr_t done_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUringFileRequest);
+};
+
+}  // namespace bin
+}  // namespace dart
+
+#endif  // RUNTIME_BIN_IO_URING_LINUX_H_
@@ -11,6 +11,7 @@
 #include "bin/abi_version.h"
 #include "bin/dartdev_utils.h"
 #include "bin/error_exit.h"
+#include "bin/eventhandler.h"
 #include "bin/options.h"
 #include "bin/platform.h"
 #include "platform/syslog.h"
@@ -97,6 +98,16 @@ static void hot_reload_test_mode_callback(CommandLineOptions* vm_options) {
 
 DEFINE_BOOL_OPTION_CB(hot_reload_test_mode, hot_reload_test_mode_callback);
 
+DEFINE_STRING_OPTION_CB(event_handler_threads, {
+  EventHandler::set_num_threads(strtol(value, NULL, 10));
+});
+
+static void io_uring_callback(CommandLineOptions* vm_options) {
+  EventHandler::set_use_io_uring(true);
+}
+
+DEFINE_BOOL_OPTION_CB(io_uring, io_uring_callback);
+
 static void hot_reload_rollback_test_mode_callback(
     CommandLineOptions* vm_options) {
   // Identity reload.
@@ -232,6 +243,15 @@ void Options::PrintUsage() {
 "  The path to a directory that dart:io calls will treat as the root of the\n"
 "  filesystem.\n"
 #endif  // defined(HOST_OS_LINUX) || defined(HOST_OS_ANDROID)
+#if defined(HOST_OS_LINUX)
+"--event-handler-threads=<count>\n"
+"  The number of threads used to poll dart:io sockets and timers\n"
+"  (default 1).\n"
+"--io-uring\n"
+"  Perform socket reads, writes and accepts, and file reads and writes,\n"
+"  through io_uring when the kernel supports it, and through epoll and\n"
+"  system calls otherwise.\n"
+#endif  // defined(HOST_OS_LINUX)
 "\n"
 "The following options are only used for VM development and may\n"
 "be changed in any future version:\n");
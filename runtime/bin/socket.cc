@@ -29,6 +29,83 @@ ListeningSocketRegistry* globalTcpListeningSocketRegistry = nullptr;
 bool Socket::short_socket_read_ = false;
 bool Socket::short_socket_write_ = false;
 
+// Creates the Socket for a connected or listening stream socket, with an
+// io_uring engine for its I/O when the owning event loop shard has one.
+static Socket* NewStreamSocket(intptr_t fd, bool is_listening) {
+  Socket* socket = new Socket(fd);
+#if defined(HOST_OS_LINUX)
+  EventHandlerImplementation* event_handler = EventHandler::delegate();
+  IOUring* ring = (event_handler != NULL) ? event_handler->RingFor(fd) : NULL;
+  if (ring != NULL) {
+    IOUringSocket* io_uring_socket = new IOUringSocket(ring, fd, is_listening);
+    socket->set_io_uring_socket(io_uring_socket);
+    io_uring_socket->Release();
+  }
+#endif
+  return socket;
+}
+
+// The socket I/O used by the natives below, performed by the io_uring engine
+// of the socket if it has one.
+static intptr_t SocketAvailable(Socket* socket) {
+#if defined(HOST_OS_LINUX)
+  if (socket->io_uring_socket() != NULL) {
+    return socket->io_uring_socket()->Available();
+  }
+#endif
+  return SocketBase::Available(socket->fd());
+}
+
+static intptr_t SocketRead(Socket* socket, void* buffer, intptr_t length) {
+#if defined(HOST_OS_LINUX)
+  if (socket->io_uring_socket() != NULL) {
+    return socket->io_uring_socket()->Read(buffer, length);
+  }
+#endif
+  return SocketBase::Read(socket->fd(), buffer, length, SocketBase::kAsync);
+}
+
+static intptr_t SocketWrite(Socket* socket,
+                            void* const* buffers,
+                            const intptr_t* lengths,
+                            intptr_t count) {
+#if defined(HOST_OS_LINUX)
+  if (socket->io_uring_socket() != NULL) {
+    return socket->io_uring_socket()->Write(buffers, lengths, count);
+  }
+#endif
+  if (count == 1) {
+    return SocketBase::Write(socket->fd(), buffers[0], lengths[0],
+                             SocketBase::kAsync);
+  }
+  return SocketBase::WriteVectored(socket->fd(), buffers, lengths, count,
+                                   SocketBase::kAsync);
+}
+
+static intptr_t SocketAccept(Socket* socket) {
+#if defined(HOST_OS_LINUX)
+  if (socket->io_uring_socket() != NULL) {
+    return socket->io_uring_socket()->Accept();
+  }
+#endif
+  return ServerSocket::Accept(socket->fd());
+}
+
+static void GetSocketError(Socket* socket, OSError* os_error) {
+#if defined(HOST_OS_LINUX)
+  // An error reported by an io_uring completion has already been taken from
+  // the socket, so SO_ERROR no longer holds it.
+  if (socket->io_uring_socket() != NULL) {
+    const int error = socket->io_uring_socket()->error();
+    if (error != 0) {
+      os_error->SetCodeAndMessage(OSError::kSystem, error);
+      return;
+    }
+  }
+#endif
+  SocketBase::GetError(socket->fd(), os_error);
+}
+
 void ListeningSocketRegistry::Initialize() {
   ASSERT(globalTcpListeningSocketRegistry == nullptr);
   globalTcpListeningSocketRegistry = new ListeningSocketRegistry();
@@ -131,6 +208,11 @@ Dart_Handle ListeningSocketRegistry::CreateBindListen(Dart_Handle socket_object,
         // of dart socket_object. Sockets here will share same fd but contain a
         // different port() through EventHandler_SendData.
         Socket* socketfd = new Socket(os_socket->fd);
+#if defined(HOST_OS_LINUX)
+        if (os_socket->io_uring_socket != NULL) {
+          socketfd->set_io_uring_socket(os_socket->io_uring_socket);
+        }
+#endif
         os_socket->ref_count++;
         // We set as a side-effect the file descriptor on the dart
         // socket_object.
@@ -177,7 +259,7 @@ Dart_Handle ListeningSocketRegistry::CreateBindListen(Dart_Handle socket_object,
     first_os_socket = LookupByPort(allocated_port);
   }
 
-  Socket* socketfd = new Socket(fd);
+  Socket* socketfd = NewStreamSocket(fd, true);
   OSSocket* os_socket =
       new OSSocket(addr, allocated_port, v6_only, shared, socketfd, nullptr);
   os_socket->ref_count = 1;
@@ -235,6 +317,11 @@ Dart_Handle ListeningSocketRegistry::CreateUnixDomainBindListen(
         // field of dart socket_object. Sockets here will share same fd but
         // contain a different port() through EventHandler_SendData.
         Socket* socketfd = new Socket(os_socket->fd);
+#if defined(HOST_OS_LINUX)
+        if (os_socket->io_uring_socket != NULL) {
+          socketfd->set_io_uring_socket(os_socket->io_uring_socket);
+        }
+#endif
         os_socket->ref_count++;
         // We set as a side-effect the file descriptor on the dart
         // socket_object.
@@ -259,7 +346,7 @@ Dart_Handle ListeningSocketRegistry::CreateUnixDomainBindListen(
     return DartUtils::NewDartOSError();
   }
 
-  Socket* socketfd = new Socket(fd);
+  Socket* socketfd = NewStreamSocket(fd, true);
   OSSocket* os_socket =
       new OSSocket(addr, -1, false, shared, socketfd, namespc);
   os_socket->ref_count = 1;
@@ -374,8 +461,9 @@ void FUNCTION_NAME(Socket_CreateConnect)(Dart_NativeArguments args) {
   intptr_t socket = Socket::CreateConnect(addr);
   OSError error;
   if (socket >= 0) {
-    Socket::SetSocketIdNativeField(Dart_GetNativeArgument(args, 0), socket,
-                                   Socket::kFinalizerNormal);
+    Socket::ReuseSocketIdNativeField(Dart_GetNativeArgument(args, 0),
+                                     NewStreamSocket(socket, false),
+                                     Socket::kFinalizerNormal);
     Dart_SetReturnValue(args, Dart_True());
   } else {
     Dart_SetReturnValue(args, DartUtils::NewDartOSError(&error));
@@ -399,8 +487,9 @@ void FUNCTION_NAME(Socket_CreateBindConnect)(Dart_NativeArguments args) {
   intptr_t socket = Socket::CreateBindConnect(addr, sourceAddr);
   OSError error;
   if (socket >= 0) {
-    Socket::SetSocketIdNativeField(Dart_GetNativeArgument(args, 0), socket,
-                                   Socket::kFinalizerNormal);
+    Socket::ReuseSocketIdNativeField(Dart_GetNativeArgument(args, 0),
+                                     NewStreamSocket(socket, false),
+                                     Socket::kFinalizerNormal);
     Dart_SetReturnValue(args, Dart_True());
   } else {
     Dart_SetReturnValue(args, DartUtils::NewDartOSError(&error));
@@ -443,8 +532,9 @@ void FUNCTION_NAME(Socket_CreateUnixDomainBindConnect)(
 
   intptr_t socket = Socket::CreateUnixDomainBindConnect(addr, sourceAddr);
   if (socket >= 0) {
-    Socket::SetSocketIdNativeField(Dart_GetNativeArgument(args, 0), socket,
-                                   Socket::kFinalizerNormal);
+    Socket::ReuseSocketIdNativeField(Dart_GetNativeArgument(args, 0),
+                                     NewStreamSocket(socket, false),
+                                     Socket::kFinalizerNormal);
     Dart_SetReturnValue(args, Dart_True());
   } else {
     Dart_SetReturnValue(args, DartUtils::NewDartOSError());
@@ -473,8 +563,9 @@ void FUNCTION_NAME(Socket_CreateUnixDomainConnect)(Dart_NativeArguments args) {
   }
   intptr_t socket = Socket::CreateUnixDomainConnect(addr);
   if (socket >= 0) {
-    Socket::SetSocketIdNativeField(Dart_GetNativeArgument(args, 0), socket,
-                                   Socket::kFinalizerNormal);
+    Socket::ReuseSocketIdNativeField(Dart_GetNativeArgument(args, 0),
+                                     NewStreamSocket(socket, false),
+                                     Socket::kFinalizerNormal);
     Dart_SetReturnValue(args, Dart_True());
   } else {
     Dart_SetReturnValue(args, DartUtils::NewDartOSError());
@@ -506,7 +597,7 @@ void FUNCTION_NAME(Socket_CreateBindDatagram)(Dart_NativeArguments args) {
 void FUNCTION_NAME(Socket_Available)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
-  intptr_t available = SocketBase::Available(socket->fd());
+  intptr_t available = SocketAvailable(socket);
   if (available >= 0) {
     Dart_SetIntegerReturnValue(args, available);
   } else {
@@ -534,8 +625,7 @@ void FUNCTION_NAME(Socket_Read)(Dart_NativeArguments args) {
       Dart_PropagateError(result);
     }
     ASSERT(buffer != nullptr);
-    intptr_t bytes_read =
-        SocketBase::Read(socket->fd(), buffer, length, SocketBase::kAsync);
+    intptr_t bytes_read = SocketRead(socket, buffer, length);
     if (bytes_read == length) {
       Dart_SetReturnValue(args, result);
     } else if (bytes_read > 0) {
@@ -565,45 +655,53 @@ void FUNCTION_NAME(Socket_Read)(Dart_NativeArguments args) {
 }
 
 void FUNCTION_NAME(Socket_RecvFrom)(Dart_NativeArguments args) {
-  // TODO(sgjesse): Use a MTU value here. Only the loopback adapter can
-  // handle 64k datagrams.
-  const int kReceiveBufferLen = 65536;
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
 
-  // Ensure that a receive buffer for the UDP socket exists.
+  // Ensure that a receive batch for the UDP socket exists.
   ASSERT(socket != nullptr);
-  uint8_t* recv_buffer = socket->udp_receive_buffer();
-  if (recv_buffer == nullptr) {
-    recv_buffer = reinterpret_cast<uint8_t*>(malloc(kReceiveBufferLen));
-    socket->set_udp_receive_buffer(recv_buffer);
+  DatagramBatch* batch = socket->udp_receive_batch();
+  if (batch == nullptr) {
+    batch = new DatagramBatch();
+    socket->set_udp_receive_batch(batch);
   }
 
-  // Read data into the buffer.
-  RawAddr addr;
-  const intptr_t bytes_read = SocketBase::RecvFrom(
-      socket->fd(), recv_buffer, kReceiveBufferLen, &addr, SocketBase::kAsync);
-  if (bytes_read == 0) {
-    Dart_SetReturnValue(args, Dart_Null());
-    return;
-  }
-  if (bytes_read < 0) {
-    ASSERT(bytes_read == -1);
-    Dart_ThrowException(DartUtils::NewDartOSError());
+  // Read the next batch of datagrams if all earlier ones were handed out.
+  if (batch->IsEmpty()) {
+    const intptr_t received = batch->Fill(socket->fd());
+    if (received == 0) {
+      Dart_SetReturnValue(args, Dart_Null());
+      return;
+    }
+    if (received < 0) {
+      ASSERT(received == -1);
+      Dart_ThrowException(DartUtils::NewDartOSError());
+    }
   }
+  RawAddr addr;
+  intptr_t bytes_read;
+  const uint8_t* recv_buffer = batch->Next(&bytes_read, &addr);
 
-  // Datagram data read. Copy into buffer of the exact size,
+  // Datagram data read. Copy into buffer of the exact size. A datagram of
+  // length 0 is delivered with empty data.
   ASSERT(bytes_read >= 0);
-  uint8_t* data_buffer = nullptr;
-  Dart_Handle data = IOBuffer::Allocate(bytes_read, &data_buffer);
-  if (Dart_IsNull(data)) {
-    Dart_ThrowException(DartUtils::NewDartOSError());
+  Dart_Handle data;
+  if (bytes_read == 0) {
+    data = Dart_NewTypedData(Dart_TypedData_kUint8, 0);
+  } else {
+    uint8_t* data_buffer = nullptr;
+    data = IOBuffer::Allocate(bytes_read, &data_buffer);
+    if (Dart_IsNull(data)) {
+      Dart_ThrowException(DartUtils::NewDartOSError());
+    }
+    if (!Dart_IsError(data)) {
+      ASSERT(data_buffer != nullptr);
+      memmove(data_buffer, recv_buffer, bytes_read);
+    }
   }
   if (Dart_IsError(data)) {
     Dart_PropagateError(data);
   }
-  ASSERT(data_buffer != nullptr);
-  memmove(data_buffer, recv_buffer, bytes_read);
 
   // Memory Sanitizer complains addr not being initialized, which is done
   // through RecvFrom().
@@ -675,9 +773,8 @@ void FUNCTION_NAME(Socket_WriteList)(Dart_NativeArguments args) {
     Dart_PropagateError(result);
   }
   ASSERT((offset + length) <= len);
-  buffer += offset;
-  intptr_t bytes_written =
-      SocketBase::Write(socket->fd(), buffer, length, SocketBase::kAsync);
+  void* data = buffer + offset;
+  intptr_t bytes_written = SocketWrite(socket, &data, &length, 1);
   if (bytes_written >= 0) {
     Dart_TypedDataReleaseData(buffer_obj);
     if (short_write) {
@@ -699,6 +796,82 @@ void FUNCTION_NAME(Socket_WriteList)(Dart_NativeArguments args) {
   }
 }
 
+void FUNCTION_NAME(Socket_WriteVectored)(Dart_NativeArguments args) {
+  Socket* socket =
+      Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
+  Dart_Handle buffers_obj = Dart_GetNativeArgument(args, 1);
+  Dart_Handle starts_obj = Dart_GetNativeArgument(args, 2);
+  Dart_Handle lengths_obj = Dart_GetNativeArgument(args, 3);
+  ASSERT(Dart_IsList(buffers_obj));
+  intptr_t count = 0;
+  Dart_Handle result = Dart_ListLength(buffers_obj, &count);
+  if (Dart_IsError(result)) {
+    Dart_PropagateError(result);
+  }
+  count = Utils::Minimum(count, SocketBase::kMaxWriteVectors);
+  ASSERT(count > 0);
+
+  // Look up all handles before acquiring any data, as no other API calls are
+  // allowed while typed data is acquired.
+  Dart_Handle buffers[SocketBase::kMaxWriteVectors];
+  intptr_t starts[SocketBase::kMaxWriteVectors];
+  intptr_t lengths[SocketBase::kMaxWriteVectors];
+  for (intptr_t i = 0; i < count; i++) {
+    buffers[i] = Dart_ListGetAt(buffers_obj, i);
+    if (Dart_IsError(buffers[i])) {
+      Dart_PropagateError(buffers[i]);
+    }
+    starts[i] = DartUtils::GetIntptrValue(Dart_ListGetAt(starts_obj, i));
+    lengths[i] = DartUtils::GetIntptrValue(Dart_ListGetAt(lengths_obj, i));
+  }
+  bool short_write = false;
+  if (Socket::short_socket_write()) {
+    count = 1;
+    if (lengths[0] > 1) {
+      short_write = true;
+    }
+    lengths[0] = (lengths[0] + 1) / 2;
+  }
+
+  void* data[SocketBase::kMaxWriteVectors];
+  for (intptr_t i = 0; i < count; i++) {
+    Dart_TypedData_Type type;
+    uint8_t* buffer = nullptr;
+    intptr_t len;
+    result = Dart_TypedDataAcquireData(
+        buffers[i], &type, reinterpret_cast<void**>(&buffer), &len);
+    if (Dart_IsError(result)) {
+      for (intptr_t j = 0; j < i; j++) {
+        Dart_TypedDataReleaseData(buffers[j]);
+      }
+      Dart_PropagateError(result);
+    }
+    ASSERT((starts[i] + lengths[i]) <= len);
+    data[i] = buffer + starts[i];
+  }
+  intptr_t bytes_written = SocketWrite(socket, data, lengths, count);
+  if (bytes_written >= 0) {
+    for (intptr_t i = 0; i < count; i++) {
+      Dart_TypedDataReleaseData(buffers[i]);
+    }
+    // A forced short write is reported as a negative count, as in
+    // Socket_WriteList.
+    Dart_SetIntegerReturnValue(args,
+                               short_write ? -bytes_written : bytes_written);
+  } else {
+    // Extract OSError before we release data, as it may override the error.
+    Dart_Handle error;
+    {
+      OSError os_error;
+      for (intptr_t i = 0; i < count; i++) {
+        Dart_TypedDataReleaseData(buffers[i]);
+      }
+      error = DartUtils::NewDartOSError(&os_error);
+    }
+    Dart_ThrowException(error);
+  }
+}
+
 void FUNCTION_NAME(Socket_SendTo)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
@@ -782,7 +955,7 @@ void FUNCTION_NAME(Socket_GetError)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
   OSError os_error;
-  SocketBase::GetError(socket->fd(), &os_error);
+  GetSocketError(socket, &os_error);
   Dart_SetReturnValue(args, DartUtils::NewDartOSError(&os_error));
 }
 
@@ -880,10 +1053,11 @@ void FUNCTION_NAME(ServerSocket_CreateUnixDomainBindListen)(
 void FUNCTION_NAME(ServerSocket_Accept)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
-  intptr_t new_socket = ServerSocket::Accept(socket->fd());
+  intptr_t new_socket = SocketAccept(socket);
   if (new_socket >= 0) {
-    Socket::SetSocketIdNativeField(Dart_GetNativeArgument(args, 1), new_socket,
-                                   Socket::kFinalizerNormal);
+    Socket::ReuseSocketIdNativeField(Dart_GetNativeArgument(args, 1),
+                                     NewStreamSocket(new_socket, false),
+                                     Socket::kFinalizerNormal);
     Dart_SetReturnValue(args, Dart_True());
   } else {
     Dart_SetReturnValue(args, Dart_False());
@@ -1246,6 +1420,12 @@ void FUNCTION_NAME(Socket_AvailableDatagram)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
   ASSERT(socket != nullptr);
+  // Datagrams already read by the last batched receive are available.
+  DatagramBatch* batch = socket->udp_receive_batch();
+  if ((batch != nullptr) && !batch->IsEmpty()) {
+    Dart_SetBooleanReturnValue(args, true);
+    return;
+  }
   // Ensure that a receive buffer for peeking the UDP socket exists.
   uint8_t recv_buffer[kReceiveBufferLen];
   bool available = SocketBase::AvailableDatagram(socket->fd(), recv_buffer,
@@ -13,10 +13,69 @@
 #include "bin/thread.h"
 #include "bin/utils.h"
 #include "platform/hashmap.h"
+#include "platform/utils.h"
+
+#if defined(HOST_OS_LINUX)
+#include "bin/io_uring_linux.h"
+#endif
 
 namespace dart {
 namespace bin {
 
+// Datagrams read ahead from a UDP socket by a single batched receive, and
+// handed out one at a time by Socket_RecvFrom.
+class DatagramBatch {
+ public:
+  // TODO(sgjesse): Use a MTU value here. Only the loopback adapter can
+  // handle 64k datagrams.
+  static const intptr_t kDatagramSize = 65536;
+
+  // The buffer is allocated by the first Fill with a single slot, which is
+  // all a socket receiving one datagram at a time needs. It only grows to
+  // SocketBase::kMaxDatagramBatch slots after a Fill filled every slot.
+  DatagramBatch() : buffer_(NULL), capacity_(0), count_(0), next_(0) {}
+  ~DatagramBatch() { free(buffer_); }
+
+  bool IsEmpty() const { return next_ == count_; }
+
+  // Receives the next batch. Returns the number of datagrams received, which
+  // is 0 if none are pending, or -1 with errno set on failure. Datagrams of
+  // length 0 are received like any other.
+  intptr_t Fill(intptr_t fd) {
+    ASSERT(IsEmpty());
+    if ((count_ == capacity_) && (capacity_ < SocketBase::kMaxDatagramBatch)) {
+      capacity_ = (capacity_ == 0) ? 1 : SocketBase::kMaxDatagramBatch;
+      free(buffer_);
+      buffer_ = reinterpret_cast<uint8_t*>(malloc(capacity_ * kDatagramSize));
+    }
+    intptr_t count =
+        SocketBase::RecvFromBatch(fd, buffer_, kDatagramSize, capacity_,
+                                  lengths_, addrs_, SocketBase::kAsync);
+    count_ = Utils::Maximum(count, static_cast<intptr_t>(0));
+    next_ = 0;
+    return count;
+  }
+
+  // Takes the next datagram. Its data stays valid until the next Fill.
+  const uint8_t* Next(intptr_t* length, RawAddr* addr) {
+    ASSERT(!IsEmpty());
+    const intptr_t index = next_++;
+    *length = lengths_[index];
+    *addr = addrs_[index];
+    return buffer_ + index * kDatagramSize;
+  }
+
+ private:
+  uint8_t* buffer_;
+  intptr_t capacity_;
+  intptr_t count_;
+  intptr_t next_;
+  intptr_t lengths_[SocketBase::kMaxDatagramBatch];
+  RawAddr addrs_[SocketBase::kMaxDatagramBatch];
+
+  DISALLOW_COPY_AND_ASSIGN(DatagramBatch);
+};
+
 // TODO(bkonyi): Socket should also inherit from SocketBase once it is
 // refactored to use instance methods when possible.
 
@@ -63,8 +122,25 @@ class Socket : public ReferenceCounted<Socket> {
   Dart_Port port() const { return port_; }
   void set_port(Dart_Port port) { port_ = port; }
 
-  uint8_t* udp_receive_buffer() const { return udp_receive_buffer_; }
-  void set_udp_receive_buffer(uint8_t* buffer) { udp_receive_buffer_ = buffer; }
+  // Index of the event-loop shard that owns this socket. Only assigned on
+  // platforms whose event handler runs more than one event loop.
+  intptr_t event_loop_shard() const { return event_loop_shard_; }
+
+  DatagramBatch* udp_receive_batch() const { return udp_receive_batch_; }
+  void set_udp_receive_batch(DatagramBatch* batch) {
+    udp_receive_batch_ = batch;
+  }
+
+#if defined(HOST_OS_LINUX)
+  // The io_uring engine performing the I/O of this stream socket, or NULL if
+  // it uses system calls and epoll.
+  IOUringSocket* io_uring_socket() const { return io_uring_socket_; }
+  void set_io_uring_socket(IOUringSocket* socket) {
+    ASSERT(io_uring_socket_ == NULL);
+    socket->Retain();
+    io_uring_socket_ = socket;
+  }
+#endif
 
   static bool Initialize();
 
@@ -115,8 +191,13 @@ class Socket : public ReferenceCounted<Socket> {
  private:
   ~Socket() {
     ASSERT(fd_ == kClosedFd);
-    free(udp_receive_buffer_);
-    udp_receive_buffer_ = NULL;
+    delete udp_receive_batch_;
+    udp_receive_batch_ = NULL;
+#if defined(HOST_OS_LINUX)
+    if (io_uring_socket_ != NULL) {
+      io_uring_socket_->Release();
+    }
+#endif
   }
 
   static const int kClosedFd = -1;
@@ -127,7 +208,11 @@ class Socket : public ReferenceCounted<Socket> {
   intptr_t fd_;
   Dart_Port isolate_port_;
   Dart_Port port_;
-  uint8_t* udp_receive_buffer_;
+  DatagramBatch* udp_receive_batch_;
+  intptr_t event_loop_shard_ = 0;
+#if defined(HOST_OS_LINUX)
+  IOUringSocket* io_uring_socket_ = nullptr;
+#endif
 
   friend class ReferenceCounted<Socket>;
   DISALLOW_COPY_AND_ASSIGN(Socket);
@@ -219,6 +304,10 @@ class ListeningSocketRegistry {
     bool shared;
     int ref_count;
     intptr_t fd;
+#if defined(HOST_OS_LINUX)
+    // The io_uring engine shared by the Sockets listening on 'fd', or NULL.
+    IOUringSocket* io_uring_socket;
+#endif
 
     // Only applicable to Unix domain socket, where address.addr.sa_family
     // == AF_UNIX.
@@ -242,6 +331,9 @@ class ListeningSocketRegistry {
           namespc(namespc),
           next(NULL) {
       fd = socketfd->fd();
+#if defined(HOST_OS_LINUX)
+      io_uring_socket = socketfd->io_uring_socket();
+#endif
     }
   };
 
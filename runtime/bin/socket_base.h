@@ -172,6 +172,15 @@ class SocketBase : public AllStatic {
                         const void* buffer,
                         intptr_t num_bytes,
                         SocketOpKind sync);
+  // Writes count buffers in order, with a single system call where the
+  // platform supports gathering writes. Returns the total number of bytes
+  // written, which may end in the middle of any buffer.
+  static const intptr_t kMaxWriteVectors = 16;
+  static intptr_t WriteVectored(intptr_t fd,
+                                void* const* buffers,
+                                const intptr_t* lengths,
+                                intptr_t count,
+                                SocketOpKind sync);
   // Send data on a socket. The port to send to is specified in the port
   // component of the passed RawAddr structure. The RawAddr structure is only
   // used for datagram sockets.
@@ -185,6 +194,22 @@ class SocketBase : public AllStatic {
                            intptr_t num_bytes,
                            RawAddr* addr,
                            SocketOpKind sync);
+  // Receives up to count datagrams into consecutive slots of datagram_size
+  // bytes in buffer, with a single system call where the platform supports
+  // it. Returns the number of datagrams received, including ones of length 0,
+  // so 0 means that no datagram was pending.
+#if defined(HOST_OS_LINUX) || defined(HOST_OS_ANDROID)
+  static const intptr_t kMaxDatagramBatch = 16;
+#else
+  static const intptr_t kMaxDatagramBatch = 1;
+#endif
+  static intptr_t RecvFromBatch(intptr_t fd,
+                                uint8_t* buffer,
+                                intptr_t datagram_size,
+                                intptr_t count,
+                                intptr_t* lengths,
+                                RawAddr* addrs,
+                                SocketOpKind sync);
   static bool AvailableDatagram(intptr_t fd, void* buffer, intptr_t num_bytes);
   // Returns true if the given error-number is because the system was not able
   // to bind the socket to a specific IP.
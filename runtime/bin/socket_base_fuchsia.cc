@@ -137,6 +137,24 @@ intptr_t SocketBase::RecvFrom(intptr_t fd,
   return -1;
 }
 
+intptr_t SocketBase::RecvFromBatch(intptr_t fd,
+                                   uint8_t* buffer,
+                                   intptr_t datagram_size,
+                                   intptr_t count,
+                                   intptr_t* lengths,
+                                   RawAddr* addrs,
+                                   SocketOpKind sync) {
+  // No batched receive here, so read a single datagram. A read of 0 bytes
+  // is a datagram of length 0.
+  ASSERT(count >= 1);
+  intptr_t read_bytes = RecvFrom(fd, buffer, datagram_size, &addrs[0], sync);
+  if (read_bytes < 0) {
+    return read_bytes;
+  }
+  lengths[0] = read_bytes;
+  return 1;
+}
+
 bool SocketBase::AvailableDatagram(intptr_t fd,
                                    void* buffer,
                                    intptr_t num_bytes) {
@@ -167,6 +185,27 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::WriteVectored(intptr_t fd,
+                                   void* const* buffers,
+                                   const intptr_t* lengths,
+                                   intptr_t count,
+                                   SocketOpKind sync) {
+  // No gathering write here, so write the buffers one at a time until one
+  // is only partially written.
+  intptr_t total = 0;
+  for (intptr_t i = 0; i < count; i++) {
+    intptr_t written_bytes = Write(fd, buffers[i], lengths[i], sync);
+    if (written_bytes < 0) {
+      return (total > 0) ? total : written_bytes;
+    }
+    total += written_bytes;
+    if (written_bytes < lengths[i]) {
+      break;
+    }
+  }
+  return total;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
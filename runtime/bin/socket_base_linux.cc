@@ -15,6 +15,7 @@
 #include <stdlib.h>       // NOLINT
 #include <string.h>       // NOLINT
 #include <sys/stat.h>     // NOLINT
+#include <sys/uio.h>      // NOLINT
 #include <unistd.h>       // NOLINT
 
 #include "bin/fdutils.h"
@@ -98,6 +99,39 @@ intptr_t SocketBase::RecvFrom(intptr_t fd,
   return read_bytes;
 }
 
+intptr_t SocketBase::RecvFromBatch(intptr_t fd,
+                                   uint8_t* buffer,
+                                   intptr_t datagram_size,
+                                   intptr_t count,
+                                   intptr_t* lengths,
+                                   RawAddr* addrs,
+                                   SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT(count <= kMaxDatagramBatch);
+  struct mmsghdr messages[kMaxDatagramBatch];
+  struct iovec iov[kMaxDatagramBatch];
+  memset(messages, 0, count * sizeof(messages[0]));
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = buffer + i * datagram_size;
+    iov[i].iov_len = datagram_size;
+    messages[i].msg_hdr.msg_iov = &iov[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &addrs[i].ss;
+    messages[i].msg_hdr.msg_namelen = sizeof(addrs[i].ss);
+  }
+  intptr_t received =
+      TEMP_FAILURE_RETRY(recvmmsg(fd, messages, count, 0, NULL));
+  if ((sync == kAsync) && (received == -1) && (errno == EWOULDBLOCK)) {
+    // If the read would block we need to retry and therefore return 0
+    // as the number of datagrams received.
+    received = 0;
+  }
+  for (intptr_t i = 0; i < received; i++) {
+    lengths[i] = messages[i].msg_len;
+  }
+  return received;
+}
+
 bool SocketBase::AvailableDatagram(intptr_t fd,
                                    void* buffer,
                                    intptr_t num_bytes) {
@@ -122,6 +156,28 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::WriteVectored(intptr_t fd,
+                                   void* const* buffers,
+                                   const intptr_t* lengths,
+                                   intptr_t count,
+                                   SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT(count <= kMaxWriteVectors);
+  struct iovec iov[kMaxWriteVectors];
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = lengths[i];
+  }
+  ssize_t written_bytes = TEMP_FAILURE_RETRY(writev(fd, iov, count));
+  ASSERT(EAGAIN == EWOULDBLOCK);
+  if ((sync == kAsync) && (written_bytes == -1) && (errno == EWOULDBLOCK)) {
+    // If the would block we need to retry and therefore return 0 as
+    // the number of bytes written.
+    written_bytes = 0;
+  }
+  return written_bytes;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
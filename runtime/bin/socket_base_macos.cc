@@ -15,6 +15,7 @@
 #include <stdlib.h>       // NOLINT
 #include <string.h>       // NOLINT
 #include <sys/stat.h>     // NOLINT
+#include <sys/uio.h>      // NOLINT
 #include <unistd.h>       // NOLINT
 
 #include "bin/fdutils.h"
@@ -97,6 +98,27 @@ intptr_t SocketBase::RecvFrom(intptr_t fd,
   return read_bytes;
 }
 
+intptr_t SocketBase::RecvFromBatch(intptr_t fd,
+                                   uint8_t* buffer,
+                                   intptr_t datagram_size,
+                                   intptr_t count,
+                                   intptr_t* lengths,
+                                   RawAddr* addrs,
+                                   SocketOpKind sync) {
+  // No batched receive here, so read a single datagram. Unlike RecvFrom, a
+  // datagram of length 0 is told apart from no datagram being pending.
+  ASSERT(fd >= 0);
+  ASSERT(count >= 1);
+  socklen_t addr_len = sizeof(addrs[0].ss);
+  ssize_t read_bytes = TEMP_FAILURE_RETRY(
+      recvfrom(fd, buffer, datagram_size, 0, &addrs[0].addr, &addr_len));
+  if (read_bytes == -1) {
+    return ((sync == kAsync) && (errno == EWOULDBLOCK)) ? 0 : -1;
+  }
+  lengths[0] = read_bytes;
+  return 1;
+}
+
 bool SocketBase::AvailableDatagram(intptr_t fd,
                                    void* buffer,
                                    intptr_t num_bytes) {
@@ -121,6 +143,28 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::WriteVectored(intptr_t fd,
+                                   void* const* buffers,
+                                   const intptr_t* lengths,
+                                   intptr_t count,
+                                   SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT(count <= kMaxWriteVectors);
+  struct iovec iov[kMaxWriteVectors];
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = lengths[i];
+  }
+  ssize_t written_bytes = TEMP_FAILURE_RETRY(writev(fd, iov, count));
+  ASSERT(EAGAIN == EWOULDBLOCK);
+  if ((sync == kAsync) && (written_bytes == -1) && (errno == EWOULDBLOCK)) {
+    // If the would block we need to retry and therefore return 0 as
+    // the number of bytes written.
+    written_bytes = 0;
+  }
+  return written_bytes;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
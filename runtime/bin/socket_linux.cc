@@ -9,6 +9,7 @@
 
 #include <errno.h>  // NOLINT
 
+#include "bin/eventhandler.h"
 #include "bin/fdutils.h"
 #include "platform/signal_blocker.h"
 #include "platform/syslog.h"
@@ -22,7 +23,8 @@ Socket::Socket(intptr_t fd)
       fd_(fd),
       isolate_port_(Dart_GetMainPortId()),
       port_(ILLEGAL_PORT),
-      udp_receive_buffer_(NULL) {}
+      udp_receive_batch_(NULL),
+      event_loop_shard_(EventHandlerImplementation::ShardIndexFor(fd)) {}
 
 void Socket::CloseFd() {
   SetClosedFd();
@@ -20,6 +20,7 @@
 #include "vm/longjump.h"
 #include "vm/message_handler.h"
 #include "vm/object.h"
+#include "vm/object_graph_copy.h"
 #include "vm/object_store.h"
 #include "vm/port.h"
 #include "vm/resolver.h"
@@ -101,10 +102,18 @@ DEFINE_NATIVE_ENTRY(SendPortImpl_sendInternal_, 0, 2) {
     PortMap::PostMessage(
         Message::New(destination_port_id, obj.raw(), Message::kNormalPriority));
   } else {
-    MessageWriter writer(can_send_any_object);
-    // TODO(turnidge): Throw an exception when the return value is false?
-    PortMap::PostMessage(writer.WriteMessage(obj, destination_port_id,
-                                             Message::kNormalPriority));
+    std::unique_ptr<Message> message =
+        can_send_any_object
+            ? CreateDirectMessage(thread, obj, destination_port_id,
+                                  Message::kNormalPriority)
+            : nullptr;
+    if (message == nullptr) {
+      MessageWriter writer(can_send_any_object);
+      // TODO(turnidge): Throw an exception when the return value is false?
+      message = writer.WriteMessage(obj, destination_port_id,
+                                    Message::kNormalPriority);
+    }
+    PortMap::PostMessage(std::move(message));
   }
   return Object::null();
 }
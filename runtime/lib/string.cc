@@ -269,18 +269,21 @@ DEFINE_NATIVE_ENTRY(OneByteString_splitWithCharCode, 0, 2) {
       zone, GrowableObjectArray::New(16, Heap::kNew));
   String& str = String::Handle(zone);
   intptr_t start = 0;
-  intptr_t i = 0;
-  for (; i < len; i++) {
-    if (split_code == OneByteString::CharAt(receiver, i)) {
-      str = OneByteString::SubStringUnchecked(receiver, start, (i - start),
-                                              Heap::kNew);
-      result.Add(str);
-      start = i + 1;
+  while (true) {
+    intptr_t end = Utf::IsLatin1(split_code)
+                       ? receiver.IndexOfCodeUnit(split_code, start)
+                       : -1;
+    if (end < 0) {
+      end = len;
     }
+    str = OneByteString::SubStringUnchecked(receiver, start, (end - start),
+                                            Heap::kNew);
+    result.Add(str);
+    if (end == len) {
+      break;
+    }
+    start = end + 1;
   }
-  str = OneByteString::SubStringUnchecked(receiver, start, (i - start),
-                                          Heap::kNew);
-  result.Add(str);
   result.SetTypeArguments(TypeArguments::Handle(
       zone, isolate->object_store()->type_argument_string()));
   return result.raw();
@@ -4,9 +4,16 @@
 
 #include "platform/unicode.h"
 
+#if defined(HOST_ARCH_X64)
+#include <emmintrin.h>
+#elif defined(HOST_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
 #include "platform/allocation.h"
 #include "platform/globals.h"
 #include "platform/syslog.h"
+#include "platform/utils.h"
 
 namespace dart {
 
@@ -40,6 +47,70 @@ const uint32_t Utf8::kOverlongMinimum[7] = {0,  // Padding.
                                             0x0,     0x80,       0x800,
                                             0x10000, 0xFFFFFFFF, 0xFFFFFFFF};
 
+// Returns the number of leading bytes of 'utf8_array' that are ASCII, looking
+// at 16 bytes at a time where the host has vector instructions (SSE2 and NEON
+// are part of the x64 and ARM64 baselines) and at a word at a time otherwise.
+static inline intptr_t AsciiPrefixLength(const uint8_t* utf8_array,
+                                         intptr_t array_len) {
+  intptr_t i = 0;
+#if defined(HOST_ARCH_X64)
+  for (; i + 16 <= array_len; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&utf8_array[i]));
+    const uint32_t non_ascii = _mm_movemask_epi8(chunk);
+    if (non_ascii != 0) {
+      return i + Utils::CountTrailingZeros32(non_ascii);
+    }
+  }
+#elif defined(HOST_ARCH_ARM64)
+  for (; i + 16 <= array_len; i += 16) {
+    if (vmaxvq_u8(vld1q_u8(&utf8_array[i])) > Utf8::kMaxOneByteChar) {
+      break;
+    }
+  }
+#else
+  const uword kHighBits = (~static_cast<uword>(0) / 0xFF) * 0x80;
+  for (; i + kWordSize <= array_len; i += kWordSize) {
+    uword chunk;
+    memcpy(&chunk, &utf8_array[i], kWordSize);
+    if ((chunk & kHighBits) != 0) {
+      break;
+    }
+  }
+#endif
+  while ((i < array_len) && (utf8_array[i] <= Utf8::kMaxOneByteChar)) {
+    i++;
+  }
+  return i;
+}
+
+// Zero-extends 'len' ASCII bytes into UTF-16 code units.
+static inline void WidenAsciiToUTF16(const uint8_t* src,
+                                     uint16_t* dst,
+                                     intptr_t len) {
+  intptr_t i = 0;
+#if defined(HOST_ARCH_X64)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= len; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]),
+                     _mm_unpacklo_epi8(chunk, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i + 8]),
+                     _mm_unpackhi_epi8(chunk, zero));
+  }
+#elif defined(HOST_ARCH_ARM64)
+  for (; i + 16 <= len; i += 16) {
+    const uint8x16_t chunk = vld1q_u8(&src[i]);
+    vst1q_u16(&dst[i], vmovl_u8(vget_low_u8(chunk)));
+    vst1q_u16(&dst[i + 8], vmovl_high_u8(chunk));
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] = src[i];
+  }
+}
+
 // Returns the most restricted coding form in which the sequence of utf8
 // characters in 'utf8_array' can be represented in, and the number of
 // code units needed in that form.
@@ -50,7 +121,13 @@ intptr_t Utf8::CodeUnitCount(const uint8_t* utf8_array,
   Type char_type = kLatin1;
   for (intptr_t i = 0; i < array_len; i++) {
     uint8_t code_unit = utf8_array[i];
-    if (!IsTrailByte(code_unit)) {
+    if (code_unit <= kMaxOneByteChar) {
+      // Each byte of a run of ASCII is one Latin-1 code unit.
+      const intptr_t ascii_len =
+          AsciiPrefixLength(&utf8_array[i], array_len - i);
+      len += ascii_len;
+      i += ascii_len - 1;
+    } else if (!IsTrailByte(code_unit)) {
       ++len;
       if (!IsLatin1SequenceStart(code_unit)) {          // > U+00FF
         if (IsSupplementarySequenceStart(code_unit)) {  // >= U+10000
@@ -89,6 +166,8 @@ bool Utf8::IsValid(const uint8_t* utf8_array, intptr_t array_len) {
             !Utf::IsOutOfRange(ch) && !IsNonShortestForm(ch, j))) {
         return false;
       }
+    } else {
+      j = AsciiPrefixLength(&utf8_array[i], array_len - i);
     }
     i += j;
   }
@@ -197,16 +276,24 @@ bool Utf8::DecodeToLatin1(const uint8_t* utf8_array,
                           intptr_t len) {
   intptr_t i = 0;
   intptr_t j = 0;
-  intptr_t num_bytes;
-  for (; (i < array_len) && (j < len); i += num_bytes, ++j) {
+  while ((i < array_len) && (j < len)) {
+    if (utf8_array[i] <= kMaxOneByteChar) {
+      // Copy a run of ASCII bytes as is.
+      const intptr_t ascii_len = AsciiPrefixLength(
+          &utf8_array[i], Utils::Minimum(array_len - i, len - j));
+      memcpy(&dst[j], &utf8_array[i], ascii_len);
+      i += ascii_len;
+      j += ascii_len;
+      continue;
+    }
     int32_t ch;
     ASSERT(IsLatin1SequenceStart(utf8_array[i]));
-    num_bytes = Utf8::Decode(&utf8_array[i], (array_len - i), &ch);
+    i += Utf8::Decode(&utf8_array[i], (array_len - i), &ch);
     if (ch == -1) {
       return false;  // Invalid input.
     }
     ASSERT(Utf::IsLatin1(ch));
-    dst[j] = ch;
+    dst[j++] = ch;
   }
   if ((i < array_len) && (j == len)) {
     return false;  // Output overflow.
@@ -220,20 +307,28 @@ bool Utf8::DecodeToUTF16(const uint8_t* utf8_array,
                          intptr_t len) {
   intptr_t i = 0;
   intptr_t j = 0;
-  intptr_t num_bytes;
-  for (; (i < array_len) && (j < len); i += num_bytes, ++j) {
+  while ((i < array_len) && (j < len)) {
+    if (utf8_array[i] <= kMaxOneByteChar) {
+      // Widen a run of ASCII bytes to code units.
+      const intptr_t ascii_len = AsciiPrefixLength(
+          &utf8_array[i], Utils::Minimum(array_len - i, len - j));
+      WidenAsciiToUTF16(&utf8_array[i], &dst[j], ascii_len);
+      i += ascii_len;
+      j += ascii_len;
+      continue;
+    }
     int32_t ch;
     bool is_supplementary = IsSupplementarySequenceStart(utf8_array[i]);
-    num_bytes = Utf8::Decode(&utf8_array[i], (array_len - i), &ch);
+    i += Utf8::Decode(&utf8_array[i], (array_len - i), &ch);
     if (ch == -1) {
       return false;  // Invalid input.
     }
     if (is_supplementary) {
       if (j == (len - 1)) return false;  // Output overflow.
       Utf16::Encode(ch, &dst[j]);
-      j = j + 1;
+      j = j + 2;
     } else {
-      dst[j] = ch;
+      dst[j++] = ch;
     }
   }
   if ((i < array_len) && (j == len)) {
@@ -13,10 +13,14 @@
 
 #include "platform/assert.h"
 #include "platform/globals.h"
+#include "platform/unicode.h"
 
 #include "vm/clustered_snapshot.h"
 #include "vm/dart_api_impl.h"
+#include "vm/message_handler.h"
+#include "vm/port.h"
 #include "vm/stack_frame.h"
+#include "vm/symbols.h"
 #include "vm/timer.h"
 
 using dart::bin::File;
@@ -344,6 +348,41 @@ BENCHMARK(DartStringAccess) {
   benchmark->set_score(elapsed_time);
 }
 
+// Decodes mostly-ASCII UTF-8 text, as Dart_NewStringFromUTF8 and reading
+// snapshots do.
+BENCHMARK(Utf8DecodeMostlyAscii) {
+  const intptr_t kNumIterations = 10000;
+  const intptr_t kTextLength = 10000;
+  uint8_t* text = reinterpret_cast<uint8_t*>(malloc(kTextLength));
+  for (intptr_t i = 0; i < kTextLength; i++) {
+    text[i] = 'a' + (i % 26);
+  }
+  // U+00E9 and U+20AC, every 200 bytes.
+  for (intptr_t i = 0; i + 5 < kTextLength; i += 200) {
+    text[i] = 0xC3;
+    text[i + 1] = 0xA9;
+    text[i + 2] = 0xE2;
+    text[i + 3] = 0x82;
+    text[i + 4] = 0xAC;
+  }
+  Utf8::Type type;
+  const intptr_t len = Utf8::CodeUnitCount(text, kTextLength, &type);
+  EXPECT_EQ(Utf8::kBMP, type);
+  uint16_t* utf16 = reinterpret_cast<uint16_t*>(malloc(len * sizeof(uint16_t)));
+  Timer timer(true, "Utf8 Decode Mostly ASCII");
+  timer.Start();
+  for (intptr_t i = 0; i < kNumIterations; i++) {
+    EXPECT(Utf8::IsValid(text, kTextLength));
+    EXPECT_EQ(len, Utf8::CodeUnitCount(text, kTextLength, &type));
+    EXPECT(Utf8::DecodeToUTF16(text, kTextLength, utf16, len));
+  }
+  timer.Stop();
+  free(utf16);
+  free(text);
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+}
+
 static void vmservice_resolver(Dart_NativeArguments args) {}
 
 static Dart_NativeFunction NativeResolver(Dart_Handle name,
@@ -699,6 +738,80 @@ BENCHMARK(SimpleMessage) {
   benchmark->set_score(elapsed_time);
 }
 
+class BenchmarkMessageHandler : public MessageHandler {
+ public:
+  BenchmarkMessageHandler() : handled_(0) {}
+
+  MessageStatus HandleMessage(std::unique_ptr<Message> message) {
+    handled_++;
+    return kOK;
+  }
+
+  intptr_t handled() const { return handled_; }
+
+ private:
+  intptr_t handled_;
+};
+
+struct MessageSenderInfo {
+  Dart_Port port;
+  intptr_t count;
+  Monitor* monitor;
+  intptr_t* running;
+  ThreadJoinId join_id;
+};
+
+static void SendSmiMessages(uword param) {
+  MessageSenderInfo* info = reinterpret_cast<MessageSenderInfo*>(param);
+  info->join_id = OSThread::GetCurrentThreadJoinId(OSThread::Current());
+  for (intptr_t i = 0; i < info->count; i++) {
+    PortMap::PostMessage(
+        Message::New(info->port, Smi::New(i), Message::kNormalPriority));
+  }
+  MonitorLocker ml(info->monitor);
+  (*info->running)--;
+  ml.Notify();
+}
+
+// Several threads post messages to one port while the benchmark thread
+// handles them.
+BENCHMARK(PostMessageMultipleSenders) {
+  const intptr_t kNumSenders = 4;
+  const intptr_t kMessagesPerSender = 250000;
+  BenchmarkMessageHandler handler;
+  const Dart_Port port = PortMap::CreatePort(&handler);
+  Monitor monitor;
+  intptr_t running = kNumSenders;
+  MessageSenderInfo senders[kNumSenders];
+  Timer timer(true, "Post Message Multiple Senders");
+  timer.Start();
+  for (intptr_t i = 0; i < kNumSenders; i++) {
+    senders[i].port = port;
+    senders[i].count = kMessagesPerSender;
+    senders[i].monitor = &monitor;
+    senders[i].running = &running;
+    senders[i].join_id = OSThread::kInvalidThreadJoinId;
+    OSThread::Start("SendSmiMessages", SendSmiMessages,
+                    reinterpret_cast<uword>(&senders[i]));
+  }
+  while (handler.handled() < kNumSenders * kMessagesPerSender) {
+    handler.HandleNextMessage();
+  }
+  timer.Stop();
+  {
+    MonitorLocker ml(&monitor);
+    while (running > 0) {
+      ml.Wait();
+    }
+  }
+  for (intptr_t i = 0; i < kNumSenders; i++) {
+    OSThread::Join(senders[i].join_id);
+  }
+  PortMap::ClosePort(port);
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+}
+
 BENCHMARK(LargeMap) {
   const char* kScript =
       "makeMap() {\n"
@@ -733,6 +846,28 @@ BENCHMARK(LargeMap) {
   benchmark->set_score(elapsed_time);
 }
 
+// Canonicalizes many new names and then looks each of them up several times,
+// like loading kernel and compiling functions do.
+BENCHMARK(SymbolsNewAndLookup) {
+  const intptr_t kNumSymbols = 100000;
+  const intptr_t kNumLookups = 10;
+  TransitionNativeToVM transition(thread);
+  StackZone zone(thread);
+  HANDLESCOPE(thread);
+  char name[64];
+  Timer timer(true, "Symbols New and Lookup");
+  timer.Start();
+  for (intptr_t k = 0; k <= kNumLookups; k++) {
+    for (intptr_t i = 0; i < kNumSymbols; i++) {
+      Utils::SNPrint(name, sizeof(name), "benchmarkSymbol%" Pd, i);
+      Symbols::New(thread, name);
+    }
+  }
+  timer.Stop();
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+}
+
 BENCHMARK_MEMORY(InitialRSS) {
   benchmark->set_score(bin::Process::MaxRSS());
 }
@@ -5,12 +5,16 @@
 #include "vm/compilation_trace.h"
 
 #include "vm/compiler/jit/compiler.h"
+#include "vm/dart.h"
+#include "vm/datastream.h"
 #include "vm/globals.h"
 #include "vm/log.h"
 #include "vm/longjump.h"
 #include "vm/object_store.h"
+#include "vm/os.h"
 #include "vm/resolver.h"
 #include "vm/symbols.h"
+#include "vm/timeline.h"
 #include "vm/version.h"
 
 namespace dart {
@@ -18,6 +22,11 @@ namespace dart {
 #if !defined(DART_PRECOMPILED_RUNTIME)
 
 DEFINE_FLAG(bool, trace_compilation_trace, false, "Trace compilation trace.");
+DEFINE_FLAG(charp,
+            jit_profile_cache,
+            NULL,
+            "Directory in which to keep the compilation trace and type "
+            "feedback of each program between runs.");
 
 CompilationTraceSaver::CompilationTraceSaver(Zone* zone)
     : buf_(zone, 1 * MB),
@@ -636,11 +645,24 @@ ObjectPtr TypeFeedbackLoader::LoadFeedback(ReadStream* stream) {
     }
   }
 
+  Isolate* isolate = thread_->isolate();
+  const bool compile_in_background =
+      compile_in_background_ && FLAG_background_compilation &&
+      !BackgroundCompiler::IsDisabled(isolate, /*optimizing_compiler=*/true);
   while (functions_to_compile_.Length() > 0) {
     func_ ^= functions_to_compile_.RemoveLast();
 
     if (Compiler::CanOptimizeFunction(thread_, func_) &&
         (func_.usage_counter() >= FLAG_optimization_counter_threshold)) {
+      if (compile_in_background && func_.is_background_optimizable()) {
+        // Like the runtime does when it requests optimization, keep the
+        // counter far from the threshold while queued, but preserve the
+        // recorded usage so hotter functions are compiled first.
+        BackgroundCompiler::Start(isolate);
+        func_.SetUsageCounter(kMinInt32 + func_.usage_counter());
+        isolate->optimizing_background_compiler()->Compile(func_);
+        continue;
+      }
       error_ = Compiler::CompileOptimizedFunction(thread_, func_);
       if (error_.IsError()) {
         return error_.raw();
@@ -1028,6 +1050,239 @@ StringPtr TypeFeedbackLoader::ReadString() {
   return Symbols::New(thread_, cstr, len);
 }
 
+// Cache files start with a fixed-size header: this magic string, the format
+// version, the program hash, a checksum of the rest of the file and the
+// lengths of the compilation trace and the type feedback that follow. Files
+// with another magic, version or hash, or that are short or corrupt, are
+// ignored and overwritten, and entries for functions that no longer exist
+// are skipped by the loaders.
+static const char kJitProfileMagic[] = "dart-jit-profile";
+static const int32_t kJitProfileFormatVersion = 2;
+static const intptr_t kJitProfileHeaderSize =
+    sizeof(kJitProfileMagic) + sizeof(int32_t) + 2 * sizeof(uint64_t) +
+    2 * sizeof(int64_t);
+static const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+static uint8_t* MallocReallocate(uint8_t* ptr,
+                                 intptr_t old_size,
+                                 intptr_t new_size) {
+  return reinterpret_cast<uint8_t*>(realloc(ptr, new_size));
+}
+
+static uint64_t HashBytes(uint64_t hash, const uint8_t* bytes, intptr_t size) {
+  // FNV-1a.
+  for (intptr_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// The header is written with WriteStream::WriteFixed.
+template <typename T>
+static T ReadFixed(ReadStream* stream) {
+  T value;
+  stream->ReadBytes(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+  return value;
+}
+
+// Replaces [to] with [from].
+static bool RenameReplacing(const char* from, const char* to) {
+#if defined(HOST_OS_WINDOWS)
+  return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(from, to) == 0;
+#endif
+}
+
+uint64_t JitProfileCache::ProgramHash(Isolate* isolate) {
+  IsolateGroupSource* source = isolate->source();
+  uint64_t hash = kFnvOffsetBasis;
+  if (source->kernel_buffer != nullptr) {
+    hash = HashBytes(hash, source->kernel_buffer, source->kernel_buffer_size);
+  }
+  if (source->script_kernel_buffer != nullptr) {
+    hash = HashBytes(hash, source->script_kernel_buffer,
+                     source->script_kernel_size);
+  }
+  return hash;
+}
+
+char* JitProfileCache::PathFor(uint64_t hash) {
+  return OS::SCreate(nullptr, "%s/%016" Px64 ".jitprofile",
+                     FLAG_jit_profile_cache, hash);
+}
+
+char* JitProfileCache::PathFor(Isolate* isolate) {
+  return PathFor(ProgramHash(isolate));
+}
+
+bool JitProfileCache::Load(Thread* thread) {
+  if (FLAG_jit_profile_cache == nullptr) return false;
+  Isolate* isolate = thread->isolate();
+  if (Isolate::IsVMInternalIsolate(isolate)) return false;
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileReadCallback file_read = Dart::file_read_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_read == nullptr) ||
+      (file_close == nullptr)) {
+    return false;
+  }
+
+  const uint64_t hash = ProgramHash(isolate);
+  char* path = PathFor(hash);
+  void* file = file_open(path, /*write=*/false);
+  if (file == nullptr) {
+    free(path);
+    return false;  // No profile for this program yet.
+  }
+  uint8_t* buffer = nullptr;
+  intptr_t size = -1;
+  file_read(&buffer, &size, file);
+  file_close(file);
+  if (buffer == nullptr || size < 0) {
+    free(buffer);
+    free(path);
+    return false;
+  }
+
+  TIMELINE_DURATION(thread, Isolate, "LoadJitProfile");
+  StackZone zone(thread);
+  HANDLESCOPE(thread);
+  const char* problem = nullptr;
+  ReadStream stream(buffer, size);
+  int64_t trace_length = 0;
+  int64_t feedback_length = 0;
+  if (stream.PendingBytes() < kJitProfileHeaderSize) {
+    problem = "truncated";
+  } else if (memcmp(stream.AddressOfCurrentPosition(), kJitProfileMagic,
+                    sizeof(kJitProfileMagic)) != 0) {
+    problem = "not a profile";
+  } else {
+    stream.Advance(sizeof(kJitProfileMagic));
+    const int32_t version = ReadFixed<int32_t>(&stream);
+    const uint64_t program_hash = ReadFixed<uint64_t>(&stream);
+    const uint64_t checksum = ReadFixed<uint64_t>(&stream);
+    trace_length = ReadFixed<int64_t>(&stream);
+    feedback_length = ReadFixed<int64_t>(&stream);
+    const intptr_t pending = stream.PendingBytes();
+    if (version != kJitProfileFormatVersion) {
+      problem = "unknown format version";
+    } else if (program_hash != hash) {
+      problem = "different program";
+    } else if ((trace_length < 0) || (feedback_length < 0) ||
+               (trace_length > pending) ||
+               (feedback_length != pending - trace_length)) {
+      problem = "truncated";
+    } else if (HashBytes(kFnvOffsetBasis, stream.AddressOfCurrentPosition(),
+                         pending) != checksum) {
+      problem = "corrupt";
+    }
+  }
+
+  if (problem == nullptr) {
+    Object& error = Object::Handle(zone.GetZone());
+    uint8_t* trace = const_cast<uint8_t*>(stream.AddressOfCurrentPosition());
+    CompilationTraceLoader trace_loader(thread);
+    error = trace_loader.CompileTrace(trace, trace_length);
+    if (!error.IsError()) {
+      ReadStream feedback(trace + trace_length, feedback_length);
+      TypeFeedbackLoader feedback_loader(thread);
+      feedback_loader.set_compile_in_background(true);
+      error = feedback_loader.LoadFeedback(&feedback);
+    }
+    if (error.IsError()) {
+      problem = Error::Cast(error).ToErrorCString();
+    }
+  }
+  if (FLAG_trace_compilation_trace) {
+    if (problem == nullptr) {
+      THR_Print("Loaded JIT profile %s\n", path);
+    } else {
+      THR_Print("Ignoring JIT profile %s: %s\n", path, problem);
+    }
+  }
+  free(buffer);
+  free(path);
+  return problem == nullptr;
+}
+
+void JitProfileCache::Save(Thread* thread) {
+  if (FLAG_jit_profile_cache == nullptr) return;
+  Isolate* isolate = thread->isolate();
+  // Spawned isolates run a part of the program and would overwrite the
+  // profile of the main isolate.
+  if (Isolate::IsVMInternalIsolate(isolate) ||
+      (isolate->spawn_state() != nullptr)) {
+    return;
+  }
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_write == nullptr) ||
+      (file_close == nullptr)) {
+    return;
+  }
+
+  TIMELINE_DURATION(thread, Isolate, "SaveJitProfile");
+  StackZone stack_zone(thread);
+  Zone* zone = stack_zone.GetZone();
+  HANDLESCOPE(thread);
+
+  uint8_t* trace = nullptr;
+  intptr_t trace_length = 0;
+  CompilationTraceSaver trace_saver(zone);
+  ProgramVisitor::WalkProgram(zone, isolate, &trace_saver);
+  trace_saver.StealBuffer(&trace, &trace_length);
+
+  uint8_t* feedback = nullptr;
+  WriteStream feedback_stream(&feedback, MallocReallocate, MB);
+  TypeFeedbackSaver feedback_saver(&feedback_stream);
+  feedback_saver.WriteHeader();
+  feedback_saver.SaveClasses();
+  feedback_saver.SaveFields();
+  ProgramVisitor::WalkProgram(zone, isolate, &feedback_saver);
+  const intptr_t feedback_length = feedback_stream.bytes_written();
+
+  const uint64_t hash = ProgramHash(isolate);
+  uint8_t* header = nullptr;
+  WriteStream header_stream(&header, MallocReallocate, kJitProfileHeaderSize);
+  header_stream.WriteBytes(kJitProfileMagic, sizeof(kJitProfileMagic));
+  header_stream.WriteFixed<int32_t>(kJitProfileFormatVersion);
+  header_stream.WriteFixed<uint64_t>(hash);
+  header_stream.WriteFixed<uint64_t>(
+      HashBytes(HashBytes(kFnvOffsetBasis, trace, trace_length), feedback,
+                feedback_length));
+  header_stream.WriteFixed<int64_t>(trace_length);
+  header_stream.WriteFixed<int64_t>(feedback_length);
+  ASSERT(header_stream.bytes_written() == kJitProfileHeaderSize);
+
+  // Write to a temporary file and rename it over the profile, so that
+  // concurrent runs of the program never read a partially written one.
+  char* path = PathFor(hash);
+  char* temp_path =
+      OS::SCreate(nullptr, "%s.%" Pd ".tmp", path, OS::ProcessId());
+  bool saved = false;
+  void* file = file_open(temp_path, /*write=*/true);
+  if (file != nullptr) {
+    file_write(header, kJitProfileHeaderSize, file);
+    file_write(trace, trace_length, file);
+    file_write(feedback, feedback_length, file);
+    file_close(file);
+    saved = RenameReplacing(temp_path, path);
+    if (!saved) {
+      remove(temp_path);
+    }
+  }
+  if (FLAG_trace_compilation_trace) {
+    THR_Print("%s JIT profile %s\n", saved ? "Saved" : "Failed to save", path);
+  }
+  free(temp_path);
+  free(path);
+  free(header);
+  free(feedback);
+}
+
 #endif  // !defined(DART_PRECOMPILED_RUNTIME)
 
 }  // namespace dart
@@ -97,6 +97,12 @@ class TypeFeedbackLoader : public ValueObject {
 
   ObjectPtr LoadFeedback(ReadStream* stream);
 
+  // Queue the functions the feedback marks as hot on the background compiler
+  // instead of optimizing them before returning.
+  void set_compile_in_background(bool value) {
+    compile_in_background_ = value;
+  }
+
  private:
   ObjectPtr CheckHeader();
   ObjectPtr LoadClasses();
@@ -129,6 +135,25 @@ class TypeFeedbackLoader : public ValueObject {
   Array& args_desc_;
   GrowableObjectArray& functions_to_compile_;
   Object& error_;
+  bool compile_in_background_ = false;
+};
+
+// Keeps the compilation trace and type feedback of a program in a file under
+// --jit_profile_cache, named after a hash of the program's kernel. The file
+// is replayed when the program is loaded again and rewritten when the isolate
+// shuts down.
+class JitProfileCache : public AllStatic {
+ public:
+  // Returns whether a profile was found and replayed.
+  static bool Load(Thread* thread);
+  static void Save(Thread* thread);
+
+  // The malloced path of the profile of the program run by isolate.
+  static char* PathFor(Isolate* isolate);
+
+ private:
+  static uint64_t ProgramHash(Isolate* isolate);
+  static char* PathFor(uint64_t hash);
 };
 
 }  // namespace dart
@@ -0,0 +1,132 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "bin/directory.h"
+#include "bin/file.h"
+#include "platform/assert.h"
+#include "vm/compilation_trace.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if !defined(DART_PRECOMPILED_RUNTIME)
+
+DECLARE_FLAG(charp, jit_profile_cache);
+
+static const char* kProfiledScript =
+    "int fib(int n) => n < 2 ? n : fib(n - 1) + fib(n - 2);\n"
+    "main() => fib(20);\n";
+
+// Points --jit_profile_cache at a fresh temporary directory.
+class JitProfileCacheScope : public ValueObject {
+ public:
+  JitProfileCacheScope() : saved_(FLAG_jit_profile_cache) {
+    directory_ = bin::Directory::CreateTemp(NULL, "jit_profile_cache");
+    EXPECT_NOTNULL(directory_);
+    FLAG_jit_profile_cache = directory_;
+  }
+  ~JitProfileCacheScope() {
+    FLAG_jit_profile_cache = saved_;
+    EXPECT(bin::Directory::Delete(NULL, directory_, /*recursive=*/true));
+  }
+
+ private:
+  const char* saved_;
+  const char* directory_;
+};
+
+static void RunProfiledScript() {
+  Dart_Handle lib = TestCase::LoadTestScript(kProfiledScript, NULL);
+  EXPECT_VALID(lib);
+  Dart_Handle result = Dart_Invoke(lib, NewString("main"), 0, NULL);
+  EXPECT_VALID(result);
+}
+
+static uint8_t* ReadProfile(const char* path, intptr_t* length) {
+  bin::File* file = bin::File::Open(NULL, path, bin::File::kRead);
+  EXPECT(file != NULL);
+  *length = file->Length();
+  uint8_t* bytes = reinterpret_cast<uint8_t*>(malloc(*length));
+  EXPECT(file->ReadFully(bytes, *length));
+  file->Release();
+  return bytes;
+}
+
+static void WriteProfile(const char* path,
+                         const uint8_t* bytes,
+                         intptr_t length) {
+  bin::File* file = bin::File::Open(NULL, path, bin::File::kWriteTruncate);
+  EXPECT(file != NULL);
+  EXPECT(file->WriteFully(bytes, length));
+  file->Release();
+}
+
+TEST_CASE(JitProfileCache_SaveAndLoad) {
+  JitProfileCacheScope scope;
+  RunProfiledScript();
+
+  TransitionNativeToVM transition(thread);
+  char* path = JitProfileCache::PathFor(thread->isolate());
+  EXPECT(!bin::File::Exists(NULL, path));
+  EXPECT(!JitProfileCache::Load(thread));
+
+  JitProfileCache::Save(thread);
+  EXPECT(bin::File::Exists(NULL, path));
+  EXPECT(JitProfileCache::Load(thread));
+
+  // Saving again replaces the profile.
+  JitProfileCache::Save(thread);
+  EXPECT(JitProfileCache::Load(thread));
+  free(path);
+}
+
+TEST_CASE(JitProfileCache_CorruptFiles) {
+  JitProfileCacheScope scope;
+  RunProfiledScript();
+
+  TransitionNativeToVM transition(thread);
+  char* path = JitProfileCache::PathFor(thread->isolate());
+  JitProfileCache::Save(thread);
+  intptr_t length = 0;
+  uint8_t* bytes = ReadProfile(path, &length);
+  EXPECT(length > 64);
+
+  // Short files, and files cut anywhere in the header or the payload.
+  const intptr_t kCuts[] = {0, 1, 16, 20, 40, 56, 64, length / 2, length - 1};
+  for (size_t i = 0; i < ARRAY_SIZE(kCuts); i++) {
+    WriteProfile(path, bytes, kCuts[i]);
+    EXPECT(!JitProfileCache::Load(thread));
+  }
+
+  // A flipped byte in the type feedback.
+  bytes[length - 1] ^= 0xff;
+  WriteProfile(path, bytes, length);
+  EXPECT(!JitProfileCache::Load(thread));
+  bytes[length - 1] ^= 0xff;
+
+  // Trailing garbage.
+  uint8_t* longer = reinterpret_cast<uint8_t*>(malloc(length + 8));
+  memmove(longer, bytes, length);
+  memset(longer + length, 0x2a, 8);
+  WriteProfile(path, longer, length + 8);
+  EXPECT(!JitProfileCache::Load(thread));
+  free(longer);
+
+  // Another magic.
+  bytes[0] ^= 0xff;
+  WriteProfile(path, bytes, length);
+  EXPECT(!JitProfileCache::Load(thread));
+  bytes[0] ^= 0xff;
+
+  // The unmodified file is still accepted.
+  WriteProfile(path, bytes, length);
+  EXPECT(JitProfileCache::Load(thread));
+
+  free(bytes);
+  free(path);
+}
+
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
+}  // namespace dart
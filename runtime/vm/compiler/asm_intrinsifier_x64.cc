@@ -2246,7 +2246,7 @@ void AsmIntrinsifier::AllocateTwoByteString(Assembler* assembler,
 static void StringEquality(Assembler* assembler,
                            Label* normal_ir_body,
                            intptr_t string_cid) {
-  Label is_true, is_false, loop;
+  Label is_true, is_false, word_loop, byte_loop;
   __ movq(RAX, Address(RSP, +2 * target::kWordSize));  // This.
   __ movq(RCX, Address(RSP, +1 * target::kWordSize));  // Other.
 
@@ -2265,29 +2265,39 @@ static void StringEquality(Assembler* assembler,
   __ cmpq(RDI, FieldAddress(RCX, target::String::length_offset()));
   __ j(NOT_EQUAL, &is_false, Assembler::kNearJump);
 
-  // Check contents, no fall-through possible.
-  // TODO(srdjan): write a faster check.
+  // Check contents a word at a time, then the remaining bytes one at a time.
+  // No fall-through possible.
+  ASSERT((string_cid == kOneByteStringCid) ||
+         (string_cid == kTwoByteStringCid));
+  const intptr_t offset = (string_cid == kOneByteStringCid)
+                              ? target::OneByteString::data_offset()
+                              : target::TwoByteString::data_offset();
+  __ leaq(RAX, FieldAddress(RAX, offset));
+  __ leaq(RCX, FieldAddress(RCX, offset));
   __ SmiUntag(RDI);
-  __ Bind(&loop);
+  if (string_cid == kTwoByteStringCid) {
+    __ addq(RDI, RDI);  // Length in bytes.
+  }
+  __ Bind(&word_loop);
+  __ cmpq(RDI, Immediate(target::kWordSize));
+  __ j(LESS, &byte_loop, Assembler::kNearJump);
+  __ movq(RBX, Address(RAX, 0));
+  __ cmpq(RBX, Address(RCX, 0));
+  __ j(NOT_EQUAL, &is_false, Assembler::kNearJump);
+  __ addq(RAX, Immediate(target::kWordSize));
+  __ addq(RCX, Immediate(target::kWordSize));
+  __ subq(RDI, Immediate(target::kWordSize));
+  __ jmp(&word_loop, Assembler::kNearJump);
+
+  __ Bind(&byte_loop);
   __ decq(RDI);
   __ cmpq(RDI, Immediate(0));
   __ j(LESS, &is_true, Assembler::kNearJump);
-  if (string_cid == kOneByteStringCid) {
-    __ movzxb(RBX, FieldAddress(RAX, RDI, TIMES_1,
-                                target::OneByteString::data_offset()));
-    __ movzxb(RDX, FieldAddress(RCX, RDI, TIMES_1,
-                                target::OneByteString::data_offset()));
-  } else if (string_cid == kTwoByteStringCid) {
-    __ movzxw(RBX, FieldAddress(RAX, RDI, TIMES_2,
-                                target::TwoByteString::data_offset()));
-    __ movzxw(RDX, FieldAddress(RCX, RDI, TIMES_2,
-                                target::TwoByteString::data_offset()));
-  } else {
-    UNIMPLEMENTED();
-  }
+  __ movzxb(RBX, Address(RAX, RDI, TIMES_1, 0));
+  __ movzxb(RDX, Address(RCX, RDI, TIMES_1, 0));
   __ cmpq(RBX, RDX);
   __ j(NOT_EQUAL, &is_false, Assembler::kNearJump);
-  __ jmp(&loop, Assembler::kNearJump);
+  __ jmp(&byte_loop, Assembler::kNearJump);
 
   __ Bind(&is_true);
   __ LoadObject(RAX, CastHandle<Object>(TrueObject()));
@@ -5710,6 +5710,15 @@ LoadIndexedInstr::LoadIndexedInstr(Value* array,
   SetInputAt(1, index);
 }
 
+bool LoadIndexedInstr::AttributesEqual(Instruction* other) const {
+  LoadIndexedInstr* other_load = other->AsLoadIndexed();
+  ASSERT(other_load != nullptr);
+  return (index_unboxed_ == other_load->index_unboxed_) &&
+         (index_scale_ == other_load->index_scale_) &&
+         (class_id_ == other_load->class_id_) &&
+         (alignment_ == other_load->alignment_);
+}
+
 StoreIndexedInstr::StoreIndexedInstr(Value* array,
                                      Value* index,
                                      Value* value,
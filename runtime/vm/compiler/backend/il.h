@@ -1136,6 +1136,7 @@ class Instruction : public ZoneAllocated {
   // GetDeoptId and/or CopyDeoptIdFrom.
   friend class CallSiteInliner;
   friend class LICM;
+  friend class LoopCloner;
   friend class ComparisonInstr;
   friend class Scheduler;
   friend class BlockEntryInstr;
@@ -5560,6 +5561,8 @@ class LoadIndexedInstr : public TemplateDefinition<2, NoThrow> {
 
   virtual bool HasUnknownSideEffects() const { return false; }
 
+  virtual bool AttributesEqual(Instruction* other) const;
+
   ADD_EXTRA_INFO_TO_S_EXPRESSION_SUPPORT
 
  private:
@@ -7990,6 +7993,7 @@ class CheckStackOverflowInstr : public TemplateInstruction<0, NoThrow> {
   bool in_loop() const { return loop_depth_ > 0; }
   intptr_t stack_depth() const { return stack_depth_; }
   intptr_t loop_depth() const { return loop_depth_; }
+  Kind kind() const { return kind_; }
 
   DECLARE_INSTRUCTION(CheckStackOverflow)
 
@@ -0,0 +1,810 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_cloner.h"
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+// Quick access to the current zone.
+#define Z (flow_graph_->zone())
+
+static int CompareBlockIds(BlockEntryInstr* const* a,
+                           BlockEntryInstr* const* b) {
+  if ((*a)->block_id() < (*b)->block_id()) return -1;
+  return (*a)->block_id() > (*b)->block_id() ? 1 : 0;
+}
+
+LoopCloner::LoopCloner(FlowGraph* flow_graph, LoopInfo* loop)
+    : flow_graph_(flow_graph),
+      loop_(loop),
+      header_(nullptr),
+      back_edge_(nullptr),
+      pre_header_goto_(nullptr),
+      pre_header_index_(-1),
+      back_edge_index_(-1),
+      exit_branch_(nullptr),
+      exit_(nullptr),
+      size_(0),
+      blocks_(),
+      sorted_blocks_(),
+      in_loop_(nullptr),
+      live_out_(),
+      exit_join_(nullptr),
+      exit_phis_(),
+      pending_phis_(),
+      definitions_(),
+      blocks_map_(),
+      copy_back_edge_(nullptr),
+      omitted_(nullptr) {}
+
+bool LoopCloner::IsCloneable(Instruction* instr) {
+  switch (instr->tag()) {
+    case Instruction::kBranch: {
+      ComparisonInstr* compare = instr->AsBranch()->comparison();
+      return compare->IsRelationalOp() || compare->IsEqualityCompare() ||
+             compare->IsStrictCompare() || compare->IsTestSmi();
+    }
+    case Instruction::kGoto:
+    case Instruction::kCheckStackOverflow:
+    case Instruction::kBinarySmiOp:
+    case Instruction::kBinaryInt32Op:
+    case Instruction::kBinaryUint32Op:
+    case Instruction::kBinaryInt64Op:
+    case Instruction::kShiftInt64Op:
+    case Instruction::kSpeculativeShiftInt64Op:
+    case Instruction::kShiftUint32Op:
+    case Instruction::kSpeculativeShiftUint32Op:
+    case Instruction::kBinaryDoubleOp:
+    case Instruction::kUnarySmiOp:
+    case Instruction::kUnaryInt64Op:
+    case Instruction::kUnaryDoubleOp:
+    case Instruction::kSmiToDouble:
+    case Instruction::kInt32ToDouble:
+    case Instruction::kInt64ToDouble:
+    case Instruction::kDoubleToFloat:
+    case Instruction::kFloatToDouble:
+    case Instruction::kBox:
+    case Instruction::kBoxInt32:
+    case Instruction::kBoxUint32:
+    case Instruction::kBoxInt64:
+    case Instruction::kUnbox:
+    case Instruction::kUnboxInt32:
+    case Instruction::kUnboxUint32:
+    case Instruction::kUnboxInt64:
+    case Instruction::kIntConverter:
+    case Instruction::kBooleanNegate:
+    case Instruction::kLoadField:
+    case Instruction::kStoreInstanceField:
+    case Instruction::kLoadIndexed:
+    case Instruction::kStoreIndexed:
+    case Instruction::kLoadUntagged:
+    case Instruction::kCheckClass:
+    case Instruction::kCheckClassId:
+    case Instruction::kCheckSmi:
+    case Instruction::kCheckNull:
+    case Instruction::kCheckArrayBound:
+    case Instruction::kGenericCheckBound:
+    case Instruction::kRedefinition:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool LoopCloner::CanClone() {
+  // Only innermost loops with a single back edge and a single entry.
+  if (loop_->inner() != nullptr || loop_->back_edges().length() != 1) {
+    return false;
+  }
+  header_ = loop_->header()->AsJoinEntry();
+  if (header_ == nullptr || header_->PredecessorCount() != 2) {
+    return false;
+  }
+  back_edge_ = loop_->back_edges()[0];
+  back_edge_index_ = header_->IndexOfPredecessor(back_edge_);
+  pre_header_index_ = 1 - back_edge_index_;
+  BlockEntryInstr* pre_header = header_->PredecessorAt(pre_header_index_);
+  if (loop_->Contains(pre_header)) {
+    return false;
+  }
+  pre_header_goto_ = pre_header->last_instruction()->AsGoto();
+  if (pre_header_goto_ == nullptr ||
+      !back_edge_->last_instruction()->IsGoto()) {
+    return false;
+  }
+
+  // Collect the blocks, and make sure the loop has a single exit.
+  in_loop_ = new (Z) BitVector(Z, flow_graph_->max_block_id() + 1);
+  for (BlockEntryInstr* block : flow_graph_->reverse_postorder()) {
+    if (loop_->Contains(block)) {
+      if (!(block->IsJoinEntry() || block->IsTargetEntry()) ||
+          block->try_index() != kInvalidTryIndex) {
+        return false;
+      }
+      blocks_.Add(block);
+      sorted_blocks_.Add(block);
+      in_loop_->Add(block->block_id());
+    }
+  }
+  sorted_blocks_.Sort(CompareBlockIds);
+  for (BlockEntryInstr* block : blocks_) {
+    Instruction* last = block->last_instruction();
+    for (intptr_t i = 0, n = last->SuccessorCount(); i < n; i++) {
+      BlockEntryInstr* succ = last->SuccessorAt(i);
+      if (InLoop(succ)) {
+        continue;
+      }
+      if (exit_ != nullptr || !last->IsBranch()) {
+        return false;
+      }
+      exit_branch_ = last->AsBranch();
+      exit_ = succ->AsTargetEntry();
+    }
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      if (!IsCloneable(it.Current())) {
+        return false;
+      }
+      size_++;
+    }
+  }
+  if (exit_ == nullptr) {
+    return false;
+  }
+
+  // Collect the definitions used after the loop.
+  for (BlockEntryInstr* block : blocks_) {
+    if (JoinEntryInstr* join = block->AsJoinEntry()) {
+      for (PhiIterator it(join); !it.Done(); it.Advance()) {
+        if (HasUseOutside(it.Current())) {
+          live_out_.Add(it.Current());
+        }
+      }
+    }
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      Definition* def = it.Current()->AsDefinition();
+      if (def != nullptr && HasUseOutside(def)) {
+        live_out_.Add(def);
+      }
+    }
+  }
+  return true;
+}
+
+bool LoopCloner::HasUseOutside(Definition* def) const {
+  for (Value::Iterator it(def->input_use_list()); !it.Done(); it.Advance()) {
+    if (!InLoop(it.Current()->instruction()->GetBlock())) {
+      return true;
+    }
+  }
+  for (Value::Iterator it(def->env_use_list()); !it.Done(); it.Advance()) {
+    if (!InLoop(it.Current()->instruction()->GetBlock())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Definition* LoopCloner::Map(Definition* def) const {
+  Definition* copy = definitions_.LookupValue(def);
+  return copy != nullptr ? copy : def;
+}
+
+Value* LoopCloner::CopyValue(Value* value) const {
+  Value* copy = value->CopyWithType(Z);
+  copy->set_definition(Map(value->definition()));
+  return copy;
+}
+
+void LoopCloner::CopyEnvironment(Instruction* from, Instruction* to) const {
+  from->env()->DeepCopyTo(Z, to);
+  for (Environment::DeepIterator it(to->env()); !it.Done(); it.Advance()) {
+    Value* value = it.CurrentValue();
+    Definition* copy = Map(value->definition());
+    if (copy != value->definition()) {
+      value->BindToEnvironment(copy);
+    }
+  }
+}
+
+Instruction* LoopCloner::CloneInstruction(Instruction* instr) {
+  const intptr_t deopt_id = instr->GetDeoptId();
+  switch (instr->tag()) {
+    case Instruction::kBinarySmiOp:
+    case Instruction::kBinaryInt32Op:
+    case Instruction::kBinaryUint32Op:
+    case Instruction::kShiftInt64Op:
+    case Instruction::kSpeculativeShiftInt64Op:
+    case Instruction::kShiftUint32Op:
+    case Instruction::kSpeculativeShiftUint32Op: {
+      BinaryIntegerOpInstr* op = instr->AsBinaryIntegerOp();
+      return BinaryIntegerOpInstr::Make(
+          op->representation(), op->op_kind(), CopyValue(op->left()),
+          CopyValue(op->right()), deopt_id, op->can_overflow(),
+          op->is_truncating(), nullptr, op->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kBinaryInt64Op: {
+      BinaryInt64OpInstr* op = instr->AsBinaryInt64Op();
+      BinaryInt64OpInstr* copy = new (Z) BinaryInt64OpInstr(
+          op->op_kind(), CopyValue(op->left()), CopyValue(op->right()),
+          deopt_id, op->SpeculativeModeOfInput(0));
+      copy->set_can_overflow(op->can_overflow());
+      if (op->is_truncating()) {
+        copy->mark_truncating();
+      }
+      return copy;
+    }
+    case Instruction::kBinaryDoubleOp: {
+      BinaryDoubleOpInstr* op = instr->AsBinaryDoubleOp();
+      return new (Z) BinaryDoubleOpInstr(
+          op->op_kind(), CopyValue(op->left()), CopyValue(op->right()),
+          deopt_id, op->token_pos(), op->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kUnarySmiOp: {
+      UnarySmiOpInstr* op = instr->AsUnarySmiOp();
+      return new (Z)
+          UnarySmiOpInstr(op->op_kind(), CopyValue(op->value()), deopt_id);
+    }
+    case Instruction::kUnaryInt64Op: {
+      UnaryInt64OpInstr* op = instr->AsUnaryInt64Op();
+      return new (Z) UnaryInt64OpInstr(op->op_kind(), CopyValue(op->value()),
+                                       deopt_id, op->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kUnaryDoubleOp: {
+      UnaryDoubleOpInstr* op = instr->AsUnaryDoubleOp();
+      return new (Z) UnaryDoubleOpInstr(op->op_kind(), CopyValue(op->value()),
+                                        deopt_id,
+                                        op->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kSmiToDouble: {
+      SmiToDoubleInstr* conv = instr->AsSmiToDouble();
+      return new (Z)
+          SmiToDoubleInstr(CopyValue(conv->value()), conv->token_pos());
+    }
+    case Instruction::kInt32ToDouble:
+      return new (Z)
+          Int32ToDoubleInstr(CopyValue(instr->AsInt32ToDouble()->value()));
+    case Instruction::kInt64ToDouble: {
+      Int64ToDoubleInstr* conv = instr->AsInt64ToDouble();
+      return new (Z) Int64ToDoubleInstr(CopyValue(conv->value()), deopt_id,
+                                        conv->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kDoubleToFloat: {
+      DoubleToFloatInstr* conv = instr->AsDoubleToFloat();
+      return new (Z) DoubleToFloatInstr(CopyValue(conv->value()), deopt_id,
+                                        conv->SpeculativeModeOfInput(0));
+    }
+    case Instruction::kFloatToDouble:
+      return new (Z) FloatToDoubleInstr(
+          CopyValue(instr->AsFloatToDouble()->value()), deopt_id);
+    case Instruction::kBox:
+    case Instruction::kBoxInt32:
+    case Instruction::kBoxUint32:
+    case Instruction::kBoxInt64: {
+      BoxInstr* box = instr->AsBox();
+      return BoxInstr::Create(box->from_representation(),
+                              CopyValue(box->value()));
+    }
+    case Instruction::kUnbox:
+    case Instruction::kUnboxInt32:
+    case Instruction::kUnboxUint32:
+    case Instruction::kUnboxInt64: {
+      UnboxInstr* unbox = instr->AsUnbox();
+      UnboxInstr* copy =
+          UnboxInstr::Create(unbox->representation(), CopyValue(unbox->value()),
+                             deopt_id, unbox->SpeculativeModeOfInput(0));
+      UnboxIntegerInstr* unbox_integer = unbox->AsUnboxInteger();
+      if (unbox_integer != nullptr && unbox_integer->is_truncating()) {
+        copy->AsUnboxInteger()->mark_truncating();
+      }
+      return copy;
+    }
+    case Instruction::kIntConverter: {
+      IntConverterInstr* conv = instr->AsIntConverter();
+      IntConverterInstr* copy = new (Z) IntConverterInstr(
+          conv->from(), conv->to(), CopyValue(conv->value()), deopt_id);
+      if (conv->is_truncating()) {
+        copy->mark_truncating();
+      }
+      return copy;
+    }
+    case Instruction::kBooleanNegate:
+      return new (Z)
+          BooleanNegateInstr(CopyValue(instr->AsBooleanNegate()->value()));
+    case Instruction::kLoadField: {
+      LoadFieldInstr* load = instr->AsLoadField();
+      return new (Z) LoadFieldInstr(CopyValue(load->instance()), load->slot(),
+                                    load->token_pos(),
+                                    load->calls_initializer(), deopt_id);
+    }
+    case Instruction::kStoreInstanceField: {
+      StoreInstanceFieldInstr* store = instr->AsStoreInstanceField();
+      return new (Z) StoreInstanceFieldInstr(
+          store->slot(), CopyValue(store->instance()),
+          CopyValue(store->value()),
+          store->ShouldEmitStoreBarrier() ? kEmitStoreBarrier
+                                          : kNoStoreBarrier,
+          store->token_pos(),
+          store->is_initialization()
+              ? StoreInstanceFieldInstr::Kind::kInitializing
+              : StoreInstanceFieldInstr::Kind::kOther);
+    }
+    case Instruction::kLoadIndexed: {
+      LoadIndexedInstr* load = instr->AsLoadIndexed();
+      return new (Z) LoadIndexedInstr(
+          CopyValue(load->array()), CopyValue(load->index()),
+          load->RequiredInputRepresentation(1) != kTagged, load->index_scale(),
+          load->class_id(), load->aligned() ? kAlignedAccess : kUnalignedAccess,
+          deopt_id, load->token_pos(), new (Z) CompileType(*load->Type()));
+    }
+    case Instruction::kStoreIndexed: {
+      StoreIndexedInstr* store = instr->AsStoreIndexed();
+      return new (Z) StoreIndexedInstr(
+          CopyValue(store->array()), CopyValue(store->index()),
+          CopyValue(store->value()),
+          store->ShouldEmitStoreBarrier() ? kEmitStoreBarrier
+                                          : kNoStoreBarrier,
+          store->RequiredInputRepresentation(StoreIndexedInstr::kIndexPos) !=
+              kTagged,
+          store->index_scale(), store->class_id(),
+          store->aligned() ? kAlignedAccess : kUnalignedAccess, deopt_id,
+          store->token_pos(),
+          store->SpeculativeModeOfInput(StoreIndexedInstr::kValuePos));
+    }
+    case Instruction::kLoadUntagged: {
+      LoadUntaggedInstr* load = instr->AsLoadUntagged();
+      return new (Z)
+          LoadUntaggedInstr(CopyValue(load->object()), load->offset());
+    }
+    case Instruction::kCheckClass: {
+      CheckClassInstr* check = instr->AsCheckClass();
+      return new (Z) CheckClassInstr(CopyValue(check->value()), deopt_id,
+                                     check->cids(), check->token_pos());
+    }
+    case Instruction::kCheckClassId: {
+      CheckClassIdInstr* check = instr->AsCheckClassId();
+      return new (Z)
+          CheckClassIdInstr(CopyValue(check->value()), check->cids(), deopt_id);
+    }
+    case Instruction::kCheckSmi: {
+      CheckSmiInstr* check = instr->AsCheckSmi();
+      return new (Z) CheckSmiInstr(CopyValue(check->value()), deopt_id,
+                                   check->token_pos());
+    }
+    case Instruction::kCheckNull: {
+      CheckNullInstr* check = instr->AsCheckNull();
+      return new (Z) CheckNullInstr(
+          CopyValue(check->value()), check->function_name(), deopt_id,
+          check->token_pos(), check->exception_type());
+    }
+    case Instruction::kCheckArrayBound: {
+      CheckArrayBoundInstr* check = instr->AsCheckArrayBound();
+      return new (Z) CheckArrayBoundInstr(CopyValue(check->length()),
+                                          CopyValue(check->index()), deopt_id);
+    }
+    case Instruction::kGenericCheckBound: {
+      GenericCheckBoundInstr* check = instr->AsGenericCheckBound();
+      return new (Z) GenericCheckBoundInstr(
+          CopyValue(check->length()), CopyValue(check->index()), deopt_id);
+    }
+    case Instruction::kCheckStackOverflow: {
+      CheckStackOverflowInstr* check = instr->AsCheckStackOverflow();
+      return new (Z) CheckStackOverflowInstr(
+          check->token_pos(), check->stack_depth(), check->loop_depth(),
+          deopt_id, check->kind());
+    }
+    case Instruction::kRedefinition: {
+      RedefinitionInstr* redef = instr->AsRedefinition();
+      RedefinitionInstr* copy =
+          new (Z) RedefinitionInstr(CopyValue(redef->value()));
+      copy->set_constrained_type(redef->constrained_type());
+      return copy;
+    }
+    default:
+      UNREACHABLE();
+      return nullptr;
+  }
+}
+
+bool LoopCloner::IsUseAfterExit(Value* use) const {
+  BlockEntryInstr* block = use->instruction()->GetBlock();
+  return !InLoop(block) && block != exit_;
+}
+
+void LoopCloner::SplitExit(intptr_t exit_count) {
+  // The new join takes over the block id of the exit, so that the order of
+  // predecessors of any join after the loop is preserved, and the exit
+  // becomes an empty block in front of the join.
+  exit_join_ = new (Z) JoinEntryInstr(exit_->block_id(), exit_->try_index(),
+                                      DeoptId::kNone);
+  exit_->set_block_id(flow_graph_->allocate_block_id());
+  exit_join_->LinkTo(exit_->next());
+  exit_join_->set_last_instruction(exit_->last_instruction());
+  GotoInstr* exit_goto = NewExitGoto();
+  exit_->LinkTo(exit_goto);
+  exit_->set_last_instruction(exit_goto);
+
+  // Merge the live out definitions and their copies in the join.
+  GrowableArray<Value*> uses;
+  for (Definition* def : live_out_) {
+    PhiInstr* phi = new (Z) PhiInstr(exit_join_, exit_count);
+    phi->set_representation(def->representation());
+    phi->mark_alive();
+    flow_graph_->AllocateSSAIndexes(phi);
+    exit_join_->InsertPhi(phi);
+    PendingPhi* pending = new (Z) PendingPhi(phi);
+    pending->predecessors.Add(exit_goto);
+    pending->inputs.Add(def);
+    exit_phis_.Add(pending);
+    pending_phis_.Add(pending);
+
+    uses.Clear();
+    for (Value::Iterator it(def->input_use_list()); !it.Done(); it.Advance()) {
+      if (IsUseAfterExit(it.Current())) {
+        uses.Add(it.Current());
+      }
+    }
+    for (Value* use : uses) {
+      use->BindTo(phi);
+    }
+    uses.Clear();
+    for (Value::Iterator it(def->env_use_list()); !it.Done(); it.Advance()) {
+      if (IsUseAfterExit(it.Current())) {
+        uses.Add(it.Current());
+      }
+    }
+    for (Value* use : uses) {
+      use->BindToEnvironment(phi);
+    }
+  }
+}
+
+GotoInstr* LoopCloner::NewExitGoto() {
+  GotoInstr* exit_goto = new (Z) GotoInstr(exit_join_, DeoptId::kNone);
+  // Conversions of the exit phis inserted later may need a deoptimization
+  // target in front of the join.
+  if (exit_branch_->env() != nullptr) {
+    exit_goto->CopyDeoptIdFrom(*exit_branch_);
+    CopyEnvironment(exit_branch_, exit_goto);
+  }
+  return exit_goto;
+}
+
+TargetEntryInstr* LoopCloner::CopySuccessor(TargetEntryInstr* target) {
+  if (target != exit_) {
+    return blocks_map_.LookupValue(target)->AsTargetEntry();
+  }
+  // The exit of the copy goes to the exit join. Since the exit branch is
+  // dominated by all live out definitions, their copies are known here.
+  TargetEntryInstr* copy_exit = new (Z) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), exit_->try_index(), DeoptId::kNone);
+  copy_exit->set_edge_weight(exit_->edge_weight());
+  GotoInstr* exit_goto = NewExitGoto();
+  copy_exit->LinkTo(exit_goto);
+  copy_exit->set_last_instruction(exit_goto);
+  for (intptr_t i = 0; i < live_out_.length(); i++) {
+    exit_phis_[i]->predecessors.Add(exit_goto);
+    exit_phis_[i]->inputs.Add(Map(live_out_[i]));
+  }
+  return copy_exit;
+}
+
+bool LoopCloner::IsOmitted(Instruction* instr) const {
+  if (omitted_ == nullptr || instr->AsCheckBoundBase() == nullptr) {
+    return false;
+  }
+  for (CheckBoundBase* check : *omitted_) {
+    if (check == instr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+JoinEntryInstr* LoopCloner::CloneIteration(bool fold_exit_test,
+                                           bool copy_loop) {
+  // When the exit test is folded, the loop successor of the header is merged
+  // into the copy of the header. When the whole loop is copied, the copy of
+  // the header gets its own phis and interrupt check.
+  TargetEntryInstr* stay = nullptr;
+  if (fold_exit_test) {
+    ASSERT(exit_branch_ == header_->last_instruction());
+    stay = exit_branch_->true_successor() == exit_
+               ? exit_branch_->false_successor()
+               : exit_branch_->true_successor();
+  }
+
+  // Allocate the copies of the blocks in the order of the original block
+  // ids, which keeps the order of the predecessors of internal joins.
+  blocks_map_.Clear();
+  for (BlockEntryInstr* block : sorted_blocks_) {
+    if (block == stay) {
+      continue;
+    }
+    BlockEntryInstr* copy = nullptr;
+    if (block->IsJoinEntry()) {
+      JoinEntryInstr* join = new (Z) JoinEntryInstr(
+          flow_graph_->allocate_block_id(), block->try_index(),
+          block->GetDeoptId());
+      if (block != header_ || copy_loop) {
+        for (PhiIterator it(block->AsJoinEntry()); !it.Done(); it.Advance()) {
+          PhiInstr* phi = it.Current();
+          PhiInstr* copy_phi = new (Z) PhiInstr(join, phi->InputCount());
+          copy_phi->set_representation(phi->representation());
+          if (phi->is_alive()) {
+            copy_phi->mark_alive();
+          }
+          if (phi->range() != nullptr) {
+            copy_phi->set_range(*phi->range());
+          }
+          flow_graph_->AllocateSSAIndexes(copy_phi);
+          join->InsertPhi(copy_phi);
+          definitions_.Insert(DefinitionKV::Pair(phi, copy_phi));
+        }
+      }
+      copy = join;
+    } else {
+      TargetEntryInstr* target = new (Z) TargetEntryInstr(
+          flow_graph_->allocate_block_id(), block->try_index(),
+          block->GetDeoptId());
+      target->set_edge_weight(block->AsTargetEntry()->edge_weight());
+      copy = target;
+    }
+    copy->set_last_instruction(copy);
+    blocks_map_.Insert(BlockKV::Pair(block, copy));
+  }
+  JoinEntryInstr* header_copy = blocks_map_.LookupValue(header_)->AsJoinEntry();
+  if (stay != nullptr) {
+    blocks_map_.Insert(BlockKV::Pair(stay, header_copy));
+  }
+
+  // Copy the instructions in reverse postorder, so that definitions are
+  // copied before their uses.
+  copy_back_edge_ = nullptr;
+  for (BlockEntryInstr* block : blocks_) {
+    BlockEntryInstr* copy = blocks_map_.LookupValue(block);
+    Instruction* cursor = copy->last_instruction();
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      Instruction* instr = it.Current();
+      Instruction* copy_instr = nullptr;
+      if (instr->IsCheckStackOverflow() && !copy_loop) {
+        // One interrupt check per iteration of the transformed loop is
+        // sufficient.
+        continue;
+      } else if (IsOmitted(instr)) {
+        definitions_.Insert(DefinitionKV::Pair(
+            instr->AsDefinition(),
+            Map(instr->AsCheckBoundBase()->index()->definition())));
+        continue;
+      } else if (GotoInstr* goto_instr = instr->AsGoto()) {
+        BlockEntryInstr* succ = goto_instr->successor();
+        GotoInstr* copy_goto = new (Z) GotoInstr(
+            succ == header_ ? header_
+                            : blocks_map_.LookupValue(succ)->AsJoinEntry(),
+            goto_instr->GetDeoptId());
+        if (succ == header_) {
+          // Retargeted by the caller.
+          copy_back_edge_ = copy_goto;
+        }
+        copy_instr = copy_goto;
+      } else if (BranchInstr* branch = instr->AsBranch()) {
+        if (branch == exit_branch_ && fold_exit_test) {
+          continue;
+        }
+        ComparisonInstr* compare = branch->comparison();
+        ComparisonInstr* copy_compare = compare->CopyWithNewOperands(
+            CopyValue(compare->left()), CopyValue(compare->right()));
+        copy_compare->SetDeoptId(*compare);
+        BranchInstr* copy_branch =
+            new (Z) BranchInstr(copy_compare, branch->GetDeoptId());
+        *copy_branch->true_successor_address() =
+            CopySuccessor(branch->true_successor());
+        *copy_branch->false_successor_address() =
+            CopySuccessor(branch->false_successor());
+        copy_instr = copy_branch;
+      } else {
+        copy_instr = CloneInstruction(instr);
+        copy_instr->CopyDeoptIdFrom(*instr);
+      }
+      copy_instr->set_inlining_id(instr->inlining_id());
+      if (instr->env() != nullptr) {
+        CopyEnvironment(instr, copy_instr);
+      }
+      if (Definition* def = instr->AsDefinition()) {
+        Definition* copy_def = copy_instr->AsDefinition();
+        if (def->range() != nullptr) {
+          copy_def->set_range(*def->range());
+        }
+        if (def->HasSSATemp()) {
+          flow_graph_->AllocateSSAIndexes(copy_def);
+        }
+        definitions_.Insert(DefinitionKV::Pair(def, copy_def));
+      }
+      cursor = cursor->AppendInstruction(copy_instr);
+    }
+    copy->set_last_instruction(cursor);
+  }
+
+  // Inputs of the phis of internal joins.
+  for (BlockEntryInstr* block : blocks_) {
+    JoinEntryInstr* join = block->AsJoinEntry();
+    if (join == nullptr || join == header_) {
+      continue;
+    }
+    for (PhiIterator it(join); !it.Done(); it.Advance()) {
+      PhiInstr* phi = it.Current();
+      PendingPhi* pending =
+          new (Z) PendingPhi(definitions_.LookupValue(phi)->AsPhi());
+      for (intptr_t i = 0, n = join->PredecessorCount(); i < n; i++) {
+        pending->predecessors.Add(
+            blocks_map_.LookupValue(join->PredecessorAt(i))
+                ->last_instruction());
+        pending->inputs.Add(Map(phi->InputAt(i)->definition()));
+      }
+      pending_phis_.Add(pending);
+    }
+  }
+  return header_copy;
+}
+
+void LoopCloner::AddHeaderInputs(
+    Instruction* entry_pred,
+    const GrowableArray<Definition*>& entry_values,
+    Instruction* back_pred,
+    const GrowableArray<Definition*>& back_values) {
+  intptr_t index = 0;
+  for (PhiIterator it(header_); !it.Done(); it.Advance(), index++) {
+    PendingPhi* pending = new (Z) PendingPhi(it.Current());
+    pending->predecessors.Add(entry_pred);
+    pending->inputs.Add(entry_values[index]);
+    pending->predecessors.Add(back_pred);
+    pending->inputs.Add(back_values[index]);
+    pending_phis_.Add(pending);
+  }
+}
+
+void LoopCloner::Peel() {
+  SplitExit(/*exit_count=*/2);
+
+  // The copy starts with the values flowing into the loop.
+  GrowableArray<Definition*> entry_values;
+  GrowableArray<Definition*> back_values;
+  definitions_.Clear();
+  for (PhiIterator it(header_); !it.Done(); it.Advance()) {
+    PhiInstr* phi = it.Current();
+    Definition* initial = phi->InputAt(pre_header_index_)->definition();
+    definitions_.Insert(DefinitionKV::Pair(phi, initial));
+    back_values.Add(phi->InputAt(back_edge_index_)->definition());
+  }
+  JoinEntryInstr* copy =
+      CloneIteration(/*fold_exit_test=*/false, /*copy_loop=*/false);
+  for (Definition* value : back_values) {
+    entry_values.Add(Map(value));
+  }
+  pre_header_goto_->set_successor(copy);
+  AddHeaderInputs(copy_back_edge_, entry_values,
+                  back_edge_->last_instruction(), back_values);
+}
+
+void LoopCloner::Unroll(intptr_t factor, bool fold_exit_tests) {
+  ASSERT(factor > 1);
+  SplitExit(fold_exit_tests ? 1 : factor);
+
+  GrowableArray<Definition*> entry_values;
+  GrowableArray<Definition*> back_values;
+  for (PhiIterator it(header_); !it.Done(); it.Advance()) {
+    entry_values.Add(it.Current()->InputAt(pre_header_index_)->definition());
+    back_values.Add(it.Current()->InputAt(back_edge_index_)->definition());
+  }
+
+  // Chain the copies after the back edge of the original iteration.
+  GotoInstr* back_goto = back_edge_->last_instruction()->AsGoto();
+  for (intptr_t i = 1; i < factor; i++) {
+    definitions_.Clear();
+    intptr_t index = 0;
+    for (PhiIterator it(header_); !it.Done(); it.Advance(), index++) {
+      definitions_.Insert(DefinitionKV::Pair(it.Current(), back_values[index]));
+    }
+    JoinEntryInstr* copy =
+        CloneIteration(fold_exit_tests, /*copy_loop=*/false);
+    index = 0;
+    for (PhiIterator it(header_); !it.Done(); it.Advance(), index++) {
+      back_values[index] =
+          Map(it.Current()->InputAt(back_edge_index_)->definition());
+    }
+    back_goto->set_successor(copy);
+    back_goto = copy_back_edge_;
+  }
+  AddHeaderInputs(pre_header_goto_, entry_values, back_goto, back_values);
+}
+
+void LoopCloner::Version(const GrowableArray<ComparisonInstr*>& guards,
+                         const GrowableArray<CheckBoundBase*>& omitted) {
+  ASSERT(!guards.is_empty());
+  SplitExit(/*exit_count=*/2);
+
+  // The copy is a loop of its own, entered from the last guard.
+  definitions_.Clear();
+  omitted_ = &omitted;
+  JoinEntryInstr* copy =
+      CloneIteration(/*fold_exit_test=*/false, /*copy_loop=*/true);
+  omitted_ = nullptr;
+  copy_back_edge_->set_successor(copy);
+
+  // The original loop is entered when any of the guards fails.
+  JoinEntryInstr* guard_entry = new (Z) JoinEntryInstr(
+      flow_graph_->allocate_block_id(), header_->try_index(), DeoptId::kNone);
+  JoinEntryInstr* fail_entry = new (Z) JoinEntryInstr(
+      flow_graph_->allocate_block_id(), header_->try_index(), DeoptId::kNone);
+  const double weight = exit_->edge_weight();
+  Instruction* cursor = guard_entry;
+  for (ComparisonInstr* guard : guards) {
+    BranchInstr* branch = new (Z) BranchInstr(guard, DeoptId::kNone);
+    flow_graph_->AppendTo(cursor, branch, nullptr, FlowGraph::kEffect);
+    TargetEntryInstr* pass = new (Z) TargetEntryInstr(
+        flow_graph_->allocate_block_id(), header_->try_index(), DeoptId::kNone);
+    TargetEntryInstr* fail = new (Z) TargetEntryInstr(
+        flow_graph_->allocate_block_id(), header_->try_index(), DeoptId::kNone);
+    pass->set_edge_weight(weight);
+    fail->set_edge_weight(weight);
+    *branch->true_successor_address() = pass;
+    *branch->false_successor_address() = fail;
+    flow_graph_->AppendTo(fail, new (Z) GotoInstr(fail_entry, DeoptId::kNone),
+                          nullptr, FlowGraph::kEffect);
+    cursor = pass;
+  }
+  GotoInstr* pass_goto = new (Z) GotoInstr(copy, DeoptId::kNone);
+  flow_graph_->AppendTo(cursor, pass_goto, nullptr, FlowGraph::kEffect);
+  GotoInstr* fail_goto = new (Z) GotoInstr(header_, DeoptId::kNone);
+  flow_graph_->AppendTo(fail_entry, fail_goto, nullptr, FlowGraph::kEffect);
+  pre_header_goto_->set_successor(guard_entry);
+
+  // Both loops start with the values flowing into the loop.
+  GrowableArray<Definition*> entry_values;
+  GrowableArray<Definition*> back_values;
+  for (PhiIterator it(header_); !it.Done(); it.Advance()) {
+    PhiInstr* phi = it.Current();
+    Definition* back_value = phi->InputAt(back_edge_index_)->definition();
+    entry_values.Add(phi->InputAt(pre_header_index_)->definition());
+    back_values.Add(back_value);
+    PendingPhi* pending = new (Z) PendingPhi(Map(phi)->AsPhi());
+    pending->predecessors.Add(pass_goto);
+    pending->inputs.Add(entry_values.Last());
+    pending->predecessors.Add(copy_back_edge_);
+    pending->inputs.Add(Map(back_value));
+    pending_phis_.Add(pending);
+  }
+  AddHeaderInputs(fail_goto, entry_values, back_edge_->last_instruction(),
+                  back_values);
+}
+
+void LoopCloner::FixupPhis() {
+  for (PendingPhi* pending : pending_phis_) {
+    PhiInstr* phi = pending->phi;
+    JoinEntryInstr* join = phi->block();
+    ASSERT(join->PredecessorCount() == pending->predecessors.length());
+    for (intptr_t i = 0, n = join->PredecessorCount(); i < n; i++) {
+      BlockEntryInstr* pred = join->PredecessorAt(i);
+      Definition* def = nullptr;
+      for (intptr_t j = 0; j < n; j++) {
+        if (pending->predecessors[j]->GetBlock() == pred) {
+          def = pending->inputs[j];
+          break;
+        }
+      }
+      ASSERT(def != nullptr);
+      Value* input = phi->InputAt(i);
+      if (input != nullptr) {
+        input->RemoveFromUseList();
+      }
+      input = new (Z) Value(def);
+      phi->SetInputAt(i, input);
+      def->AddInputUse(input);
+    }
+  }
+}
+
+}  // namespace dart
@@ -0,0 +1,149 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/growable_array.h"
+#include "vm/hash_map.h"
+
+namespace dart {
+
+class FlowGraph;
+class LoopInfo;
+
+// Copies the blocks of an innermost loop to peel or unroll its iterations,
+// or to version the loop.
+//
+// Only loops with a single entry through a pre-header ending in a goto, a
+// single back edge and a single exit out of a branch are supported, and all
+// instructions of the loop must be copyable. Definitions of the loop that are
+// used after the loop are merged with their copies in a new join at the exit.
+//
+// Transformations of several loops can be combined, after which blocks have
+// to be rediscovered and FixupPhis() has to be called for every loop:
+//
+//   LoopCloner cloner(flow_graph, loop);
+//   if (cloner.CanClone()) {
+//     cloner.Peel();
+//     flow_graph->DiscoverBlocks();
+//     cloner.FixupPhis();
+//     flow_graph->ComputeDominators(&dominance_frontier);
+//   }
+//
+class LoopCloner : public ZoneAllocated {
+ public:
+  LoopCloner(FlowGraph* flow_graph, LoopInfo* loop);
+
+  // Returns true if the loop can be copied. Must be called before any of
+  // the transformations below.
+  bool CanClone();
+
+  // Inserts a copy of the first iteration of the loop in front of the loop.
+  void Peel();
+
+  // Replaces the loop body by [factor] copies of the loop iteration, each
+  // with its own exit test. When [fold_exit_tests] is set, the caller
+  // guarantees that the trip count is a multiple of [factor], and the exit
+  // tests of all but the first copy are folded.
+  void Unroll(intptr_t factor, bool fold_exit_tests);
+
+  // Inserts a copy of the loop that is entered instead of the loop when all
+  // [guards] hold. The [omitted] checks of the loop are left out of the
+  // copy, so the guards must imply that these checks pass. Definitions used
+  // by the guards must be available at the end of the pre-header.
+  void Version(const GrowableArray<ComparisonInstr*>& guards,
+               const GrowableArray<CheckBoundBase*>& omitted);
+
+  // Sets the phi inputs affected by the transformation in the order of
+  // the rediscovered predecessors.
+  void FixupPhis();
+
+  LoopInfo* loop() const { return loop_; }
+  GotoInstr* pre_header_goto() const { return pre_header_goto_; }
+
+  // Number of instructions in the loop.
+  intptr_t size() const { return size_; }
+
+  // Returns true if the given instruction can be copied.
+  static bool IsCloneable(Instruction* instr);
+
+ private:
+  typedef RawPointerKeyValueTrait<Definition, Definition*> DefinitionKV;
+  typedef RawPointerKeyValueTrait<BlockEntryInstr, BlockEntryInstr*> BlockKV;
+
+  // Inputs of a phi, keyed by the last instruction of the predecessors
+  // (blocks can change when the exit of another loop is split).
+  struct PendingPhi : public ZoneAllocated {
+    explicit PendingPhi(PhiInstr* phi) : phi(phi), predecessors(), inputs() {}
+    PhiInstr* phi;
+    GrowableArray<Instruction*> predecessors;
+    GrowableArray<Definition*> inputs;
+  };
+
+  bool InLoop(BlockEntryInstr* block) const {
+    return block->block_id() < in_loop_->length() &&
+           in_loop_->Contains(block->block_id());
+  }
+
+  Definition* Map(Definition* def) const;
+  Value* CopyValue(Value* value) const;
+  void CopyEnvironment(Instruction* from, Instruction* to) const;
+  Instruction* CloneInstruction(Instruction* instr);
+  bool HasUseOutside(Definition* def) const;
+  bool IsUseAfterExit(Value* use) const;
+  void SplitExit(intptr_t exit_count);
+  GotoInstr* NewExitGoto();
+  TargetEntryInstr* CopySuccessor(TargetEntryInstr* target);
+  bool IsOmitted(Instruction* instr) const;
+  JoinEntryInstr* CloneIteration(bool fold_exit_test, bool copy_loop);
+  void AddHeaderInputs(Instruction* entry_pred,
+                       const GrowableArray<Definition*>& entry_values,
+                       Instruction* back_pred,
+                       const GrowableArray<Definition*>& back_values);
+
+  FlowGraph* flow_graph_;
+  LoopInfo* loop_;
+  JoinEntryInstr* header_;
+  BlockEntryInstr* back_edge_;
+  GotoInstr* pre_header_goto_;
+  intptr_t pre_header_index_;
+  intptr_t back_edge_index_;
+  BranchInstr* exit_branch_;
+  TargetEntryInstr* exit_;
+  intptr_t size_;
+
+  // Blocks of the loop in reverse postorder, and in order of block ids.
+  GrowableArray<BlockEntryInstr*> blocks_;
+  GrowableArray<BlockEntryInstr*> sorted_blocks_;
+  BitVector* in_loop_;
+
+  // Definitions of the loop used after the loop.
+  GrowableArray<Definition*> live_out_;
+
+  // Join after the loop, where live out definitions are merged by the
+  // exit phis (in the order of live_out_).
+  JoinEntryInstr* exit_join_;
+  GrowableArray<PendingPhi*> exit_phis_;
+  GrowableArray<PendingPhi*> pending_phis_;
+
+  // Mappings of the iteration being copied.
+  DirectChainedHashMap<DefinitionKV> definitions_;
+  DirectChainedHashMap<BlockKV> blocks_map_;
+  GotoInstr* copy_back_edge_;
+  const GrowableArray<CheckBoundBase*>* omitted_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopCloner);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
@@ -0,0 +1,183 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_printer.h"
+#include "vm/compiler/backend/loop_cloner.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_peeling,
+            false,
+            "Peel the first iteration of loops with invariant checks.");
+DEFINE_FLAG(bool, loop_unrolling, false, "Unroll small countable loops.");
+DEFINE_FLAG(int,
+            loop_unrolling_factor,
+            4,
+            "Maximal number of copies of the body of an unrolled loop.");
+DEFINE_FLAG(int,
+            loop_unrolling_max_size,
+            64,
+            "Maximal number of instructions of an unrolled loop.");
+DEFINE_FLAG(bool,
+            trace_loop_unrolling,
+            false,
+            "Trace loop peeling and unrolling.");
+
+static bool MayHaveVisibleEffect(Instruction* instr) {
+  return instr->IsStoreInstanceField() || instr->IsStoreIndexed() ||
+         instr->HasUnknownSideEffects() || instr->MayThrow();
+}
+
+// Returns true if the loop checks a loop invariant value in every iteration
+// while LICM cannot hoist the check.
+static bool ShouldPeel(FlowGraph* flow_graph, LoopInfo* loop) {
+  const bool prohibits_hoisting =
+      flow_graph->function().ProhibitsHoistingCheckClass();
+  BlockEntryInstr* back_edge = loop->back_edges()[0];
+  bool seen_visible_effect = false;
+  for (BitVector::Iterator it(loop->blocks()); !it.Done(); it.Advance()) {
+    BlockEntryInstr* block = flow_graph->preorder()[it.Current()];
+    if (!loop->IsAlwaysTaken(block)) {
+      seen_visible_effect = true;
+    }
+    const bool every_iteration = block->Dominates(back_edge);
+    for (ForwardInstructionIterator instr_it(block); !instr_it.Done();
+         instr_it.Advance()) {
+      Instruction* instr = instr_it.Current();
+      if (every_iteration &&
+          (instr->IsCheckNull() || instr->IsCheckClass()) &&
+          !loop->Contains(instr->InputAt(0)->definition()->GetBlock())) {
+        if (prohibits_hoisting ||
+            (instr->IsCheckNull() && seen_visible_effect)) {
+          return true;
+        }
+      }
+      if (MayHaveVisibleEffect(instr)) {
+        seen_visible_effect = true;
+      }
+    }
+  }
+  return false;
+}
+
+// Returns the number of copies of the body of the given loop, and whether
+// the trip count is a multiple of that number.
+static intptr_t UnrollFactor(LoopCloner* cloner, bool* fold_exit_tests) {
+  *fold_exit_tests = false;
+  LoopInfo* loop = cloner->loop();
+  InductionVar* control = loop->control();
+  if (control == nullptr) {
+    return 1;  // not countable
+  }
+  intptr_t factor = FLAG_loop_unrolling_factor;
+  while (factor > 1 && cloner->size() * factor > FLAG_loop_unrolling_max_size) {
+    factor /= 2;
+  }
+  if (factor <= 1) {
+    return 1;
+  }
+
+  // Find the bound of the header branch.
+  InductionVar* limit = nullptr;
+  for (const auto& bound : control->bounds()) {
+    if (bound.branch_ == loop->header()->last_instruction()) {
+      limit = bound.limit_;
+    }
+  }
+  int64_t stride = 0;
+  int64_t initial = 0;
+  int64_t end = 0;
+  if (limit != nullptr && InductionVar::IsLinear(control, &stride) &&
+      InductionVar::IsConstant(control->initial(), &initial) &&
+      InductionVar::IsConstant(limit, &end)) {
+    const int64_t trip_count = stride == 1 ? end - initial : initial - end;
+    if (trip_count < 2) {
+      return 1;
+    }
+    if (trip_count < factor) {
+      factor = trip_count;
+    }
+    while (trip_count % factor != 0) {
+      factor--;
+    }
+    *fold_exit_tests = factor > 1;
+  }
+  return factor;
+}
+
+// A loop and the way it is transformed.
+struct LoopTransformation {
+  LoopCloner* cloner;
+  bool peel;
+  intptr_t factor;
+  bool fold_exit_tests;
+};
+
+void LoopUnroller::Optimize(FlowGraph* flow_graph) {
+  if (!(FLAG_loop_peeling || FLAG_loop_unrolling) ||
+      flow_graph->IsCompiledForOsr()) {
+    return;
+  }
+
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  loop_hierarchy.ComputeInduction();
+
+  // Analyze all loops before changing the graph.
+  GrowableArray<LoopTransformation> transformations;
+  const ZoneGrowableArray<BlockEntryInstr*>& headers = loop_hierarchy.headers();
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    LoopInfo* loop = headers[i]->loop_info();
+    LoopTransformation transformation = {new LoopCloner(flow_graph, loop),
+                                         false, 1, false};
+    if (!transformation.cloner->CanClone()) {
+      continue;
+    }
+    if (FLAG_loop_peeling && ShouldPeel(flow_graph, loop)) {
+      transformation.peel = true;
+    } else if (FLAG_loop_unrolling) {
+      transformation.factor = UnrollFactor(transformation.cloner,
+                                           &transformation.fold_exit_tests);
+    }
+    if (transformation.peel || transformation.factor > 1) {
+      transformations.Add(transformation);
+    }
+  }
+  if (transformations.is_empty()) {
+    return;
+  }
+
+  for (const LoopTransformation& transformation : transformations) {
+    LoopCloner* cloner = transformation.cloner;
+    if (FLAG_support_il_printer && FLAG_trace_loop_unrolling) {
+      if (transformation.peel) {
+        THR_Print("Peeling loop %s in %s\n", cloner->loop()->ToCString(),
+                  flow_graph->function().ToFullyQualifiedCString());
+      } else {
+        THR_Print("Unrolling loop %s by %" Pd "%s in %s\n",
+                  cloner->loop()->ToCString(), transformation.factor,
+                  transformation.fold_exit_tests ? " (exit tests folded)" : "",
+                  flow_graph->function().ToFullyQualifiedCString());
+      }
+    }
+    if (transformation.peel) {
+      cloner->Peel();
+    } else {
+      cloner->Unroll(transformation.factor, transformation.fold_exit_tests);
+    }
+  }
+  flow_graph->DiscoverBlocks();
+  for (const LoopTransformation& transformation : transformations) {
+    transformation.cloner->FixupPhis();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+}
+
+}  // namespace dart
@@ -0,0 +1,36 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+
+namespace dart {
+
+class FlowGraph;
+
+// Peels and unrolls small innermost loops.
+//
+// The first iteration of a loop is peeled when the loop checks a loop
+// invariant value in every iteration (CheckNull, CheckClass), but the check
+// cannot be hoisted by LICM because it follows a visible effect of the loop.
+// The check in the peeled iteration then dominates the loop and CSE removes
+// the check from the loop.
+//
+// Countable loops (see InductionVarAnalysis) are unrolled by up to
+// FLAG_loop_unrolling_factor copies of the loop body. When the trip count is
+// a known multiple of the factor, only the first copy tests for the exit.
+class LoopUnroller : public AllStatic {
+ public:
+  static void Optimize(FlowGraph* flow_graph);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
@@ -0,0 +1,157 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, loop_peeling);
+DECLARE_FLAG(bool, loop_unrolling);
+
+// Helper method to count instructions with the given tag. Only instructions
+// in loops are counted when in_loops is set.
+static intptr_t CountInstructions(FlowGraph* flow_graph,
+                                  Instruction::Tag tag,
+                                  bool in_loops = false) {
+  flow_graph->ResetLoopHierarchy();
+  flow_graph->GetLoopHierarchy();
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    BlockEntryInstr* block = block_it.Current();
+    if (in_loops && block->loop_info() == nullptr) {
+      continue;
+    }
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      if (it.Current()->tag() == tag) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_ConstantTripCount) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a) {
+        int sum = 0;
+        for (int i = 0; i < 8; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      int check() => foo(List<int>.generate(8, (i) => i));
+
+      main() {
+        check();
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // Unrolled by 4, with a single exit test for every 4 elements.
+  EXPECT_EQ(4, CountInstructions(flow_graph, Instruction::kLoadIndexed));
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kBranch));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(28, Smi::Cast(result).Value());
+  // Ensure we didn't deoptimize to unoptimized code.
+  EXPECT(function.unoptimized_code() == Code::null());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_SymbolicTripCount) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a, int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      // Not a multiple of the unrolling factor.
+      int check() => foo(List<int>.generate(7, (i) => i), 7);
+
+      main() {
+        check();
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // Every copy keeps its exit test.
+  EXPECT_EQ(4, CountInstructions(flow_graph, Instruction::kLoadIndexed));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(21, Smi::Cast(result).Value());
+  EXPECT(function.unoptimized_code() == Code::null());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_PeelInvariantCheck) {
+  const char* kScript =
+      R"(
+      class A {
+        int x = 3;
+      }
+
+      int foo(List<int> a, A obj, int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+          sum += a[i] + obj.x;
+        }
+        return sum;
+      }
+
+      int check() => foo(List<int>.filled(4, 1), A(), 4);
+
+      main() {
+        check();
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+
+  // Pretend that a hoisted class check deoptimized before, so that LICM
+  // keeps the class checks in the loop.
+  function.SetProhibitsHoistingCheckClass(true);
+  SetFlagScope<bool> sfs(&FLAG_loop_peeling, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // The checks in the peeled iteration make the checks in the loop
+  // redundant.
+  EXPECT_LT(0, CountInstructions(flow_graph, Instruction::kCheckClass));
+  EXPECT_EQ(0, CountInstructions(flow_graph, Instruction::kCheckClass,
+                                 /*in_loops=*/true));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(16, Smi::Cast(result).Value());
+}
+
+}  // namespace dart
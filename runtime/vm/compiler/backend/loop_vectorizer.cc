@@ -0,0 +1,827 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_printer.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/hash_map.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_vectorization,
+            false,
+            "Widen simple loops over typed data into SIMD loops.");
+DEFINE_FLAG(bool,
+            trace_loop_vectorization,
+            false,
+            "Trace loop vectorization progress.");
+
+// Quick access to the current zone.
+#define Z (flow_graph_->zone())
+
+// Maximal number of operations in a widened computation.
+static const intptr_t kMaxTreeSize = 16;
+
+// Describes how elements of a typed data class are grouped into vectors.
+struct VectorLane {
+  intptr_t array_cid;         // Class id of the scalar typed data.
+  intptr_t vector_array_cid;  // Class id used to access vectors of elements.
+  intptr_t vector_cid;        // Class id of the vector values.
+  intptr_t width;             // Number of elements in a vector.
+};
+
+// Note that there is no Int8x16 or Int16x8 support in the SIMD operations,
+// so narrower integer typed data is not widened.
+static const VectorLane kVectorLanes[] = {
+    {kTypedDataFloat64ArrayCid, kTypedDataFloat64x2ArrayCid, kFloat64x2Cid, 2},
+    {kTypedDataFloat32ArrayCid, kTypedDataFloat32x4ArrayCid, kFloat32x4Cid, 4},
+    {kTypedDataInt32ArrayCid, kTypedDataInt32x4ArrayCid, kInt32x4Cid, 4},
+    {kTypedDataUint32ArrayCid, kTypedDataInt32x4ArrayCid, kInt32x4Cid, 4},
+};
+
+static const VectorLane* LaneFor(intptr_t array_cid) {
+  for (const VectorLane& lane : kVectorLanes) {
+    if (lane.array_cid == array_cid) {
+      return &lane;
+    }
+  }
+  return nullptr;
+}
+
+// Returns true if the given instruction can be executed any number of times,
+// in any order, without observable effects.
+static bool IsPure(Instruction* instr) {
+  if (instr->HasUnknownSideEffects() || instr->MayThrow() ||
+      instr->CanDeoptimize()) {
+    return false;
+  }
+  return instr->AllowsCSE() || instr->IsLoadField() ||
+         instr->IsLoadIndexed() || instr->IsLoadUntagged();
+}
+
+// Analysis and transformation of a single loop.
+//
+// The loop must consist of a header, which tests i < n for a unit stride
+// induction i, and a single body block. The body may contain bounds checks
+// on i, a single store at index i into typed data, and the computation of
+// the stored value from loads at index i and (for Float64 elements) loop
+// invariant doubles. The transformation produces
+//
+//   if (W <= n && n <= length_0 && ... && 0 <= i0 && no_overlap) {
+//     m = n - W
+//     for (vi = i0; vi <= m; vi += W) {
+//       c[vi] = widened computation of a[vi], b[vi], ...
+//     }
+//     i0' = vi
+//   }
+//   for (i = i0'; i < n; i++) {
+//     original loop
+//   }
+//
+// where W is the number of elements in a vector.
+class LoopVectorization : public ZoneAllocated {
+ public:
+  LoopVectorization(FlowGraph* flow_graph, LoopInfo* loop)
+      : flow_graph_(flow_graph),
+        loop_(loop),
+        header_(nullptr),
+        body_(nullptr),
+        pre_header_(nullptr),
+        pre_header_index_(-1),
+        phi_(nullptr),
+        branch_(nullptr),
+        limit_(nullptr),
+        initial_(nullptr),
+        increment_(nullptr),
+        store_(nullptr),
+        stack_check_(nullptr),
+        lane_(nullptr),
+        lengths_(),
+        bases_(),
+        untagged_bases_(),
+        invariants_(),
+        tree_(),
+        effects_(),
+        widened_(),
+        back_edge_value_(nullptr),
+        vector_header_(nullptr),
+        vector_body_(nullptr),
+        vector_exit_(nullptr),
+        scalar_entry_(nullptr),
+        guard_count_(0),
+        vector_phi_(nullptr),
+        vector_next_(nullptr),
+        scalar_phi_(nullptr) {}
+
+  // Returns true if the loop can be widened.
+  bool Analyze();
+
+  // Inserts the guarded vector loop in front of the loop. Blocks must be
+  // rediscovered before calling FixupPhis().
+  void Transform();
+
+  // Sets the inputs of the new and the changed phis in the order of the
+  // rediscovered predecessors.
+  void FixupPhis();
+
+  LoopInfo* loop() const { return loop_; }
+  const VectorLane* lane() const { return lane_; }
+
+ private:
+  bool IsInLoop(Definition* def) const {
+    return loop_->Contains(def->GetBlock());
+  }
+
+  bool IsInduction(Value* value) const {
+    Definition* def = value->definition();
+    return def->OriginalDefinitionIgnoreBoxingAndConstraints() == phi_;
+  }
+
+  bool IsConversion(Definition* def) const;
+  Definition* SkipConversions(Definition* def) const;
+
+  bool AnalyzeControl();
+  bool AnalyzeHeader();
+  bool AnalyzeBody();
+  bool AnalyzeTree(Definition* def);
+  bool AddLength(Value* length);
+  bool AddArray(Value* array);
+  bool AddInvariant(Definition* def);
+
+  TargetEntryInstr* NewTarget(double edge_weight);
+  JoinEntryInstr* NewJoin();
+  GotoInstr* NewGoto(JoinEntryInstr* target);
+  ComparisonInstr* NewCompare(Token::Kind kind,
+                              Definition* left,
+                              Definition* right);
+  Instruction* AppendGuard(Instruction* cursor, ComparisonInstr* compare);
+  Definition* WidenedArray(Value* array, Instruction** cursor);
+  Definition* Widen(Definition* def, Instruction** cursor);
+  PhiInstr* NewPhi(JoinEntryInstr* join,
+                   intptr_t input_count,
+                   Representation representation);
+  void SetPhiInput(PhiInstr* phi, intptr_t index, Definition* def);
+
+  FlowGraph* flow_graph_;
+  LoopInfo* loop_;
+
+  // Analyzed loop.
+  JoinEntryInstr* header_;
+  BlockEntryInstr* body_;
+  BlockEntryInstr* pre_header_;
+  intptr_t pre_header_index_;
+  PhiInstr* phi_;
+  BranchInstr* branch_;
+  Definition* limit_;
+  Definition* initial_;
+  Definition* increment_;
+  StoreIndexedInstr* store_;
+  CheckStackOverflowInstr* stack_check_;
+  const VectorLane* lane_;
+  GrowableArray<Definition*> lengths_;
+  GrowableArray<Definition*> bases_;
+  GrowableArray<Definition*> untagged_bases_;
+  GrowableArray<Definition*> invariants_;
+  GrowableArray<Definition*> tree_;
+  GrowableArray<Instruction*> effects_;
+
+  // Scalar definitions mapped to their widened counterparts.
+  DirectChainedHashMap<RawPointerKeyValueTrait<Definition, Definition*>>
+      widened_;
+
+  // Transformed loop.
+  Value* back_edge_value_;
+  JoinEntryInstr* vector_header_;
+  TargetEntryInstr* vector_body_;
+  TargetEntryInstr* vector_exit_;
+  JoinEntryInstr* scalar_entry_;
+  intptr_t guard_count_;
+  PhiInstr* vector_phi_;
+  Definition* vector_next_;
+  PhiInstr* scalar_phi_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopVectorization);
+};
+
+template <typename T>
+static void AddUnique(GrowableArray<T*>* list, T* element) {
+  for (intptr_t i = 0; i < list->length(); i++) {
+    if ((*list)[i] == element) {
+      return;
+    }
+  }
+  list->Add(element);
+}
+
+template <typename T>
+static bool ListContains(const GrowableArray<T*>& list, T* element) {
+  for (intptr_t i = 0; i < list.length(); i++) {
+    if (list[i] == element) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LoopVectorization::Analyze() {
+  return AnalyzeControl() && AnalyzeHeader() && AnalyzeBody();
+}
+
+bool LoopVectorization::AnalyzeControl() {
+  // Innermost loop with a single body block.
+  if (loop_->inner() != nullptr || loop_->back_edges().length() != 1) {
+    return false;
+  }
+  header_ = loop_->header()->AsJoinEntry();
+  body_ = loop_->back_edges()[0];
+  if (header_ == nullptr || body_ == header_ ||
+      header_->try_index() != kInvalidTryIndex ||
+      header_->PredecessorCount() != 2 || body_->PredecessorCount() != 1 ||
+      body_->PredecessorAt(0) != header_ ||
+      !body_->last_instruction()->IsGoto()) {
+    return false;
+  }
+  intptr_t block_count = 0;
+  for (BitVector::Iterator it(loop_->blocks()); !it.Done(); it.Advance()) {
+    block_count++;
+  }
+  if (block_count != 2) {
+    return false;
+  }
+  pre_header_index_ = header_->PredecessorAt(0) == body_ ? 1 : 0;
+  pre_header_ = header_->PredecessorAt(pre_header_index_);
+  if (!pre_header_->last_instruction()->IsGoto()) {
+    return false;
+  }
+
+  // A single header phi, which is the unit stride induction controlling
+  // the loop.
+  if (header_->phis() == nullptr || header_->phis()->length() != 1) {
+    return false;
+  }
+  phi_ = (*header_->phis())[0];
+  int64_t stride = 0;
+  if (loop_->control() == nullptr ||
+      loop_->LookupInduction(phi_) != loop_->control() ||
+      !InductionVar::IsLinear(loop_->control(), &stride) || stride != 1) {
+    return false;
+  }
+  initial_ = phi_->InputAt(pre_header_index_)->definition();
+  increment_ = phi_->InputAt(1 - pre_header_index_)->definition();
+  if (increment_->GetBlock() != body_) {
+    return false;
+  }
+
+  // The loop runs while i < limit.
+  branch_ = header_->last_instruction()->AsBranch();
+  if (branch_ == nullptr) {
+    return false;
+  }
+  RelationalOpInstr* compare = branch_->comparison()->AsRelationalOp();
+  if (compare == nullptr || (compare->operation_cid() != kSmiCid &&
+                             compare->operation_cid() != kMintCid)) {
+    return false;
+  }
+  Token::Kind kind = compare->kind();
+  if (branch_->true_successor() != body_) {
+    kind = Token::NegateComparison(kind);
+  }
+  Value* limit = compare->right();
+  if (!IsInduction(compare->left())) {
+    if (!IsInduction(compare->right())) {
+      return false;
+    }
+    kind = Token::FlipComparison(kind);
+    limit = compare->left();
+  }
+  if (kind != Token::kLT || IsInLoop(limit->definition())) {
+    return false;
+  }
+  limit_ = limit->definition();
+  return true;
+}
+
+bool LoopVectorization::AnalyzeHeader() {
+  for (ForwardInstructionIterator it(header_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if (current == branch_) {
+      continue;
+    }
+    if (CheckStackOverflowInstr* check = current->AsCheckStackOverflow()) {
+      if (stack_check_ != nullptr) {
+        return false;
+      }
+      stack_check_ = check;
+    } else if (!IsPure(current)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LoopVectorization::AnalyzeBody() {
+  for (ForwardInstructionIterator it(body_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if (current == body_->last_instruction() || current == increment_) {
+      continue;
+    }
+    if (CheckBoundBase* check = current->AsCheckBoundBase()) {
+      if (!IsInduction(check->index()) || !AddLength(check->length())) {
+        return false;
+      }
+    } else if (StoreIndexedInstr* store = current->AsStoreIndexed()) {
+      if (store_ != nullptr) {
+        return false;
+      }
+      store_ = store;
+    } else if (CheckStackOverflowInstr* check =
+                   current->AsCheckStackOverflow()) {
+      if (stack_check_ != nullptr) {
+        return false;
+      }
+      stack_check_ = check;
+    } else if (!IsPure(current)) {
+      // Must be part of the widened computation.
+      effects_.Add(current);
+    }
+  }
+
+  // A single store of a lane-wise computation at index i.
+  if (store_ == nullptr || !IsInduction(store_->index())) {
+    return false;
+  }
+  lane_ = LaneFor(store_->class_id());
+  if (lane_ == nullptr || !AddArray(store_->array()) ||
+      !AnalyzeTree(store_->value()->definition())) {
+    return false;
+  }
+  for (intptr_t i = 0; i < effects_.length(); i++) {
+    Definition* def = effects_[i]->AsDefinition();
+    if (def == nullptr || !ListContains(tree_, def)) {
+      return false;
+    }
+  }
+
+  // The environment of the stack overflow check is replicated in the
+  // vector loop, where only the induction is available.
+  if (stack_check_ != nullptr && stack_check_->env() != nullptr) {
+    for (Environment::DeepIterator it(stack_check_->env()); !it.Done();
+         it.Advance()) {
+      Definition* def = it.CurrentValue()->definition();
+      if (def != phi_ && IsInLoop(def)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool LoopVectorization::IsConversion(Definition* def) const {
+  if (def->GetBlock() != body_) {
+    return false;
+  }
+  switch (lane_->vector_cid) {
+    case kFloat32x4Cid:
+      if (def->IsFloatToDouble() || def->IsDoubleToFloat()) {
+        return true;
+      }
+      FALL_THROUGH;
+    case kFloat64x2Cid:
+      return (def->IsBox() &&
+              def->AsBox()->from_representation() == kUnboxedDouble) ||
+             (def->IsUnbox() && def->representation() == kUnboxedDouble);
+    case kInt32x4Cid:
+      return def->IsBoxInteger() || def->IsUnboxInteger() ||
+             def->IsIntConverter();
+    default:
+      UNREACHABLE();
+  }
+  return false;
+}
+
+Definition* LoopVectorization::SkipConversions(Definition* def) const {
+  while (IsConversion(def)) {
+    def = def->InputAt(0)->definition();
+  }
+  return def;
+}
+
+bool LoopVectorization::AnalyzeTree(Definition* def) {
+  while (IsConversion(def)) {
+    tree_.Add(def);
+    def = def->InputAt(0)->definition();
+  }
+  if (!IsInLoop(def)) {
+    return AddInvariant(def);
+  }
+  if (def->GetBlock() != body_ || tree_.length() >= kMaxTreeSize) {
+    return false;
+  }
+  tree_.Add(def);
+  if (LoadIndexedInstr* load = def->AsLoadIndexed()) {
+    return load->class_id() == lane_->array_cid && IsInduction(load->index()) &&
+           AddArray(load->array());
+  }
+
+  Token::Kind op_kind = Token::kILLEGAL;
+  Value* left = nullptr;
+  Value* right = nullptr;
+  if (lane_->vector_cid == kInt32x4Cid) {
+    if (BinaryIntegerOpInstr* op = def->AsBinaryIntegerOp()) {
+      op_kind = op->op_kind();
+      left = op->left();
+      right = op->right();
+    }
+  } else if (BinaryDoubleOpInstr* op = def->AsBinaryDoubleOp()) {
+    op_kind = op->op_kind();
+    left = op->left();
+    right = op->right();
+    // Float32 elements are computed in double precision and rounded when
+    // stored. This is only the same as computing in single precision for a
+    // single operation over the loaded values.
+    if (lane_->vector_cid == kFloat32x4Cid &&
+        (!SkipConversions(left->definition())->IsLoadIndexed() ||
+         !SkipConversions(right->definition())->IsLoadIndexed())) {
+      return false;
+    }
+  }
+  if (left == nullptr ||
+      SimdOpInstr::KindForOperator(lane_->vector_cid, op_kind) ==
+          SimdOpInstr::kIllegalSimdOp) {
+    return false;
+  }
+  return AnalyzeTree(left->definition()) && AnalyzeTree(right->definition());
+}
+
+bool LoopVectorization::AddLength(Value* length) {
+  Definition* def = length->definition();
+  if (!IsInLoop(def)) {
+    AddUnique(&lengths_, def);
+    return true;
+  }
+  // Immutable length loads in the loop are reloaded in front of it.
+  def = def->OriginalDefinitionIgnoreBoxingAndConstraints();
+  LoadFieldInstr* load = def->AsLoadField();
+  if (!IsInLoop(def) ||
+      (load != nullptr && load->IsImmutableLengthLoad() &&
+       !IsInLoop(load->instance()->definition()))) {
+    AddUnique(&lengths_, def);
+    return true;
+  }
+  return false;
+}
+
+bool LoopVectorization::AddArray(Value* array) {
+  Definition* def = array->definition();
+  if (LoadUntaggedInstr* data = def->AsLoadUntagged()) {
+    // Data of typed data reloaded in the loop.
+    Definition* object = data->object()->definition();
+    if (def->GetBlock() != body_ || IsInLoop(object) ||
+        data->offset() !=
+            compiler::target::TypedDataBase::data_field_offset()) {
+      return false;
+    }
+    AddUnique(&bases_, object);
+    if (object->Type()->ToCid() != lane_->array_cid) {
+      AddUnique(&untagged_bases_, object);
+    }
+    return true;
+  }
+  if (IsInLoop(def) || def->representation() != kTagged) {
+    return false;
+  }
+  AddUnique(&bases_, def);
+  return true;
+}
+
+bool LoopVectorization::AddInvariant(Definition* def) {
+  // Invariants are splatted into vectors, which is only supported
+  // for doubles.
+  if (lane_->vector_cid != kFloat64x2Cid ||
+      (def->representation() != kUnboxedDouble &&
+       def->Type()->ToCid() != kDoubleCid)) {
+    return false;
+  }
+  AddUnique(&invariants_, def);
+  return true;
+}
+
+TargetEntryInstr* LoopVectorization::NewTarget(double edge_weight) {
+  TargetEntryInstr* target = new (Z) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), header_->try_index(), DeoptId::kNone);
+  target->set_edge_weight(edge_weight);
+  return target;
+}
+
+JoinEntryInstr* LoopVectorization::NewJoin() {
+  return new (Z) JoinEntryInstr(flow_graph_->allocate_block_id(),
+                                header_->try_index(), DeoptId::kNone);
+}
+
+GotoInstr* LoopVectorization::NewGoto(JoinEntryInstr* target) {
+  return new (Z) GotoInstr(target, DeoptId::kNone);
+}
+
+ComparisonInstr* LoopVectorization::NewCompare(Token::Kind kind,
+                                               Definition* left,
+                                               Definition* right) {
+  return new (Z) RelationalOpInstr(
+      branch_->token_pos(), kind, new (Z) Value(left), new (Z) Value(right),
+      kMintCid, DeoptId::kNone, Instruction::kNotSpeculative);
+}
+
+Instruction* LoopVectorization::AppendGuard(Instruction* cursor,
+                                            ComparisonInstr* compare) {
+  const double weight = body_->AsTargetEntry()->edge_weight();
+  TargetEntryInstr* pass = NewTarget(weight);
+  TargetEntryInstr* fail = NewTarget(weight);
+  BranchInstr* branch = new (Z) BranchInstr(compare, DeoptId::kNone);
+  flow_graph_->AppendTo(cursor, branch, nullptr, FlowGraph::kEffect);
+  *branch->true_successor_address() = pass;
+  *branch->false_successor_address() = fail;
+  flow_graph_->AppendTo(fail, NewGoto(scalar_entry_), nullptr,
+                        FlowGraph::kEffect);
+  guard_count_++;
+  return pass;
+}
+
+PhiInstr* LoopVectorization::NewPhi(JoinEntryInstr* join,
+                                    intptr_t input_count,
+                                    Representation representation) {
+  // Inputs are set once the predecessors are known.
+  PhiInstr* phi = new (Z) PhiInstr(join, input_count);
+  phi->set_representation(representation);
+  phi->mark_alive();
+  if (phi_->range() != nullptr) {
+    phi->set_range(*phi_->range());
+  }
+  flow_graph_->AllocateSSAIndexes(phi);
+  join->InsertPhi(phi);
+  return phi;
+}
+
+void LoopVectorization::SetPhiInput(PhiInstr* phi,
+                                    intptr_t index,
+                                    Definition* def) {
+  Value* input = new (Z) Value(def);
+  phi->SetInputAt(index, input);
+  def->AddInputUse(input);
+}
+
+Definition* LoopVectorization::WidenedArray(Value* array,
+                                            Instruction** cursor) {
+  LoadUntaggedInstr* data = array->definition()->AsLoadUntagged();
+  if (data == nullptr) {
+    return array->definition();
+  }
+  // Derived pointers must not live across the stack overflow check,
+  // so the data is reloaded for every access.
+  LoadUntaggedInstr* load = new (Z) LoadUntaggedInstr(
+      new (Z) Value(data->object()->definition()), data->offset());
+  *cursor = flow_graph_->AppendTo(*cursor, load, nullptr, FlowGraph::kValue);
+  return load;
+}
+
+Definition* LoopVectorization::Widen(Definition* def, Instruction** cursor) {
+  def = SkipConversions(def);
+  if (Definition* widened = widened_.LookupValue(def)) {
+    return widened;
+  }
+  Definition* result = nullptr;
+  if (LoadIndexedInstr* load = def->AsLoadIndexed()) {
+    Definition* array = WidenedArray(load->array(), cursor);
+    result = new (Z) LoadIndexedInstr(
+        new (Z) Value(array), new (Z) Value(vector_phi_),
+        /*index_unboxed=*/true, load->index_scale(), lane_->vector_array_cid,
+        load->aligned() ? kAlignedAccess : kUnalignedAccess, DeoptId::kNone,
+        load->token_pos());
+  } else {
+    Token::Kind op_kind;
+    Definition* left;
+    Definition* right;
+    if (BinaryDoubleOpInstr* op = def->AsBinaryDoubleOp()) {
+      op_kind = op->op_kind();
+      left = op->left()->definition();
+      right = op->right()->definition();
+    } else {
+      BinaryIntegerOpInstr* int_op = def->AsBinaryIntegerOp();
+      op_kind = int_op->op_kind();
+      left = int_op->left()->definition();
+      right = int_op->right()->definition();
+    }
+    Definition* widened_left = Widen(left, cursor);
+    Definition* widened_right = Widen(right, cursor);
+    result = SimdOpInstr::Create(
+        SimdOpInstr::KindForOperator(lane_->vector_cid, op_kind),
+        new (Z) Value(widened_left), new (Z) Value(widened_right),
+        DeoptId::kNone);
+  }
+  *cursor = flow_graph_->AppendTo(*cursor, result, nullptr, FlowGraph::kValue);
+  widened_.Insert({def, result});
+  return result;
+}
+
+void LoopVectorization::Transform() {
+  const TokenPosition pos = branch_->token_pos();
+  const double weight = body_->AsTargetEntry()->edge_weight();
+  ConstantInstr* width =
+      flow_graph_->GetConstant(Smi::ZoneHandle(Z, Smi::New(lane_->width)));
+
+  JoinEntryInstr* guard_entry = NewJoin();
+  scalar_entry_ = NewJoin();
+
+  // Guards. Running W elements ahead must stay within the bounds checked
+  // by the loop, and elements written must not be read at another index.
+  Instruction* cursor = guard_entry;
+  cursor = AppendGuard(cursor, NewCompare(Token::kLTE, width, limit_));
+  if (!lengths_.is_empty()) {
+    cursor = AppendGuard(
+        cursor,
+        NewCompare(Token::kLTE,
+                   flow_graph_->GetConstant(Smi::ZoneHandle(Z, Smi::New(0))),
+                   initial_));
+    for (intptr_t i = 0; i < lengths_.length(); i++) {
+      Definition* length = lengths_[i];
+      if (IsInLoop(length)) {
+        LoadFieldInstr* load = length->AsLoadField();
+        length = new (Z) LoadFieldInstr(
+            new (Z) Value(load->instance()->definition()), load->slot(),
+            load->token_pos());
+        cursor =
+            flow_graph_->AppendTo(cursor, length, nullptr, FlowGraph::kValue);
+      }
+      cursor = AppendGuard(cursor, NewCompare(Token::kLTE, limit_, length));
+    }
+  }
+  if (bases_.length() > 1) {
+    // Distinct internal typed data never overlap, views might.
+    ConstantInstr* cid = flow_graph_->GetConstant(
+        Smi::ZoneHandle(Z, Smi::New(lane_->array_cid)));
+    for (intptr_t i = 0; i < untagged_bases_.length(); i++) {
+      LoadClassIdInstr* load_cid =
+          new (Z) LoadClassIdInstr(new (Z) Value(untagged_bases_[i]));
+      cursor =
+          flow_graph_->AppendTo(cursor, load_cid, nullptr, FlowGraph::kValue);
+      cursor = AppendGuard(
+          cursor, new (Z) StrictCompareInstr(
+                      pos, Token::kEQ_STRICT, new (Z) Value(load_cid),
+                      new (Z) Value(cid),
+                      /*needs_number_check=*/false, DeoptId::kNone));
+    }
+  }
+
+  // Vector loop preheader.
+  Definition* vector_limit = new (Z) BinaryInt64OpInstr(
+      Token::kSUB, new (Z) Value(limit_), new (Z) Value(width), DeoptId::kNone,
+      Instruction::kNotSpeculative);
+  cursor =
+      flow_graph_->AppendTo(cursor, vector_limit, nullptr, FlowGraph::kValue);
+  for (intptr_t i = 0; i < invariants_.length(); i++) {
+    Definition* splat =
+        SimdOpInstr::Create(MethodRecognizer::kFloat64x2Splat,
+                            new (Z) Value(invariants_[i]), DeoptId::kNone);
+    cursor = flow_graph_->AppendTo(cursor, splat, nullptr, FlowGraph::kValue);
+    widened_.Insert({invariants_[i], splat});
+  }
+  vector_header_ = NewJoin();
+  flow_graph_->AppendTo(cursor, NewGoto(vector_header_), nullptr,
+                        FlowGraph::kEffect);
+
+  // Vector loop header.
+  vector_phi_ = NewPhi(vector_header_, 2, kUnboxedInt64);
+  cursor = vector_header_;
+  if (stack_check_ != nullptr) {
+    CheckStackOverflowInstr* check = new (Z) CheckStackOverflowInstr(
+        stack_check_->token_pos(), stack_check_->stack_depth(),
+        stack_check_->loop_depth(), stack_check_->deopt_id(),
+        CheckStackOverflowInstr::kOsrAndPreemption);
+    cursor = flow_graph_->AppendTo(cursor, check, stack_check_->env(),
+                                   FlowGraph::kEffect);
+    if (check->env() != nullptr) {
+      for (Environment::DeepIterator it(check->env()); !it.Done();
+           it.Advance()) {
+        Value* value = it.CurrentValue();
+        if (value->definition() == phi_) {
+          value->BindToEnvironment(vector_phi_);
+        }
+      }
+    }
+  }
+  vector_body_ = NewTarget(weight);
+  vector_exit_ = NewTarget(weight);
+  BranchInstr* vector_branch = new (Z) BranchInstr(
+      NewCompare(Token::kLTE, vector_phi_, vector_limit), DeoptId::kNone);
+  flow_graph_->AppendTo(cursor, vector_branch, nullptr, FlowGraph::kEffect);
+  *vector_branch->true_successor_address() = vector_body_;
+  *vector_branch->false_successor_address() = vector_exit_;
+
+  // Vector loop body.
+  cursor = vector_body_;
+  Definition* value = Widen(store_->value()->definition(), &cursor);
+  Definition* array = WidenedArray(store_->array(), &cursor);
+  StoreIndexedInstr* store = new (Z) StoreIndexedInstr(
+      new (Z) Value(array), new (Z) Value(vector_phi_), new (Z) Value(value),
+      kNoStoreBarrier, /*index_unboxed=*/true, store_->index_scale(),
+      lane_->vector_array_cid,
+      store_->aligned() ? kAlignedAccess : kUnalignedAccess, DeoptId::kNone,
+      store_->token_pos(), Instruction::kNotSpeculative);
+  cursor = flow_graph_->AppendTo(cursor, store, nullptr, FlowGraph::kEffect);
+  vector_next_ = new (Z) BinaryInt64OpInstr(
+      Token::kADD, new (Z) Value(vector_phi_), new (Z) Value(width),
+      DeoptId::kNone, Instruction::kNotSpeculative);
+  cursor =
+      flow_graph_->AppendTo(cursor, vector_next_, nullptr, FlowGraph::kValue);
+  flow_graph_->AppendTo(cursor, NewGoto(vector_header_), nullptr,
+                        FlowGraph::kEffect);
+
+  // Continue with the scalar loop at the first unprocessed element.
+  flow_graph_->AppendTo(vector_exit_, NewGoto(scalar_entry_), nullptr,
+                        FlowGraph::kEffect);
+  scalar_phi_ =
+      NewPhi(scalar_entry_, guard_count_ + 1, phi_->representation());
+  flow_graph_->AppendTo(scalar_entry_, NewGoto(header_), nullptr,
+                        FlowGraph::kEffect);
+  pre_header_->last_instruction()->AsGoto()->set_successor(guard_entry);
+
+  // The header phi gets a new input from the scalar entry.
+  phi_->InputAt(pre_header_index_)->RemoveFromUseList();
+  back_edge_value_ = phi_->InputAt(1 - pre_header_index_);
+}
+
+void LoopVectorization::FixupPhis() {
+  ASSERT(vector_header_->PredecessorCount() == 2);
+  for (intptr_t i = 0; i < 2; i++) {
+    SetPhiInput(vector_phi_, i,
+                vector_header_->PredecessorAt(i) == vector_body_
+                    ? vector_next_
+                    : initial_);
+  }
+  ASSERT(scalar_entry_->PredecessorCount() == guard_count_ + 1);
+  for (intptr_t i = 0; i <= guard_count_; i++) {
+    SetPhiInput(scalar_phi_, i,
+                scalar_entry_->PredecessorAt(i) == vector_exit_ ? vector_phi_
+                                                                : initial_);
+  }
+  ASSERT(header_->PredecessorCount() == 2);
+  for (intptr_t i = 0; i < 2; i++) {
+    if (header_->PredecessorAt(i) == scalar_entry_) {
+      SetPhiInput(phi_, i, scalar_phi_);
+    } else {
+      phi_->SetInputAt(i, back_edge_value_);
+    }
+  }
+}
+
+void LoopVectorizer::Optimize(FlowGraph* flow_graph) {
+#if !defined(TARGET_ARCH_IS_64_BIT)
+  // The widened loop uses unboxed int64 indices, which are only supported
+  // as array indices on 64-bit targets.
+  return;
+#endif  // !defined(TARGET_ARCH_IS_64_BIT)
+  if (!FLAG_loop_vectorization ||
+      !FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    return;
+  }
+
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  loop_hierarchy.ComputeInduction();
+
+  // Analyze all loops before changing the graph.
+  GrowableArray<LoopVectorization*> candidates;
+  const ZoneGrowableArray<BlockEntryInstr*>& headers = loop_hierarchy.headers();
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    LoopVectorization* candidate =
+        new LoopVectorization(flow_graph, headers[i]->loop_info());
+    if (candidate->Analyze()) {
+      candidates.Add(candidate);
+    }
+  }
+  if (candidates.is_empty()) {
+    return;
+  }
+
+  for (intptr_t i = 0; i < candidates.length(); i++) {
+    if (FLAG_support_il_printer && FLAG_trace_loop_vectorization) {
+      THR_Print("Vectorizing loop %s by %" Pd " in %s\n",
+                candidates[i]->loop()->ToCString(),
+                candidates[i]->lane()->width,
+                flow_graph->function().ToFullyQualifiedCString());
+    }
+    candidates[i]->Transform();
+  }
+  flow_graph->DiscoverBlocks();
+  for (intptr_t i = 0; i < candidates.length(); i++) {
+    candidates[i]->FixupPhis();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+}
+
+}  // namespace dart
@@ -0,0 +1,39 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+
+namespace dart {
+
+class FlowGraph;
+
+// Widens countable innermost loops over typed data into SIMD loops.
+//
+// A loop qualifies when its body stores a lane-wise computation over
+// loads at the induction variable back into typed data, e.g.
+//
+//   for (int i = 0; i < n; i++) {
+//     c[i] = a[i] * b[i] + k;
+//   }
+//
+// The widened loop processes Float64x2, Float32x4 or Int32x4 chunks of the
+// arrays and runs ahead of the original loop, which is kept unchanged as the
+// scalar epilogue for the remaining iterations. Guards in front of the
+// widened loop fall back to the scalar loop whenever a bounds check could
+// fail or the arrays could overlap.
+class LoopVectorizer : public AllStatic {
+ public:
+  static void Optimize(FlowGraph* flow_graph);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
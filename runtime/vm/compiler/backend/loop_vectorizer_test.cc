@@ -0,0 +1,151 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, loop_vectorization);
+
+// Helper method to count number of SIMD operations.
+static intptr_t CountSimdOps(FlowGraph* flow_graph) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsSimdOp()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// Helper method to build the optimized graph of foo with vectorization.
+static FlowGraph* VectorizeFoo(TestPipeline* pipeline) {
+  SetFlagScope<bool> sfs(&FLAG_loop_vectorization, true);
+  return pipeline->RunPasses({});
+}
+
+#if defined(TARGET_ARCH_IS_64_BIT)
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Float64) {
+  if (!FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    return;
+  }
+  const char* kScript =
+      R"(
+      import 'dart:typed_data';
+
+      void foo(Float64List a, Float64List b, Float64List c, int n) {
+        for (int i = 0; i < n; i++) {
+          c[i] = a[i] * b[i] + 1.5;
+        }
+      }
+
+      double check(int n) {
+        final a = Float64List(n);
+        final b = Float64List(n);
+        final c = Float64List(n);
+        for (int i = 0; i < n; i++) {
+          a[i] = i.toDouble();
+          b[i] = 2.0;
+        }
+        foo(a, b, c, n);
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+          sum += c[i];
+        }
+        return sum;
+      }
+
+      // Odd length to exercise the scalar epilogue.
+      double checkOdd() => check(7);
+
+      main() {
+        check(16);
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = VectorizeFoo(&pipeline);
+
+  // Widened multiplication, addition and splat of the constant.
+  EXPECT_EQ(3, CountSimdOps(flow_graph));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "checkOdd"));
+  EXPECT(result.IsDouble());
+  EXPECT_EQ(52.5, Double::Cast(result).value());
+  // Ensure we didn't deoptimize to unoptimized code.
+  EXPECT(function.unoptimized_code() == Code::null());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Int32) {
+  if (!FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    return;
+  }
+  const char* kScript =
+      R"(
+      import 'dart:typed_data';
+
+      void foo(Int32List a, Int32List b, Int32List c, int n) {
+        for (int i = 0; i < n; i++) {
+          c[i] = a[i] ^ b[i];
+        }
+      }
+
+      main() {
+        final a = Int32List(16);
+        foo(a, a, a, 16);
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = VectorizeFoo(&pipeline);
+  EXPECT_EQ(1, CountSimdOps(flow_graph));
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Reduction) {
+  const char* kScript =
+      R"(
+      import 'dart:typed_data';
+
+      double foo(Float64List a, int n) {
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      main() {
+        foo(Float64List(16), 16);
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = VectorizeFoo(&pipeline);
+
+  // Loop carried values other than the induction are not widened.
+  EXPECT_EQ(0, CountSimdOps(flow_graph));
+}
+
+#endif  // defined(TARGET_ARCH_IS_64_BIT)
+
+}  // namespace dart
@@ -0,0 +1,318 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_versioner.h"
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_printer.h"
+#include "vm/compiler/backend/loop_cloner.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/compiler/backend/range_analysis.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_versioning,
+            false,
+            "Version loops to remove bounds checks that cannot be proven "
+            "redundant at compile time.");
+DEFINE_FLAG(int,
+            loop_versioning_max_size,
+            128,
+            "Maximal number of instructions of a versioned loop.");
+DEFINE_FLAG(bool, trace_loop_versioning, false, "Trace loop versioning.");
+
+DECLARE_FLAG(bool, array_bounds_check_elimination);
+
+// Quick access to the current zone.
+#define Z (flow_graph_->zone())
+
+// Returns true if the given definition is an integer that can be compared
+// without speculation.
+static bool IsIntegerValue(Definition* def) {
+  switch (def->representation()) {
+    case kUnboxedInt32:
+    case kUnboxedUint32:
+    case kUnboxedInt64:
+      return true;
+    case kTagged:
+      return def->Type()->IsInt();
+    default:
+      return false;
+  }
+}
+
+// Returns true if the range of the given definition shows that adding the
+// offset to it cannot wrap around, as in SafelyAdjust of the induction
+// analysis.
+static bool CanAddWithoutOverflow(Definition* def, int64_t offset) {
+  if (offset == 0) {
+    return true;
+  }
+  const int64_t min = Range::ConstantMin(def->range()).ConstantValue();
+  const int64_t max = Range::ConstantMax(def->range()).ConstantValue();
+  return !Utils::WillAddOverflow(min, offset) &&
+         !Utils::WillAddOverflow(max, offset);
+}
+
+// Splits a loop invariant induction into a definition and a constant
+// offset. The definition is null for a constant. The guards compare the
+// definition, so def + offset must be the exact value of the induction.
+static bool SplitInvariant(InductionVar* x,
+                           Definition** def,
+                           int64_t* offset) {
+  if (!InductionVar::IsInvariant(x) || !Utils::IsInt(32, x->offset())) {
+    return false;
+  }
+  *offset = x->offset();
+  if (x->mult() == 0) {
+    *def = nullptr;
+    return true;
+  }
+  *def = x->def();
+  return x->mult() == 1 && IsIntegerValue(x->def()) &&
+         CanAddWithoutOverflow(x->def(), x->offset());
+}
+
+// Versioning of a single loop.
+class LoopVersioning : public ZoneAllocated {
+ public:
+  LoopVersioning(FlowGraph* flow_graph, LoopInfo* loop)
+      : flow_graph_(flow_graph),
+        cloner_(new LoopCloner(flow_graph, loop)),
+        checks_(),
+        lower_bounds_(),
+        upper_bounds_() {}
+
+  // Collects the bounds checks that can be removed from a copy of the loop
+  // and the guards of the copy. Returns false if the loop is not versioned.
+  bool Analyze();
+
+  // Inserts the guards and the copy of the loop without the checks.
+  void Transform();
+
+  void FixupPhis() { cloner_->FixupPhis(); }
+
+  LoopInfo* loop() const { return cloner_->loop(); }
+  intptr_t check_count() const { return checks_.length(); }
+
+ private:
+  // Guard min <= def.
+  struct LowerBound {
+    Definition* def;
+    int64_t min;
+  };
+
+  // Guard def + offset <= length, or offset <= length without def.
+  struct UpperBound {
+    Definition* def;
+    int64_t offset;
+    Definition* length;
+  };
+
+  bool AddCheck(CheckBoundBase* check);
+  void AddLowerBound(Definition* def, int64_t min);
+  void AddUpperBound(Definition* def, int64_t offset, Definition* length);
+  ComparisonInstr* NewCompare(Definition* left, Definition* right);
+  ConstantInstr* NewConstant(int64_t value);
+
+  FlowGraph* flow_graph_;
+  LoopCloner* cloner_;
+  GrowableArray<CheckBoundBase*> checks_;
+  GrowableArray<LowerBound> lower_bounds_;
+  GrowableArray<UpperBound> upper_bounds_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopVersioning);
+};
+
+bool LoopVersioning::Analyze() {
+  if (!cloner_->CanClone() ||
+      cloner_->size() > FLAG_loop_versioning_max_size ||
+      loop()->control() == nullptr) {
+    return false;
+  }
+  for (BitVector::Iterator it(loop()->blocks()); !it.Done(); it.Advance()) {
+    BlockEntryInstr* block = flow_graph_->preorder()[it.Current()];
+    for (ForwardInstructionIterator instr_it(block); !instr_it.Done();
+         instr_it.Advance()) {
+      CheckBoundBase* check = instr_it.Current()->AsCheckBoundBase();
+      if (check != nullptr && AddCheck(check)) {
+        checks_.Add(check);
+      }
+    }
+  }
+  // Checks that need no guard at all are left to range analysis.
+  return !checks_.is_empty() &&
+         !(lower_bounds_.is_empty() && upper_bounds_.is_empty());
+}
+
+bool LoopVersioning::AddCheck(CheckBoundBase* check) {
+  Definition* length = check->length()->definition();
+  if (loop()->Contains(length->GetBlock()) || !IsIntegerValue(length)) {
+    return false;
+  }
+
+  // The index must be a unit stride induction i - diff of the control i,
+  // under control of the exit test in the header, which runs in every
+  // iteration and keeps i from wrapping around.
+  InductionVar* control = loop()->control();
+  Definition* index_def = check->index()->definition();
+  InductionVar* index = loop()->LookupInduction(
+      index_def->OriginalDefinitionIgnoreBoxingAndConstraints());
+  int64_t stride = 0;
+  int64_t diff = 0;
+  if (!InductionVar::IsLinear(index, &stride) || Utils::Abs(stride) != 1 ||
+      !index->CanComputeDifferenceWith(control, &diff) ||
+      !Utils::IsInt(32, diff)) {
+    return false;
+  }
+  BranchInstr* exit_test = loop()->header()->last_instruction()->AsBranch();
+  InductionVar* limit = nullptr;
+  for (const auto& bound : control->bounds()) {
+    if (bound.branch_ == exit_test) {
+      limit = bound.limit_;
+    }
+  }
+  Definition* initial_def = nullptr;
+  Definition* limit_def = nullptr;
+  int64_t initial_offset = 0;
+  int64_t limit_offset = 0;
+  if (limit == nullptr || !check->IsDominatedBy(exit_test) ||
+      !SplitInvariant(control->initial(), &initial_def, &initial_offset) ||
+      !SplitInvariant(limit, &limit_def, &limit_offset)) {
+    return false;
+  }
+
+  // The control is in [initial, limit - 1] when counting up, and in
+  // [limit + 1, initial] when counting down, so the index is within the
+  // bounds if 0 <= min - diff and max - diff + 1 <= length.
+  Definition* min_def = initial_def;
+  int64_t min_offset = initial_offset;
+  Definition* max_def = limit_def;
+  int64_t max_offset = limit_offset - 1;
+  if (stride < 0) {
+    min_def = limit_def;
+    min_offset = limit_offset + 1;
+    max_def = initial_def;
+    max_offset = initial_offset;
+  }
+  const int64_t lower = diff - min_offset;
+  const int64_t upper = max_offset - diff + 1;
+  if (!Smi::IsValid(lower) || !Smi::IsValid(upper) ||
+      (min_def == nullptr && lower > 0)) {
+    return false;
+  }
+  if (min_def != nullptr) {
+    AddLowerBound(min_def, lower);
+  }
+  if (max_def != nullptr || upper > 0) {
+    AddUpperBound(max_def, upper, length);
+  }
+  return true;
+}
+
+void LoopVersioning::AddLowerBound(Definition* def, int64_t min) {
+  for (const LowerBound& bound : lower_bounds_) {
+    if (bound.def == def && bound.min == min) {
+      return;
+    }
+  }
+  lower_bounds_.Add({def, min});
+}
+
+void LoopVersioning::AddUpperBound(Definition* def,
+                                   int64_t offset,
+                                   Definition* length) {
+  for (const UpperBound& bound : upper_bounds_) {
+    if (bound.def == def && bound.offset == offset && bound.length == length) {
+      return;
+    }
+  }
+  upper_bounds_.Add({def, offset, length});
+}
+
+ComparisonInstr* LoopVersioning::NewCompare(Definition* left,
+                                            Definition* right) {
+  return new (Z) RelationalOpInstr(
+      loop()->header()->last_instruction()->token_pos(), Token::kLTE,
+      new (Z) Value(left), new (Z) Value(right), kMintCid, DeoptId::kNone,
+      Instruction::kNotSpeculative);
+}
+
+ConstantInstr* LoopVersioning::NewConstant(int64_t value) {
+  return flow_graph_->GetConstant(Smi::ZoneHandle(Z, Smi::New(value)));
+}
+
+void LoopVersioning::Transform() {
+  GrowableArray<ComparisonInstr*> guards;
+  for (const LowerBound& bound : lower_bounds_) {
+    guards.Add(NewCompare(NewConstant(bound.min), bound.def));
+  }
+  for (const UpperBound& bound : upper_bounds_) {
+    if (bound.def == nullptr) {
+      guards.Add(NewCompare(NewConstant(bound.offset), bound.length));
+      continue;
+    }
+    // Lengths are small enough for the adjustment not to overflow.
+    Definition* length = bound.length;
+    if (bound.offset != 0) {
+      length = new (Z) BinaryInt64OpInstr(
+          Token::kSUB, new (Z) Value(length),
+          new (Z) Value(NewConstant(bound.offset)), DeoptId::kNone,
+          Instruction::kNotSpeculative);
+      flow_graph_->InsertBefore(cloner_->pre_header_goto(), length, nullptr,
+                                FlowGraph::kValue);
+    }
+    guards.Add(NewCompare(bound.def, length));
+  }
+  cloner_->Version(guards, checks_);
+}
+
+intptr_t LoopVersioner::Optimize(FlowGraph* flow_graph) {
+  if (!FLAG_loop_versioning || !FLAG_array_bounds_check_elimination ||
+      flow_graph->IsCompiledForOsr()) {
+    return 0;
+  }
+
+  // Range analysis has removed its constraints since the induction was
+  // last computed.
+  flow_graph->ResetLoopHierarchy();
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  loop_hierarchy.ComputeInduction();
+
+  // Analyze all loops before changing the graph.
+  GrowableArray<LoopVersioning*> candidates;
+  const ZoneGrowableArray<BlockEntryInstr*>& headers = loop_hierarchy.headers();
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    LoopVersioning* candidate =
+        new LoopVersioning(flow_graph, headers[i]->loop_info());
+    if (candidate->Analyze()) {
+      candidates.Add(candidate);
+    }
+  }
+  if (candidates.is_empty()) {
+    return 0;
+  }
+
+  intptr_t removed = 0;
+  for (LoopVersioning* candidate : candidates) {
+    if (FLAG_support_il_printer && FLAG_trace_loop_versioning) {
+      THR_Print("Versioning loop %s on %" Pd " bounds checks in %s\n",
+                candidate->loop()->ToCString(), candidate->check_count(),
+                flow_graph->function().ToFullyQualifiedCString());
+    }
+    candidate->Transform();
+    removed += candidate->check_count();
+  }
+  flow_graph->DiscoverBlocks();
+  for (LoopVersioning* candidate : candidates) {
+    candidate->FixupPhis();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+  return removed;
+}
+
+}  // namespace dart
@@ -0,0 +1,42 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+
+namespace dart {
+
+class FlowGraph;
+
+// Versions innermost countable loops to remove the bounds checks that range
+// analysis could not prove redundant.
+//
+// A bounds check on a unit stride induction of the loop control is
+// redundant if the range of the induction, which is bounded by the loop
+// invariant initial value and limit of the loop, lies within the length of
+// the array. When the length cannot be related to the limit at compile time
+// (e.g. the limit is a parameter), the comparison is made once in front of
+// the loop:
+//
+//   if (0 <= initial && limit <= length) {
+//     loop without bounds checks
+//   } else {
+//     original loop
+//   }
+//
+class LoopVersioner : public AllStatic {
+ public:
+  // Returns the number of bounds checks removed from the fast copies.
+  static intptr_t Optimize(FlowGraph* flow_graph);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
@@ -0,0 +1,177 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_versioner.h"
+
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, loop_versioning);
+
+// Helper method to count instructions with the given tag.
+static intptr_t CountInstructions(FlowGraph* flow_graph,
+                                  Instruction::Tag tag) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->tag() == tag) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// If the guard fails for the arguments passed by check, the original loop
+// runs and deoptimizes on its bounds check.
+static void TestVersionedLoop(const char* script,
+                              intptr_t expected,
+                              bool guard_holds = true) {
+  const auto& root_library = Library::Handle(LoadTestScript(script));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+
+  // Pretend that a generalized bounds check deoptimized before, so that
+  // range analysis leaves the bounds check in the loop.
+  function.SetProhibitsBoundsCheckGeneralization(true);
+  SetFlagScope<bool> sfs(&FLAG_loop_versioning, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // Only the original loop keeps its bounds check.
+  EXPECT_EQ(2, CountInstructions(flow_graph, Instruction::kLoadIndexed));
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kCheckArrayBound));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(expected, Smi::Cast(result).Value());
+  if (guard_holds) {
+    // Ensure we didn't deoptimize to unoptimized code.
+    EXPECT(function.unoptimized_code() == Code::null());
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_CountUp) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a, int n) {
+        int m = n & 0xff;
+        int sum = 0;
+        for (int i = 0; i < m; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      int check() => foo(List<int>.filled(8, 2), 5);
+
+      main() {
+        check();
+      }
+      )";
+  TestVersionedLoop(kScript, 10);
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_CountDown) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a, int n) {
+        int m = n & 0xff;
+        int sum = 0;
+        for (int i = m - 1; i >= 0; i--) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      int check() => foo(List<int>.filled(8, 3), 4);
+
+      main() {
+        check();
+      }
+      )";
+  TestVersionedLoop(kScript, 12);
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_GuardFails) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a, int n) {
+        int m = n & 0xff;
+        int sum = 0;
+        for (int i = 0; i < m; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      int check() {
+        try {
+          foo(List<int>.filled(8, 2), 10);
+        } on RangeError {
+          return -1;
+        }
+        return 0;
+      }
+
+      main() {
+        foo(List<int>.filled(8, 2), 5);
+      }
+      )";
+  TestVersionedLoop(kScript, -1, /*guard_holds=*/false);
+}
+
+// The initial value n + 5 wraps around for large n, so a guard on n does
+// not bound the index and the loop is not versioned.
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_InitialOverflow) {
+  const char* kScript =
+      R"(
+      int foo(List<int> a, int n) {
+        int sum = 0;
+        for (int i = n + 5; i < 10; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+
+      int check() {
+        try {
+          foo(List<int>.filled(10, 2), 9223372036854775805);
+        } on RangeError {
+          return -1;
+        }
+        return 0;
+      }
+
+      main() {
+        foo(List<int>.filled(10, 2), 0);
+      }
+      )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+
+  function.SetProhibitsBoundsCheckGeneralization(true);
+  SetFlagScope<bool> sfs(&FLAG_loop_versioning, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kLoadIndexed));
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kCheckArrayBound));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(-1, Smi::Cast(result).Value());
+}
+
+}  // namespace dart
@@ -1355,6 +1355,7 @@ void RangeAnalysis::EliminateRedundantBoundsChecks() {
       if (check->IsRedundant(/*use_loops=*/true)) {
         check->ReplaceUsesWith(check->index()->definition());
         check->RemoveFromGraph();
+        eliminated_bounds_checks_++;
       } else if (try_generalization) {
         if (auto jit_check = check->AsCheckArrayBound()) {
           generalizer.TryGeneralize(jit_check);
@@ -552,7 +552,8 @@ class RangeAnalysis : public ValueObject {
   explicit RangeAnalysis(FlowGraph* flow_graph)
       : flow_graph_(flow_graph),
         smi_range_(Range::Full(RangeBoundary::kRangeBoundarySmi)),
-        int64_range_(Range::Full(RangeBoundary::kRangeBoundaryInt64)) {}
+        int64_range_(Range::Full(RangeBoundary::kRangeBoundaryInt64)),
+        eliminated_bounds_checks_(0) {}
 
   // Infer ranges for all values and remove overflow checks from binary smi
   // operations when proven redundant.
@@ -571,6 +572,11 @@ class RangeAnalysis : public ValueObject {
 
   void AssignRangesRecursively(Definition* defn);
 
+  // Number of bounds checks proven redundant and removed.
+  intptr_t eliminated_bounds_checks() const {
+    return eliminated_bounds_checks_;
+  }
+
  private:
   enum JoinOperator { NONE, WIDEN, NARROW };
   static char OpPrefix(JoinOperator op);
@@ -655,6 +661,8 @@ class RangeAnalysis : public ValueObject {
   // in the reverse postorder.
   GrowableArray<Definition*> definitions_;
 
+  intptr_t eliminated_bounds_checks_;
+
   DISALLOW_COPY_AND_ASSIGN(RangeAnalysis);
 };
 
@@ -15,11 +15,25 @@
 namespace dart {
 
 DEFINE_FLAG(bool, dead_store_elimination, true, "Eliminate dead stores");
+DEFINE_FLAG(bool,
+            gvn_pre,
+            false,
+            "Eliminate partially redundant loads, checks and arithmetic.");
 DEFINE_FLAG(bool, load_cse, true, "Use redundant load elimination.");
 DEFINE_FLAG(bool,
             optimize_lazy_initializer_calls,
             true,
             "Eliminate redundant lazy initializer calls.");
+DEFINE_FLAG(bool,
+            partial_escape_analysis,
+            false,
+            "Sink allocations into the branches where they escape.");
+DEFINE_FLAG(bool,
+            print_gvn_pre_stats,
+            false,
+            "Print the number of instructions removed and moved by partial "
+            "redundancy elimination and the size of the graph before and "
+            "after it.");
 DEFINE_FLAG(bool,
             trace_load_optimization,
             false,
@@ -2680,6 +2694,421 @@ bool DominatorBasedCSE::OptimizeRecursive(FlowGraph* graph,
   return changed;
 }
 
+// Moves partially redundant instructions out of joins, see
+// PartialRedundancyElimination.
+class PartialRedundancyEliminator : public ValueObject {
+ public:
+  PartialRedundancyEliminator(FlowGraph* graph, AliasedSet* aliased_set)
+      : graph_(graph),
+        aliased_set_(aliased_set),
+        moved_(),
+        removed_count_(0),
+        moved_count_(0),
+        phi_count_(0) {}
+
+  ~PartialRedundancyEliminator() {
+    if (aliased_set_ != nullptr) {
+      aliased_set_->RollbackAliasedIdentites();
+    }
+  }
+
+  Zone* zone() const { return graph_->zone(); }
+
+  bool Optimize();
+
+  intptr_t removed_count() const { return removed_count_; }
+  intptr_t moved_count() const { return moved_count_; }
+  intptr_t phi_count() const { return phi_count_; }
+
+ private:
+  typedef RawPointerKeyValueTrait<Instruction, bool> MovedKV;
+
+  static const intptr_t kUnknownPlace = -1;
+
+  // Loads that may be affected by stores and calls.
+  bool IsLoad(Instruction* instr) const {
+    return !instr->AllowsCSE() && IsLoadEliminationCandidate(instr);
+  }
+
+  bool IsCandidate(Instruction* instr) const;
+  intptr_t LookupPlaceId(Instruction* load) const;
+  bool MayKill(Instruction* instr, intptr_t place_id) const;
+  bool MayKillAfter(Instruction* from, intptr_t place_id) const;
+  bool IsKilledBefore(Instruction* load, BlockEntryInstr* block) const;
+  bool CanMoveToStart(JoinEntryInstr* join, Instruction* instr) const;
+  bool CanTranslateEnvironment(JoinEntryInstr* join, Instruction* instr) const;
+  Definition* Translate(JoinEntryInstr* join,
+                        intptr_t pred_index,
+                        Definition* def) const;
+  Instruction* FindAvailable(Instruction* instr,
+                             const GrowableArray<Definition*>& inputs,
+                             BlockEntryInstr* pred) const;
+  bool TryEliminate(ForwardInstructionIterator* it, JoinEntryInstr* join);
+  void MoveToPredecessor(ForwardInstructionIterator* it,
+                         JoinEntryInstr* join,
+                         intptr_t pred_index);
+
+  FlowGraph* graph_;
+
+  // Places of the loads, or null if loads are not optimized.
+  AliasedSet* aliased_set_;
+
+  // Instructions that were already moved, which are not moved again.
+  DirectChainedHashMap<MovedKV> moved_;
+
+  intptr_t removed_count_;
+  intptr_t moved_count_;
+  intptr_t phi_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PartialRedundancyEliminator);
+};
+
+bool PartialRedundancyEliminator::IsCandidate(Instruction* instr) const {
+  if (instr->InputCount() == 0 || instr->HasUnknownSideEffects() ||
+      moved_.HasKey(instr)) {
+    return false;
+  }
+  // Untagged addresses must not be kept alive across instructions that can
+  // trigger a GC.
+  Definition* defn = instr->AsDefinition();
+  if ((defn != nullptr) && (defn->representation() == kUntagged)) {
+    return false;
+  }
+  if (instr->AllowsCSE()) {
+    return true;
+  }
+  return (aliased_set_ != nullptr) && IsLoadEliminationCandidate(instr);
+}
+
+intptr_t PartialRedundancyEliminator::LookupPlaceId(Instruction* load) const {
+  bool is_load = false, is_store = false;
+  Place place(load, &is_load, &is_store);
+  ASSERT(is_load);
+  Place* canonical = aliased_set_->LookupCanonical(&place);
+  return (canonical != nullptr) ? canonical->id() : kUnknownPlace;
+}
+
+bool PartialRedundancyEliminator::MayKill(Instruction* instr,
+                                          intptr_t place_id) const {
+  if (instr->HasUnknownSideEffects()) {
+    return aliased_set_->aliased_by_effects()->Contains(place_id);
+  }
+  bool is_load = false, is_store = false;
+  Place place(instr, &is_load, &is_store);
+  if (!is_store) {
+    return false;
+  }
+  const intptr_t alias_id = aliased_set_->LookupAliasId(place.ToAlias());
+  if (alias_id == AliasedSet::kNoAlias) {
+    return true;
+  }
+  BitVector* killed = aliased_set_->GetKilledSet(alias_id);
+  return (killed != nullptr) && killed->Contains(place_id);
+}
+
+// Returns true if an instruction after [from] in its block may change the
+// value of the place.
+bool PartialRedundancyEliminator::MayKillAfter(Instruction* from,
+                                               intptr_t place_id) const {
+  for (Instruction* instr = from->next(); instr != nullptr;
+       instr = instr->next()) {
+    if (MayKill(instr, place_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if the value of [load] may be changed before the end of
+// [block], which is dominated by the load.
+bool PartialRedundancyEliminator::IsKilledBefore(
+    Instruction* load,
+    BlockEntryInstr* block) const {
+  const intptr_t place_id = LookupPlaceId(load);
+  if ((place_id == kUnknownPlace) || MayKillAfter(load, place_id)) {
+    return true;
+  }
+
+  // All blocks on the paths from the load to the block are dominated by the
+  // block of the load, so a backwards walk that stops there finds them all.
+  BlockEntryInstr* load_block = load->GetBlock();
+  if (block == load_block) {
+    return false;
+  }
+  BitVector* visited = new (Z) BitVector(Z, graph_->preorder().length());
+  GrowableArray<BlockEntryInstr*> worklist;
+  visited->Add(block->preorder_number());
+  worklist.Add(block);
+  while (!worklist.is_empty()) {
+    BlockEntryInstr* current = worklist.RemoveLast();
+    if (MayKillAfter(current, place_id)) {
+      return true;
+    }
+    for (intptr_t i = 0; i < current->PredecessorCount(); i++) {
+      BlockEntryInstr* pred = current->PredecessorAt(i);
+      if ((pred != load_block) &&
+          !visited->Contains(pred->preorder_number())) {
+        visited->Add(pred->preorder_number());
+        worklist.Add(pred);
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if [instr] can be executed in front of the instructions that
+// precede it in the join.
+bool PartialRedundancyEliminator::CanMoveToStart(JoinEntryInstr* join,
+                                                 Instruction* instr) const {
+  const bool is_load = IsLoad(instr);
+  const intptr_t place_id = is_load ? LookupPlaceId(instr) : kUnknownPlace;
+  if (is_load && (place_id == kUnknownPlace)) {
+    return false;
+  }
+  // A deoptimization or exception must remain the first visible effect.
+  const bool has_effect = instr->CanDeoptimize() || instr->MayThrow();
+  for (Instruction* current = join->next(); current != instr;
+       current = current->next()) {
+    if (is_load && MayKill(current, place_id)) {
+      return false;
+    }
+    if (has_effect &&
+        (current->CanDeoptimize() || MayHaveVisibleEffect(current))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PartialRedundancyEliminator::CanTranslateEnvironment(
+    JoinEntryInstr* join,
+    Instruction* instr) const {
+  for (Environment::DeepIterator it(instr->env()); !it.Done(); it.Advance()) {
+    if (Translate(join, 0, it.CurrentValue()->definition()) == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the value of [def] at the end of the given predecessor of the
+// join, or null if [def] is defined in the join.
+Definition* PartialRedundancyEliminator::Translate(JoinEntryInstr* join,
+                                                   intptr_t pred_index,
+                                                   Definition* def) const {
+  PhiInstr* phi = def->AsPhi();
+  if ((phi != nullptr) && (phi->block() == join)) {
+    return phi->InputAt(pred_index)->definition();
+  }
+  return (def->GetBlock() != join) ? def : nullptr;
+}
+
+// Finds an instruction equivalent to [instr] with the given [inputs] whose
+// value is available at the end of [pred].
+Instruction* PartialRedundancyEliminator::FindAvailable(
+    Instruction* instr,
+    const GrowableArray<Definition*>& inputs,
+    BlockEntryInstr* pred) const {
+  for (Value::Iterator it(inputs[0]->input_use_list()); !it.Done();
+       it.Advance()) {
+    Value* use = it.Current();
+    Instruction* other = use->instruction();
+    // Comparisons of branches are not linked into the graph.
+    if ((use->use_index() != 0) || (other == instr) ||
+        (other->tag() != instr->tag()) || (other->previous() == nullptr) ||
+        (other->InputCount() != instr->InputCount())) {
+      continue;
+    }
+    bool same_inputs = true;
+    for (intptr_t i = 1; i < inputs.length(); i++) {
+      if (other->InputAt(i)->definition() != inputs[i]) {
+        same_inputs = false;
+        break;
+      }
+    }
+    if (!same_inputs || !other->AttributesEqual(instr) ||
+        !other->GetBlock()->Dominates(pred)) {
+      continue;
+    }
+    if (IsLoad(instr) && IsKilledBefore(other, pred)) {
+      continue;
+    }
+    return other;
+  }
+  return nullptr;
+}
+
+bool PartialRedundancyEliminator::TryEliminate(ForwardInstructionIterator* it,
+                                               JoinEntryInstr* join) {
+  Instruction* instr = it->Current();
+  if (!IsCandidate(instr) || !CanMoveToStart(join, instr)) {
+    return false;
+  }
+
+  // Look for the value on every incoming edge. It may be missing on one.
+  const intptr_t pred_count = join->PredecessorCount();
+  GrowableArray<Instruction*> available(pred_count);
+  GrowableArray<Definition*> inputs(instr->InputCount());
+  intptr_t missing = -1;
+  for (intptr_t i = 0; i < pred_count; i++) {
+    inputs.Clear();
+    for (intptr_t j = 0; j < instr->InputCount(); j++) {
+      Definition* input = Translate(join, i, instr->InputAt(j)->definition());
+      if (input == nullptr) {
+        return false;
+      }
+      inputs.Add(input);
+    }
+    Instruction* other = FindAvailable(instr, inputs, join->PredecessorAt(i));
+    if (other == nullptr) {
+      if (missing >= 0) {
+        return false;
+      }
+      missing = i;
+    }
+    available.Add(other);
+  }
+  if (missing >= 0) {
+    BlockEntryInstr* pred = join->PredecessorAt(missing);
+    if (!pred->last_instruction()->IsGoto() ||
+        (pred->try_index() != join->try_index()) ||
+        !CanTranslateEnvironment(join, instr)) {
+      return false;
+    }
+  }
+
+  // Uses of the instruction are replaced by a phi of the available values.
+  Definition* defn = instr->AsDefinition();
+  PhiInstr* phi = nullptr;
+  if ((defn != nullptr) && defn->HasUses()) {
+    phi = new (Z) PhiInstr(join, pred_count);
+    phi->set_representation(defn->representation());
+    graph_->AllocateSSAIndexes(phi);
+    phi->mark_alive();
+    defn->ReplaceUsesWith(phi);
+  }
+  if (missing >= 0) {
+    MoveToPredecessor(it, join, missing);
+    available[missing] = instr;
+  } else {
+    if (FLAG_trace_optimization) {
+      THR_Print("Removing redundant %s from B%" Pd "\n", instr->ToCString(),
+                join->block_id());
+    }
+    it->RemoveCurrentFromGraph();
+    removed_count_++;
+  }
+  if (phi != nullptr) {
+    for (intptr_t i = 0; i < pred_count; i++) {
+      Value* input = new (Z) Value(available[i]->AsDefinition());
+      phi->SetInputAt(i, input);
+      input->definition()->AddInputUse(input);
+    }
+    join->InsertPhi(phi);
+    phi->RecomputeType();
+    phi_count_++;
+  }
+  return true;
+}
+
+void PartialRedundancyEliminator::MoveToPredecessor(
+    ForwardInstructionIterator* it,
+    JoinEntryInstr* join,
+    intptr_t pred_index) {
+  Instruction* instr = it->Current();
+  BlockEntryInstr* pred = join->PredecessorAt(pred_index);
+  if (FLAG_trace_optimization) {
+    THR_Print("Moving partially redundant %s from B%" Pd " to B%" Pd "\n",
+              instr->ToCString(), join->block_id(), pred->block_id());
+  }
+  // The instruction keeps its deoptimization target: nothing with a visible
+  // effect happens between the end of the predecessor and its old position.
+  Environment* env = instr->env();
+  instr->RemoveEnvironment();
+  it->RemoveCurrentFromGraph();
+  for (intptr_t i = 0; i < instr->InputCount(); i++) {
+    Value* input = instr->InputAt(i);
+    input->set_definition(Translate(join, pred_index, input->definition()));
+    input->SetReachingType(nullptr);
+  }
+  graph_->InsertBefore(pred->last_instruction(), instr, env,
+                       FlowGraph::kEffect);
+  for (Environment::DeepIterator env_it(instr->env()); !env_it.Done();
+       env_it.Advance()) {
+    Value* value = env_it.CurrentValue();
+    Definition* def = Translate(join, pred_index, value->definition());
+    if (def != value->definition()) {
+      value->BindToEnvironment(def);
+    }
+  }
+  moved_.Insert(MovedKV::Pair(instr, true));
+  moved_count_++;
+}
+
+bool PartialRedundancyEliminator::Optimize() {
+  bool changed = false;
+  for (BlockIterator block_it = graph_->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    JoinEntryInstr* join = block_it.Current()->AsJoinEntry();
+    if ((join == nullptr) || (join->PredecessorCount() < 2)) {
+      continue;
+    }
+    for (ForwardInstructionIterator it(join); !it.Done(); it.Advance()) {
+      changed = TryEliminate(&it, join) || changed;
+    }
+  }
+  return changed;
+}
+
+// Number of instructions and phis in the graph.
+static intptr_t GraphSize(FlowGraph* graph) {
+  intptr_t size = 0;
+  for (BlockIterator block_it = graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    if (JoinEntryInstr* join = block_it.Current()->AsJoinEntry()) {
+      for (PhiIterator it(join); !it.Done(); it.Advance()) {
+        size++;
+      }
+    }
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      size++;
+    }
+  }
+  return size;
+}
+
+bool PartialRedundancyElimination::Optimize(FlowGraph* graph) {
+  if (!FLAG_gvn_pre) {
+    return false;
+  }
+
+  // Loads are only moved when load forwarding is enabled, with the same
+  // limit on the size of the function.
+  DirectChainedHashMap<PointerKeyValueTrait<Place> > map;
+  AliasedSet* aliased_set = nullptr;
+  const intptr_t function_length = graph->function().end_token_pos().Pos() -
+                                   graph->function().token_pos().Pos();
+  if (FLAG_load_cse && (function_length < FLAG_huge_method_cutoff_in_tokens)) {
+    aliased_set = NumberPlaces(graph, &map, kOptimizeLoads);
+    if ((aliased_set != nullptr) && aliased_set->IsEmpty()) {
+      aliased_set = nullptr;
+    }
+  }
+
+  const intptr_t size_before = FLAG_print_gvn_pre_stats ? GraphSize(graph) : 0;
+  PartialRedundancyEliminator eliminator(graph, aliased_set);
+  const bool changed = eliminator.Optimize();
+  if (FLAG_print_gvn_pre_stats) {
+    THR_Print("GVN-PRE in %s: %" Pd " removed, %" Pd " moved, %" Pd
+              " phis, size %" Pd " -> %" Pd "\n",
+              graph->function().ToFullyQualifiedCString(),
+              eliminator.removed_count(), eliminator.moved_count(),
+              eliminator.phi_count(), size_before, GraphSize(graph));
+  }
+  return changed;
+}
+
 class StoreOptimizer : public LivenessAnalysis {
  public:
   StoreOptimizer(FlowGraph* graph,
@@ -3190,7 +3619,276 @@ void AllocationSinking::DiscoverFailedCandidates() {
   candidates_.TruncateTo(j);
 }
 
+// Add given instruction to the list of the instructions if it is not yet
+// present there.
+template <typename T>
+void AddInstruction(GrowableArray<T*>* list, T* value) {
+  ASSERT(!value->IsGraphEntry() && !value->IsFunctionEntry());
+  for (intptr_t i = 0; i < list->length(); i++) {
+    if ((*list)[i] == value) {
+      return;
+    }
+  }
+  list->Add(value);
+}
+
+// Returns true if the given instruction uses the given definition as an
+// input or in its environment.
+static bool UsesDefinition(Instruction* instr, Definition* def) {
+  for (intptr_t i = 0; i < instr->InputCount(); i++) {
+    if (instr->InputAt(i)->definition() == def) {
+      return true;
+    }
+  }
+  if (instr->env() != nullptr) {
+    for (Environment::DeepIterator it(instr->env()); !it.Done(); it.Advance()) {
+      if (it.CurrentValue()->definition() == def) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Find the initializing store of the given slot.
+static StoreInstanceFieldInstr* FindStore(
+    const GrowableArray<StoreInstanceFieldInstr*>& stores,
+    const Slot& slot) {
+  for (StoreInstanceFieldInstr* store : stores) {
+    if (&store->slot() == &slot) {
+      return store;
+    }
+  }
+  return nullptr;
+}
+
+// Returns true if the given use of an allocation reads one of the fields
+// initialized by the given stores.
+static bool IsInitializedLoad(
+    Value* use,
+    const GrowableArray<StoreInstanceFieldInstr*>& stores) {
+  LoadFieldInstr* load = use->instruction()->AsLoadField();
+  return (load != nullptr) && !load->calls_initializer() &&
+         (FindStore(stores, load->slot()) != nullptr);
+}
+
+void AllocationSinking::SinkPartiallyEscapingAllocations() {
+  GrowableArray<AllocateObjectInstr*> allocations;
+  GrowableArray<BoxInstr*> boxes;
+  for (BlockIterator block_it = flow_graph_->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      Instruction* current = it.Current();
+      if (AllocateObjectInstr* alloc = current->AsAllocateObject()) {
+        allocations.Add(alloc);
+      } else if (BoxInstr* box = current->AsBox()) {
+        if (box->from_representation() == kUnboxedDouble ||
+            box->from_representation() == kUnboxedInt64) {
+          boxes.Add(box);
+        }
+      }
+    }
+  }
+  for (AllocateObjectInstr* alloc : allocations) {
+    SinkIntoEscapes(alloc);
+  }
+  for (BoxInstr* box : boxes) {
+    SinkBox(box);
+  }
+}
+
+// An allocation whose fields are only written by stores in the block of the
+// allocation can be allocated again at an escaping use, if no other use of
+// the allocation can be reached from that use (without allocating the
+// object anew). Loads of the fields then read the stored values, and the
+// original allocation remains for the non-escaping paths.
+bool AllocationSinking::SinkIntoEscapes(AllocateObjectInstr* alloc) {
+  BlockEntryInstr* block = alloc->GetBlock();
+
+  // Collect the stores that initialize the allocation. Any other use in
+  // the block of the allocation escapes on every path.
+  GrowableArray<StoreInstanceFieldInstr*> stores;
+  GrowableArray<LoadFieldInstr*> loads;
+  for (Instruction* instr = alloc->next(); instr != nullptr;
+       instr = instr->next()) {
+    for (intptr_t i = 0; i < instr->InputCount(); i++) {
+      Value* use = instr->InputAt(i);
+      if (use->definition() != alloc) {
+        continue;
+      }
+      StoreInstanceFieldInstr* store = instr->AsStoreInstanceField();
+      if ((store != nullptr) && (use == store->instance()) &&
+          (FindStore(stores, store->slot()) == nullptr)) {
+        stores.Add(store);
+      } else if (IsInitializedLoad(use, stores)) {
+        loads.Add(instr->AsLoadField());
+      } else {
+        return false;
+      }
+    }
+  }
+
+  // Collect the escaping uses, and the blocks of all uses.
+  GrowableArray<Instruction*> escapes;
+  BitVector* use_blocks =
+      new (Z) BitVector(Z, flow_graph_->preorder().length());
+  for (Value::Iterator it(alloc->input_use_list()); !it.Done(); it.Advance()) {
+    Value* use = it.Current();
+    Instruction* instr = use->instruction();
+    if (instr->IsPhi()) {
+      return false;
+    }
+    BlockEntryInstr* use_block = instr->GetBlock();
+    use_blocks->Add(use_block->preorder_number());
+    if (use_block == block) {
+      continue;
+    }
+    StoreInstanceFieldInstr* store = instr->AsStoreInstanceField();
+    if ((store != nullptr) && (use == store->instance())) {
+      return false;
+    }
+    if (IsInitializedLoad(use, stores)) {
+      loads.Add(instr->AsLoadField());
+    } else {
+      AddInstruction(&escapes, instr);
+    }
+  }
+  if (escapes.is_empty()) {
+    return false;
+  }
+  for (Value::Iterator it(alloc->env_use_list()); !it.Done(); it.Advance()) {
+    use_blocks->Add(it.Current()->instruction()->GetBlock()->preorder_number());
+  }
+
+  // Once escaped, the object must not be used again, neither in the rest of
+  // the block of the escape nor in any block reachable from it.
+  GrowableArray<BlockEntryInstr*> worklist;
+  BitVector* visited = new (Z) BitVector(Z, flow_graph_->preorder().length());
+  for (Instruction* escape : escapes) {
+    for (Instruction* instr = escape->next(); instr != nullptr;
+         instr = instr->next()) {
+      if (UsesDefinition(instr, alloc)) {
+        return false;
+      }
+    }
+    visited->Clear();
+    worklist.Clear();
+    worklist.Add(escape->GetBlock());
+    while (!worklist.is_empty()) {
+      Instruction* last = worklist.RemoveLast()->last_instruction();
+      for (intptr_t i = 0; i < last->SuccessorCount(); i++) {
+        BlockEntryInstr* succ = last->SuccessorAt(i);
+        if ((succ == block) || visited->Contains(succ->preorder_number())) {
+          continue;
+        }
+        if (use_blocks->Contains(succ->preorder_number())) {
+          return false;
+        }
+        visited->Add(succ->preorder_number());
+        worklist.Add(succ);
+      }
+    }
+  }
+
+  if (FLAG_trace_optimization) {
+    THR_Print("sinking allocation v%" Pd " into %" Pd " escapes\n",
+              alloc->ssa_temp_index(), escapes.length());
+  }
+
+  // Allocate and initialize the object right before each escape.
+  for (Instruction* escape : escapes) {
+    Value* type_arguments =
+        (alloc->type_arguments() != nullptr)
+            ? new (Z) Value(alloc->type_arguments()->definition())
+            : nullptr;
+    AllocateObjectInstr* copy = new (Z)
+        AllocateObjectInstr(alloc->token_pos(), alloc->cls(), type_arguments);
+    copy->set_closure_function(alloc->closure_function());
+    flow_graph_->InsertBefore(escape, copy, nullptr, FlowGraph::kValue);
+    for (StoreInstanceFieldInstr* store : stores) {
+      StoreInstanceFieldInstr* copy_store = new (Z) StoreInstanceFieldInstr(
+          store->slot(), new (Z) Value(copy),
+          new (Z) Value(store->value()->definition()),
+          store->ShouldEmitStoreBarrier() ? kEmitStoreBarrier : kNoStoreBarrier,
+          store->token_pos(),
+          store->is_initialization()
+              ? StoreInstanceFieldInstr::Kind::kInitializing
+              : StoreInstanceFieldInstr::Kind::kOther);
+      flow_graph_->InsertBefore(escape, copy_store, nullptr,
+                                FlowGraph::kEffect);
+    }
+    for (intptr_t i = 0; i < escape->InputCount(); i++) {
+      Value* use = escape->InputAt(i);
+      if (use->definition() == alloc) {
+        use->BindTo(copy);
+      }
+    }
+    escape->ReplaceInEnvironment(alloc, copy);
+  }
+
+  // Loads on the remaining paths read the initial values.
+  for (LoadFieldInstr* load : loads) {
+    load->ReplaceUsesWith(
+        FindStore(stores, load->slot())->value()->definition());
+    load->RemoveFromGraph();
+  }
+  return true;
+}
+
+// A box used in a single block other than its own is only needed when
+// that block is reached, unless the block is in a loop the box is not in.
+// Deoptimization environments refer to the unboxed value instead.
+void AllocationSinking::SinkBox(BoxInstr* box) {
+  BlockEntryInstr* block = box->GetBlock();
+  BlockEntryInstr* target = nullptr;
+  for (Value::Iterator it(box->input_use_list()); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current()->instruction();
+    if (instr->IsPhi()) {
+      return;
+    }
+    BlockEntryInstr* use_block = instr->GetBlock();
+    if ((use_block == block) ||
+        ((target != nullptr) && (use_block != target))) {
+      return;
+    }
+    target = use_block;
+  }
+  if (target == nullptr) {
+    return;
+  }
+  LoopInfo* loop = target->loop_info();
+  if ((loop != nullptr) && !loop->Contains(block)) {
+    return;
+  }
+  Instruction* first_use = nullptr;
+  for (ForwardInstructionIterator it(target); !it.Done(); it.Advance()) {
+    if (UsesDefinition(it.Current(), box)) {
+      first_use = it.Current();
+      break;
+    }
+  }
+  ASSERT(first_use != nullptr);
+
+  if (FLAG_trace_optimization) {
+    THR_Print("sinking box v%" Pd " from B%" Pd " into B%" Pd "\n",
+              box->ssa_temp_index(), block->block_id(), target->block_id());
+  }
+  Definition* value = box->value()->definition();
+  while (box->env_use_list() != nullptr) {
+    box->env_use_list()->BindToEnvironment(value);
+  }
+  box->RemoveFromGraph();
+  flow_graph_->InsertBefore(first_use, box, nullptr, FlowGraph::kEffect);
+}
+
 void AllocationSinking::Optimize() {
+  if (FLAG_partial_escape_analysis) {
+    // Uses loop information to avoid sinking boxes into loops.
+    flow_graph_->GetLoopHierarchy();
+    SinkPartiallyEscapingAllocations();
+  }
+
   CollectCandidates();
 
   // Insert MaterializeObject instructions that will describe the state of the
@@ -3350,19 +4048,6 @@ void AllocationSinking::CreateMaterializationAt(
   materializations_.Add(mat);
 }
 
-// Add given instruction to the list of the instructions if it is not yet
-// present there.
-template <typename T>
-void AddInstruction(GrowableArray<T*>* list, T* value) {
-  ASSERT(!value->IsGraphEntry() && !value->IsFunctionEntry());
-  for (intptr_t i = 0; i < list->length(); i++) {
-    if ((*list)[i] == value) {
-      return;
-    }
-  }
-  list->Add(value);
-}
-
 // Transitively collect all deoptimization exits that might need this allocation
 // rematerialized. It is not enough to collect only environment uses of this
 // allocation because it can flow into other objects that will be
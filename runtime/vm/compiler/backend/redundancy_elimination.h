@@ -56,6 +56,16 @@ class AllocationSinking : public ZoneAllocated {
     GrowableArray<Definition*> worklist_;
   };
 
+  // Partial escape analysis: allocations that escape only outside of their
+  // own block are allocated again right before each escaping use, so that
+  // the original allocation no longer escapes and can be sunk. Boxes used
+  // in a single other block are moved into that block.
+  void SinkPartiallyEscapingAllocations();
+
+  bool SinkIntoEscapes(AllocateObjectInstr* alloc);
+
+  void SinkBox(BoxInstr* box);
+
   void CollectCandidates();
 
   void NormalizeMaterializations();
@@ -97,6 +107,32 @@ class DominatorBasedCSE : public AllStatic {
                                 CSEInstructionMap* map);
 };
 
+// Partial redundancy elimination based on global value numbering.
+//
+// An instruction at the start of a join is partially redundant if an
+// equivalent instruction is available at the end of some but not all
+// predecessors of the join. Equivalence is decided on the value numbers of
+// the inputs after translating the phis of the join into their inputs on the
+// incoming edge, e.g. a.f is available on the first edge only in
+//
+//   if (c) { x = a.f; } else { ... }
+//   y = a.f;
+//
+// When the value is missing on a single edge, the instruction is moved to
+// the end of that predecessor and replaced by a phi of the available values,
+// so that no path executes more instructions than before. This also covers
+// values computed in front of a loop and recomputed in the loop header.
+//
+// Loads rely on the alias analysis of load forwarding to ensure that no
+// store or call in between changes the loaded value. Checks and other
+// instructions that can deoptimize or throw are only moved if nothing with
+// a visible effect precedes them in the join.
+class PartialRedundancyElimination : public AllStatic {
+ public:
+  // Returns true if the flow graph was changed.
+  static bool Optimize(FlowGraph* graph);
+};
+
 class DeadStoreElimination : public AllStatic {
  public:
   static void Optimize(FlowGraph* graph);
@@ -26,6 +26,9 @@
 
 namespace dart {
 
+DECLARE_FLAG(bool, gvn_pre);
+DECLARE_FLAG(bool, partial_escape_analysis);
+
 static void NoopNative(Dart_NativeArguments args) {}
 
 static Dart_NativeFunction NoopNativeLookup(Dart_Handle name,
@@ -1114,4 +1117,129 @@ ISOLATE_UNIT_TEST_CASE(LoadOptimizer_RedundantInitializerCallInLoop) {
   EXPECT(load_field_in_loop2->calls_initializer());
 }
 
+ISOLATE_UNIT_TEST_CASE(AllocationSinking_PartialEscape) {
+  const char* kScript = R"(
+    class Point {
+      final double x;
+      final double y;
+      Point(this.x, this.y);
+    }
+
+    dynamic sink;
+
+    @pragma('vm:never-inline')
+    void escape(Object o) {
+      sink = o;
+    }
+
+    double foo(double x, double y, bool rare) {
+      final p = Point(x, y);
+      final sum = p.x + p.y;
+      if (rare) {
+        escape(p);
+      }
+      return sum;
+    }
+
+    double check() => foo(1.0, 2.0, true) + (sink as Point).y;
+
+    main() {
+      foo(1.0, 2.0, false);
+      check();
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  SetFlagScope<bool> sfs(&FLAG_partial_escape_analysis, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  ASSERT(flow_graph != nullptr);
+
+  // The point is only allocated on the path where it escapes.
+  AllocateObjectInstr* alloc = nullptr;
+  ReturnInstr* ret = nullptr;
+  intptr_t alloc_count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsAllocateObject()) {
+        alloc = it.Current()->AsAllocateObject();
+        alloc_count++;
+      } else if (it.Current()->IsReturn()) {
+        ret = it.Current()->AsReturn();
+      }
+    }
+  }
+  EXPECT_EQ(1, alloc_count);
+  EXPECT(ret != nullptr);
+  EXPECT(alloc != nullptr &&
+         !alloc->GetBlock()->Dominates(ret->GetBlock()));
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsDouble());
+  EXPECT_EQ(5.0, Double::Cast(result).value());
+}
+
+ISOLATE_UNIT_TEST_CASE(PartialRedundancyElimination_LoadAfterIf) {
+  const char* kScript = R"(
+    class A {
+      int f;
+      A(this.f);
+    }
+
+    int foo(A a, bool c) {
+      int x = 0;
+      if (c) {
+        x = a.f;
+      }
+      return x + a.f;
+    }
+
+    int check() => foo(A(3), true) + foo(A(4), false);
+
+    main() {
+      foo(A(1), true);
+      foo(A(2), false);
+      check();
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  SetFlagScope<bool> sfs(&FLAG_gvn_pre, true);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  ASSERT(flow_graph != nullptr);
+
+  // The load after the if is moved into the else branch.
+  ReturnInstr* ret = nullptr;
+  GrowableArray<LoadFieldInstr*> loads;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsLoadField()) {
+        loads.Add(it.Current()->AsLoadField());
+      } else if (it.Current()->IsReturn()) {
+        ret = it.Current()->AsReturn();
+      }
+    }
+  }
+  EXPECT_EQ(2, loads.length());
+  EXPECT(ret != nullptr);
+  for (LoadFieldInstr* load : loads) {
+    EXPECT(!load->GetBlock()->Dominates(ret->GetBlock()));
+  }
+
+  pipeline.CompileGraphAndAttachFunction();
+  const auto& result = Object::Handle(Invoke(root_library, "check"));
+  EXPECT(result.IsSmi());
+  EXPECT_EQ(10, Smi::Cast(result).Value());
+}
+
 }  // namespace dart
@@ -13,6 +13,9 @@
 #include "vm/compiler/backend/il_serializer.h"
 #include "vm/compiler/backend/inliner.h"
 #include "vm/compiler/backend/linearscan.h"
+#include "vm/compiler/backend/loop_unroller.h"
+#include "vm/compiler/backend/loop_vectorizer.h"
+#include "vm/compiler/backend/loop_versioner.h"
 #include "vm/compiler/backend/range_analysis.h"
 #include "vm/compiler/backend/redundancy_elimination.h"
 #include "vm/compiler/backend/type_propagator.h"
@@ -63,6 +66,11 @@ DEFINE_FLAG(bool,
             late_round_trip_serialization,
             false,
             "Perform late round trip serialization compiler pass.");
+DEFINE_FLAG(bool,
+            print_bounds_check_stats,
+            false,
+            "Print the number of bounds checks eliminated in every optimized "
+            "function.");
 DECLARE_FLAG(bool, print_flow_graph);
 DECLARE_FLAG(bool, print_flow_graph_optimized);
 
@@ -321,15 +329,19 @@ FlowGraph* CompilerPass::RunPipeline(PipelineMode mode,
     INVOKE_PASS(OptimizeTypedDataAccesses);
   }
 #endif
+  INVOKE_PASS(UnrollLoops);
   INVOKE_PASS(WidenSmiToInt32);
   INVOKE_PASS(SelectRepresentations);
   INVOKE_PASS(CSE);
   INVOKE_PASS(LICM);
+  INVOKE_PASS(PRE);
   INVOKE_PASS(TryOptimizePatterns);
   INVOKE_PASS(DSE);
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(RangeAnalysis);
+  INVOKE_PASS(VersionLoops);
   INVOKE_PASS(OptimizeBranches);
+  INVOKE_PASS(VectorizeLoops);
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(TryCatchOptimization);
   INVOKE_PASS(EliminateEnvironments);
@@ -459,6 +471,8 @@ COMPILER_PASS(LICM, {
   flow_graph->RemoveRedefinitions(/*keep_checks*/ true);
 });
 
+COMPILER_PASS(PRE, { PartialRedundancyElimination::Optimize(flow_graph); });
+
 COMPILER_PASS(DSE, { DeadStoreElimination::Optimize(flow_graph); });
 
 COMPILER_PASS(RangeAnalysis, {
@@ -467,6 +481,7 @@ COMPILER_PASS(RangeAnalysis, {
   // making some phis smi.
   RangeAnalysis range_analysis(flow_graph);
   range_analysis.Analyze();
+  state->eliminated_bounds_checks += range_analysis.eliminated_bounds_checks();
 });
 
 COMPILER_PASS(OptimizeBranches, {
@@ -476,6 +491,14 @@ COMPILER_PASS(OptimizeBranches, {
   ConstantPropagator::OptimizeBranches(flow_graph);
 });
 
+COMPILER_PASS(UnrollLoops, { LoopUnroller::Optimize(flow_graph); });
+
+COMPILER_PASS(VectorizeLoops, { LoopVectorizer::Optimize(flow_graph); });
+
+COMPILER_PASS(VersionLoops, {
+  state->versioned_bounds_checks += LoopVersioner::Optimize(flow_graph);
+});
+
 COMPILER_PASS(OptimizeTypedDataAccesses,
               { TypedDataSpecializer::Optimize(flow_graph); });
 
@@ -545,6 +568,27 @@ COMPILER_PASS(FinalizeGraph, {
                                      /*force*/ true, &instruction_count,
                                      &call_site_count);
   flow_graph->function().set_inlining_depth(state->inlining_depth);
+  if (FLAG_print_bounds_check_stats) {
+    intptr_t remaining_bounds_checks = 0;
+    for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+         !block_it.Done(); block_it.Advance()) {
+      for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+           it.Advance()) {
+        if (it.Current()->AsCheckBoundBase() != nullptr) {
+          remaining_bounds_checks++;
+        }
+      }
+    }
+    const intptr_t eliminated_bounds_checks =
+        state->eliminated_bounds_checks + state->versioned_bounds_checks;
+    if (eliminated_bounds_checks + remaining_bounds_checks > 0) {
+      THR_Print("Bounds checks in %s: %" Pd " eliminated (%" Pd
+                " by loop versioning), %" Pd " remaining\n",
+                flow_graph->function().ToFullyQualifiedCString(),
+                eliminated_bounds_checks, state->versioned_bounds_checks,
+                remaining_bounds_checks);
+    }
+  }
   // Remove redefinitions for the rest of the pipeline.
   flow_graph->RemoveRedefinitions();
 });
@@ -41,6 +41,7 @@ namespace dart {
   V(OptimisticallySpecializeSmiPhis)                                           \
   V(OptimizeBranches)                                                          \
   V(OptimizeTypedDataAccesses)                                                 \
+  V(PRE)                                                                       \
   V(RangeAnalysis)                                                             \
   V(ReorderBlocks)                                                             \
   V(RoundTripSerialization)                                                    \
@@ -50,7 +51,10 @@ namespace dart {
   V(TryCatchOptimization)                                                      \
   V(TryOptimizePatterns)                                                       \
   V(TypePropagation)                                                           \
+  V(UnrollLoops)                                                               \
   V(UseTableDispatch)                                                          \
+  V(VectorizeLoops)                                                            \
+  V(VersionLoops)                                                              \
   V(WidenSmiToInt32)                                                           \
   V(EliminateWriteBarriers)
 
@@ -77,6 +81,8 @@ struct CompilerPassState {
         speculative_policy(speculative_policy),
         reorder_blocks(false),
         sticky_flags(0),
+        eliminated_bounds_checks(0),
+        versioned_bounds_checks(0),
         flow_graph_(flow_graph) {}
 
   FlowGraph* flow_graph() const { return flow_graph_; }
@@ -104,6 +110,11 @@ struct CompilerPassState {
 
   intptr_t sticky_flags;
 
+  // Bounds checks removed by range analysis, and from the fast copies of
+  // versioned loops.
+  intptr_t eliminated_bounds_checks;
+  intptr_t versioned_bounds_checks;
+
  private:
   FlowGraph* flow_graph_;
 };
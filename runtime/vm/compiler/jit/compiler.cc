@@ -65,6 +65,11 @@ DEFINE_FLAG(bool,
             false,
             "Print the deopt-id to ICData map in optimizing compiler.");
 DEFINE_FLAG(bool, print_code_source_map, false, "Print code source map.");
+DEFINE_FLAG(int,
+            optimizing_compiler_threads,
+            1,
+            "Maximum number of threads an isolate uses for optimizing "
+            "compilation in the background.");
 DEFINE_FLAG(bool,
             stress_test_background_compilation,
             false,
@@ -1069,7 +1074,7 @@ void Compiler::AbortBackgroundCompilation(intptr_t deopt_id, const char* msg) {
 class QueueElement {
  public:
   explicit QueueElement(const Function& function)
-      : next_(NULL), function_(function.raw()) {}
+      : next_(NULL), function_(function.raw()), is_claimed_(false) {}
 
   virtual ~QueueElement() {
     next_ = NULL;
@@ -1084,18 +1089,26 @@ class QueueElement {
   ObjectPtr function() const { return function_; }
   ObjectPtr* function_ptr() { return reinterpret_cast<ObjectPtr*>(&function_); }
 
+  // Whether a compiler thread is working on this element. Claimed elements
+  // stay in the queue so that requests for the same function are dropped.
+  bool is_claimed() const { return is_claimed_; }
+  void set_is_claimed(bool value) { is_claimed_ = value; }
+
  private:
   QueueElement* next_;
   FunctionPtr function_;
+  bool is_claimed_;
 
   DISALLOW_COPY_AND_ASSIGN(QueueElement);
 };
 
 // Allocated in C-heap. Handles both input and output of background compilation.
-// It implements a FIFO queue, using Peek, Add, Remove operations.
+// Elements are kept in insertion order, but are handed to compiler threads
+// hottest first, see Claim.
 class BackgroundCompilationQueue {
  public:
-  BackgroundCompilationQueue() : first_(NULL), last_(NULL) {}
+  BackgroundCompilationQueue()
+      : first_(NULL), last_(NULL), num_unclaimed_(0) {}
   virtual ~BackgroundCompilationQueue() { Clear(); }
 
   void VisitObjectPointers(ObjectPointerVisitor* visitor) {
@@ -1109,9 +1122,13 @@ class BackgroundCompilationQueue {
 
   bool IsEmpty() const { return first_ == NULL; }
 
+  // Whether there are elements no compiler thread is working on yet.
+  bool HasUnclaimed() const { return num_unclaimed_ > 0; }
+
   void Add(QueueElement* value) {
     ASSERT(value != NULL);
     ASSERT(value->next() == NULL);
+    ASSERT(!value->is_claimed());
     if (first_ == NULL) {
       first_ = value;
       ASSERT(last_ == NULL);
@@ -1120,28 +1137,55 @@ class BackgroundCompilationQueue {
       last_->set_next(value);
     }
     last_ = value;
+    num_unclaimed_++;
     ASSERT(first_ != NULL && last_ != NULL);
   }
 
-  QueueElement* Peek() const { return first_; }
-
-  FunctionPtr PeekFunction() const {
-    QueueElement* e = Peek();
-    if (e == NULL) {
-      return Function::null();
-    } else {
-      return e->Function();
+  // Claims the unclaimed element whose function has the highest usage
+  // counter. The mutator resets the counter to INT32_MIN when it requests
+  // optimization, so the counter measures how often the function ran
+  // unoptimized while waiting. Returns NULL if all elements are claimed.
+  QueueElement* Claim() {
+    QueueElement* hottest = NULL;
+    int32_t hottest_usage = 0;
+    Function& function = Function::Handle();
+    for (QueueElement* p = first_; p != NULL; p = p->next()) {
+      if (p->is_claimed()) continue;
+      function = p->Function();
+      const int32_t usage = function.usage_counter();
+      if ((hottest == NULL) || (usage > hottest_usage)) {
+        hottest = p;
+        hottest_usage = usage;
+      }
     }
+    if (hottest != NULL) {
+      hottest->set_is_claimed(true);
+      num_unclaimed_--;
+    }
+    return hottest;
   }
 
-  QueueElement* Remove() {
-    ASSERT(first_ != NULL);
-    QueueElement* result = first_;
-    first_ = first_->next();
-    if (first_ == NULL) {
-      last_ = NULL;
+  void Remove(QueueElement* value) {
+    ASSERT(value != NULL);
+    QueueElement* prev = NULL;
+    QueueElement* p = first_;
+    while (p != value) {
+      ASSERT(p != NULL);
+      prev = p;
+      p = p->next();
     }
-    return result;
+    if (prev == NULL) {
+      first_ = value->next();
+    } else {
+      prev->set_next(value->next());
+    }
+    if (last_ == value) {
+      last_ = prev;
+    }
+    if (!value->is_claimed()) {
+      num_unclaimed_--;
+    }
+    value->set_next(NULL);
   }
 
   bool ContainsObj(const Object& obj) const {
@@ -1157,15 +1201,18 @@ class BackgroundCompilationQueue {
 
   void Clear() {
     while (!IsEmpty()) {
-      QueueElement* e = Remove();
+      QueueElement* e = first_;
+      Remove(e);
       delete e;
     }
     ASSERT((first_ == NULL) && (last_ == NULL));
+    ASSERT(num_unclaimed_ == 0);
   }
 
  private:
   QueueElement* first_;
   QueueElement* last_;
+  intptr_t num_unclaimed_;
 
   DISALLOW_COPY_AND_ASSIGN(BackgroundCompilationQueue);
 };
@@ -1176,7 +1223,7 @@ BackgroundCompiler::BackgroundCompiler(Isolate* isolate, bool optimizing)
       function_queue_(new BackgroundCompilationQueue()),
       done_monitor_(),
       running_(false),
-      done_(true),
+      active_tasks_(0),
       optimizing_(optimizing),
       disabled_depth_(0) {}
 
@@ -1197,10 +1244,14 @@ void BackgroundCompiler::Run() {
       Zone* zone = stack_zone.GetZone();
       HANDLESCOPE(thread);
       Function& function = Function::Handle(zone);
+      QueueElement* claimed = NULL;
       {
         MonitorLocker ml(&queue_monitor_);
         if (running_) {
-          function = function_queue()->PeekFunction();
+          claimed = function_queue()->Claim();
+          if (claimed != NULL) {
+            function = claimed->Function();
+          }
         }
       }
       while (!function.IsNull()) {
@@ -1215,11 +1266,12 @@ void BackgroundCompiler::Run() {
         QueueElement* qelem = NULL;
         {
           MonitorLocker ml(&queue_monitor_);
-          if (!running_ || function_queue()->IsEmpty()) {
+          if (!running_) {
             // We are shutting down, queue was cleared.
             function = Function::null();
           } else {
-            qelem = function_queue()->Remove();
+            qelem = claimed;
+            function_queue()->Remove(qelem);
             const Function& old = Function::Handle(qelem->Function());
             // If an optimizable method is not optimized, put it back on
             // the background queue (unless it was passed to foreground).
@@ -1232,7 +1284,9 @@ void BackgroundCompiler::Run() {
                 function_queue()->Add(repeat_qelem);
               }
             }
-            function = function_queue()->PeekFunction();
+            claimed = function_queue()->Claim();
+            function =
+                (claimed == NULL) ? Function::null() : claimed->Function();
           }
         }
         if (qelem != NULL) {
@@ -1242,9 +1296,9 @@ void BackgroundCompiler::Run() {
     }
     Thread::ExitIsolateAsHelper();
     {
-      // Wait to be notified when the work queue is not empty.
+      // Wait to be notified when the work queue has unclaimed work.
       MonitorLocker ml(&queue_monitor_);
-      while (function_queue()->IsEmpty() && running_) {
+      while (!function_queue()->HasUnclaimed() && running_) {
         ml.Wait();
       }
     }
@@ -1253,8 +1307,10 @@ void BackgroundCompiler::Run() {
   {
     // Notify that the thread is done.
     MonitorLocker ml_done(&done_monitor_);
-    done_ = true;
-    ml_done.Notify();
+    active_tasks_--;
+    if (active_tasks_ == 0) {
+      ml_done.Notify();
+    }
   }
 }
 
@@ -1294,17 +1350,28 @@ void BackgroundCompiler::Start() {
   ASSERT(!thread->IsAtSafepoint());
 
   MonitorLocker ml(&done_monitor_);
-  if (running_ || !done_) return;
+  if (running_ || (active_tasks_ > 0)) return;
   running_ = true;
-  done_ = false;
+  intptr_t num_tasks = 1;
+  if (is_optimizing()) {
+    num_tasks = Utils::Minimum(
+        Utils::Maximum(FLAG_optimizing_compiler_threads, 1),
+        OS::NumberOfAvailableProcessors());
+  }
   // If we ever wanted to run the BG compiler on the
   // `IsolateGroup::mutator_pool()` we would need to ensure the BG compiler
   // stops when it's idle - otherwise the [MutatorThreadPool]-based idle
   // notification would not work anymore.
-  bool task_started = Dart::thread_pool()->Run<BackgroundCompilerTask>(this);
-  if (!task_started) {
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    active_tasks_++;
+    bool task_started = Dart::thread_pool()->Run<BackgroundCompilerTask>(this);
+    if (!task_started) {
+      active_tasks_--;
+      break;
+    }
+  }
+  if (active_tasks_ == 0) {
     running_ = false;
-    done_ = true;
   }
 }
 
@@ -1317,12 +1384,12 @@ void BackgroundCompiler::Stop() {
     MonitorLocker ml(&queue_monitor_);
     running_ = false;
     function_queue_->Clear();
-    ml.Notify();  // Stop waiting for the queue.
+    ml.NotifyAll();  // Stop waiting for the queue.
   }
 
   {
     MonitorLocker ml_done(&done_monitor_);
-    while (!done_) {
+    while (active_tasks_ > 0) {
       ml_done.WaitWithSafepointCheck(thread);
     }
   }
@@ -195,16 +195,16 @@ class BackgroundCompiler {
   void Enable();
   void Disable();
   bool IsDisabled();
-  bool IsRunning() { return !done_; }
+  bool IsRunning() { return active_tasks_ > 0; }
 
   Isolate* isolate_;
 
   Monitor queue_monitor_;  // Controls access to the queue.
   BackgroundCompilationQueue* function_queue_;
 
-  Monitor done_monitor_;    // Notify/wait that the thread is done.
+  Monitor done_monitor_;    // Notify/wait that the threads are done.
   bool running_;            // While true, will try to read queue and compile.
-  bool done_;               // True if the thread is done.
+  intptr_t active_tasks_;   // Number of threads that are not done.
   bool optimizing_;
 
   int16_t disabled_depth_;
@@ -17,6 +17,8 @@
 
 namespace dart {
 
+DECLARE_FLAG(int, optimizing_compiler_threads);
+
 ISOLATE_UNIT_TEST_CASE(CompileFunction) {
   const char* kScriptChars =
       "class A {\n"
@@ -99,6 +101,65 @@ ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionOnHelperThread) {
   BackgroundCompiler::Stop(isolate);
 }
 
+ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionsOnHelperThreads) {
+  // Queue several functions for optimization with more than one compiler
+  // thread, and check that each of them gets optimized.
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo() { return 42; }\n"
+      "  static bar() { return 43; }\n"
+      "  static baz() { return 44; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const char* kNames[] = {"foo", "bar", "baz"};
+  const intptr_t kNumFunctions = ARRAY_SIZE(kNames);
+  const Array& functions = Array::Handle(Array::New(kNumFunctions));
+  Function& func = Function::Handle();
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    func = cls.LookupStaticFunction(String::Handle(String::New(kNames[i])));
+    EXPECT(!func.IsNull());
+    CompilerTest::TestCompileFunction(func);
+    EXPECT(func.HasCode());
+    EXPECT(!func.HasOptimizedCode());
+    functions.SetAt(i, func);
+  }
+#if !defined(PRODUCT)
+  // Constant in product mode.
+  FLAG_background_compilation = true;
+#endif
+  const int saved_threads = FLAG_optimizing_compiler_threads;
+  FLAG_optimizing_compiler_threads = 2;
+  Isolate* isolate = thread->isolate();
+  BackgroundCompiler::Start(isolate);
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    func ^= functions.At(i);
+    isolate->optimizing_background_compiler()->Compile(func);
+    // Duplicate requests are dropped.
+    isolate->optimizing_background_compiler()->Compile(func);
+  }
+  Monitor* m = new Monitor();
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    func ^= functions.At(i);
+    MonitorLocker ml(m);
+    while (!func.HasOptimizedCode()) {
+      ml.WaitWithSafepointCheck(thread, 1);
+    }
+  }
+  delete m;
+  BackgroundCompiler::Stop(isolate);
+  FLAG_optimizing_compiler_threads = saved_threads;
+}
+
 ISOLATE_UNIT_TEST_CASE(CompileFunctionOnHelperThread) {
   // Create a simple function and compile it without optimization.
   const char* kScriptChars =
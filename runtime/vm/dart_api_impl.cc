@@ -1485,6 +1485,7 @@ DART_EXPORT void Dart_ShutdownIsolate() {
   }
   T->set_api_top_scope(NULL);
 
+  NOT_IN_PRECOMPILED(JitProfileCache::Save(T));
   {
     StackZone zone(T);
     HandleScope handle_scope(T);
@@ -5842,6 +5843,8 @@ DART_EXPORT Dart_Handle Dart_FinalizeLoading(bool complete_futures) {
   // re-initialize the growth policy.
   if (I->group()->ContainsOnlyOneIsolate()) {
     I->heap()->old_space()->EvaluateAfterLoading();
+    // Replay the profile of a previous run of this program, if any.
+    NOT_IN_PRECOMPILED(JitProfileCache::Load(T));
   }
 
 #if !defined(DART_PRECOMPILED_RUNTIME)
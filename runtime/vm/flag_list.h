@@ -124,6 +124,9 @@ constexpr bool kDartUseBackgroundCompilation = true;
     "Don't optimize away static field initialization")                         \
   C(force_clone_compiler_objects, false, false, bool, false,                   \
     "Force cloning of objects needed in compiler (ICData and Field).")         \
+  P(gc_target_overhead, int, 0,                                                \
+    "If positive, size the generations so that garbage collection takes "      \
+    "about this percentage of run time (0 means use the fixed heuristics).")   \
   P(getter_setter_ratio, int, 13,                                              \
     "Ratio of getter/setter usage used for double field unboxing heuristics")  \
   P(guess_icdata_cid, bool, true,                                              \
@@ -140,11 +143,14 @@ constexpr bool kDartUseBackgroundCompilation = true;
   R(log_marker_tasks, false, bool, false,                                      \
     "Log debugging information for old gen GC marking tasks.")                 \
   P(scavenger_tasks, int, 2,                                                   \
-    "The number of tasks to spawn during scavenging (0 means "                 \
-    "perform all marking on main thread).")                                    \
+    "The maximum number of tasks to spawn during scavenging, fewer are used "  \
+    "for small live sets (0 means perform all scavenging on main thread).")    \
   P(marker_tasks, int, 2,                                                      \
     "The number of tasks to spawn during old gen GC marking (0 means "         \
     "perform all marking on main thread).")                                    \
+  P(mark_bitmap, bool, false,                                                  \
+    "Record old gen GC marks in per-page side bitmaps instead of object "      \
+    "headers.")                                                                \
   P(max_polymorphic_checks, int, 4,                                            \
     "Maximum number of polymorphic check, otherwise it is megamorphic.")       \
   P(max_equality_polymorphic_checks, int, 32,                                  \
@@ -193,6 +199,9 @@ constexpr bool kDartUseBackgroundCompilation = true;
     "Serialize function objects for all code objects even if not otherwise "   \
     "needed in the precompiled runtime.")                                      \
   P(enable_isolate_groups, bool, false, "Enable isolate group support.")       \
+  P(direct_isolate_messages, bool, true,                                       \
+    "Share or copy messages to isolates of the same isolate group directly "   \
+    "on the heap instead of serializing them.")                                \
   P(show_invisible_frames, bool, false,                                        \
     "Show invisible frames in stack traces.")                                  \
   R(show_invisible_isolates, false, bool, false,                               \
@@ -239,6 +248,8 @@ constexpr bool kDartUseBackgroundCompilation = true;
     "Enables heap verification before GC.")                                    \
   R(verify_store_buffer, false, bool, false,                                   \
     "Enables store buffer verification before and after scavenges.")           \
+  P(zone_size_classes, bool, false,                                            \
+    "Reuse large zone segments through power-of-two size class caches.")       \
   P(enable_slow_path_sharing, bool, true, "Enable sharing of slow-path code.") \
   P(shared_slow_path_triggers_gc, bool, false,                                 \
     "TESTING: slow-path triggers a GC.")                                       \
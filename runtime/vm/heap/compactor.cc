@@ -9,6 +9,7 @@
 #include "vm/heap/become.h"
 #include "vm/heap/heap.h"
 #include "vm/heap/pages.h"
+#include "vm/heap/sweeper.h"
 #include "vm/thread_barrier.h"
 #include "vm/timeline.h"
 
@@ -19,6 +20,9 @@ DEFINE_FLAG(bool,
             false,
             "Force compaction to move every movable object");
 
+// Pages that are at least this full are never worth compacting on a budget.
+static constexpr intptr_t kMaxSelectedOccupancyPercent = 75;
+
 // Each OldPage is divided into blocks of size kBlockSize. Each object belongs
 // to the block containing its header word (so up to kBlockSize +
 // kAllocatablePageSize - 2 * kObjectAlignment bytes belong to the same block).
@@ -157,6 +161,7 @@ class CompactorTask : public ThreadPool::Task {
   OldPage* free_page_;
   uword free_current_;
   uword free_end_;
+  intptr_t live_bytes_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(CompactorTask);
 };
@@ -169,9 +174,17 @@ class CompactorTask : public ThreadPool::Task {
 // added to the freelist.
 void GCCompactor::Compact(OldPage* pages,
                           FreeList* freelist,
-                          Mutex* pages_lock) {
+                          Mutex* pages_lock,
+                          intptr_t budget_in_words) {
   SetupImagePageBoundaries();
 
+  if ((budget_in_words > 0) && !FLAG_force_evacuation) {
+    pages = SelectPages(pages, budget_in_words);
+    // Dead objects on unswept pages may point into compacted pages, which
+    // the verifier would reject.
+    sweep_untouched_pages_ = !FLAG_concurrent_sweep || FLAG_verify_after_gc;
+  }
+
   // Divide the heap.
   // TODO(30978): Try to divide based on live bytes or with work stealing.
   intptr_t num_pages = 0;
@@ -311,13 +324,35 @@ void GCCompactor::Compact(OldPage* pages,
       }
     }
 
-    // Re-join the heap.
+    // Re-join the heap. Untouched pages go first, so that the concurrent
+    // sweeper can be given them as a prefix of the page list.
     for (intptr_t task_index = 0; task_index < num_tasks - 1; task_index++) {
       tails[task_index]->set_next(heads[task_index + 1]);
     }
-    tails[num_tasks - 1]->set_next(NULL);
-    heap_->old_space()->pages_ = pages = heads[0];
-    heap_->old_space()->pages_tail_ = tails[num_tasks - 1];
+    pages = heads[0];
+    OldPage* untouched_tail = nullptr;
+    for (intptr_t i = untouched_pages_.length() - 1; i >= 0; i--) {
+      OldPage* page = untouched_pages_[i];
+      page->forwarding_page_ = untouched_forwarding_pages_[i];
+      if (untouched_pages_in_use_[i]) {
+        page->set_next(pages);
+        pages = page;
+        if (untouched_tail == nullptr) {
+          untouched_tail = page;
+        }
+      } else {
+        heap_->old_space()->IncreaseCapacityInWordsLocked(
+            -(page->memory_->size() >> kWordSizeLog2));
+        page->Deallocate();
+      }
+    }
+    if (!sweep_untouched_pages_) {
+      unswept_pages_tail_ = untouched_tail;
+    }
+    OldPage* tail = tails[num_tasks - 1];
+    tail->set_next(NULL);
+    heap_->old_space()->pages_ = pages;
+    heap_->old_space()->pages_tail_ = tail;
 
     delete[] heads;
     delete[] tails;
@@ -343,6 +378,7 @@ void CompactorTask::RunEnteredIsolateGroup() {
   Thread* thread = Thread::Current();
 #endif
   {
+    int64_t start = OS::GetCurrentMonotonicMicros();
     {
       TIMELINE_FUNCTION_GC_DURATION(thread, "Plan");
       free_page_ = head_;
@@ -374,8 +410,13 @@ void CompactorTask::RunEnteredIsolateGroup() {
       }
 
       ASSERT(free_page_ != NULL);
+      free_page_->set_used_in_bytes(free_current_ -
+                                    free_page_->object_start());
       *tail_ = free_page_;  // Last live page.
     }
+    compactor_->compacted_in_words_.fetch_add(live_bytes_ >> kWordSizeLog2);
+    compactor_->compact_micros_.fetch_add(OS::GetCurrentMonotonicMicros() -
+                                          start);
 
     // Heap: Regular pages already visited during sliding. Code and image pages
     // have no pointers to forward. Visit large pages and new-space.
@@ -432,6 +473,11 @@ void CompactorTask::RunEnteredIsolateGroup() {
       }
     }
 
+    if (!compactor_->untouched_pages_.is_empty()) {
+      TIMELINE_FUNCTION_GC_DURATION(thread, "ForwardUntouchedPages");
+      compactor_->ForwardUntouchedPages();
+    }
+
     barrier_->Sync();
   }
 }
@@ -457,6 +503,9 @@ void CompactorTask::SlidePage(OldPage* page) {
   while (current < end) {
     current = SlideBlock(current, forwarding_page);
   }
+  // Later pages only slide into pages that were already slid, so the marks
+  // of this page are no longer needed.
+  page->ClearMarkBitmap();
 }
 
 // Plans the destination for a set of live objects starting with the first
@@ -475,7 +524,7 @@ uword CompactorTask::PlanBlock(uword first_object,
   while (current < block_end) {
     ObjectPtr obj = ObjectLayout::FromAddr(current);
     intptr_t size = obj->ptr()->HeapSize();
-    if (obj->ptr()->IsMarked()) {
+    if (OldPage::IsMarked(obj)) {
       forwarding_block->RecordLive(current, size);
       ASSERT(static_cast<intptr_t>(forwarding_block->Lookup(current)) ==
              block_live_size);
@@ -491,6 +540,7 @@ uword CompactorTask::PlanBlock(uword first_object,
   PlanMoveToContiguousSize(block_live_size);
   forwarding_block->set_new_address(free_current_);
   free_current_ += block_live_size;
+  live_bytes_ += block_live_size;
 
   return current;  // First object in the next block
 }
@@ -505,7 +555,7 @@ uword CompactorTask::SlideBlock(uword first_object,
   while (old_addr < block_end) {
     ObjectPtr old_obj = ObjectLayout::FromAddr(old_addr);
     intptr_t size = old_obj->ptr()->HeapSize();
-    if (old_obj->ptr()->IsMarked()) {
+    if (OldPage::IsMarked(old_obj)) {
       uword new_addr = forwarding_block->Lookup(old_addr);
       if (new_addr != free_current_) {
         // The only situation where these two don't match is if we are moving
@@ -518,6 +568,8 @@ uword CompactorTask::SlideBlock(uword first_object,
         if (free_remaining > 0) {
           freelist_->Free(free_current_, free_remaining);
         }
+        free_page_->set_used_in_bytes(free_current_ -
+                                      free_page_->object_start());
         free_page_ = free_page_->next();
         ASSERT(free_page_ != NULL);
         free_current_ = free_page_->object_start();
@@ -537,7 +589,9 @@ uword CompactorTask::SlideBlock(uword first_object,
           static_cast<TypedDataPtr>(new_obj)->ptr()->RecomputeDataField();
         }
       }
-      new_obj->ptr()->ClearMarkBit();
+      if (new_obj->ptr()->IsMarked()) {
+        new_obj->ptr()->ClearMarkBit();
+      }
       new_obj->ptr()->VisitPointers(compactor_);
 
       ASSERT(free_current_ == new_addr);
@@ -568,6 +622,93 @@ void CompactorTask::PlanMoveToContiguousSize(intptr_t size) {
   }
 }
 
+static int CompareUsedInBytes(OldPage* const* a, OldPage* const* b) {
+  const uword a_used = (*a)->used_in_bytes();
+  const uword b_used = (*b)->used_in_bytes();
+  if (a_used < b_used) return -1;
+  if (a_used > b_used) return 1;
+  return 0;
+}
+
+// Chooses the pages with the least live data according to their last sweep,
+// as long as their live data fits in the budget, and returns them as a list.
+// At least one page is chosen. The other pages are left in place: their
+// forwarding pages are hidden so that ForwardPointer leaves pointers to them
+// alone.
+OldPage* GCCompactor::SelectPages(OldPage* pages, intptr_t budget_in_words) {
+  TIMELINE_FUNCTION_GC_DURATION(thread(), "SelectPages");
+  MallocGrowableArray<OldPage*> by_usage;
+  for (OldPage* page = pages; page != nullptr; page = page->next()) {
+    by_usage.Add(page);
+  }
+  if (by_usage.length() <= 1) {
+    return pages;
+  }
+  by_usage.Sort(CompareUsedInBytes);
+
+  const intptr_t budget_in_bytes = budget_in_words << kWordSizeLog2;
+  intptr_t selected_in_bytes = 0;
+  intptr_t num_selected = 0;
+  for (; num_selected < by_usage.length(); num_selected++) {
+    OldPage* page = by_usage[num_selected];
+    const intptr_t used = page->used_in_bytes();
+    const intptr_t capacity = page->object_end() - page->object_start();
+    if ((num_selected > 0) &&
+        ((used * 100 >= capacity * kMaxSelectedOccupancyPercent) ||
+         (selected_in_bytes + used > budget_in_bytes))) {
+      break;
+    }
+    selected_in_bytes += used;
+  }
+
+  for (intptr_t i = 0; i < num_selected; i++) {
+    by_usage[i]->set_next(i + 1 < num_selected ? by_usage[i + 1] : nullptr);
+  }
+  for (intptr_t i = num_selected; i < by_usage.length(); i++) {
+    OldPage* page = by_usage[i];
+    page->set_next(nullptr);
+    untouched_pages_.Add(page);
+    untouched_forwarding_pages_.Add(page->forwarding_page_);
+    untouched_pages_in_use_.Add(true);
+    page->forwarding_page_ = nullptr;
+  }
+  return by_usage[0];
+}
+
+// Pages that are not compacted still need their pointers to compacted pages
+// forwarded, which all tasks share page by page. Only live objects are
+// visited, since dead ones may point to freed pages. Unless the concurrent
+// sweeper frees their dead objects after the pause, that is done in the same
+// pass.
+void GCCompactor::ForwardUntouchedPages() {
+  GCSweeper sweeper;
+  const intptr_t num_shards = heap_->old_space()->num_data_freelists();
+  for (;;) {
+    const intptr_t i = next_untouched_page_.fetch_add(1);
+    if (i >= untouched_pages_.length()) {
+      return;
+    }
+    OldPage* page = untouched_pages_[i];
+    uword current = page->object_start();
+    const uword end = page->object_end();
+    while (current < end) {
+      ObjectPtr obj = ObjectLayout::FromAddr(current);
+      if (OldPage::IsMarked(obj)) {
+        current += obj->ptr()->VisitPointers(this);
+      } else {
+        current += obj->ptr()->HeapSize();
+      }
+    }
+
+    if (sweep_untouched_pages_) {
+      FreeList* freelist = heap_->old_space()->DataFreeList(i % num_shards);
+      MutexLocker ml(freelist->mutex());
+      untouched_pages_in_use_[i] =
+          sweeper.SweepPage(page, freelist, /*locked=*/true);
+    }
+  }
+}
+
 void GCCompactor::SetupImagePageBoundaries() {
   for (intptr_t i = 0; i < kMaxImagePages; i++) {
     image_page_ranges_[i].base = 0;
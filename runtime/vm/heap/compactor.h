@@ -5,6 +5,7 @@
 #ifndef RUNTIME_VM_HEAP_COMPACTOR_H_
 #define RUNTIME_VM_HEAP_COMPACTOR_H_
 
+#include "platform/atomic.h"
 #include "platform/growable_array.h"
 
 #include "vm/allocation.h"
@@ -15,11 +16,14 @@
 namespace dart {
 
 // Forward declarations.
+class ForwardingPage;
 class FreeList;
 class Heap;
 class OldPage;
 
-// Implements a sliding compactor.
+// Implements a sliding compactor. With a budget, only the most fragmented
+// pages are slid; the others are swept in place, concurrently with the
+// mutator if --concurrent_sweep is set.
 class GCCompactor : public ValueObject,
                     public HandleVisitor,
                     public ObjectPointerVisitor {
@@ -30,11 +34,27 @@ class GCCompactor : public ValueObject,
         heap_(heap) {}
   ~GCCompactor() {}
 
-  void Compact(OldPage* pages, FreeList* freelist, Mutex* mutex);
+  // If [budget_in_words] is positive, only compact pages whose live objects
+  // add up to about that many words.
+  void Compact(OldPage* pages,
+               FreeList* freelist,
+               Mutex* mutex,
+               intptr_t budget_in_words = 0);
+
+  // Words of live objects on the pages that were compacted.
+  intptr_t compacted_in_words() const { return compacted_in_words_; }
+  // Time spent planning and sliding, summed over all tasks.
+  int64_t compact_micros() const { return compact_micros_; }
+  // With --concurrent_sweep, the pages that were not compacted are left
+  // unswept at the start of the page list, up to and including this page.
+  // Null if there are none.
+  OldPage* unswept_pages_tail() const { return unswept_pages_tail_; }
 
  private:
   friend class CompactorTask;
 
+  OldPage* SelectPages(OldPage* pages, intptr_t budget_in_words);
+  void ForwardUntouchedPages();
   void SetupImagePageBoundaries();
   void ForwardStackPointers();
   void ForwardPointer(ObjectPtr* ptr);
@@ -59,6 +79,20 @@ class GCCompactor : public ValueObject,
   // complete.
   Mutex typed_data_view_mutex_;
   MallocGrowableArray<TypedDataViewPtr> typed_data_views_;
+
+  // Pages that are not compacted. Their forwarding pages are hidden during
+  // compaction, so pointers to their objects are left alone.
+  MallocGrowableArray<OldPage*> untouched_pages_;
+  MallocGrowableArray<ForwardingPage*> untouched_forwarding_pages_;
+  // Whether each untouched page still has live objects after sweeping.
+  MallocGrowableArray<bool> untouched_pages_in_use_;
+  RelaxedAtomic<intptr_t> next_untouched_page_ = {0};
+  // Whether the untouched pages are swept during compaction.
+  bool sweep_untouched_pages_ = true;
+  OldPage* unswept_pages_tail_ = nullptr;
+
+  RelaxedAtomic<intptr_t> compacted_in_words_ = {0};
+  RelaxedAtomic<int64_t> compact_micros_ = {0};
 };
 
 }  // namespace dart
@@ -15,6 +15,8 @@
 #include "vm/globals.h"
 #include "vm/heap/become.h"
 #include "vm/heap/heap.h"
+#include "vm/heap/weak_table.h"
+#include "vm/json_stream.h"
 #include "vm/message_handler.h"
 #include "vm/object_graph.h"
 #include "vm/port.h"
@@ -23,6 +25,9 @@
 
 namespace dart {
 
+DECLARE_FLAG(int, compaction_budget_words);
+DECLARE_FLAG(int, compaction_pause_budget_ms);
+
 TEST_CASE(OldGC) {
   const char* kScriptChars =
       "main() {\n"
@@ -819,4 +824,268 @@ ISOLATE_UNIT_TEST_CASE(ArrayTruncationRaces) {
   }
 }
 
+ISOLATE_UNIT_TEST_CASE(ParallelScavengeManyLivePages) {
+  // Keep several to-space pages worth of objects alive so that scavenger tasks
+  // have unresolved pages to steal from one another.
+  const intptr_t kNumArrays = 4 * 1024;
+  const intptr_t kArrayLength = 64;
+  Array& arrays = Array::Handle(Array::New(kNumArrays, Heap::kNew));
+  Array& array = Array::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    array = Array::New(kArrayLength, Heap::kNew);
+    for (intptr_t j = 0; j < kArrayLength; j++) {
+      array.SetAt(j, Smi::Handle(Smi::New(i + j)));
+    }
+    arrays.SetAt(i, array);
+  }
+
+  // The first scavenge sizes the task count for the next ones.
+  for (intptr_t k = 0; k < 3; k++) {
+    GCTestHelper::CollectNewSpace();
+  }
+
+  Smi& value = Smi::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    array ^= arrays.At(i);
+    EXPECT_EQ(kArrayLength, array.Length());
+    for (intptr_t j = 0; j < kArrayLength; j++) {
+      value ^= array.At(j);
+      EXPECT_EQ(i + j, value.Value());
+    }
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(ParallelScavengeRememberedSet) {
+  // Many remembered old objects and two card-remembered arrays with stores
+  // spread over most of their cards, so that every scavenger task has part of
+  // the remembered set to process.
+  const intptr_t kNumOldObjects = 16 * 1024;
+  const intptr_t kLargeLength = 256 * 1024;
+  Array& old_objects = Array::Handle(Array::New(kNumOldObjects, Heap::kOld));
+  Array& object = Array::Handle();
+  for (intptr_t i = 0; i < kNumOldObjects; i++) {
+    object = Array::New(1, Heap::kOld);
+    old_objects.SetAt(i, object);
+  }
+  Array& large = Array::Handle(Array::New(kLargeLength, Heap::kOld));
+  Array& immutable =
+      Array::Handle(ImmutableArray::New(kLargeLength, Heap::kOld));
+  EXPECT(large.raw()->ptr()->IsCardRemembered());
+  EXPECT(immutable.raw()->ptr()->IsCardRemembered());
+
+  Smi& value = Smi::Handle();
+  for (intptr_t k = 0; k < 3; k++) {
+    for (intptr_t i = 0; i < kNumOldObjects; i++) {
+      object ^= old_objects.At(i);
+      object.SetAt(0, Array::Handle(Array::New(1, Heap::kNew)));
+    }
+    for (intptr_t i = 0; i < kLargeLength; i += 97) {
+      value = Smi::New(i);
+      large.SetAt(i, Array::Handle(Array::New(1, Heap::kNew)));
+      immutable.SetAt(i, Array::Handle(Array::New(1, Heap::kNew)));
+      Array::Handle(Array::RawCast(large.At(i))).SetAt(0, value);
+      Array::Handle(Array::RawCast(immutable.At(i))).SetAt(0, value);
+    }
+
+    GCTestHelper::CollectNewSpace();
+
+    Array& element = Array::Handle();
+    for (intptr_t i = 0; i < kNumOldObjects; i++) {
+      object ^= old_objects.At(i);
+      element ^= object.At(0);
+      EXPECT_EQ(1, element.Length());
+    }
+    for (intptr_t i = 0; i < kLargeLength; i += 97) {
+      element ^= large.At(i);
+      value ^= element.At(0);
+      EXPECT_EQ(i, value.Value());
+      element ^= immutable.At(i);
+      value ^= element.At(0);
+      EXPECT_EQ(i, value.Value());
+    }
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(BudgetedCompaction) {
+  // Leave holes in every page so that a budgeted compaction has pages to
+  // choose from and must forward pointers into them from the others.
+  const intptr_t kNumArrays = 16 * 1024;
+  const intptr_t kArrayLength = 16;
+  Array& arrays = Array::Handle(Array::New(kNumArrays, Heap::kOld));
+  Array& array = Array::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    array = Array::New(kArrayLength, Heap::kOld);
+    array.SetAt(0, Smi::Handle(Smi::New(i)));
+    arrays.SetAt(i, array);
+  }
+  for (intptr_t i = 0; i < kNumArrays; i += 2) {
+    arrays.SetAt(i, Object::null_object());
+  }
+
+  const int saved_budget = FLAG_compaction_pause_budget_ms;
+  FLAG_compaction_pause_budget_ms = 1;
+  // The first collection records how full each page is.
+  GCTestHelper::CollectAllGarbage();
+  Thread::Current()->heap()->CollectAllGarbage(Heap::kLowMemory);
+  FLAG_compaction_pause_budget_ms = saved_budget;
+
+  Smi& value = Smi::Handle();
+  for (intptr_t i = 1; i < kNumArrays; i += 2) {
+    array ^= arrays.At(i);
+    EXPECT_EQ(kArrayLength, array.Length());
+    value ^= array.At(0);
+    EXPECT_EQ(i, value.Value());
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(BudgetedCompactionIsIncremental) {
+  // About ten half-full pages, i.e. five pages of live arrays.
+  const intptr_t kNumArrays = 32 * 1024;
+  const intptr_t kArrayLength = 16;
+  Array& arrays = Array::Handle(Array::New(kNumArrays, Heap::kOld));
+  Array& array = Array::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    array = Array::New(kArrayLength, Heap::kOld);
+    array.SetAt(0, Smi::Handle(Smi::New(i)));
+    arrays.SetAt(i, array);
+  }
+  for (intptr_t i = 0; i < kNumArrays; i += 2) {
+    arrays.SetAt(i, Object::null_object());
+  }
+  // Record how full each page is.
+  GCTestHelper::CollectAllGarbage();
+
+  Heap* heap = thread->heap();
+  const int saved_budget = FLAG_compaction_budget_words;
+  // Each compaction slides at most about one and a half pages of live
+  // objects, so freeing the holes takes several of them.
+  FLAG_compaction_budget_words = (3 * kOldPageSize / 2) >> kWordSizeLog2;
+  const int64_t capacity_before = heap->CapacityInWords(Heap::kOld);
+  heap->CollectAllGarbage(Heap::kLowMemory);
+  const int64_t capacity_after_first = heap->CapacityInWords(Heap::kOld);
+  heap->CollectAllGarbage(Heap::kLowMemory);
+  const int64_t capacity_after_second = heap->CapacityInWords(Heap::kOld);
+  FLAG_compaction_budget_words = saved_budget;
+  EXPECT_LT(capacity_after_first, capacity_before);
+  EXPECT_LT(capacity_after_second, capacity_after_first);
+
+  // A full compaction still finds pages to free.
+  heap->CollectAllGarbage(Heap::kLowMemory);
+  EXPECT_LT(heap->CapacityInWords(Heap::kOld), capacity_after_second);
+
+  Smi& value = Smi::Handle();
+  for (intptr_t i = 1; i < kNumArrays; i += 2) {
+    array ^= arrays.At(i);
+    EXPECT_EQ(kArrayLength, array.Length());
+    value ^= array.At(0);
+    EXPECT_EQ(i, value.Value());
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(MarkBitmap) {
+  // Finish any marking in progress before switching where marks are kept.
+  GCTestHelper::CollectAllGarbage();
+  const bool saved_mark_bitmap = FLAG_mark_bitmap;
+  FLAG_mark_bitmap = true;
+
+  // Runs of dead objects of different lengths between survivors.
+  const intptr_t kNumArrays = 8 * 1024;
+  Array& arrays = Array::Handle(Array::New(kNumArrays, Heap::kOld));
+  Array& array = Array::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    array = Array::New(i % 7, Heap::kOld);
+    if (array.Length() > 0) {
+      array.SetAt(0, Smi::Handle(Smi::New(i)));
+    }
+    arrays.SetAt(i, array);
+  }
+  for (intptr_t i = 0; i < kNumArrays; i++) {
+    if ((i % 3) != 0) {
+      arrays.SetAt(i, Object::null_object());
+    }
+  }
+  // A weak property whose value is in new space. The value has no side bit.
+  WeakProperty& weak = WeakProperty::Handle(WeakProperty::New(Heap::kOld));
+  weak.set_key(arrays);
+  const Array& young = Array::Handle(Array::New(1, Heap::kNew));
+  weak.set_value(young);
+
+  Heap* heap = thread->heap();
+  const int64_t used_before = heap->UsedInWords(Heap::kOld);
+  GCTestHelper::CollectOldSpace();
+  EXPECT_LT(heap->UsedInWords(Heap::kOld), used_before);
+  EXPECT(weak.key() == arrays.raw());
+  EXPECT(weak.value() == young.raw());
+  // Marks from the previous cycle must not keep anything alive.
+  GCTestHelper::CollectOldSpace();
+
+  Smi& value = Smi::Handle();
+  for (intptr_t i = 0; i < kNumArrays; i += 3) {
+    array ^= arrays.At(i);
+    EXPECT_EQ(i % 7, array.Length());
+    if (array.Length() > 0) {
+      value ^= array.At(0);
+      EXPECT_EQ(i, value.Value());
+    }
+  }
+
+  GCTestHelper::CollectAllGarbage();
+  FLAG_mark_bitmap = saved_mark_bitmap;
+}
+
+ISOLATE_UNIT_TEST_CASE(WeakTableChunks) {
+  // More entries than fit in one chunk, so that the weak tables are split
+  // between GC tasks.
+  const intptr_t kNumObjects = 3 * WeakTable::kGCChunkSize;
+  const Heap::Space kSpaces[] = {Heap::kNew, Heap::kOld};
+  Heap* heap = thread->heap();
+  const int64_t peers_before = heap->PeerCount();
+  for (intptr_t s = 0; s < 2; s++) {
+    Array& objects = Array::Handle(Array::New(kNumObjects, Heap::kOld));
+    Array& object = Array::Handle();
+    for (intptr_t i = 0; i < kNumObjects; i++) {
+      object = Array::New(0, kSpaces[s]);
+      heap->SetPeer(object.raw(), reinterpret_cast<void*>(i + 1));
+      if ((i % 2) == 0) {
+        objects.SetAt(i, object);
+      }
+    }
+    object = Array::null();
+    GCTestHelper::CollectAllGarbage();
+    EXPECT_EQ(peers_before + kNumObjects / 2, heap->PeerCount());
+    for (intptr_t i = 0; i < kNumObjects; i += 2) {
+      object ^= objects.At(i);
+      EXPECT_EQ(reinterpret_cast<void*>(i + 1), heap->GetPeer(object.raw()));
+    }
+    object = Array::null();
+    objects = Array::null();
+    GCTestHelper::CollectAllGarbage();
+    EXPECT_EQ(peers_before, heap->PeerCount());
+  }
+}
+
+#ifndef PRODUCT
+ISOLATE_UNIT_TEST_CASE(GCTargetOverheadSizing) {
+  const int saved_overhead = FLAG_gc_target_overhead;
+  FLAG_gc_target_overhead = 5;
+  Heap* heap = thread->heap();
+  for (intptr_t i = 0; i < 4; i++) {
+    GCTestHelper::CollectNewSpace();
+    GCTestHelper::CollectOldSpace();
+  }
+  EXPECT_LE(heap->new_space()->CapacityInWords(),
+            FLAG_new_gen_semi_max_size * MBInWords);
+  {
+    JSONStream js;
+    {
+      JSONObject obj(&js);
+      heap->PrintToJSONObject(Heap::kNew, &obj);
+      heap->PrintToJSONObject(Heap::kOld, &obj);
+    }
+    EXPECT_SUBSTRING("\"_sizing\":{\"targetOverhead\":5", js.ToCString());
+  }
+  FLAG_gc_target_overhead = saved_overhead;
+}
+#endif  // !PRODUCT
+
 }  // namespace dart
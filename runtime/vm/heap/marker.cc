@@ -25,16 +25,21 @@ namespace dart {
 template <bool sync>
 class MarkingVisitorBase : public ObjectPointerVisitor {
  public:
-  MarkingVisitorBase(IsolateGroup* isolate_group,
+  MarkingVisitorBase(GCMarker* marker,
+                     IsolateGroup* isolate_group,
                      PageSpace* page_space,
                      MarkingStack* marking_stack,
                      MarkingStack* deferred_marking_stack)
       : ObjectPointerVisitor(isolate_group),
         thread_(Thread::Current()),
+        marker_(marker),
         page_space_(page_space),
         work_list_(marking_stack),
         deferred_work_list_(deferred_marking_stack),
         delayed_weak_properties_(nullptr),
+        delayed_weak_count_(0),
+        round_(0),
+        publish_round_(0),
         marked_bytes_(0),
         marked_micros_(0) {
     ASSERT(thread_->isolate_group() == isolate_group);
@@ -46,18 +51,39 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
   void AddMicros(int64_t micros) { marked_micros_ += micros; }
 
   bool ProcessPendingWeakProperties() {
-    bool marked = false;
     WeakPropertyPtr cur_weak = delayed_weak_properties_;
     delayed_weak_properties_ = nullptr;
+    delayed_weak_count_ = 0;
+    return ProcessWeakProperties(cur_weak);
+  }
+
+  // One round of the ephemeron fixpoint: processes this task's pending weak
+  // properties and any segments published by other tasks. Called by all
+  // marking tasks in lock step.
+  bool ProcessSharedWeakProperties() {
+    publish_round_ = round_ + 1;
+    bool marked = ProcessPendingWeakProperties();
+    WeakPropertyPtr segment;
+    while ((segment = marker_->TakeWeakProperties(round_)) != nullptr) {
+      if (ProcessWeakProperties(segment)) {
+        marked = true;
+      }
+    }
+    round_++;
+    return marked;
+  }
+
+  bool ProcessWeakProperties(WeakPropertyPtr cur_weak) {
+    bool marked = false;
     while (cur_weak != nullptr) {
       uword next_weak = cur_weak->ptr()->next_;
       ObjectPtr raw_key = cur_weak->ptr()->key_;
       // Reset the next pointer in the weak property.
       cur_weak->ptr()->next_ = 0;
-      if (raw_key->ptr()->IsMarked()) {
+      if (OldPage::IsMarked(raw_key)) {
         ObjectPtr raw_val = cur_weak->ptr()->value_;
-        marked =
-            marked || (raw_val->IsHeapObject() && !raw_val->ptr()->IsMarked());
+        marked = marked ||
+                 (raw_val->IsHeapObject() && !OldPage::IsMarked(raw_val));
 
         // The key is marked so we make sure to properly visit all pointers
         // originating from this weak property.
@@ -84,6 +110,12 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
 
     do {
       do {
+        if (FLAG_mark_bitmap && !AcquireBitmapBitOfShaded(raw_obj)) {
+          // Already visited, or queued again by the marker.
+          raw_obj = work_list_.Pop();
+          continue;
+        }
+
         // First drain the marking stacks.
         const intptr_t class_id = raw_obj->GetClassId();
 
@@ -132,17 +164,23 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
     ASSERT(raw_weak->IsHeapObject());
     ASSERT(raw_weak->IsOldObject());
     ASSERT(raw_weak->IsWeakProperty());
-    ASSERT(raw_weak->ptr()->IsMarked());
+    ASSERT(OldPage::IsMarked(raw_weak));
     ASSERT(raw_weak->ptr()->next_ == 0);
     raw_weak->ptr()->next_ = static_cast<uword>(delayed_weak_properties_);
     delayed_weak_properties_ = raw_weak;
+    if (sync && (++delayed_weak_count_ >= kWeakPropertySegmentSize)) {
+      // Let idle tasks help with the fixpoint.
+      marker_->PublishWeakProperties(publish_round_, delayed_weak_properties_);
+      delayed_weak_properties_ = nullptr;
+      delayed_weak_count_ = 0;
+    }
   }
 
   intptr_t ProcessWeakProperty(WeakPropertyPtr raw_weak, bool did_mark) {
     // The fate of the weak property is determined by its key.
     ObjectPtr raw_key = LoadPointerIgnoreRace(&raw_weak->ptr()->key_);
     if (raw_key->IsHeapObject() && raw_key->IsOldObject() &&
-        !raw_key->ptr()->IsMarked()) {
+        !OldPage::IsMarked(raw_key)) {
       // Key was white. Enqueue the weak property.
       if (did_mark) {
         EnqueueWeakProperty(raw_weak);
@@ -183,18 +221,16 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
   // Called when all marking is complete.
   void Finalize() {
     work_list_.Finalize();
-    // Clear pending weak properties.
-    WeakPropertyPtr cur_weak = delayed_weak_properties_;
+    // Clear pending weak properties, including segments left unresolved by
+    // the last round of the fixpoint.
+    ClearWeakProperties(delayed_weak_properties_);
     delayed_weak_properties_ = nullptr;
-    intptr_t weak_properties_cleared = 0;
-    while (cur_weak != nullptr) {
-      uword next_weak = cur_weak->ptr()->next_;
-      cur_weak->ptr()->next_ = 0;
-      RELEASE_ASSERT(!cur_weak->ptr()->key_->ptr()->IsMarked());
-      WeakProperty::Clear(cur_weak);
-      weak_properties_cleared++;
-      // Advance to next weak property in the queue.
-      cur_weak = static_cast<WeakPropertyPtr>(next_weak);
+    delayed_weak_count_ = 0;
+    WeakPropertyPtr segment;
+    for (intptr_t round = round_; round <= round_ + 1; round++) {
+      while ((segment = marker_->TakeWeakProperties(round)) != nullptr) {
+        ClearWeakProperties(segment);
+      }
     }
   }
 
@@ -209,11 +245,38 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
     ASSERT(raw_obj->IsOldObject());
 
     // Push the marked object on the marking stack.
-    ASSERT(raw_obj->ptr()->IsMarked());
+    ASSERT(OldPage::IsMarked(raw_obj));
     work_list_.Push(raw_obj);
   }
 
+  static void ClearWeakProperties(WeakPropertyPtr cur_weak) {
+    while (cur_weak != nullptr) {
+      uword next_weak = cur_weak->ptr()->next_;
+      cur_weak->ptr()->next_ = 0;
+      RELEASE_ASSERT(!OldPage::IsMarked(cur_weak->ptr()->key_));
+      WeakProperty::Clear(cur_weak);
+      // Advance to next weak property in the queue.
+      cur_weak = static_cast<WeakPropertyPtr>(next_weak);
+    }
+  }
+
+  // Objects marked through the header bit (allocated or shaded black while
+  // marking) are pushed without their side bit. Returns false if the object
+  // was already visited.
+  static bool AcquireBitmapBitOfShaded(ObjectPtr raw_obj) {
+    if (!raw_obj->ptr()->IsMarked()) {
+      return true;
+    }
+    return OldPage::Of(raw_obj)->TryMarkInBitmap<sync>(
+        ObjectLayout::ToAddr(raw_obj));
+  }
+
   static bool TryAcquireMarkBit(ObjectPtr raw_obj) {
+    if (FLAG_mark_bitmap) {
+      // The side bitmap is not affected by W^X.
+      return OldPage::Of(raw_obj)->TryMarkInBitmap<sync>(
+          ObjectLayout::ToAddr(raw_obj));
+    }
     if (FLAG_write_protect_code && raw_obj->IsInstructions()) {
       // A non-writable alias mapping may exist for instruction pages.
       raw_obj = OldPage::ToWritable(raw_obj);
@@ -240,7 +303,7 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
     // change in the value.
     // Doing this before checking for an Instructions object avoids
     // unnecessary queueing of pre-marked objects.
-    if (raw_obj->ptr()->IsMarked()) {
+    if (OldPage::IsMarked(raw_obj)) {
       return;
     }
 
@@ -262,11 +325,18 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
     PushMarked(raw_obj);
   }
 
+  static const intptr_t kWeakPropertySegmentSize = 1024;
+
   Thread* thread_;
+  GCMarker* marker_;
   PageSpace* page_space_;
   MarkerWorkList work_list_;
   MarkerWorkList deferred_work_list_;
   WeakPropertyPtr delayed_weak_properties_;
+  intptr_t delayed_weak_count_;
+  // Round of the ephemeron fixpoint, see ProcessSharedWeakProperties.
+  intptr_t round_;
+  intptr_t publish_round_;
   uintptr_t marked_bytes_;
   int64_t marked_micros_;
 
@@ -286,7 +356,7 @@ static bool IsUnreachable(const ObjectPtr raw_obj) {
   if (!raw_obj->IsOldObject()) {
     return false;
   }
-  return !raw_obj->ptr()->IsMarked();
+  return !OldPage::IsMarked(raw_obj);
 }
 
 class MarkingWeakVisitor : public HandleVisitor {
@@ -387,26 +457,20 @@ void GCMarker::IterateRoots(ObjectPointerVisitor* visitor) {
 
 enum WeakSlices {
   kWeakHandles = 0,
-  kWeakTables,
   kObjectIdRing,
   kRememberedSet,
-  kNumWeakSlices,
+  kNumFixedWeakSlices,
+  // Followed by one slice per chunk of each old-space weak table.
 };
 
 void GCMarker::IterateWeakRoots(Thread* thread) {
   for (;;) {
     intptr_t slice = weak_slices_started_.fetch_add(1);
-    if (slice >= kNumWeakSlices) {
-      return;  // No more slices.
-    }
 
     switch (slice) {
       case kWeakHandles:
         ProcessWeakHandles(thread);
         break;
-      case kWeakTables:
-        ProcessWeakTables(thread);
-        break;
       case kObjectIdRing:
         ProcessObjectIdTable(thread);
         break;
@@ -414,7 +478,9 @@ void GCMarker::IterateWeakRoots(Thread* thread) {
         ProcessRememberedSet(thread);
         break;
       default:
-        UNREACHABLE();
+        if (!ProcessWeakTableChunk(thread, slice - kNumFixedWeakSlices)) {
+          return;  // No more slices.
+        }
     }
   }
 }
@@ -427,22 +493,34 @@ void GCMarker::ProcessWeakHandles(Thread* thread) {
   isolate_group_->VisitWeakPersistentHandles(&visitor);
 }
 
-void GCMarker::ProcessWeakTables(Thread* thread) {
-  TIMELINE_FUNCTION_GC_DURATION(thread, "ProcessWeakTables");
+bool GCMarker::ProcessWeakTableChunk(Thread* thread, intptr_t chunk) {
   for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
     WeakTable* table =
         heap_->GetWeakTable(Heap::kOld, static_cast<Heap::WeakSelector>(sel));
-    intptr_t size = table->size();
-    for (intptr_t i = 0; i < size; i++) {
+    const intptr_t num_chunks = table->NumGCChunks();
+    if (chunk >= num_chunks) {
+      chunk -= num_chunks;
+      continue;
+    }
+    TIMELINE_FUNCTION_GC_DURATION(thread, "ProcessWeakTables");
+    const intptr_t start = chunk * WeakTable::kGCChunkSize;
+    const intptr_t end =
+        Utils::Minimum(start + WeakTable::kGCChunkSize, table->size());
+    intptr_t removed = 0;
+    for (intptr_t i = start; i < end; i++) {
       if (table->IsValidEntryAtExclusive(i)) {
         ObjectPtr raw_obj = table->ObjectAtExclusive(i);
         ASSERT(raw_obj->IsHeapObject());
-        if (!raw_obj->ptr()->IsMarked()) {
-          table->InvalidateAtExclusive(i);
+        if (!OldPage::IsMarked(raw_obj)) {
+          table->InvalidateAtConcurrently(i);
+          removed++;
         }
       }
     }
+    table->RemoveFromCountConcurrently(removed);
+    return true;
   }
+  return false;
 }
 
 void GCMarker::ProcessRememberedSet(Thread* thread) {
@@ -459,7 +537,7 @@ void GCMarker::ProcessRememberedSet(Thread* thread) {
       ObjectPtr raw_object = reading->Pop();
       ASSERT(!raw_object->IsForwardingCorpse());
       ASSERT(raw_object->ptr()->IsRemembered());
-      if (raw_object->ptr()->IsMarked()) {
+      if (OldPage::IsMarked(raw_object)) {
         writing->Push(raw_object);
         if (writing->IsFull()) {
           store_buffer->PushBlock(writing, StoreBuffer::kIgnoreThreshold);
@@ -484,7 +562,7 @@ class ObjectIdRingClearPointerVisitor : public ObjectPointerVisitor {
     for (ObjectPtr* current = first; current <= last; current++) {
       ObjectPtr raw_obj = *current;
       ASSERT(raw_obj->IsHeapObject());
-      if (raw_obj->IsOldObject() && !raw_obj->ptr()->IsMarked()) {
+      if (raw_obj->IsOldObject() && !OldPage::IsMarked(raw_obj)) {
         // Object has become garbage. Replace it will null.
         *current = Object::null();
       }
@@ -571,7 +649,7 @@ class ParallelMarkTask : public ThreadPool::Task {
 #endif
         // Check if we have any pending properties with marked keys.
         // Those might have been marked by another marker.
-        more_to_mark = visitor_->ProcessPendingWeakProperties();
+        more_to_mark = visitor_->ProcessSharedWeakProperties();
         if (more_to_mark) {
           // We have more work to do. Notify others.
           num_busy_->fetch_add(1u);
@@ -693,6 +771,20 @@ void GCMarker::FinalizeResultsFrom(MarkingVisitorType* visitor) {
   visitor->Finalize();
 }
 
+void GCMarker::PublishWeakProperties(intptr_t round, WeakPropertyPtr segment) {
+  MutexLocker ml(&weak_pool_mutex_);
+  weak_pool_[round & 1].Add(segment);
+}
+
+WeakPropertyPtr GCMarker::TakeWeakProperties(intptr_t round) {
+  MutexLocker ml(&weak_pool_mutex_);
+  MallocGrowableArray<WeakPropertyPtr>* pool = &weak_pool_[round & 1];
+  if (pool->is_empty()) {
+    return nullptr;
+  }
+  return pool->RemoveLast();
+}
+
 intptr_t GCMarker::MarkedWordsPerMicro() const {
   intptr_t marked_words_per_job_micro;
   if (marked_micros_ == 0) {
@@ -757,8 +849,9 @@ void GCMarker::StartConcurrentMark(PageSpace* page_space) {
   ResetSlices();
   for (intptr_t i = 0; i < num_tasks; i++) {
     ASSERT(visitors_[i] == NULL);
-    visitors_[i] = new SyncMarkingVisitor(
-        isolate_group_, page_space, &marking_stack_, &deferred_marking_stack_);
+    visitors_[i] =
+        new SyncMarkingVisitor(this, isolate_group_, page_space,
+                               &marking_stack_, &deferred_marking_stack_);
 
     // Begin marking on a helper thread.
     bool result = Dart::thread_pool()->Run<ConcurrentMarkTask>(
@@ -788,8 +881,8 @@ void GCMarker::MarkObjects(PageSpace* page_space) {
       TIMELINE_FUNCTION_GC_DURATION(thread, "Mark");
       int64_t start = OS::GetCurrentMonotonicMicros();
       // Mark everything on main thread.
-      UnsyncMarkingVisitor mark(isolate_group_, page_space, &marking_stack_,
-                                &deferred_marking_stack_);
+      UnsyncMarkingVisitor mark(this, isolate_group_, page_space,
+                                &marking_stack_, &deferred_marking_stack_);
       ResetSlices();
       IterateRoots(&mark);
       mark.ProcessDeferredMarking();
@@ -812,9 +905,9 @@ void GCMarker::MarkObjects(PageSpace* page_space) {
           visitor = visitors_[i];
           visitors_[i] = NULL;
         } else {
-          visitor =
-              new SyncMarkingVisitor(isolate_group_, page_space,
-                                     &marking_stack_, &deferred_marking_stack_);
+          visitor = new SyncMarkingVisitor(this, isolate_group_, page_space,
+                                           &marking_stack_,
+                                           &deferred_marking_stack_);
         }
         if (i < (num_tasks - 1)) {
           // Begin marking on a helper thread.
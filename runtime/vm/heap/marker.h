@@ -5,9 +5,11 @@
 #ifndef RUNTIME_VM_HEAP_MARKER_H_
 #define RUNTIME_VM_HEAP_MARKER_H_
 
+#include "platform/growable_array.h"
 #include "vm/allocation.h"
 #include "vm/heap/pointer_block.h"
 #include "vm/os_thread.h"  // Mutex.
+#include "vm/tagged_pointer.h"
 
 namespace dart {
 
@@ -52,10 +54,18 @@ class GCMarker {
   void IterateRoots(ObjectPointerVisitor* visitor);
   void IterateWeakRoots(Thread* thread);
   void ProcessWeakHandles(Thread* thread);
-  void ProcessWeakTables(Thread* thread);
+  // Returns false if there is no such chunk.
+  bool ProcessWeakTableChunk(Thread* thread, intptr_t chunk);
   void ProcessRememberedSet(Thread* thread);
   void ProcessObjectIdTable(Thread* thread);
 
+  // Segments of weak properties whose keys were not marked yet, shared by the
+  // marking tasks so that the ephemeron fixpoint is spread over all of them.
+  // Segments published during a round of the fixpoint are taken in the same
+  // round, while those left unresolved are published for the next one.
+  void PublishWeakProperties(intptr_t round, WeakPropertyPtr segment);
+  WeakPropertyPtr TakeWeakProperties(intptr_t round);
+
   // Called by anyone: finalize and accumulate stats from 'visitor'.
   template <class MarkingVisitorType>
   void FinalizeResultsFrom(MarkingVisitorType* visitor);
@@ -73,10 +83,15 @@ class GCMarker {
   intptr_t root_slices_count_;
   RelaxedAtomic<intptr_t> weak_slices_started_;
 
+  Mutex weak_pool_mutex_;
+  MallocGrowableArray<WeakPropertyPtr> weak_pool_[2];
+
   Mutex stats_mutex_;
   uintptr_t marked_bytes_;
   int64_t marked_micros_;
 
+  template <bool sync>
+  friend class MarkingVisitorBase;
   friend class ConcurrentMarkTask;
   friend class ParallelMarkTask;
   DISALLOW_IMPLICIT_CONSTRUCTORS(GCMarker);
@@ -42,6 +42,17 @@ DEFINE_FLAG(bool,
             false,
             "Print free list statistics after a GC");
 DEFINE_FLAG(bool, log_growth, false, "Log PageSpace growth policy decisions.");
+DEFINE_FLAG(int,
+            compaction_pause_budget_ms,
+            0,
+            "If positive, compaction only slides the most fragmented pages "
+            "that it expects to move within this many milliseconds");
+DEFINE_FLAG(int,
+            compaction_budget_words,
+            0,
+            "If positive, compaction only slides the most fragmented pages "
+            "whose live objects add up to about this many words. Overrides "
+            "--compaction_pause_budget_ms.");
 
 OldPage* OldPage::Allocate(intptr_t size_in_words,
                            PageType type,
@@ -61,6 +72,11 @@ OldPage* OldPage::Allocate(intptr_t size_in_words,
   result->used_in_bytes_ = 0;
   result->forwarding_page_ = NULL;
   result->card_table_ = NULL;
+  result->mark_bitmap_ = NULL;
+  if (FLAG_mark_bitmap) {
+    result->mark_bitmap_ = reinterpret_cast<RelaxedAtomic<uword>*>(
+        calloc(kMarkBitmapWords, sizeof(uword)));
+  }
   result->type_ = type;
 
   LSAN_REGISTER_ROOT_REGION(result, sizeof(*result));
@@ -73,6 +89,10 @@ void OldPage::Deallocate() {
     free(card_table_);
     card_table_ = NULL;
   }
+  if (mark_bitmap_ != NULL) {
+    free(mark_bitmap_);
+    mark_bitmap_ = NULL;
+  }
 
   bool image_page = is_image_page();
 
@@ -91,6 +111,52 @@ void OldPage::Deallocate() {
   }
 }
 
+uword OldPage::NextMarkedInBitmap(uword addr, uword end) const {
+  ASSERT(mark_bitmap_ != NULL);
+  if (addr >= end) {
+    return end;
+  }
+  const uword page_start = reinterpret_cast<uword>(this);
+  const intptr_t end_bit =
+      Utils::Minimum(static_cast<intptr_t>(end - page_start), kOldPageSize) >>
+      kObjectAlignmentLog2;
+  intptr_t bit = MarkBitmapIndex(addr);
+  intptr_t index = bit >> kBitsPerWordLog2;
+  // Ignore the bits below addr in the first word.
+  uword word = mark_bitmap_[index].load() &
+               ~((static_cast<uword>(1) << (bit & (kBitsPerWord - 1))) - 1);
+  while (true) {
+    if (word != 0) {
+      bit = (index << kBitsPerWordLog2) + Utils::CountTrailingZerosWord(word);
+      if (bit >= end_bit) {
+        return end;
+      }
+      return page_start + (bit << kObjectAlignmentLog2);
+    }
+    index++;
+    if ((index << kBitsPerWordLog2) >= end_bit) {
+      return end;
+    }
+    word = mark_bitmap_[index].load();
+  }
+}
+
+void OldPage::EnsureMarkBitmap() {
+  if (is_image_page() || (mark_bitmap_ != NULL)) {
+    return;
+  }
+  mark_bitmap_ = reinterpret_cast<RelaxedAtomic<uword>*>(
+      calloc(kMarkBitmapWords, sizeof(uword)));
+}
+
+void OldPage::ClearMarkBitmap() {
+  if (mark_bitmap_ == NULL) {
+    return;
+  }
+  memset(reinterpret_cast<void*>(mark_bitmap_), 0,
+         kMarkBitmapWords * sizeof(uword));
+}
+
 void OldPage::VisitObjects(ObjectVisitor* visitor) const {
   ASSERT(Thread::Current()->IsAtSafepoint());
   NoSafepointScope no_safepoint;
@@ -117,46 +183,76 @@ void OldPage::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
   ASSERT(obj_addr == end_addr);
 }
 
-void OldPage::VisitRememberedCards(ObjectPointerVisitor* visitor) {
+intptr_t OldPage::VisitRememberedCards(ObjectPointerVisitor* visitor) {
   ASSERT(Thread::Current()->IsAtSafepoint() ||
          (Thread::Current()->task_kind() == Thread::kScavengerTask));
   NoSafepointScope no_safepoint;
 
   if (card_table_ == NULL) {
-    return;
+    return 0;
   }
 
-  bool table_is_empty = false;
+  bool table_is_empty = true;
+  intptr_t cards_visited = 0;
 
   ArrayPtr obj = static_cast<ArrayPtr>(ObjectLayout::FromAddr(object_start()));
-  ASSERT(obj->IsArray());
+  ASSERT(obj->IsArray() || obj->IsImmutableArray());
   ASSERT(obj->ptr()->IsCardRemembered());
   ObjectPtr* obj_from = obj->ptr()->from();
   ObjectPtr* obj_to = obj->ptr()->to(Smi::Value(obj->ptr()->length_));
 
   const intptr_t size = card_table_size();
-  for (intptr_t i = 0; i < size; i++) {
-    if (card_table_[i] != 0) {
-      ObjectPtr* card_from =
-          reinterpret_cast<ObjectPtr*>(this) + (i << kSlotsPerCardLog2);
-      ObjectPtr* card_to = reinterpret_cast<ObjectPtr*>(card_from) +
-                           (1 << kSlotsPerCardLog2) - 1;
-      // Minus 1 because to is inclusive.
-
-      if (card_from < obj_from) {
-        // First card overlaps with header.
-        card_from = obj_from;
-      }
-      if (card_to > obj_to) {
-        // Last card(s) may extend past the object. Array truncation can make
-        // this happen for more than one card.
-        card_to = obj_to;
-      }
+  intptr_t i = 0;
+  while (i < size) {
+    // Skip clean cards a word at a time; most of a large array's cards are
+    // usually clean.
+    if (Utils::IsAligned(i, kWordSize) && (i + kWordSize <= size) &&
+        (*reinterpret_cast<uword*>(&card_table_[i]) == 0)) {
+      i += kWordSize;
+      continue;
+    }
+    if (card_table_[i] == 0) {
+      i++;
+      continue;
+    }
+
+    // Visit a run of adjacent remembered cards at once.
+    intptr_t run_end = i + 1;
+    while ((run_end < size) && (card_table_[run_end] != 0)) {
+      run_end++;
+    }
+    cards_visited += run_end - i;
+
+    ObjectPtr* card_from =
+        reinterpret_cast<ObjectPtr*>(this) + (i << kSlotsPerCardLog2);
+    ObjectPtr* card_to =
+        reinterpret_cast<ObjectPtr*>(this) + (run_end << kSlotsPerCardLog2) - 1;
+    // Minus 1 because to is inclusive.
 
+    if (card_from < obj_from) {
+      // First card overlaps with header.
+      card_from = obj_from;
+    }
+    if (card_to > obj_to) {
+      // Last card(s) may extend past the object. Array truncation can make
+      // this happen for more than one card.
+      card_to = obj_to;
+    }
+
+    if (card_from <= card_to) {
       visitor->VisitPointers(card_from, card_to);
+    }
+
+    // Keep only the cards which still point into new space remembered.
+    for (intptr_t j = i; j < run_end; j++) {
+      ObjectPtr* slot_from =
+          reinterpret_cast<ObjectPtr*>(this) + (j << kSlotsPerCardLog2);
+      ObjectPtr* slot_to = slot_from + (1 << kSlotsPerCardLog2) - 1;
+      if (slot_from < card_from) slot_from = card_from;
+      if (slot_to > card_to) slot_to = card_to;
 
       bool has_new_target = false;
-      for (ObjectPtr* slot = card_from; slot <= card_to; slot++) {
+      for (ObjectPtr* slot = slot_from; slot <= slot_to; slot++) {
         if ((*slot)->IsNewObjectMayBeSmi()) {
           has_new_target = true;
           break;
@@ -167,15 +263,17 @@ void OldPage::VisitRememberedCards(ObjectPointerVisitor* visitor) {
         // Card remains remembered.
         table_is_empty = false;
       } else {
-        card_table_[i] = 0;
+        card_table_[j] = 0;
       }
     }
+    i = run_end;
   }
 
   if (table_is_empty) {
     free(card_table_);
     card_table_ = NULL;
   }
+  return cards_visited;
 }
 
 ObjectPtr OldPage::FindObject(FindObjectVisitor* visitor) const {
@@ -217,6 +315,7 @@ void OldPage::WriteProtect(bool read_only) {
 // Flutter on a Nexus 4. After the first mark-sweep, we instead use a value
 // based on the device's actual speed.
 static const intptr_t kConservativeInitialMarkSpeed = 20;
+static const intptr_t kConservativeInitialCompactSpeed = 20;
 
 PageSpace::PageSpace(Heap* heap, intptr_t max_capacity_in_words)
     : heap_(heap),
@@ -241,6 +340,7 @@ PageSpace::PageSpace(Heap* heap, intptr_t max_capacity_in_words)
       gc_time_micros_(0),
       collections_(0),
       mark_words_per_micro_(kConservativeInitialMarkSpeed),
+      compact_words_per_micro_(kConservativeInitialCompactSpeed),
       enable_concurrent_mark_(FLAG_concurrent_mark) {
   // We aren't holding the lock but no one can reference us yet.
   UpdateMaxCapacityLocked();
@@ -369,6 +469,9 @@ OldPage* PageSpace::AllocatePage(OldPage::PageType type, bool link) {
       (heap_->isolate_group() != Dart::vm_isolate()->group())) {
     page->AllocateForwardingPage();
   }
+  // Until the page is first swept, treat it as full so that budgeted
+  // compaction does not pick it over pages known to be fragmented.
+  page->set_used_in_bytes(page->object_end() - page->object_start());
   return page;
 }
 
@@ -681,6 +784,14 @@ void PageSpace::AbandonBumpAllocation() {
   }
 }
 
+void PageSpace::EnsureMarkBitmaps() {
+  ASSERT(FLAG_mark_bitmap);
+  MutexLocker ml(&pages_lock_);
+  for (UnsafeExclusivePageIterator it(this); !it.Done(); it.Advance()) {
+    it.page()->EnsureMarkBitmap();
+  }
+}
+
 void PageSpace::AbandonMarkingForShutdown() {
   delete marker_;
   marker_ = NULL;
@@ -790,9 +901,8 @@ void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
   }
 }
 
-void PageSpace::VisitRememberedCards(ObjectPointerVisitor* visitor) const {
-  ASSERT(Thread::Current()->IsAtSafepoint() ||
-         (Thread::Current()->task_kind() == Thread::kScavengerTask));
+void PageSpace::PrepareRememberedCards() {
+  ASSERT(Thread::Current()->IsAtSafepoint());
 
   // Wait for the sweeper to finish mutating the large page list.
   MonitorLocker ml(tasks_lock());
@@ -800,22 +910,32 @@ void PageSpace::VisitRememberedCards(ObjectPointerVisitor* visitor) const {
     ml.Wait();  // No safepoint check.
   }
 
-  // Large pages may be added concurrently due to promotion in another scavenge
-  // worker, so terminate the traversal when we hit the tail we saw while
-  // holding the pages lock, instead of at NULL, otherwise we are racing when we
-  // read OldPage::next_ and OldPage::remembered_cards_.
-  OldPage* page;
-  OldPage* tail;
-  {
-    MutexLocker ml(&pages_lock_);
-    page = large_pages_;
-    tail = large_pages_tail_;
-  }
+  // Large pages may be added concurrently due to promotion in a scavenge
+  // worker, so the traversal terminates at the tail we saw while holding the
+  // pages lock, instead of at NULL, otherwise we are racing when we read
+  // OldPage::next_ and OldPage::remembered_cards_.
+  MutexLocker pl(&pages_lock_);
+  remembered_cards_next_.store(large_pages_);
+  remembered_cards_tail_ = large_pages_tail_;
+}
+
+intptr_t PageSpace::VisitRememberedCards(ObjectPointerVisitor* visitor) {
+  ASSERT(Thread::Current()->IsAtSafepoint() ||
+         (Thread::Current()->task_kind() == Thread::kScavengerTask));
+
+  intptr_t cards_visited = 0;
+  OldPage* page = remembered_cards_next_.load();
   while (page != nullptr) {
-    page->VisitRememberedCards(visitor);
-    if (page == tail) break;
-    page = page->next();
+    // Only this list's own pages are read here, never the tail's next_, which
+    // may be written by promotion concurrently.
+    OldPage* next = (page == remembered_cards_tail_) ? nullptr : page->next();
+    if (remembered_cards_next_.compare_exchange_weak(page, next)) {
+      cards_visited += page->VisitRememberedCards(visitor);
+      page = next;
+    }
+    // Otherwise 'page' was updated to the current unclaimed page.
   }
+  return cards_visited;
 }
 
 ObjectPtr PageSpace::FindObject(FindObjectVisitor* visitor,
@@ -878,6 +998,9 @@ void PageSpace::PrintToJSONObject(JSONObject* object) const {
   } else {
     space.AddProperty("avgCollectionPeriodMillis", 0.0);
   }
+  if (FLAG_gc_target_overhead > 0) {
+    page_space_controller_.PrintToJSONObject(&space);
+  }
 }
 
 class HeapMapAsJSONVisitor : public ObjectVisitor {
@@ -1122,6 +1245,9 @@ void PageSpace::CollectGarbageAtSafepoint(bool compact,
   // Mark all reachable old-gen objects.
   if (marker_ == NULL) {
     ASSERT(phase() == kDone);
+    if (FLAG_mark_bitmap) {
+      EnsureMarkBitmaps();
+    }
     marker_ = new GCMarker(isolate_group, heap_);
   } else {
     ASSERT(phase() == kAwaitingFinalization);
@@ -1186,7 +1312,6 @@ void PageSpace::CollectGarbageAtSafepoint(bool compact,
   if (compact) {
     SweepLarge();
     Compact(thread);
-    set_phase(kDone);
   } else if (FLAG_concurrent_sweep) {
     ConcurrentSweep(isolate_group);
   } else {
@@ -1292,14 +1417,38 @@ void PageSpace::ConcurrentSweep(IsolateGroup* isolate_group) {
 void PageSpace::Compact(Thread* thread) {
   thread->isolate_group()->set_compaction_in_progress(true);
   GCCompactor compactor(thread, heap_);
-  compactor.Compact(pages_, &freelists_[OldPage::kData], &pages_lock_);
+  intptr_t budget_in_words = 0;
+  if (FLAG_compaction_budget_words > 0) {
+    budget_in_words = FLAG_compaction_budget_words;
+  } else if (FLAG_compaction_pause_budget_ms > 0) {
+    budget_in_words = static_cast<intptr_t>(FLAG_compaction_pause_budget_ms) *
+                      kMicrosecondsPerMillisecond * compact_words_per_micro_ *
+                      Utils::Maximum(FLAG_compactor_tasks, 1);
+  }
+  compactor.Compact(pages_, &freelists_[OldPage::kData], &pages_lock_,
+                    budget_in_words);
   thread->isolate_group()->set_compaction_in_progress(false);
+  if (compactor.compact_micros() > 0) {
+    compact_words_per_micro_ = Utils::Maximum<intptr_t>(
+        1, compactor.compacted_in_words() / compactor.compact_micros());
+  }
 
   if (FLAG_verify_after_gc) {
     OS::PrintErr("Verifying after compacting...");
     heap_->VerifyGC(kForbidMarked);
     OS::PrintErr(" done.\n");
   }
+
+  // Pages that were not compacted may be swept after the pause.
+  OldPage* unswept_tail = compactor.unswept_pages_tail();
+  if (unswept_tail != nullptr) {
+    GCSweeper::SweepConcurrent(thread->isolate_group(), pages_, unswept_tail,
+                               /*large_first=*/nullptr,
+                               /*large_last=*/nullptr,
+                               &freelists_[OldPage::kData]);
+  } else {
+    set_phase(kDone);
+  }
 }
 
 uword PageSpace::TryAllocateDataBumpLocked(FreeList* freelist, intptr_t size) {
@@ -1346,13 +1495,71 @@ uword PageSpace::TryAllocateDataBumpLocked(FreeList* freelist, intptr_t size) {
   return result;
 }
 
-uword PageSpace::TryAllocatePromoLockedSlow(FreeList* freelist, intptr_t size) {
-  uword result = freelist->TryAllocateSmallLocked(size);
-  if (result != 0) {
-    freelist->AddUnaccountedSize(size);
-    return result;
+// Size of the private buffers scavenger tasks promote into. Large free blocks
+// are used whole, so most buffers are bigger than this.
+static constexpr intptr_t kPromoBufferSize = 32 * KB;
+// Larger objects are promoted individually so they don't waste most of a
+// buffer.
+static constexpr intptr_t kMaxBufferedPromoSize = kPromoBufferSize / 4;
+
+uword PageSpace::TryAllocatePromoSlow(FreeList* freelist,
+                                      intptr_t size,
+                                      uword* top,
+                                      uword* end) {
+  ASSERT(size >= kObjectAlignment);
+  ASSERT(Utils::IsAligned(size, kObjectAlignment));
+
+  MutexLocker ml(freelist->mutex());
+  if (size > kMaxBufferedPromoSize) {
+    return TryAllocateDataLocked(freelist, size, kForceGrowth);
+  }
+
+  const intptr_t remaining = *end - *top;
+  if (remaining > 0) {
+    freelist->FreeLocked(*top, remaining);
+    usage_.used_in_words -= (remaining >> kWordSizeLog2);
   }
-  return TryAllocateDataBumpLocked(freelist, size);
+  *top = *end = 0;
+
+  // Carve the new buffer out of a large free block, which keeps the promoted
+  // objects of this task together.
+  FreeListElement* block = freelist->TryAllocateLargeLocked(kPromoBufferSize);
+  if (block != nullptr) {
+    const intptr_t block_size = block->HeapSize();
+    usage_.used_in_words += (block_size >> kWordSizeLog2);
+    *top = reinterpret_cast<uword>(block);
+    *end = *top + block_size;
+  } else {
+    // Fill holes that are too small for a buffer before growing.
+    uword result = freelist->TryAllocateLocked(size, /*is_protected=*/false);
+    if (result != 0) {
+      usage_.used_in_words += (size >> kWordSizeLog2);
+      return result;
+    }
+    result = TryAllocateInFreshPage(kPromoBufferSize, freelist, OldPage::kData,
+                                    kForceGrowth, /*is_locked=*/true);
+    if (result == 0) {
+      return 0;
+    }
+    // Note: usage_ is updated by TryAllocateInFreshPage.
+    *top = result;
+    *end = result + kPromoBufferSize;
+  }
+
+  ASSERT(*end - *top >= static_cast<uword>(size));
+  uword result = *top;
+  *top = result + size;
+  return result;
+}
+
+void PageSpace::RetirePromoBuffer(FreeList* freelist, uword* top, uword* end) {
+  const intptr_t remaining = *end - *top;
+  if (remaining > 0) {
+    MutexLocker ml(freelist->mutex());
+    freelist->FreeLocked(*top, remaining);
+    usage_.used_in_words -= (remaining >> kWordSizeLog2);
+  }
+  *top = *end = 0;
 }
 
 void PageSpace::SetupImagePage(void* pointer, uword size, bool is_executable) {
@@ -1374,6 +1581,7 @@ void PageSpace::SetupImagePage(void* pointer, uword size, bool is_executable) {
   page->used_in_bytes_ = page->object_end_ - page->object_start();
   page->forwarding_page_ = NULL;
   page->card_table_ = NULL;
+  page->mark_bitmap_ = NULL;
   if (is_executable) {
     page->type_ = OldPage::kExecutable;
   } else {
@@ -1541,6 +1749,7 @@ void PageSpaceController::EvaluateGarbageCollection(SpaceUsage before,
   history_.AddGarbageCollectionTime(start, end);
   const int gc_time_fraction = history_.GarbageCollectionTimeFraction();
   heap_->RecordData(PageSpace::kGCTimeFraction, gc_time_fraction);
+  gc_time_fraction_ = gc_time_fraction;
 
   // Assume garbage increases linearly with allocation:
   // G = kA, and estimate k from the previous cycle.
@@ -1611,6 +1820,14 @@ void PageSpaceController::EvaluateGarbageCollection(SpaceUsage before,
     heap_->RecordData(PageSpace::kGarbageRatio, 100);
     grow_heap = 0;
   }
+  if (FLAG_gc_target_overhead > 0) {
+    const intptr_t target_growth = TargetOverheadGrowthInPages(
+        start, end, Utils::Maximum<intptr_t>(allocated_since_previous_gc, 0));
+    if (target_growth >= 0) {
+      grow_heap = target_growth;
+    }
+  }
+  last_end_micros_ = end;
   heap_->RecordData(PageSpace::kPageGrowth, grow_heap);
 
   // Limit shrinkage: allow growth by at least half the pages freed by GC.
@@ -1620,10 +1837,47 @@ void PageSpaceController::EvaluateGarbageCollection(SpaceUsage before,
   grow_heap = Utils::Maximum(grow_heap, freed_pages / 2);
   heap_->RecordData(PageSpace::kAllowedGrowth, grow_heap);
   last_usage_ = after;
+  growth_in_pages_ = grow_heap;
 
   RecordUpdate(before, after, grow_heap, "gc");
 }
 
+// If a collection costs C and the mutator allocates at rate R, then keeping
+// GC to a fraction o of run time means running the next one no sooner than
+// C * (1 - o) / o later, by which time R * C * (1 - o) / o more words are
+// allocated. Returns -1 if there is no allocation rate to go by yet.
+intptr_t PageSpaceController::TargetOverheadGrowthInPages(
+    int64_t start,
+    int64_t end,
+    intptr_t allocated_in_words) {
+  if (last_end_micros_ == 0 || start <= last_end_micros_) {
+    return -1;
+  }
+  allocated_words_per_micro_ =
+      allocated_in_words / static_cast<double>(start - last_end_micros_);
+  const double overhead =
+      Utils::Minimum(FLAG_gc_target_overhead, 100) / 100.0;
+  const double interval_micros = (end - start) * (1.0 - overhead) / overhead;
+  const double growth_in_words = allocated_words_per_micro_ * interval_micros;
+  const intptr_t growth_in_pages = static_cast<intptr_t>(
+      Utils::Minimum(growth_in_words / kOldPageSizeInWords,
+                     static_cast<double>(heap_growth_max_)));
+  return growth_in_pages;
+}
+
+#ifndef PRODUCT
+void PageSpaceController::PrintToJSONObject(JSONObject* object) const {
+  JSONObject sizing(object, "_sizing");
+  AddGCSizingProperties(&sizing, gc_time_fraction_,
+                        allocated_words_per_micro_);
+  sizing.AddProperty("growthInPages", growth_in_pages_);
+  sizing.AddProperty64("hardThreshold",
+                       hard_gc_threshold_in_words_ * kWordSize);
+  sizing.AddProperty64("softThreshold",
+                       soft_gc_threshold_in_words_ * kWordSize);
+}
+#endif  // !PRODUCT
+
 void PageSpaceController::EvaluateAfterLoading(SpaceUsage after) {
   // Number of pages we can allocate and still be within the desired growth
   // ratio.
@@ -145,9 +145,70 @@ class OldPage {
     ASSERT((index >= 0) && (index < card_table_size()));
     card_table_[index] = 1;
   }
-  void VisitRememberedCards(ObjectPointerVisitor* visitor);
+  // Visits the slots of all remembered cards, treating runs of adjacent
+  // remembered cards as a single range. Returns the number of cards visited.
+  intptr_t VisitRememberedCards(ObjectPointerVisitor* visitor);
+
+  // With --mark_bitmap, the marker records marks in a side bitmap with one
+  // bit per allocation unit instead of in object headers. The header mark bit
+  // is then only set for objects allocated or shaded black while concurrent
+  // marking is in progress, and those also get their side bit when the
+  // marker visits them. The bitmap covers the first kOldPageSize bytes, which
+  // includes the start of the single object on a large page.
+  static constexpr intptr_t kMarkBitmapWords =
+      (kOldPageSize >> kObjectAlignmentLog2) / kBitsPerWord;
+
+  bool IsMarkedInBitmap(uword addr) const {
+    ASSERT(mark_bitmap_ != NULL);
+    const intptr_t bit = MarkBitmapIndex(addr);
+    return (mark_bitmap_[bit >> kBitsPerWordLog2].load() &
+            (static_cast<uword>(1) << (bit & (kBitsPerWord - 1)))) != 0;
+  }
+  // Returns whether this call set the bit.
+  template <bool sync>
+  bool TryMarkInBitmap(uword addr) {
+    ASSERT(mark_bitmap_ != NULL);
+    const intptr_t bit = MarkBitmapIndex(addr);
+    const uword mask = static_cast<uword>(1) << (bit & (kBitsPerWord - 1));
+    RelaxedAtomic<uword>* word = &mark_bitmap_[bit >> kBitsPerWordLog2];
+    if (!sync) {
+      const uword old = word->load();
+      word->store(old | mask);
+      return (old & mask) == 0;
+    }
+    return (word->fetch_or(mask) & mask) == 0;
+  }
+  // Returns the address of the first object in [addr, end) with its side bit
+  // set, or end if there is none.
+  uword NextMarkedInBitmap(uword addr, uword end) const;
+  // Allocates a cleared bitmap for pages created before the flag was set.
+  void EnsureMarkBitmap();
+  // Called once the marks of this page have been consumed by the sweeper or
+  // the compactor, so the bitmap is clear when the next marking starts.
+  void ClearMarkBitmap();
+
+  // Whether obj is marked, either in its header or in the side bitmap.
+  // New-space objects are never marked.
+  static bool IsMarked(ObjectPtr obj) {
+    if (obj->ptr()->IsMarked()) {
+      return true;
+    }
+    if (!FLAG_mark_bitmap || !obj->IsOldObject()) {
+      return false;
+    }
+    // Image objects are always marked in the header, so obj has a bitmap.
+    return Of(obj)->IsMarkedInBitmap(ObjectLayout::ToAddr(obj));
+  }
 
  private:
+  intptr_t MarkBitmapIndex(uword addr) const {
+    // Code pages may be reached through their executable alias, which has the
+    // same layout relative to its page start.
+    const intptr_t offset = addr - reinterpret_cast<uword>(this);
+    ASSERT((offset >= 0) && (offset < kOldPageSize));
+    return offset >> kObjectAlignmentLog2;
+  }
+
   void set_object_end(uword value) {
     ASSERT((value & kObjectAlignmentMask) == kOldObjectAlignmentOffset);
     object_end_ = value;
@@ -168,6 +229,7 @@ class OldPage {
   uword used_in_bytes_;
   ForwardingPage* forwarding_page_;
   uint8_t* card_table_;  // Remembered set, not marking.
+  RelaxedAtomic<uword>* mark_bitmap_;
   PageType type_;
 
   friend class PageSpace;
@@ -235,9 +297,19 @@ class PageSpaceController {
   void Disable() { is_enabled_ = false; }
   bool is_enabled() { return is_enabled_; }
 
+#ifndef PRODUCT
+  void PrintToJSONObject(JSONObject* object) const;
+#endif  // !PRODUCT
+
  private:
   friend class PageSpace;  // For MergeOtherPageSpaceController
 
+  // Growth that keeps the time spent in GC near --gc_target_overhead, given
+  // the cost of the last collection and the allocation rate before it.
+  intptr_t TargetOverheadGrowthInPages(int64_t start,
+                                       int64_t end,
+                                       intptr_t allocated_in_words);
+
   void RecordUpdate(SpaceUsage before, SpaceUsage after, const char* reason);
   void MergeFrom(PageSpaceController* donor);
 
@@ -279,6 +351,12 @@ class PageSpaceController {
 
   PageSpaceGarbageCollectionHistory history_;
 
+  // Feedback from the last evaluated GC, kept for the service protocol.
+  int gc_time_fraction_ = 0;
+  int64_t last_end_micros_ = 0;
+  double allocated_words_per_micro_ = 0.0;
+  intptr_t growth_in_pages_ = 0;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(PageSpaceController);
 };
 
@@ -362,7 +440,14 @@ class PageSpace {
   void VisitObjectsImagePages(ObjectVisitor* visitor) const;
   void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
 
-  void VisitRememberedCards(ObjectPointerVisitor* visitor) const;
+  // Snapshots the large pages whose cards the scavenger tasks will visit.
+  // Must be called before any scavenger task starts.
+  void PrepareRememberedCards();
+
+  // Visits the remembered cards of large pages not yet claimed by another
+  // scavenger task since PrepareRememberedCards, one page at a time. Returns
+  // the number of cards visited.
+  intptr_t VisitRememberedCards(ObjectPointerVisitor* visitor);
 
   ObjectPtr FindObject(FindObjectVisitor* visitor,
                        OldPage::PageType type) const;
@@ -425,8 +510,12 @@ class PageSpace {
 
   // Bulk data allocation.
   FreeList* DataFreeList(intptr_t i = 0) {
+    ASSERT((i >= 0) && (i < num_data_freelists()));
     return &freelists_[OldPage::kData + i];
   }
+  intptr_t num_data_freelists() const {
+    return num_freelists_ - OldPage::kData;
+  }
   void AcquireLock(FreeList* freelist);
   void ReleaseLock(FreeList* freelist);
 
@@ -458,20 +547,37 @@ class PageSpace {
     return TryAllocateDataBumpLocked(&freelists_[OldPage::kData], size);
   }
   uword TryAllocateDataBumpLocked(FreeList* freelist, intptr_t size);
+
+  // Scavenger tasks promote objects by bump allocation in a private buffer
+  // [*top, *end), so they only take the lock of [freelist] on refill. This
+  // returns the unused part of the buffer to [freelist] and allocates [size]
+  // bytes, preferably from a new buffer. Large objects bypass the buffer.
   DART_FORCE_INLINE
-  uword TryAllocatePromoLocked(FreeList* freelist, intptr_t size) {
-    uword result = freelist->TryAllocateBumpLocked(size);
-    if (result != 0) {
+  uword TryAllocatePromo(FreeList* freelist,
+                         intptr_t size,
+                         uword* top,
+                         uword* end) {
+    uword result = *top;
+    if (LIKELY(size <= static_cast<intptr_t>(*end - result))) {
+      *top = result + size;
       return result;
     }
-    return TryAllocatePromoLockedSlow(freelist, size);
+    return TryAllocatePromoSlow(freelist, size, top, end);
   }
-  uword TryAllocatePromoLockedSlow(FreeList* freelist, intptr_t size);
+  uword TryAllocatePromoSlow(FreeList* freelist,
+                             intptr_t size,
+                             uword* top,
+                             uword* end);
+  // Returns the unused part of a promotion buffer to [freelist].
+  void RetirePromoBuffer(FreeList* freelist, uword* top, uword* end);
 
   void SetupImagePage(void* pointer, uword size, bool is_executable);
 
   // Return any bump allocation block to the freelist.
   void AbandonBumpAllocation();
+  // Give every page a side mark bitmap (FLAG_mark_bitmap). The bitmaps are
+  // already clear: each page clears its own after it is swept or compacted.
+  void EnsureMarkBitmaps();
   // Have threads release marking stack blocks, etc.
   void AbandonMarkingForShutdown();
 
@@ -578,6 +684,11 @@ class PageSpace {
   OldPage* large_pages_tail_ = nullptr;
   OldPage* image_pages_ = nullptr;
 
+  // The next large page whose cards are unclaimed during a scavenge, up to
+  // and including remembered_cards_tail_.
+  AcqRelAtomic<OldPage*> remembered_cards_next_;
+  OldPage* remembered_cards_tail_ = nullptr;
+
   // Various sizes being tracked for this generation.
   intptr_t max_capacity_in_words_;
 
@@ -601,6 +712,9 @@ class PageSpace {
   int64_t gc_time_micros_;
   intptr_t collections_;
   intptr_t mark_words_per_micro_;
+  // Per-task sliding speed of the last compaction, used to size the next
+  // one under --compaction_pause_budget_ms.
+  intptr_t compact_words_per_micro_;
 
   bool enable_concurrent_mark_;
 
@@ -31,4 +31,32 @@ TEST_CASE(Pages) {
   delete space;
 }
 
+TEST_CASE(PagesPromoBuffer) {
+  PageSpace* space = new PageSpace(NULL, 4 * MBInWords);
+  FreeList* freelist = space->DataFreeList(0);
+  uword top = 0;
+  uword end = 0;
+  const intptr_t kSize = 4 * kWordSize;
+  uword first = space->TryAllocatePromo(freelist, kSize, &top, &end);
+  EXPECT(first != 0);
+  EXPECT(top == first + kSize);
+  EXPECT(end > top);
+  // Small objects are bump allocated from the buffer.
+  uword second = space->TryAllocatePromo(freelist, kSize, &top, &end);
+  EXPECT(second == first + kSize);
+  // Large objects bypass the buffer.
+  uword large = space->TryAllocatePromo(freelist, 16 * KB, &top, &end);
+  EXPECT(large != 0);
+  EXPECT(top == second + kSize);
+  EXPECT(space->IsValidAddress(large));
+  // The unused part of the buffer is returned to the freelist.
+  const int64_t used_in_words = space->UsedInWords();
+  const intptr_t remaining = end - top;
+  space->RetirePromoBuffer(freelist, &top, &end);
+  EXPECT(top == 0);
+  EXPECT(end == 0);
+  EXPECT_EQ(used_in_words - (remaining >> kWordSizeLog2), space->UsedInWords());
+  delete space;
+}
+
 }  // namespace dart
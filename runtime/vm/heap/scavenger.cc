@@ -100,6 +100,61 @@ static inline void objcpy(void* dst, const void* src, size_t size) {
   } while (size > 0);
 }
 
+// To-space pages that a scavenger task has finished copying into but has not
+// yet resolved. The owning task pushes and pops at the back, while idle tasks
+// steal the oldest pages from the front. Pages are coarse units of work, so a
+// mutex is adequate here.
+class PendingPageDeque {
+ public:
+  PendingPageDeque() {}
+  ~PendingPageDeque() { ASSERT(IsEmpty()); }
+
+  void PushBack(NewPage* page) {
+    MutexLocker ml(&mutex_);
+    pages_.Add(page);
+    size_ = size_ + 1;
+  }
+
+  NewPage* PopBack() {
+    if (IsEmpty()) return nullptr;
+    MutexLocker ml(&mutex_);
+    if (front_ == pages_.length()) return nullptr;
+    NewPage* page = pages_.RemoveLast();
+    Shrink();
+    return page;
+  }
+
+  NewPage* PopFront() {
+    if (IsEmpty()) return nullptr;
+    MutexLocker ml(&mutex_);
+    if (front_ == pages_.length()) return nullptr;
+    NewPage* page = pages_[front_++];
+    Shrink();
+    return page;
+  }
+
+  // May be stale, but never reports empty while the owner has pushed pages
+  // that nobody has popped.
+  bool IsEmpty() const { return size_ == 0; }
+
+ private:
+  void Shrink() {
+    DEBUG_ASSERT(mutex_.IsOwnedByCurrentThread());
+    size_ = size_ - 1;
+    if (front_ == pages_.length()) {
+      pages_.Clear();
+      front_ = 0;
+    }
+  }
+
+  Mutex mutex_;
+  MallocGrowableArray<NewPage*> pages_;
+  intptr_t front_ = 0;
+  RelaxedAtomic<intptr_t> size_ = {0};
+
+  DISALLOW_COPY_AND_ASSIGN(PendingPageDeque);
+};
+
 template <bool parallel>
 class ScavengerVisitorBase : public ObjectPointerVisitor {
  public:
@@ -174,10 +229,24 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
   }
 
   intptr_t bytes_promoted() const { return bytes_promoted_; }
+  intptr_t bytes_copied() const { return bytes_copied_; }
+  intptr_t pages_stolen() const { return pages_stolen_; }
+  intptr_t remembered_objects() const { return remembered_objects_; }
+  intptr_t remembered_cards() const { return remembered_cards_; }
+
+  void AddRememberedObjects(intptr_t count) { remembered_objects_ += count; }
+  void AddRememberedCards(intptr_t count) { remembered_cards_ += count; }
+
+  void set_peers(ScavengerVisitorBase<parallel>** peers,
+                 intptr_t num_peers,
+                 intptr_t index) {
+    peers_ = peers;
+    num_peers_ = num_peers;
+    index_ = index;
+  }
 
   void ProcessRoots() {
     thread_ = Thread::Current();
-    page_space_->AcquireLock(freelist_);
     scavenger_->IterateRoots(this);
   }
 
@@ -200,7 +269,25 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
 
   bool HasWork() {
     return (scan_ != tail_) || (scan_ != nullptr && !scan_->IsResolved()) ||
-           !promoted_list_.IsEmpty();
+           !pending_.IsEmpty() || !promoted_list_.IsEmpty();
+  }
+
+  // Takes a to-space page that another task has filled but not yet resolved.
+  // Only called while this task has no to-space work of its own.
+  bool TrySteal() {
+    ASSERT(scan_ == tail_);
+    ASSERT(pending_.IsEmpty());
+    for (intptr_t i = 1; i < num_peers_; i++) {
+      ScavengerVisitorBase<parallel>* victim =
+          peers_[(index_ + i) % num_peers_];
+      NewPage* page = victim->pending_.PopFront();
+      if (page != nullptr) {
+        scan_ = page;
+        pages_stolen_++;
+        return true;
+      }
+    }
+    return false;
   }
 
   void Finalize() {
@@ -214,8 +301,9 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
     promoted_list_.Finalize();
 
     MournWeakProperties();
+    scavenger_->ForwardWeakTables();
 
-    page_space_->ReleaseLock(freelist_);
+    page_space_->RetirePromoBuffer(freelist_, &promo_top_, &promo_end_);
     thread_ = nullptr;
   }
 
@@ -261,11 +349,15 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
         // Not a survivor of a previous scavenge. Just copy the object into the
         // to space.
         new_addr = TryAllocateCopy(size);
+        if (LIKELY(new_addr != 0)) {
+          bytes_copied_ += size;
+        }
       }
       if (new_addr == 0) {
         // This object is a survivor of a previous scavenge. Attempt to promote
         // the object. (Or, unlikely, to-space was exhausted by fragmentation.)
-        new_addr = page_space_->TryAllocatePromoLocked(freelist_, size);
+        new_addr = page_space_->TryAllocatePromo(freelist_, size, &promo_top_,
+                                                 &promo_end_);
         if (LIKELY(new_addr != 0)) {
           // If promotion succeeded then we need to remember it so that it can
           // be traversed later.
@@ -280,6 +372,7 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
           if (UNLIKELY(new_addr == 0)) {
             OUT_OF_MEMORY();
           }
+          bytes_copied_ += size;
         }
       }
       ASSERT(new_addr != 0);
@@ -314,12 +407,18 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
       if (!InstallForwardingPointer(raw_addr, &header, forwarding_header)) {
         ASSERT(IsForwarding(header));
         if (new_obj->IsOldObject()) {
-          // Abandon as a free list element.
-          FreeListElement::AsElement(new_addr, size);
+          if (new_addr + size == promo_top_) {
+            // Undo promotion buffer allocation.
+            promo_top_ = new_addr;
+          } else {
+            // Abandon as a free list element.
+            FreeListElement::AsElement(new_addr, size);
+          }
           bytes_promoted_ -= size;
         } else {
           // Undo to-space allocation.
           tail_->Unallocate(new_addr, size);
+          bytes_copied_ -= size;
         }
         // Use the winner's forwarding target.
         new_obj = ForwardedObj(header);
@@ -386,7 +485,14 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
   SemiSpace* from_;
   PageSpace* page_space_;
   FreeList* freelist_;
+  // Private promotion buffer, carved out of freelist_.
+  uword promo_top_ = 0;
+  uword promo_end_ = 0;
   intptr_t bytes_promoted_;
+  intptr_t bytes_copied_ = 0;
+  intptr_t pages_stolen_ = 0;
+  intptr_t remembered_objects_ = 0;
+  intptr_t remembered_cards_ = 0;
   ObjectPtr visiting_old_object_;
 
   PromotionWorkList promoted_list_;
@@ -396,6 +502,13 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
   NewPage* tail_ = nullptr;  // Allocating from here.
   NewPage* scan_ = nullptr;  // Resolving from here.
 
+  // Full pages of this task that are not yet resolved. Other tasks may steal
+  // them.
+  PendingPageDeque pending_;
+  ScavengerVisitorBase<parallel>** peers_ = nullptr;
+  intptr_t num_peers_ = 0;
+  intptr_t index_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(ScavengerVisitorBase);
 };
 
@@ -468,11 +581,23 @@ class ParallelScavengerTask : public ThreadPool::Task {
         // then there will never be more work (NB: 1 is *before* decrement).
         if (num_busy_->fetch_sub(1u) == 1) break;
 
-        // Wait for some work to appear.
+        // Wait for some work to appear, or steal unresolved pages from
+        // another task.
         // TODO(iposva): Replace busy-waiting with a solution using Monitor,
         // and redraw the boundaries between stack/visitor/task as needed.
+        bool stole = false;
         while (!visitor_->HasWork() && num_busy_->load() > 0) {
+          if (visitor_->TrySteal()) {
+            // Other tasks may have seen no busy task before we count
+            // ourselves, and stopped. That only costs parallelism: we do not
+            // stop before the stolen page and all work found from it are
+            // done.
+            num_busy_->fetch_add(1u);
+            stole = true;
+            break;
+          }
         }
+        if (stole) continue;
 
         // If no tasks are busy, there will never be more work.
         if (num_busy_->load() == 0) break;
@@ -726,6 +851,9 @@ intptr_t Scavenger::NewSizeInWords(intptr_t old_size_in_words) const {
   if (stats_history_.Size() == 0) {
     return old_size_in_words;
   }
+  if (FLAG_gc_target_overhead > 0) {
+    return TargetOverheadSizeInWords(old_size_in_words);
+  }
   double garbage = stats_history_.Get(0).ExpectedGarbageFraction();
   if (garbage < (FLAG_new_gen_garbage_threshold / 100.0)) {
     return Utils::Minimum(max_semi_capacity_in_words_,
@@ -735,6 +863,74 @@ intptr_t Scavenger::NewSizeInWords(intptr_t old_size_in_words) const {
   }
 }
 
+// The cost of a scavenge depends on the survivors rather than on the size of
+// new space, so the time fraction spent scavenging is inversely proportional
+// to the size of new space. Scale it towards the target, moving by at most
+// the growth factor per scavenge to damp oscillation.
+intptr_t Scavenger::TargetOverheadSizeInWords(
+    intptr_t old_size_in_words) const {
+  if (stats_history_.Size() < 2) {
+    return old_size_in_words;
+  }
+  const double time_fraction = ScavengeTimeFraction();
+  const intptr_t factor = Utils::Maximum(FLAG_new_gen_growth_factor, 1);
+  intptr_t new_size_in_words = static_cast<intptr_t>(
+      old_size_in_words * (time_fraction / FLAG_gc_target_overhead));
+  new_size_in_words = Utils::Minimum(new_size_in_words,
+                                     old_size_in_words * factor);
+  new_size_in_words = Utils::Maximum(new_size_in_words,
+                                     old_size_in_words / factor);
+  const intptr_t min_size_in_words = Utils::Minimum(
+      max_semi_capacity_in_words_, FLAG_new_gen_semi_initial_size * MBInWords);
+  new_size_in_words = Utils::Maximum(new_size_in_words, min_size_in_words);
+  new_size_in_words =
+      Utils::Minimum(new_size_in_words, max_semi_capacity_in_words_);
+  return Utils::RoundUp(new_size_in_words, kNewPageSizeInWords);
+}
+
+double Scavenger::ScavengeTimeFraction() const {
+  int64_t gc_time = 0;
+  int64_t total_time = 0;
+  for (intptr_t i = 0; i < stats_history_.Size() - 1; i++) {
+    const ScavengeStats& current = stats_history_.Get(i);
+    const ScavengeStats& previous = stats_history_.Get(i + 1);
+    gc_time += current.DurationMicros();
+    total_time += current.end_micros() - previous.end_micros();
+  }
+  if (total_time <= 0) {
+    return 0.0;
+  }
+  return (static_cast<double>(gc_time) / static_cast<double>(total_time)) * 100;
+}
+
+double Scavenger::AllocatedWordsPerMicro() const {
+  intptr_t allocated_in_words = 0;
+  int64_t mutator_time = 0;
+  for (intptr_t i = 0; i < stats_history_.Size() - 1; i++) {
+    const ScavengeStats& current = stats_history_.Get(i);
+    const ScavengeStats& previous = stats_history_.Get(i + 1);
+    allocated_in_words +=
+        current.UsedBeforeInWords() - previous.UsedAfterInWords();
+    mutator_time += current.start_micros() - previous.end_micros();
+  }
+  if (mutator_time <= 0) {
+    return 0.0;
+  }
+  return allocated_in_words / static_cast<double>(mutator_time);
+}
+
+double Scavenger::SurvivalFraction() const {
+  if (stats_history_.Size() == 0) {
+    return 0.0;
+  }
+  const ScavengeStats& last = stats_history_.Get(0);
+  if (last.UsedBeforeInWords() == 0) {
+    return 0.0;
+  }
+  return last.SurvivedInWords() /
+         static_cast<double>(last.UsedBeforeInWords());
+}
+
 class CollectStoreBufferVisitor : public ObjectPointerVisitor {
  public:
   explicit CollectStoreBufferVisitor(ObjectSet* in_store_buffer)
@@ -839,7 +1035,8 @@ SemiSpace* Scavenger::Prologue() {
 
   // Need to stash the old remembered set before any worker begins adding to the
   // new remembered set.
-  blocks_ = heap_->isolate_group()->store_buffer()->TakeBlocks();
+  blocks_.store(heap_->isolate_group()->store_buffer()->TakeBlocks());
+  heap_->old_space()->PrepareRememberedCards();
 
   // Flip the two semi-spaces so that to_ is always the space for allocating
   // objects.
@@ -979,17 +1176,17 @@ void Scavenger::IterateStoreBuffers(ScavengerVisitorBase<parallel>* visitor) {
   TIMELINE_FUNCTION_GC_DURATION(Thread::Current(), "IterateStoreBuffers");
 
   // Iterating through the store buffers.
-  // Grab the deduplication sets out of the isolate's consolidated store buffer.
+  // Every task takes blocks from the isolate's consolidated store buffer until
+  // none are left. Blocks never return to blocks_, so popping is ABA-free.
   StoreBuffer* store_buffer = heap_->isolate_group()->store_buffer();
-  StoreBufferBlock* pending = blocks_;
-  blocks_ = nullptr;
-  intptr_t total_count = 0;
-  while (pending != NULL) {
-    StoreBufferBlock* next = pending->next();
+  StoreBufferBlock* pending = blocks_.load();
+  while (pending != nullptr) {
+    if (!blocks_.compare_exchange_weak(pending, pending->next())) {
+      continue;  // 'pending' was updated to the current head.
+    }
     // Generated code appends to store buffers; tell MemorySanitizer.
     MSAN_UNPOISON(pending, sizeof(*pending));
-    intptr_t count = pending->Count();
-    total_count += count;
+    visitor->AddRememberedObjects(pending->Count());
     while (!pending->IsEmpty()) {
       ObjectPtr raw_object = pending->Pop();
       ASSERT(!raw_object->IsForwardingCorpse());
@@ -1003,21 +1200,18 @@ void Scavenger::IterateStoreBuffers(ScavengerVisitorBase<parallel>* visitor) {
     pending->Reset();
     // Return the emptied block for recycling (no need to check threshold).
     store_buffer->PushBlock(pending, StoreBuffer::kIgnoreThreshold);
-    pending = next;
+    pending = blocks_.load();
   }
   // Done iterating through old objects remembered in the store buffers.
   visitor->VisitingOldObject(NULL);
-
-  heap_->RecordData(kStoreBufferEntries, total_count);
-  heap_->RecordData(kDataUnused1, 0);
-  heap_->RecordData(kDataUnused2, 0);
 }
 
 template <bool parallel>
 void Scavenger::IterateRememberedCards(
     ScavengerVisitorBase<parallel>* visitor) {
   TIMELINE_FUNCTION_GC_DURATION(Thread::Current(), "IterateRememberedCards");
-  heap_->old_space()->VisitRememberedCards(visitor);
+  visitor->AddRememberedCards(
+      heap_->old_space()->VisitRememberedCards(visitor));
   visitor->VisitingOldObject(NULL);
 }
 
@@ -1031,8 +1225,6 @@ void Scavenger::IterateObjectIdTable(ObjectPointerVisitor* visitor) {
 enum RootSlices {
   kIsolate = 0,
   kObjectIdRing,
-  kCards,
-  kStoreBuffer,
   kNumRootSlices,
 };
 
@@ -1041,7 +1233,7 @@ void Scavenger::IterateRoots(ScavengerVisitorBase<parallel>* visitor) {
   for (;;) {
     intptr_t slice = root_slices_started_.fetch_add(1);
     if (slice >= kNumRootSlices) {
-      return;  // No more slices.
+      break;  // No more slices.
     }
 
     switch (slice) {
@@ -1051,16 +1243,16 @@ void Scavenger::IterateRoots(ScavengerVisitorBase<parallel>* visitor) {
       case kObjectIdRing:
         IterateObjectIdTable(visitor);
         break;
-      case kCards:
-        IterateRememberedCards(visitor);
-        break;
-      case kStoreBuffer:
-        IterateStoreBuffers(visitor);
-        break;
       default:
         UNREACHABLE();
     }
   }
+
+  // The remembered set is usually the largest root, so rather than being a
+  // single slice it is shared by all tasks one card page or store buffer block
+  // at a time.
+  IterateRememberedCards(visitor);
+  IterateStoreBuffers(visitor);
 }
 
 bool Scavenger::IsUnreachable(ObjectPtr* p) {
@@ -1100,12 +1292,17 @@ void ScavengerVisitorBase<parallel>::ProcessToSpace() {
     }
     scan_->resolved_top_ = resolved_top;
 
-    NewPage* next = scan_->next();
-    if (next == nullptr) {
+    if (scan_ == tail_) {
       // Don't update scan_. More objects may yet be copied to this TLAB.
       return;
     }
-    scan_ = next;
+    // Nothing more will be copied into a page other than our tail, so it is
+    // now fully resolved. Continue with our most recently filled page, which
+    // is most likely to still be in cache, and finally our tail.
+    scan_ = pending_.PopBack();
+    if (scan_ == nullptr) {
+      scan_ = tail_;
+    }
   }
 }
 
@@ -1226,25 +1423,70 @@ intptr_t ScavengerVisitorBase<parallel>::ProcessCopied(ObjectPtr raw_obj) {
   return raw_obj->ptr()->VisitPointersNonvirtual(this);
 }
 
+// Replaces the keys of surviving entries by their forwarded objects and
+// invalidates the others.
+static void ForwardWeakTableEntries(WeakTable* table,
+                                    intptr_t start,
+                                    intptr_t end) {
+  intptr_t removed = 0;
+  for (intptr_t i = start; i < end; i++) {
+    if (table->IsValidEntryAtExclusive(i)) {
+      ObjectPtr raw_obj = table->ObjectAtExclusive(i);
+      ASSERT(raw_obj->IsHeapObject());
+      uword raw_addr = ObjectLayout::ToAddr(raw_obj);
+      uword header = *reinterpret_cast<uword*>(raw_addr);
+      if (IsForwarding(header)) {
+        // The object has survived.  Preserve its record.
+        table->ReplaceKeyAtConcurrently(i, ForwardedObj(header));
+      } else {
+        table->InvalidateAtConcurrently(i);
+        removed++;
+      }
+    }
+  }
+  table->RemoveFromCountConcurrently(removed);
+}
+
+// Reading the header of every key is the expensive part of mourning the
+// new-space weak tables, so all scavenger tasks share it chunk by chunk once
+// they have finished copying. MournWeakTables then only rehashes the entries.
+void Scavenger::ForwardWeakTables() {
+  for (;;) {
+    intptr_t chunk = weak_table_chunks_started_.fetch_add(1);
+    WeakTable* table = nullptr;
+    for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
+      WeakTable* candidate =
+          heap_->GetWeakTable(Heap::kNew, static_cast<Heap::WeakSelector>(sel));
+      if (chunk < candidate->NumGCChunks()) {
+        table = candidate;
+        break;
+      }
+      chunk -= candidate->NumGCChunks();
+    }
+    if (table == nullptr) {
+      return;  // No more chunks.
+    }
+    TIMELINE_FUNCTION_GC_DURATION(Thread::Current(), "ForwardWeakTables");
+    const intptr_t start = chunk * WeakTable::kGCChunkSize;
+    const intptr_t end =
+        Utils::Minimum(start + WeakTable::kGCChunkSize, table->size());
+    ForwardWeakTableEntries(table, start, end);
+  }
+}
+
 void Scavenger::MournWeakTables() {
   TIMELINE_FUNCTION_GC_DURATION(Thread::Current(), "MournWeakTables");
 
+  // The keys have already been forwarded, and dead entries removed.
   auto rehash_weak_table = [](WeakTable* table, WeakTable* replacement_new,
                               WeakTable* replacement_old) {
     intptr_t size = table->size();
     for (intptr_t i = 0; i < size; i++) {
       if (table->IsValidEntryAtExclusive(i)) {
         ObjectPtr raw_obj = table->ObjectAtExclusive(i);
-        ASSERT(raw_obj->IsHeapObject());
-        uword raw_addr = ObjectLayout::ToAddr(raw_obj);
-        uword header = *reinterpret_cast<uword*>(raw_addr);
-        if (IsForwarding(header)) {
-          // The object has survived.  Preserve its record.
-          raw_obj = ForwardedObj(header);
-          auto replacement =
-              raw_obj->IsNewObject() ? replacement_new : replacement_old;
-          replacement->SetValueExclusive(raw_obj, table->ValueAtExclusive(i));
-        }
+        auto replacement =
+            raw_obj->IsNewObject() ? replacement_new : replacement_old;
+        replacement->SetValueExclusive(raw_obj, table->ValueAtExclusive(i));
       }
     }
   };
@@ -1271,6 +1513,7 @@ void Scavenger::MournWeakTables() {
       [&](Isolate* isolate) {
         auto table = isolate->forward_table_new();
         if (table != nullptr) {
+          ForwardWeakTableEntries(table, 0, table->size());
           auto replacement = WeakTable::NewFrom(table);
           rehash_weak_table(table, replacement, isolate->forward_table_old());
           isolate->set_forward_table_new(replacement);
@@ -1406,12 +1649,18 @@ uword ScavengerVisitorBase<parallel>::TryAllocateCopySlow(intptr_t size) {
   }
 
   if (head_ == nullptr) {
-    head_ = scan_ = page;
+    head_ = page;
   } else {
-    ASSERT(scan_ != nullptr);
     tail_->set_next(page);
+    if (tail_ != scan_) {
+      // The previous tail is full. Make it available to idle tasks.
+      pending_.PushBack(tail_);
+    }
   }
   tail_ = page;
+  if (scan_ == nullptr) {
+    scan_ = page;
+  }
 
   return tail_->TryAllocateGC(size);
 }
@@ -1444,6 +1693,7 @@ void Scavenger::Scavenge() {
   // Prepare for a scavenge.
   failed_to_promote_ = false;
   root_slices_started_ = 0;
+  weak_table_chunks_started_ = 0;
   intptr_t abandoned_bytes = 0;  // TODO(rmacnak): Count fragmentation?
   SpaceUsage usage_before = GetCurrentUsage();
   intptr_t promo_candidate_words = 0;
@@ -1456,12 +1706,26 @@ void Scavenger::Scavenge() {
   }
   SemiSpace* from = Prologue();
 
-  intptr_t bytes_promoted;
-  if (FLAG_scavenger_tasks == 0) {
-    bytes_promoted = SerialScavenge(from);
+  ScavengeTaskStats task_stats[ScavengeStats::kMaxTaskStats];
+  const intptr_t num_tasks = NumScavengerTasks();
+  if (num_tasks == 1) {
+    SerialScavenge(from, task_stats);
   } else {
-    bytes_promoted = ParallelScavenge(from);
+    ParallelScavenge(from, num_tasks, task_stats);
   }
+  const intptr_t num_task_stats =
+      Utils::Minimum(num_tasks, ScavengeStats::kMaxTaskStats);
+  intptr_t bytes_promoted = 0;
+  intptr_t pages_stolen = 0;
+  intptr_t remembered_objects = 0;
+  for (intptr_t i = 0; i < num_task_stats; i++) {
+    bytes_promoted += task_stats[i].promoted_in_words << kWordSizeLog2;
+    pages_stolen += task_stats[i].stolen_pages;
+    remembered_objects += task_stats[i].remembered_objects;
+  }
+  heap_->RecordData(kStoreBufferEntries, remembered_objects);
+  heap_->RecordData(kScavengerTasks, num_tasks);
+  heap_->RecordData(kStolenPages, pages_stolen);
   MournWeakHandles();
   MournWeakTables();
 
@@ -1472,7 +1736,8 @@ void Scavenger::Scavenge() {
   int64_t end = OS::GetCurrentMonotonicMicros();
   stats_history_.Add(ScavengeStats(
       start, end, usage_before, GetCurrentUsage(), promo_candidate_words,
-      bytes_promoted >> kWordSizeLog2, abandoned_bytes >> kWordSizeLog2));
+      bytes_promoted >> kWordSizeLog2, abandoned_bytes >> kWordSizeLog2,
+      num_tasks, task_stats));
   Epilogue(from);
 
   if (FLAG_verify_after_gc) {
@@ -1487,7 +1752,34 @@ void Scavenger::Scavenge() {
   scavenging_ = false;
 }
 
-intptr_t Scavenger::SerialScavenge(SemiSpace* from) {
+// Rough amount of surviving data worth giving its own scavenger task: one
+// to-space page, which is also the unit of work stealing.
+static constexpr intptr_t kScavengeWordsPerTask = kNewPageSizeInWords;
+
+intptr_t Scavenger::NumScavengerTasks() const {
+  if (FLAG_scavenger_tasks == 0) {
+    return 1;
+  }
+  // There are only enough freelists for FLAG_scavenger_tasks at the time the
+  // old space was created.
+  intptr_t max_tasks =
+      Utils::Minimum(static_cast<intptr_t>(FLAG_scavenger_tasks),
+                     heap_->old_space()->num_data_freelists());
+  max_tasks = Utils::Minimum(
+      max_tasks, static_cast<intptr_t>(OS::NumberOfAvailableProcessors()));
+  if (max_tasks <= 1 || stats_history_.Size() == 0) {
+    return Utils::Maximum(max_tasks, static_cast<intptr_t>(1));
+  }
+  // Survivorship rates don't change much, so the previous scavenge is a good
+  // predictor of how much this one will copy.
+  const intptr_t expected_survivors_in_words =
+      stats_history_.Get(0).SurvivedInWords();
+  const intptr_t wanted_tasks =
+      1 + expected_survivors_in_words / kScavengeWordsPerTask;
+  return Utils::Minimum(max_tasks, wanted_tasks);
+}
+
+void Scavenger::SerialScavenge(SemiSpace* from, ScavengeTaskStats* task_stats) {
   FreeList* freelist = heap_->old_space()->DataFreeList(0);
   SerialScavengerVisitor visitor(heap_->isolate_group(), this, from, freelist,
                                  &promotion_stack_);
@@ -1499,12 +1791,16 @@ intptr_t Scavenger::SerialScavenge(SemiSpace* from) {
   visitor.Finalize();
 
   to_->AddList(visitor.head(), visitor.tail());
-  return visitor.bytes_promoted();
+  task_stats[0].copied_in_words = visitor.bytes_copied() >> kWordSizeLog2;
+  task_stats[0].promoted_in_words = visitor.bytes_promoted() >> kWordSizeLog2;
+  task_stats[0].stolen_pages = 0;
+  task_stats[0].remembered_objects = visitor.remembered_objects();
+  task_stats[0].remembered_cards = visitor.remembered_cards();
 }
 
-intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
-  intptr_t bytes_promoted = 0;
-  const intptr_t num_tasks = FLAG_scavenger_tasks;
+void Scavenger::ParallelScavenge(SemiSpace* from,
+                                 intptr_t num_tasks,
+                                 ScavengeTaskStats* task_stats) {
   ASSERT(num_tasks > 0);
 
   ThreadBarrier barrier(num_tasks, heap_->barrier(), heap_->barrier_done());
@@ -1512,10 +1808,15 @@ intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
 
   ParallelScavengerVisitor** visitors =
       new ParallelScavengerVisitor*[num_tasks];
+  // Create all visitors before starting any task, as every task may steal
+  // from every other.
   for (intptr_t i = 0; i < num_tasks; i++) {
     FreeList* freelist = heap_->old_space()->DataFreeList(i);
     visitors[i] = new ParallelScavengerVisitor(
         heap_->isolate_group(), this, from, freelist, &promotion_stack_);
+    visitors[i]->set_peers(visitors, num_tasks, i);
+  }
+  for (intptr_t i = 0; i < num_tasks; i++) {
     if (i < (num_tasks - 1)) {
       // Begin scavenging on a helper thread.
       bool result = Dart::thread_pool()->Run<ParallelScavengerTask>(
@@ -1531,13 +1832,21 @@ intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
   }
 
   for (intptr_t i = 0; i < num_tasks; i++) {
+    ScavengeTaskStats* stats =
+        &task_stats[Utils::Minimum(i, ScavengeStats::kMaxTaskStats - 1)];
+    if (i < ScavengeStats::kMaxTaskStats) {
+      *stats = ScavengeTaskStats();
+    }
+    stats->copied_in_words += visitors[i]->bytes_copied() >> kWordSizeLog2;
+    stats->promoted_in_words += visitors[i]->bytes_promoted() >> kWordSizeLog2;
+    stats->stolen_pages += visitors[i]->pages_stolen();
+    stats->remembered_objects += visitors[i]->remembered_objects();
+    stats->remembered_cards += visitors[i]->remembered_cards();
     to_->AddList(visitors[i]->head(), visitors[i]->tail());
-    bytes_promoted += visitors[i]->bytes_promoted();
     delete visitors[i];
   }
 
   delete[] visitors;
-  return bytes_promoted;
 }
 
 void Scavenger::WriteProtect(bool read_only) {
@@ -1569,6 +1878,15 @@ void Scavenger::PrintToJSONObject(JSONObject* object) const {
   space.AddProperty64("capacity", CapacityInWords() * kWordSize);
   space.AddProperty64("external", ExternalInWords() * kWordSize);
   space.AddProperty("time", MicrosecondsToSeconds(gc_time_micros()));
+  if (FLAG_gc_target_overhead > 0) {
+    JSONObject sizing(&space, "_sizing");
+    AddGCSizingProperties(&sizing, ScavengeTimeFraction(),
+                          AllocatedWordsPerMicro());
+    sizing.AddProperty("survivalFraction", SurvivalFraction());
+    sizing.AddProperty64("targetCapacity",
+                         TargetOverheadSizeInWords(CapacityInWords()) *
+                             kWordSize);
+  }
 }
 #endif  // !PRODUCT
 
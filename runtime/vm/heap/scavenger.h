@@ -196,9 +196,22 @@ class SemiSpace {
   NewPage* tail_ = nullptr;
 };
 
+// Statistics for a single task of a particular scavenge.
+struct ScavengeTaskStats {
+  intptr_t copied_in_words = 0;
+  intptr_t promoted_in_words = 0;
+  intptr_t stolen_pages = 0;
+  // Old objects taken from the store buffer and remembered cards visited.
+  intptr_t remembered_objects = 0;
+  intptr_t remembered_cards = 0;
+};
+
 // Statistics for a particular scavenge.
 class ScavengeStats {
  public:
+  // Statistics of tasks beyond this limit are accumulated into the last entry.
+  static constexpr intptr_t kMaxTaskStats = 32;
+
   ScavengeStats() {}
   ScavengeStats(int64_t start_micros,
                 int64_t end_micros,
@@ -206,14 +219,21 @@ class ScavengeStats {
                 SpaceUsage after,
                 intptr_t promo_candidates_in_words,
                 intptr_t promoted_in_words,
-                intptr_t abandoned_in_words)
+                intptr_t abandoned_in_words,
+                intptr_t num_tasks,
+                const ScavengeTaskStats* task_stats)
       : start_micros_(start_micros),
         end_micros_(end_micros),
         before_(before),
         after_(after),
         promo_candidates_in_words_(promo_candidates_in_words),
         promoted_in_words_(promoted_in_words),
-        abandoned_in_words_(abandoned_in_words) {}
+        abandoned_in_words_(abandoned_in_words),
+        num_tasks_(num_tasks) {
+    for (intptr_t i = 0; i < NumTaskStats(); i++) {
+      task_stats_[i] = task_stats[i];
+    }
+  }
 
   // Of all data before scavenge, what fraction was found to be garbage?
   // If this scavenge included growth, assume the extra capacity would become
@@ -234,9 +254,47 @@ class ScavengeStats {
   }
 
   intptr_t UsedBeforeInWords() const { return before_.used_in_words; }
+  intptr_t UsedAfterInWords() const { return after_.used_in_words; }
 
+  // Words that survived this scavenge, either by copying or by promotion.
+  intptr_t SurvivedInWords() const {
+    return after_.used_in_words + promoted_in_words_;
+  }
+
+  int64_t start_micros() const { return start_micros_; }
+  int64_t end_micros() const { return end_micros_; }
   int64_t DurationMicros() const { return end_micros_ - start_micros_; }
 
+  intptr_t num_tasks() const { return num_tasks_; }
+  intptr_t NumTaskStats() const {
+    return Utils::Minimum(num_tasks_, kMaxTaskStats);
+  }
+  const ScavengeTaskStats& TaskStatsAt(intptr_t i) const {
+    ASSERT((i >= 0) && (i < NumTaskStats()));
+    return task_stats_[i];
+  }
+  intptr_t StolenPages() const {
+    intptr_t result = 0;
+    for (intptr_t i = 0; i < NumTaskStats(); i++) {
+      result += task_stats_[i].stolen_pages;
+    }
+    return result;
+  }
+  intptr_t RememberedObjects() const {
+    intptr_t result = 0;
+    for (intptr_t i = 0; i < NumTaskStats(); i++) {
+      result += task_stats_[i].remembered_objects;
+    }
+    return result;
+  }
+  intptr_t RememberedCards() const {
+    intptr_t result = 0;
+    for (intptr_t i = 0; i < NumTaskStats(); i++) {
+      result += task_stats_[i].remembered_cards;
+    }
+    return result;
+  }
+
  private:
   int64_t start_micros_;
   int64_t end_micros_;
@@ -245,6 +303,8 @@ class ScavengeStats {
   intptr_t promo_candidates_in_words_;
   intptr_t promoted_in_words_;
   intptr_t abandoned_in_words_;
+  intptr_t num_tasks_;
+  ScavengeTaskStats task_stats_[kMaxTaskStats];
 };
 
 class Scavenger {
@@ -313,6 +373,12 @@ class Scavenger {
 
   intptr_t collections() const { return collections_; }
 
+  // Feedback from the recent scavenges used to size new space under
+  // --gc_target_overhead.
+  double ScavengeTimeFraction() const;
+  double AllocatedWordsPerMicro() const;
+  double SurvivalFraction() const;
+
 #ifndef PRODUCT
   void PrintToJSONObject(JSONObject* object) const;
 #endif  // !PRODUCT
@@ -368,8 +434,8 @@ class Scavenger {
     kIterateWeaks = 5,
     // Data
     kStoreBufferEntries = 0,
-    kDataUnused1 = 1,
-    kDataUnused2 = 2,
+    kScavengerTasks = 1,
+    kStolenPages = 2,
     kToKBAfterStoreBuffer = 3
   };
 
@@ -391,8 +457,11 @@ class Scavenger {
   void TryAllocateNewTLAB(Thread* thread, intptr_t size);
 
   SemiSpace* Prologue();
-  intptr_t ParallelScavenge(SemiSpace* from);
-  intptr_t SerialScavenge(SemiSpace* from);
+  intptr_t NumScavengerTasks() const;
+  void ParallelScavenge(SemiSpace* from,
+                        intptr_t num_tasks,
+                        ScavengeTaskStats* task_stats);
+  void SerialScavenge(SemiSpace* from, ScavengeTaskStats* task_stats);
   void IterateIsolateRoots(ObjectPointerVisitor* visitor);
   template <bool parallel>
   void IterateStoreBuffers(ScavengerVisitorBase<parallel>* visitor);
@@ -411,9 +480,12 @@ class Scavenger {
   void UpdateMaxHeapCapacity();
   void UpdateMaxHeapUsage();
 
+  // Called by every scavenger task once copying is done.
+  void ForwardWeakTables();
   void MournWeakTables();
 
   intptr_t NewSizeInWords(intptr_t old_size_in_words) const;
+  intptr_t TargetOverheadSizeInWords(intptr_t old_size_in_words) const;
 
   Heap* heap_;
 
@@ -427,7 +499,10 @@ class Scavenger {
   bool scavenging_;
   bool early_tenure_ = false;
   RelaxedAtomic<intptr_t> root_slices_started_;
-  StoreBufferBlock* blocks_;
+  RelaxedAtomic<intptr_t> weak_table_chunks_started_;
+  // Blocks of the store buffer taken at the start of the scavenge which no
+  // task has claimed yet.
+  AcqRelAtomic<StoreBufferBlock*> blocks_;
 
   int64_t gc_time_micros_;
   intptr_t collections_;
@@ -0,0 +1,24 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/heap/spaces.h"
+
+#include "vm/flags.h"
+#include "vm/json_stream.h"
+
+namespace dart {
+
+#ifndef PRODUCT
+void AddGCSizingProperties(JSONObject* sizing,
+                           double gc_time_fraction,
+                           double allocated_words_per_micro) {
+  sizing->AddProperty("targetOverhead",
+                      static_cast<intptr_t>(FLAG_gc_target_overhead));
+  sizing->AddProperty("gcTimeFraction", gc_time_fraction);
+  sizing->AddProperty("allocationRateBytesPerMicro",
+                      allocated_words_per_micro * kWordSize);
+}
+#endif  // !PRODUCT
+
+}  // namespace dart
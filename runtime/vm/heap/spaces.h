@@ -29,6 +29,16 @@ class SpaceUsage {
   }
 };
 
+#ifndef PRODUCT
+class JSONObject;
+
+// Adds the properties which the "_sizing" objects of both spaces report under
+// --gc_target_overhead. The GC time fraction is in percent of the run time.
+void AddGCSizingProperties(JSONObject* sizing,
+                           double gc_time_fraction,
+                           double allocated_words_per_micro);
+#endif  // !PRODUCT
+
 }  // namespace dart
 
 #endif  // RUNTIME_VM_HEAP_SPACES_H_
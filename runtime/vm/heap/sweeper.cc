@@ -25,26 +25,35 @@ bool GCSweeper::SweepPage(OldPage* page, FreeList* freelist, bool locked) {
   uword start = page->object_start();
   uword end = page->object_end();
   uword current = start;
+  const bool use_bitmap = FLAG_mark_bitmap;
 
   while (current < end) {
     intptr_t obj_size;
     ObjectPtr raw_obj = ObjectLayout::FromAddr(current);
     ASSERT(OldPage::Of(raw_obj) == page);
-    if (raw_obj->ptr()->IsMarked()) {
+    if (OldPage::IsMarked(raw_obj)) {
       // Found marked object. Clear the mark bit and update swept bytes.
-      raw_obj->ptr()->ClearMarkBit();
+      if (raw_obj->ptr()->IsMarked()) {
+        raw_obj->ptr()->ClearMarkBit();
+      }
       obj_size = raw_obj->ptr()->HeapSize();
       used_in_bytes += obj_size;
     } else {
       uword free_end = current + raw_obj->ptr()->HeapSize();
-      while (free_end < end) {
-        ObjectPtr next_obj = ObjectLayout::FromAddr(free_end);
-        if (next_obj->ptr()->IsMarked()) {
-          // Reached the end of the free block.
-          break;
+      if (use_bitmap) {
+        // Every live object has its side bit set, so the free block extends
+        // to the next set bit without reading the headers of dead objects.
+        free_end = page->NextMarkedInBitmap(free_end, end);
+      } else {
+        while (free_end < end) {
+          ObjectPtr next_obj = ObjectLayout::FromAddr(free_end);
+          if (next_obj->ptr()->IsMarked()) {
+            // Reached the end of the free block.
+            break;
+          }
+          // Expand the free block by the size of this object.
+          free_end += next_obj->ptr()->HeapSize();
         }
-        // Expand the free block by the size of this object.
-        free_end += next_obj->ptr()->HeapSize();
       }
       obj_size = free_end - current;
       if (is_executable) {
@@ -71,6 +80,9 @@ bool GCSweeper::SweepPage(OldPage* page, FreeList* freelist, bool locked) {
     current += obj_size;
   }
   ASSERT(current == end);
+  if (used_in_bytes != 0) {
+    page->ClearMarkBitmap();
+  }
 
   page->set_used_in_bytes(used_in_bytes);
   return used_in_bytes != 0;  // In use.
@@ -82,9 +94,12 @@ intptr_t GCSweeper::SweepLargePage(OldPage* page) {
   intptr_t words_to_end = 0;
   ObjectPtr raw_obj = ObjectLayout::FromAddr(page->object_start());
   ASSERT(OldPage::Of(raw_obj) == page);
-  if (raw_obj->ptr()->IsMarked()) {
-    raw_obj->ptr()->ClearMarkBit();
+  if (OldPage::IsMarked(raw_obj)) {
+    if (raw_obj->ptr()->IsMarked()) {
+      raw_obj->ptr()->ClearMarkBit();
+    }
     words_to_end = (raw_obj->ptr()->HeapSize() >> kWordSizeLog2);
+    page->ClearMarkBitmap();
   }
 #ifdef DEBUG
   // Array::MakeFixedLength creates trailing filler objects,
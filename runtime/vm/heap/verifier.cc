@@ -33,7 +33,7 @@ void VerifyObjectVisitor::VisitObject(ObjectPtr raw_obj) {
         case kAllowMarked:
           break;
         case kRequireMarked:
-          if (raw_obj->IsOldObject() && !raw_obj->ptr()->IsMarked()) {
+          if (raw_obj->IsOldObject() && !OldPage::IsMarked(raw_obj)) {
             FATAL1("Unmarked object encountered %#" Px "\n", raw_addr);
           }
           break;
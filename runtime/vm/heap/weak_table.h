@@ -126,6 +126,31 @@ class WeakTable {
     return 0;
   }
 
+  // The following methods let the GC process disjoint ranges of entries on
+  // several threads. Entries are updated in place without maintaining the
+  // count, which the caller adjusts once per range with
+  // RemoveFromCountConcurrently. The table must be rehashed (e.g. with
+  // Forward or by inserting the entries into a new table) afterwards if keys
+  // were replaced.
+  static const intptr_t kGCChunkSize = 16 * KB;
+  intptr_t NumGCChunks() const {
+    return (size() + kGCChunkSize - 1) / kGCChunkSize;
+  }
+  void ReplaceKeyAtConcurrently(intptr_t i, ObjectPtr key) {
+    ASSERT(IsValidEntryAtExclusive(i));
+    SetObjectAt(i, key);
+  }
+  void InvalidateAtConcurrently(intptr_t i) {
+    ASSERT(IsValidEntryAtExclusive(i));
+    data_[ObjectIndex(i)] = kDeletedEntry;
+    data_[ValueIndex(i)] = 0;
+  }
+  void RemoveFromCountConcurrently(intptr_t removed) {
+    if (removed == 0) return;
+    MutexLocker ml(&mutex_);
+    set_count(count() - removed);
+  }
+
   void Forward(ObjectPointerVisitor* visitor);
 
   void Reset();
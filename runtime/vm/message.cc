@@ -189,6 +189,36 @@ void MessageQueue::Clear() {
   }
 }
 
+bool MessageInbox::Post(std::unique_ptr<Message> msg0) {
+  Message* msg = msg0.release();
+  // Make sure messages are not reused.
+  ASSERT(msg->next_ == nullptr);
+  Message* head = head_.load(std::memory_order_relaxed);
+  do {
+    msg->next_ = head;
+  } while (!head_.compare_exchange_weak(head, msg, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  return head == nullptr;
+}
+
+void MessageInbox::MoveTo(MessageQueue* queue) {
+  Message* head = head_.exchange(nullptr, std::memory_order_acquire);
+  // Reverse the list to restore the posting order.
+  Message* ordered = nullptr;
+  while (head != nullptr) {
+    Message* next = head->next_;
+    head->next_ = ordered;
+    ordered = head;
+    head = next;
+  }
+  while (ordered != nullptr) {
+    Message* next = ordered->next_;
+    ordered->next_ = nullptr;
+    queue->Enqueue(std::unique_ptr<Message>(ordered), false);
+    ordered = next;
+  }
+}
+
 MessageQueue::Iterator::Iterator(const MessageQueue* queue) : next_(NULL) {
   Reset(queue);
 }
@@ -5,6 +5,7 @@
 #ifndef RUNTIME_VM_MESSAGE_H_
 #define RUNTIME_VM_MESSAGE_H_
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -114,7 +115,8 @@ class Message {
   bool IsSnapshot() const { return !IsRaw() && !IsBequest(); }
   // A message whose object is an immortal object from the vm-isolate's heap.
   bool IsRaw() const { return snapshot_length_ == 0; }
-  // A message sent from sendAndExit.
+  // A message sent from sendAndExit, or an object graph copied directly to an
+  // isolate of the same isolate group.
   bool IsBequest() const { return snapshot_length_ == -1; }
 
   bool RedirectToDeliveryFailurePort();
@@ -130,6 +132,7 @@ class Message {
   static const char* PriorityAsString(Priority priority);
 
  private:
+  friend class MessageInbox;
   friend class MessageQueue;
 
   Message* next_;
@@ -200,6 +203,37 @@ class MessageQueue {
   DISALLOW_COPY_AND_ASSIGN(MessageQueue);
 };
 
+// Messages posted to a message handler which have not been moved into its
+// MessageQueue yet.
+//
+// Any number of threads can post to the inbox without taking a lock. Only a
+// single thread at a time (the one holding the handler's monitor) may take
+// messages out of it.
+class MessageInbox {
+ public:
+  MessageInbox() : head_(nullptr) {}
+  ~MessageInbox() { ASSERT(IsEmpty()); }
+
+  // Adds 'msg' to the inbox. Returns true if the inbox was empty before, in
+  // which case the caller is responsible for waking up the consumer.
+  bool Post(std::unique_ptr<Message> msg);
+
+  // Moves all messages in the inbox to the tail of 'queue', in the order they
+  // were posted.
+  void MoveTo(MessageQueue* queue);
+
+  bool IsEmpty() const {
+    return head_.load(std::memory_order_relaxed) == nullptr;
+  }
+
+ private:
+  // The most recently posted message. Messages are linked through
+  // Message::next_ in reverse posting order.
+  std::atomic<Message*> head_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageInbox);
+};
+
 }  // namespace dart
 
 #endif  // RUNTIME_VM_MESSAGE_H_
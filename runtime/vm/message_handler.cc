@@ -60,6 +60,7 @@ MessageHandler::MessageHandler()
       oob_message_handling_allowed_(true),
       paused_for_messages_(false),
       live_ports_(0),
+      senders_(0),
       paused_(0),
 #if !defined(PRODUCT)
       should_pause_on_start_(false),
@@ -79,6 +80,7 @@ MessageHandler::MessageHandler()
 }
 
 MessageHandler::~MessageHandler() {
+  inbox_.MoveTo(queue_);
   delete queue_;
   delete oob_queue_;
   queue_ = NULL;
@@ -118,64 +120,88 @@ void MessageHandler::Run(ThreadPool* pool,
   end_callback_ = end_callback;
   callback_data_ = data;
   task_running_ = true;
-  const bool launched_successfully = pool_->Run<MessageHandlerTask>(this);
+  const bool launched_successfully =
+      pool_->RunWithAffinity<MessageHandlerTask>(&affinity_, this);
   ASSERT(launched_successfully);
 }
 
 void MessageHandler::PostMessage(std::unique_ptr<Message> message,
                                  bool before_events) {
-  Message::Priority saved_priority;
-
-  {
-    MonitorLocker ml(&monitor_);
-    if (FLAG_trace_isolates) {
-      Isolate* source_isolate = Isolate::Current();
-      if (source_isolate != nullptr) {
-        OS::PrintErr(
-            "[>] Posting message:\n"
-            "\tlen:        %" Pd "\n\tsource:     (%" Pd64
-            ") %s\n\tdest:       %s\n"
-            "\tdest_port:  %" Pd64 "\n",
-            message->Size(), static_cast<int64_t>(source_isolate->main_port()),
-            source_isolate->name(), name(), message->dest_port());
-      } else {
-        OS::PrintErr(
-            "[>] Posting message:\n"
-            "\tlen:        %" Pd
-            "\n\tsource:     <native code>\n"
-            "\tdest:       %s\n"
-            "\tdest_port:  %" Pd64 "\n",
-            message->Size(), name(), message->dest_port());
-      }
+  if (FLAG_trace_isolates) {
+    Isolate* source_isolate = Isolate::Current();
+    if (source_isolate != nullptr) {
+      OS::PrintErr(
+          "[>] Posting message:\n"
+          "\tlen:        %" Pd "\n\tsource:     (%" Pd64
+          ") %s\n\tdest:       %s\n"
+          "\tdest_port:  %" Pd64 "\n",
+          message->Size(), static_cast<int64_t>(source_isolate->main_port()),
+          source_isolate->name(), name(), message->dest_port());
+    } else {
+      OS::PrintErr(
+          "[>] Posting message:\n"
+          "\tlen:        %" Pd
+          "\n\tsource:     <native code>\n"
+          "\tdest:       %s\n"
+          "\tdest_port:  %" Pd64 "\n",
+          message->Size(), name(), message->dest_port());
     }
+  }
 
-    saved_priority = message->priority();
+  const Message::Priority saved_priority = message->priority();
+  if (!message->IsOOB() && !before_events) {
+    // Only the sender which finds the inbox empty has to make sure that the
+    // message gets handled. Later senders see a non-empty inbox until the
+    // handler takes all messages out of it under the monitor.
+    if (inbox_.Post(std::move(message))) {
+      MonitorLocker ml(&monitor_);
+      NotifyLocked(&ml);
+    }
+  } else {
+    MonitorLocker ml(&monitor_);
     if (message->IsOOB()) {
       oob_queue_->Enqueue(std::move(message), before_events);
     } else {
+      // Keep the messages in the inbox behind the ones already queued.
+      ReceiveInboxLocked();
       queue_->Enqueue(std::move(message), before_events);
     }
-    if (paused_for_messages_) {
-      ml.Notify();
-    }
-
-    if (pool_ != nullptr && !task_running_) {
-      ASSERT(!delete_me_);
-      task_running_ = true;
-      const bool launched_successfully = pool_->Run<MessageHandlerTask>(this);
-      ASSERT(launched_successfully);
-    }
+    NotifyLocked(&ml);
   }
 
   // Invoke any custom message notification.
   MessageNotify(saved_priority);
 }
 
+void MessageHandler::NotifyLocked(MonitorLocker* ml) {
+  if (paused_for_messages_) {
+    ml->Notify();
+  }
+
+  if (pool_ != nullptr && !task_running_) {
+    ASSERT(!delete_me_);
+    task_running_ = true;
+    const bool launched_successfully =
+        pool_->RunWithAffinity<MessageHandlerTask>(&affinity_, this);
+    ASSERT(launched_successfully);
+  }
+}
+
+void MessageHandler::ReceiveInboxLocked() {
+  ASSERT(monitor_.IsOwnedByCurrentThread());
+  if (!inbox_.IsEmpty()) {
+    inbox_.MoveTo(queue_);
+  }
+}
+
 std::unique_ptr<Message> MessageHandler::DequeueMessage(
     Message::Priority min_priority) {
   // TODO(turnidge): Add assert that monitor_ is held here.
   std::unique_ptr<Message> message = oob_queue_->Dequeue();
   if ((message == nullptr) && (min_priority < Message::kOOBPriority)) {
+    if (queue_->IsEmpty()) {
+      ReceiveInboxLocked();
+    }
     message = queue_->Dequeue();
   }
   return message;
@@ -303,6 +329,7 @@ MessageHandler::MessageStatus MessageHandler::PauseAndHandleAllMessages(
   CheckAccess();
 #endif
   paused_for_messages_ = true;
+  ReceiveInboxLocked();
   while (queue_->IsEmpty() && oob_queue_->IsEmpty()) {
     Monitor::WaitResult wr;
     {
@@ -316,6 +343,7 @@ MessageHandler::MessageStatus MessageHandler::PauseAndHandleAllMessages(
     if (wr == Monitor::kTimedOut) {
       break;
     }
+    ReceiveInboxLocked();
     if (queue_->IsEmpty()) {
       // There are only OOB messages. Handle them and then continue waiting for
       // normal messages unless there is an error.
@@ -373,7 +401,7 @@ bool MessageHandler::HasOOBMessages() {
 
 bool MessageHandler::HasMessages() {
   MonitorLocker ml(&monitor_);
-  return !queue_->IsEmpty();
+  return !queue_->IsEmpty() || !inbox_.IsEmpty();
 }
 
 void MessageHandler::TaskCallback() {
@@ -534,6 +562,7 @@ void MessageHandler::CloseAllPorts() {
         "\thandler:    %s\n",
         name());
   }
+  ReceiveInboxLocked();
   queue_->Clear();
   oob_queue_->Clear();
 }
@@ -640,6 +669,7 @@ void MessageHandler::PausedOnExitLocked(MonitorLocker* ml, bool paused) {
 MessageHandler::AcquiredQueues::AcquiredQueues(MessageHandler* handler)
     : handler_(handler), ml_(&handler->monitor_) {
   ASSERT(handler != NULL);
+  handler_->ReceiveInboxLocked();
   handler_->oob_message_handling_allowed_ = false;
 }
 
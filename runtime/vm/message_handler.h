@@ -239,13 +239,21 @@ class MessageHandler {
 
   void ClearOOBQueue();
 
+  // Moves messages posted without holding the monitor to queue_.
+  void ReceiveInboxLocked();
+
+  // Wakes up the thread processing messages, or starts a task for it.
+  void NotifyLocked(MonitorLocker* ml);
+
   // Handles any pending messages.
   MessageStatus HandleMessages(MonitorLocker* ml,
                                bool allow_normal_messages,
                                bool allow_multiple_normal_messages);
 
-  Monitor monitor_;  // Protects all fields in MessageHandler.
+  Monitor monitor_;  // Protects all fields in MessageHandler but inbox_.
   MessageQueue* queue_;
+  // Normal priority messages posted since the last time queue_ was refilled.
+  MessageInbox inbox_;
   MessageQueue* oob_queue_;
   // This flag is not thread safe and can only reliably be accessed on a single
   // thread.
@@ -254,6 +262,8 @@ class MessageHandler {
   PortSet<PortSetEntry>
       ports_;  // Only accessed by [PortMap], protected by [PortMap]s lock.
   intptr_t live_ports_;  // The number of open ports, including control ports.
+  // The number of threads posting a message they sent through [PortMap].
+  std::atomic<intptr_t> senders_;
   intptr_t paused_;      // The number of pause messages received.
 #if !defined(PRODUCT)
   bool should_pause_on_start_;
@@ -265,6 +275,8 @@ class MessageHandler {
   bool task_running_;
   bool delete_me_;
   ThreadPool* pool_;
+  // Lets the tasks of this handler prefer the worker that ran the last one.
+  ThreadPool::Affinity affinity_;
   StartCallback start_callback_;
   EndCallback end_callback_;
   CallbackData callback_data_;
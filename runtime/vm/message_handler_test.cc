@@ -24,7 +24,11 @@ class MessageHandlerTestPeer {
   void increment_live_ports() { handler_->increment_live_ports(); }
   void decrement_live_ports() { handler_->decrement_live_ports(); }
 
-  MessageQueue* queue() const { return handler_->queue_; }
+  MessageQueue* queue() const {
+    MonitorLocker ml(&handler_->monitor_);
+    handler_->ReceiveInboxLocked();
+    return handler_->queue_;
+  }
   MessageQueue* oob_queue() const { return handler_->oob_queue_; }
 
  private:
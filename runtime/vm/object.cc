@@ -2660,6 +2660,10 @@ ObjectPtr Object::Allocate(intptr_t cls_id, intptr_t size, Heap::Space space) {
     // this object before the stores that initialize its slots), and helps the
     // collection to finish sooner.
     raw_obj->ptr()->SetMarkBitUnsynchronized();
+    if (FLAG_mark_bitmap) {
+      // The sweeper looks for live objects in the side bitmap.
+      OldPage::Of(raw_obj)->TryMarkInBitmap</*sync=*/true>(address);
+    }
     // Setting the mark bit must not be ordered after a publishing store of this
     // object. Adding a barrier here is cheaper than making every store into the
     // heap a store-release. Compare Scavenger::ScavengePointer.
@@ -21303,6 +21307,55 @@ bool String::Equals(const Instance& other) const {
   return Equals(other_string);
 }
 
+const uint8_t* String::OneByteData(const String& str) {
+  if (str.IsOneByteString()) {
+    return OneByteString::DataStart(str);
+  }
+  ASSERT(str.IsExternalOneByteString());
+  return ExternalOneByteString::DataStart(str);
+}
+
+const uint16_t* String::TwoByteData(const String& str) {
+  if (str.IsTwoByteString()) {
+    return TwoByteString::DataStart(str);
+  }
+  ASSERT(str.IsExternalTwoByteString());
+  return ExternalTwoByteString::DataStart(str);
+}
+
+// Compares one block of code units at a time without early exits inside the
+// block, so that the compiler can vectorize the comparison.
+template <typename T1, typename T2>
+static bool CodeUnitsEqual(const T1* a, const T2* b, intptr_t len) {
+  const intptr_t kBlockSize = 16;
+  intptr_t i = 0;
+  for (; i + kBlockSize <= len; i += kBlockSize) {
+    uint32_t diff = 0;
+    for (intptr_t j = 0; j < kBlockSize; j++) {
+      diff |= a[i + j] ^ LoadUnaligned(&b[i + j]);
+    }
+    if (diff != 0) {
+      return false;
+    }
+  }
+  for (; i < len; i++) {
+    if (a[i] != LoadUnaligned(&b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool CodeUnitsEqual(const uint8_t* a, const uint8_t* b, intptr_t len) {
+  return memcmp(a, b, len) == 0;
+}
+
+static bool CodeUnitsEqual(const uint16_t* a,
+                           const uint16_t* b,
+                           intptr_t len) {
+  return memcmp(a, b, len * sizeof(uint16_t)) == 0;
+}
+
 bool String::Equals(const String& str,
                     intptr_t begin_index,
                     intptr_t len) const {
@@ -21314,13 +21367,41 @@ bool String::Equals(const String& str,
     return false;  // Lengths don't match.
   }
 
-  for (intptr_t i = 0; i < len; i++) {
-    if (CharAt(i) != str.CharAt(begin_index + i)) {
-      return false;
+  NoSafepointScope no_safepoint;
+  if (CharSize() == kOneByteChar) {
+    const uint8_t* data = OneByteData(*this);
+    if (str.CharSize() == kOneByteChar) {
+      return CodeUnitsEqual(data, OneByteData(str) + begin_index, len);
     }
+    return CodeUnitsEqual(data, TwoByteData(str) + begin_index, len);
+  }
+  const uint16_t* data = TwoByteData(*this);
+  if (str.CharSize() == kOneByteChar) {
+    return CodeUnitsEqual(data, OneByteData(str) + begin_index, len);
   }
+  return CodeUnitsEqual(data, TwoByteData(str) + begin_index, len);
+}
 
-  return true;
+intptr_t String::IndexOfCodeUnit(uint16_t code_unit, intptr_t start) const {
+  const intptr_t len = Length();
+  ASSERT((start >= 0) && (start <= len));
+  NoSafepointScope no_safepoint;
+  if (CharSize() == kOneByteChar) {
+    if (!Utf::IsLatin1(code_unit)) {
+      return -1;
+    }
+    // memchr scans many bytes at a time.
+    const uint8_t* data = OneByteData(*this);
+    const void* found = memchr(data + start, code_unit, len - start);
+    return (found == nullptr) ? -1 : static_cast<const uint8_t*>(found) - data;
+  }
+  const uint16_t* data = TwoByteData(*this);
+  for (intptr_t i = start; i < len; i++) {
+    if (data[i] == code_unit) {
+      return i;
+    }
+  }
+  return -1;
 }
 
 bool String::Equals(const char* cstr) const {
@@ -21350,12 +21431,11 @@ bool String::Equals(const uint8_t* latin1_array, intptr_t len) const {
     return false;
   }
 
-  for (intptr_t i = 0; i < len; i++) {
-    if (this->CharAt(i) != latin1_array[i]) {
-      return false;
-    }
+  NoSafepointScope no_safepoint;
+  if (CharSize() == kOneByteChar) {
+    return CodeUnitsEqual(OneByteData(*this), latin1_array, len);
   }
-  return true;
+  return CodeUnitsEqual(TwoByteData(*this), latin1_array, len);
 }
 
 bool String::Equals(const uint16_t* utf16_array, intptr_t len) const {
@@ -21364,12 +21444,11 @@ bool String::Equals(const uint16_t* utf16_array, intptr_t len) const {
     return false;
   }
 
-  for (intptr_t i = 0; i < len; i++) {
-    if (this->CharAt(i) != LoadUnaligned(&utf16_array[i])) {
-      return false;
-    }
+  NoSafepointScope no_safepoint;
+  if (CharSize() == kOneByteChar) {
+    return CodeUnitsEqual(OneByteData(*this), utf16_array, len);
   }
-  return true;
+  return CodeUnitsEqual(TwoByteData(*this), utf16_array, len);
 }
 
 bool String::Equals(const int32_t* utf32_array, intptr_t len) const {
@@ -21990,13 +22069,69 @@ StringPtr String::Transform(int32_t (*mapping)(int32_t ch),
   return TwoByteString::Transform(mapping, str, space);
 }
 
+StringPtr String::TransformAscii(const String& str,
+                                 uint8_t first,
+                                 Heap::Space space) {
+  ASSERT(str.CharSize() == String::kOneByteChar);
+  const intptr_t len = str.Length();
+  const intptr_t kBlockSize = 16;
+  {
+    // Inspect one block at a time without early exits inside the block, so
+    // that the compiler can vectorize the loop.
+    NoSafepointScope no_safepoint;
+    const uint8_t* data = OneByteData(str);
+    uint8_t has_mapping = 0;
+    intptr_t i = 0;
+    for (; i + kBlockSize <= len; i += kBlockSize) {
+      uint8_t non_ascii = 0;
+      for (intptr_t j = 0; j < kBlockSize; j++) {
+        const uint8_t ch = data[i + j];
+        non_ascii |= ch;
+        has_mapping |= static_cast<uint8_t>(ch - first) < 26;
+      }
+      if (non_ascii > Utf8::kMaxOneByteChar) {
+        return String::null();
+      }
+    }
+    for (; i < len; i++) {
+      const uint8_t ch = data[i];
+      if (ch > Utf8::kMaxOneByteChar) {
+        return String::null();
+      }
+      has_mapping |= static_cast<uint8_t>(ch - first) < 26;
+    }
+    if (has_mapping == 0) {
+      return str.raw();
+    }
+  }
+  const String& result = String::Handle(OneByteString::New(len, space));
+  NoSafepointScope no_safepoint;
+  const uint8_t* src = OneByteData(str);
+  uint8_t* dst = OneByteString::DataStart(result);
+  for (intptr_t i = 0; i < len; i++) {
+    const uint8_t ch = src[i];
+    dst[i] = ch ^ ((static_cast<uint8_t>(ch - first) < 26) ? 0x20 : 0);
+  }
+  return result.raw();
+}
+
 StringPtr String::ToUpperCase(const String& str, Heap::Space space) {
-  // TODO(cshapiro): create a fast-path for OneByteString instances.
+  if (str.CharSize() == kOneByteChar) {
+    const StringPtr result = TransformAscii(str, 'a', space);
+    if (result != String::null()) {
+      return result;
+    }
+  }
   return Transform(CaseMapping::ToUpper, str, space);
 }
 
 StringPtr String::ToLowerCase(const String& str, Heap::Space space) {
-  // TODO(cshapiro): create a fast-path for OneByteString instances.
+  if (str.CharSize() == kOneByteChar) {
+    const StringPtr result = TransformAscii(str, 'A', space);
+    if (result != String::null()) {
+      return result;
+    }
+  }
   return Transform(CaseMapping::ToLower, str, space);
 }
 
@@ -22703,12 +22838,7 @@ uint32_t Array::CanonicalizeHash() const {
 
 ArrayPtr Array::New(intptr_t len, Heap::Space space) {
   ASSERT(Isolate::Current()->object_store()->array_class() != Class::null());
-  ArrayPtr result = New(kClassId, len, space);
-  if (UseCardMarkingForAllocation(len)) {
-    ASSERT(result->IsOldObject());
-    result->ptr()->SetCardRememberedBitUnsynchronized();
-  }
-  return result;
+  return New(kClassId, len, space);
 }
 
 ArrayPtr Array::New(intptr_t len,
@@ -22734,6 +22864,12 @@ ArrayPtr Array::New(intptr_t class_id, intptr_t len, Heap::Space space) {
         Object::Allocate(class_id, Array::InstanceSize(len), space));
     NoSafepointScope no_safepoint;
     raw->ptr()->StoreSmi(&(raw->ptr()->length_), Smi::New(len));
+    // Large arrays of either class remember stores per card rather than as a
+    // whole, so the scavenger only visits the parts which were written.
+    if (UseCardMarkingForAllocation(len)) {
+      ASSERT(raw->IsOldObject());
+      raw->ptr()->SetCardRememberedBitUnsynchronized();
+    }
     return raw;
   }
 }
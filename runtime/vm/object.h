@@ -7327,6 +7327,7 @@ class Instance : public Object {
   friend class ClassDeserializationCluster;  // vtable
   friend class InstanceMorpher;
   friend class Obfuscator;  // RawGetFieldAtOffset, RawSetFieldAtOffset
+  friend class ObjectGraphCopier;  // RawGetFieldAtOffset, RawSetFieldAtOffset
 };
 
 class LibraryPrefix : public Instance {
@@ -8636,6 +8637,10 @@ class String : public Instance {
   bool StartsWith(const String& other) const;
   bool EndsWith(const String& other) const;
 
+  // Returns the index of the first occurrence of 'code_unit' at or after
+  // 'start', or -1 if there is none.
+  intptr_t IndexOfCodeUnit(uint16_t code_unit, intptr_t start) const;
+
   // Strings are canonicalized using the symbol table.
   virtual InstancePtr CheckAndCanonicalize(Thread* thread,
                                            const char** error_str) const;
@@ -8818,6 +8823,18 @@ class String : public Instance {
 
   void SetHash(intptr_t value) const { SetCachedHash(raw(), value); }
 
+  // Return the code units of a one-byte or two-byte string. The result is only
+  // valid inside a NoSafepointScope.
+  static const uint8_t* OneByteData(const String& str);
+  static const uint16_t* TwoByteData(const String& str);
+
+  // Fast path of ToUpperCase and ToLowerCase for one-byte strings that only
+  // contain ASCII, which flips the case of the letters from 'first' to
+  // 'first' + 25. Returns null if the string contains other characters.
+  static StringPtr TransformAscii(const String& str,
+                                  uint8_t first,
+                                  Heap::Space space);
+
   template <typename HandleType, typename ElementType, typename CallbackType>
   static void ReadFromImpl(SnapshotReader* reader,
                            String* str_obj,
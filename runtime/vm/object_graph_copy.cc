@@ -0,0 +1,249 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/object_graph_copy.h"
+
+#include "vm/dart_api_state.h"
+#include "vm/flags.h"
+#include "vm/heap/weak_table.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/port.h"
+#include "vm/timeline.h"
+#include "vm/visitor.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, direct_isolate_messages);
+
+class ObjectGraphCopier : public ValueObject {
+ public:
+  enum Kind {
+    kShare,        // Deeply immutable, passed by reference.
+    kCopy,         // Copied, and its pointers are copied or shared in turn.
+    kUnsupported,  // The message needs to be serialized.
+  };
+
+  ObjectGraphCopier(Thread* thread, bool shares_object_store)
+      : thread_(thread),
+        zone_(thread->zone()),
+        isolate_(thread->isolate()),
+        shares_object_store_(shares_object_store),
+        klass_(Class::Handle(zone_)),
+        copies_(GrowableObjectArray::Handle(zone_)) {}
+
+  Kind Classify(ObjectPtr raw) {
+    if (!raw->IsHeapObject() || raw->ptr()->InVMIsolateHeap()) {
+      return kShare;
+    }
+    if (raw->ptr()->IsCanonical()) {
+      // The receiver would not find the object in its canonical tables.
+      return shares_object_store_ ? kShare : kUnsupported;
+    }
+    const intptr_t cid = raw->GetClassId();
+    switch (cid) {
+      case kOneByteStringCid:
+      case kTwoByteStringCid:
+      case kMintCid:
+      case kDoubleCid:
+        return kShare;
+      case kArrayCid:
+      case kImmutableArrayCid:
+      case kGrowableObjectArrayCid:
+        return kCopy;
+    }
+    if ((cid < kNumPredefinedCids) || !shares_object_store_) {
+      return kUnsupported;
+    }
+    klass_ = isolate_->class_table()->At(cid);
+    if (klass_.num_native_fields() != 0) {
+      return kUnsupported;
+    }
+    return kCopy;
+  }
+
+  // Returns whether every object reachable from 'root' can be shared or
+  // copied.
+  bool CanCopy(const Object& root) {
+    class Checker : public ObjectPointerVisitor {
+     public:
+      Checker(ObjectGraphCopier* copier,
+              WeakTable* visited,
+              MallocGrowableArray<ObjectPtr>* working_set)
+          : ObjectPointerVisitor(copier->isolate_->group()),
+            copier_(copier),
+            visited_(visited),
+            working_set_(working_set),
+            failed_(false) {}
+
+      bool failed() const { return failed_; }
+
+      void Add(ObjectPtr raw) {
+        switch (copier_->Classify(raw)) {
+          case kShare:
+            return;
+          case kUnsupported:
+            failed_ = true;
+            return;
+          case kCopy:
+            if (visited_->GetValueExclusive(raw) == 0) {
+              visited_->SetValueExclusive(raw, 1);
+              working_set_->Add(raw);
+            }
+            return;
+        }
+      }
+
+      void VisitPointers(ObjectPtr* from, ObjectPtr* to) {
+        for (ObjectPtr* raw = from; raw <= to; raw++) {
+          Add(*raw);
+        }
+      }
+
+     private:
+      ObjectGraphCopier* copier_;
+      WeakTable* visited_;
+      MallocGrowableArray<ObjectPtr>* working_set_;
+      bool failed_;
+    };
+
+    TIMELINE_DURATION(thread_, Isolate, "CheckDirectMessage");
+    MallocGrowableArray<ObjectPtr> working_set;
+    std::unique_ptr<WeakTable> visited(new WeakTable());
+    NoSafepointScope no_safepoint;
+    Checker checker(this, visited.get(), &working_set);
+    checker.Add(root.raw());
+    while (!checker.failed() && !working_set.is_empty()) {
+      working_set.RemoveLast()->ptr()->VisitPointers(&checker);
+    }
+    return !checker.failed();
+  }
+
+  // Copies the object graph reachable from 'root', sharing its deeply
+  // immutable parts. CanCopy(root) must hold.
+  ObjectPtr Copy(const Object& root) {
+    TIMELINE_DURATION(thread_, Isolate, "CopyDirectMessage");
+    // Maps originals to their copies. These tables are updated by the GC.
+    isolate_->set_forward_table_new(new WeakTable());
+    isolate_->set_forward_table_old(new WeakTable());
+    copies_ = GrowableObjectArray::New();
+
+    const Object& result = Object::Handle(zone_, Forward(root.raw()));
+    Instance& copy = Instance::Handle(zone_);
+    Object& child = Object::Handle(zone_);
+    GrowableArray<intptr_t> offsets;
+    // The clones still point to the original objects. Replace those pointers,
+    // which may copy more objects and append them to copies_.
+    for (intptr_t i = 0; i < copies_.Length(); i++) {
+      copy ^= copies_.At(i);
+      CollectPointerOffsets(copy.raw(), &offsets);
+      for (intptr_t j = 0; j < offsets.length(); j++) {
+        const intptr_t offset = offsets[j];
+        child = copy.RawGetFieldAtOffset(offset);
+        if (Classify(child.raw()) == kShare) {
+          continue;
+        }
+        child = Forward(child.raw());
+        copy.RawSetFieldAtOffset(offset, child);
+      }
+    }
+
+    isolate_->set_forward_table_new(nullptr);
+    isolate_->set_forward_table_old(nullptr);
+    return result.raw();
+  }
+
+ private:
+  ObjectPtr Forward(ObjectPtr raw) {
+    if (Classify(raw) == kShare) {
+      return raw;
+    }
+    ASSERT(Classify(raw) == kCopy);
+    const intptr_t id = GetCopyId(raw);
+    if (id != 0) {
+      return copies_.At(id - 1);
+    }
+    const Object& original = Object::Handle(zone_, raw);
+    const Object& copy =
+        Object::Handle(zone_, Object::Clone(original, Heap::kNew));
+    copies_.Add(copy);
+    SetCopyId(original.raw(), copies_.Length());
+    return copy.raw();
+  }
+
+  intptr_t GetCopyId(ObjectPtr raw) {
+    if (raw->IsNewObject()) {
+      return isolate_->forward_table_new()->GetValueExclusive(raw);
+    }
+    return isolate_->forward_table_old()->GetValueExclusive(raw);
+  }
+
+  void SetCopyId(ObjectPtr raw, intptr_t id) {
+    if (raw->IsNewObject()) {
+      isolate_->forward_table_new()->SetValueExclusive(raw, id);
+    } else {
+      isolate_->forward_table_old()->SetValueExclusive(raw, id);
+    }
+  }
+
+  void CollectPointerOffsets(ObjectPtr raw, GrowableArray<intptr_t>* offsets) {
+    class OffsetCollector : public ObjectPointerVisitor {
+     public:
+      OffsetCollector(IsolateGroup* isolate_group,
+                      ObjectPtr raw,
+                      GrowableArray<intptr_t>* offsets)
+          : ObjectPointerVisitor(isolate_group),
+            start_(ObjectLayout::ToAddr(raw)),
+            offsets_(offsets) {}
+
+      void VisitPointers(ObjectPtr* from, ObjectPtr* to) {
+        for (ObjectPtr* p = from; p <= to; p++) {
+          offsets_->Add(reinterpret_cast<uword>(p) - start_);
+        }
+      }
+
+     private:
+      uword start_;
+      GrowableArray<intptr_t>* offsets_;
+    };
+
+    offsets->Clear();
+    NoSafepointScope no_safepoint;
+    OffsetCollector collector(isolate_->group(), raw, offsets);
+    raw->ptr()->VisitPointers(&collector);
+  }
+
+  Thread* thread_;
+  Zone* zone_;
+  Isolate* isolate_;
+  const bool shares_object_store_;
+  Class& klass_;
+  GrowableObjectArray& copies_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectGraphCopier);
+};
+
+std::unique_ptr<Message> CreateDirectMessage(Thread* thread,
+                                             const Instance& obj,
+                                             Dart_Port dest_port,
+                                             Message::Priority priority) {
+  if (!FLAG_direct_isolate_messages) {
+    return nullptr;
+  }
+  IsolateGroup* group = thread->isolate_group();
+  if (!PortMap::IsReceiverInThisIsolateGroup(dest_port, group)) {
+    return nullptr;
+  }
+  // The isolates of a group share its object store, and with it the
+  // canonical objects, if the group has one.
+  ObjectGraphCopier copier(thread, group->object_store() != nullptr);
+  if (!copier.CanCopy(obj)) {
+    return nullptr;
+  }
+  PersistentHandle* handle = group->api_state()->AllocatePersistentHandle();
+  handle->set_raw(copier.Copy(obj));
+  return Message::New(dest_port, new Bequest(handle, dest_port), priority);
+}
+
+}  // namespace dart
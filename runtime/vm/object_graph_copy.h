@@ -0,0 +1,34 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_OBJECT_GRAPH_COPY_H_
+#define RUNTIME_VM_OBJECT_GRAPH_COPY_H_
+
+#include <memory>
+
+#include "include/dart_api.h"
+#include "vm/message.h"
+
+namespace dart {
+
+class Instance;
+class Thread;
+
+// Creates a message that hands 'obj' to the receiver of 'dest_port' without
+// serializing it. This is only possible if the receiver runs in the same
+// isolate group, and thus on the same heap, as the current isolate.
+//
+// Deeply immutable objects (strings, boxed numbers and, if the receiver uses
+// the same object store, canonical objects) are passed by reference. Arrays,
+// growable arrays and plain Dart instances are copied directly on the heap.
+// If the message contains anything else, nullptr is returned and the message
+// has to be written into a snapshot instead.
+std::unique_ptr<Message> CreateDirectMessage(Thread* thread,
+                                             const Instance& obj,
+                                             Dart_Port dest_port,
+                                             Message::Priority priority);
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_OBJECT_GRAPH_COPY_H_
@@ -352,6 +352,17 @@ class ObjectStore {
 #undef DECLARE_GETTER
 #undef DECLARE_GETTER_AND_SETTER
 
+  // Access to the symbol table with acquire release semantics, for threads
+  // which read it without holding the symbols lock.
+  ArrayPtr symbol_table_acquire() const {
+    return reinterpret_cast<const std::atomic<ArrayPtr>*>(&symbol_table_)
+        ->load(std::memory_order_acquire);
+  }
+  void set_symbol_table_release(const Array& value) {
+    reinterpret_cast<std::atomic<ArrayPtr>*>(&symbol_table_)
+        ->store(value.raw(), std::memory_order_release);
+  }
+
   LibraryPtr bootstrap_library(BootstrapLibraryId index) {
     switch (index) {
 #define MAKE_CASE(CamelName, name)                                             \
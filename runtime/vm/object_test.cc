@@ -1527,6 +1527,84 @@ ISOLATE_UNIT_TEST_CASE(StringEqualsUTF32) {
   EXPECT(!th_str.Equals(chars, 3));
 }
 
+ISOLATE_UNIT_TEST_CASE(StringEqualsMixedWidth) {
+  // Long enough to cover the blocked comparison and its tail.
+  const intptr_t kLength = 40;
+  uint8_t latin1[kLength];
+  uint16_t utf16[kLength];
+  for (intptr_t i = 0; i < kLength; i++) {
+    latin1[i] = utf16[i] = 'a' + (i % 26);
+  }
+  const String& one =
+      String::Handle(OneByteString::New(latin1, kLength, Heap::kNew));
+  const String& two =
+      String::Handle(TwoByteString::New(utf16, kLength, Heap::kNew));
+  EXPECT(one.IsOneByteString());
+  EXPECT(two.IsTwoByteString());
+  EXPECT(one.Equals(two));
+  EXPECT(two.Equals(one));
+  EXPECT(one.Equals(utf16, kLength));
+  EXPECT(two.Equals(one, 0, kLength));
+  String& other = String::Handle();
+  for (intptr_t i = 0; i < kLength; i++) {
+    utf16[i] = 0x100 + latin1[i];
+    other = TwoByteString::New(utf16, kLength, Heap::kNew);
+    EXPECT(!one.Equals(other));
+    EXPECT(!other.Equals(one));
+    EXPECT(!one.Equals(utf16, kLength));
+    EXPECT(!two.Equals(other));
+    utf16[i] = latin1[i];
+    latin1[i] = 'A';
+    other = OneByteString::New(latin1, kLength, Heap::kNew);
+    EXPECT(!one.Equals(other));
+    EXPECT(!two.Equals(other));
+    latin1[i] = utf16[i];
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(StringIndexOfCodeUnit) {
+  const String& one = String::Handle(String::New("a,bc,,d"));
+  EXPECT(one.IsOneByteString());
+  EXPECT_EQ(1, one.IndexOfCodeUnit(',', 0));
+  EXPECT_EQ(1, one.IndexOfCodeUnit(',', 1));
+  EXPECT_EQ(4, one.IndexOfCodeUnit(',', 2));
+  EXPECT_EQ(5, one.IndexOfCodeUnit(',', 5));
+  EXPECT_EQ(-1, one.IndexOfCodeUnit(',', 6));
+  EXPECT_EQ(-1, one.IndexOfCodeUnit(',', 7));
+  EXPECT_EQ(-1, one.IndexOfCodeUnit(0x12C, 0));
+
+  const String& two = String::Handle(String::New("\xD7\x90,\xD7\x91"));
+  EXPECT(two.IsTwoByteString());
+  EXPECT_EQ(0, two.IndexOfCodeUnit(0x5D0, 0));
+  EXPECT_EQ(1, two.IndexOfCodeUnit(',', 0));
+  EXPECT_EQ(2, two.IndexOfCodeUnit(0x5D1, 0));
+  EXPECT_EQ(-1, two.IndexOfCodeUnit(0x5D0, 1));
+}
+
+ISOLATE_UNIT_TEST_CASE(StringChangeCase) {
+  const String& ascii = String::Handle(
+      String::New("The quick brown fox jumps over the lazy dog @[`{"));
+  String& result = String::Handle(String::ToUpperCase(ascii));
+  EXPECT(result.IsOneByteString());
+  EXPECT(result.Equals("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG @[`{"));
+  result = String::ToLowerCase(ascii);
+  EXPECT(result.Equals("the quick brown fox jumps over the lazy dog @[`{"));
+
+  // Unchanged strings are returned as is.
+  const String& digits = String::Handle(String::New("0123456789"));
+  EXPECT_EQ(digits.raw(), String::ToUpperCase(digits));
+  EXPECT_EQ(digits.raw(), String::ToLowerCase(digits));
+
+  // Latin-1 letters take the general path, and may not map to Latin-1.
+  const String& latin1 = String::Handle(String::New("a\xC3\xA9\xC3\xBF"));
+  EXPECT(latin1.IsOneByteString());
+  result = String::ToUpperCase(latin1);
+  EXPECT(result.IsTwoByteString());
+  EXPECT(result.Equals("A\xC3\x89\xC5\xB8"));
+  result = String::ToLowerCase(String::Handle(String::New("A\xC3\x89")));
+  EXPECT(result.Equals("a\xC3\xA9"));
+}
+
 static void NoopFinalizer(void* isolate_callback_data,
                           Dart_WeakPersistentHandle handle,
                           void* peer) {}
@@ -3599,6 +3677,45 @@ ISOLATE_UNIT_TEST_CASE(WeakProperty_ClearTwoShared_OldSpace) {
   EXPECT(weak2.value() == Object::null());
 }
 
+ISOLATE_UNIT_TEST_CASE(WeakProperty_LongChains_OldSpace) {
+  // Enough weak properties to be shared between marking tasks, where each key
+  // is only reachable through the value of the previous weak property.
+  const intptr_t kLength = 4 * KB;
+  Array& live = Array::Handle(Array::New(kLength, Heap::kOld));
+  Array& dead = Array::Handle(Array::New(kLength, Heap::kOld));
+  Array& root = Array::Handle(Array::New(1, Heap::kOld));
+  {
+    HANDLESCOPE(thread);
+    WeakProperty& weak = WeakProperty::Handle();
+    Array& key = Array::Handle();
+    Array& value = Array::Handle();
+    for (intptr_t chain = 0; chain < 2; chain++) {
+      key = Array::New(1, Heap::kOld);
+      if (chain == 0) {
+        root.SetAt(0, key);
+      }
+      for (intptr_t i = 0; i < kLength; i++) {
+        value = Array::New(1, Heap::kOld);
+        weak ^= WeakProperty::New(Heap::kOld);
+        weak.set_key(key);
+        weak.set_value(value);
+        (chain == 0 ? live : dead).SetAt(i, weak);
+        key = value.raw();
+      }
+    }
+  }
+  GCTestHelper::CollectAllGarbage();
+  WeakProperty& weak = WeakProperty::Handle();
+  for (intptr_t i = 0; i < kLength; i++) {
+    weak ^= live.At(i);
+    EXPECT(weak.key() != Object::null());
+    EXPECT(weak.value() != Object::null());
+    weak ^= dead.At(i);
+    EXPECT(weak.key() == Object::null());
+    EXPECT(weak.value() == Object::null());
+  }
+}
+
 ISOLATE_UNIT_TEST_CASE(MirrorReference) {
   const MirrorReference& reference =
       MirrorReference::Handle(MirrorReference::New(Object::Handle()));
@@ -10,6 +10,7 @@
 #include "vm/log.h"
 #include "vm/thread_interrupter.h"
 #include "vm/timeline.h"
+#include "vm/zone.h"
 
 namespace dart {
 
@@ -85,6 +86,7 @@ OSThread::~OSThread() {
   }
 #endif
   timeline_block_ = NULL;
+  Zone::ReleaseSegmentCache(this);
   free(name_);
 }
 
@@ -38,6 +38,7 @@ class Log;
 class Mutex;
 class ThreadState;
 class TimelineEventBlock;
+class VirtualMemory;
 
 class Mutex {
  public:
@@ -298,6 +299,11 @@ class OSThread : public BaseThread {
   // started by a ThreadPool it will be nullptr. This TLS value is not
   // protected and should only be read/written by the OSThread itself.
   void* owning_thread_pool_worker_ = nullptr;
+  // Zone segments freed on this thread, which are reused before taking any
+  // from the shared segment cache. Only read/written by the OSThread itself.
+  static constexpr intptr_t kZoneSegmentCacheCapacity = 4;
+  VirtualMemory* zone_segment_cache_[kZoneSegmentCacheCapacity] = {};
+  intptr_t zone_segment_cache_size_ = 0;
 
   // thread_list_lock_ cannot have a static lifetime because the order in which
   // destructors run is undefined. At the moment this lock cannot be deleted
@@ -317,6 +323,7 @@ class OSThread : public BaseThread {
   friend class ThreadInterrupterWin;
   friend class ThreadInterrupterFuchsia;
   friend class ThreadPool;  // to access owning_thread_pool_worker_
+  friend class Zone;        // to access zone_segment_cache_
 };
 
 // Note that this takes the thread list lock, prohibiting threads from coming
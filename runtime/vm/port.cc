@@ -16,8 +16,164 @@
 
 namespace dart {
 
+// An open addressing hash table from ports to message handlers, which can be
+// searched by any number of threads while a single thread modifies it.
+//
+// Removed entries leave a tombstone which is never reused, so a reader can not
+// mistake a newly added entry for the one it was looking at. The table is
+// rebuilt instead once too many of its slots have been used.
+class PortHandlerTable {
+ public:
+  static const intptr_t kInitialCapacity = 8;
+
+  explicit PortHandlerTable(intptr_t capacity)
+      : capacity_(capacity),
+        used_(0),
+        live_(0),
+        slots_(new Slot[capacity]),
+        retired_epoch_(0),
+        next_retired_(nullptr) {
+    ASSERT(Utils::IsPowerOfTwo(capacity));
+    for (intptr_t i = 0; i < capacity_; i++) {
+      slots_[i].port.store(kFreePort, std::memory_order_relaxed);
+      slots_[i].handler.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~PortHandlerTable() { delete[] slots_; }
+
+  // Can be called concurrently with modifications of the table.
+  MessageHandler* Lookup(Dart_Port port) const {
+    if (port == kFreePort || port == kDeletedPort) {
+      return nullptr;
+    }
+    for (intptr_t i = IndexOf(port);; i = (i + 1) & (capacity_ - 1)) {
+      const Dart_Port slot_port =
+          slots_[i].port.load(std::memory_order_acquire);
+      if (slot_port == port) {
+        // Null if the entry was removed since we read the port.
+        return slots_[i].handler.load(std::memory_order_acquire);
+      }
+      if (slot_port == kFreePort) {
+        return nullptr;
+      }
+    }
+  }
+
+  // The table always keeps a quarter of its slots free, so that lookups of
+  // ports which are not in the table terminate.
+  bool HasRoomForInsert() const { return (used_ + 1) * 4 <= capacity_ * 3; }
+
+  void Insert(Dart_Port port, MessageHandler* handler) {
+    ASSERT(HasRoomForInsert());
+    ASSERT(Lookup(port) == nullptr);
+    intptr_t i = IndexOf(port);
+    while (slots_[i].port.load(std::memory_order_relaxed) != kFreePort) {
+      i = (i + 1) & (capacity_ - 1);
+    }
+    slots_[i].handler.store(handler, std::memory_order_relaxed);
+    // Publishes the handler to readers that find the port.
+    slots_[i].port.store(port, std::memory_order_release);
+    used_++;
+    live_++;
+  }
+
+  void Remove(Dart_Port port) {
+    for (intptr_t i = IndexOf(port);; i = (i + 1) & (capacity_ - 1)) {
+      const Dart_Port slot_port =
+          slots_[i].port.load(std::memory_order_relaxed);
+      ASSERT(slot_port != kFreePort);
+      if (slot_port == port) {
+        slots_[i].handler.store(nullptr, std::memory_order_release);
+        slots_[i].port.store(kDeletedPort, std::memory_order_release);
+        live_--;
+        return;
+      }
+    }
+  }
+
+  // Returns a new table with the live entries of this one and room for at
+  // least as many more.
+  PortHandlerTable* Rebuild() const {
+    const intptr_t capacity = Utils::Maximum(
+        kInitialCapacity,
+        static_cast<intptr_t>(Utils::RoundUpToPowerOfTwo((live_ + 1) * 4)));
+    PortHandlerTable* table = new PortHandlerTable(capacity);
+    for (intptr_t i = 0; i < capacity_; i++) {
+      const Dart_Port port = slots_[i].port.load(std::memory_order_relaxed);
+      if (port != kFreePort && port != kDeletedPort) {
+        table->Insert(port,
+                      slots_[i].handler.load(std::memory_order_relaxed));
+      }
+    }
+    return table;
+  }
+
+  // The epoch in which the table was replaced, and the next table in
+  // PortMap::retired_tables_.
+  intptr_t retired_epoch() const { return retired_epoch_; }
+  void set_retired_epoch(intptr_t epoch) { retired_epoch_ = epoch; }
+  PortHandlerTable* next_retired() const { return next_retired_; }
+  void set_next_retired(PortHandlerTable* next) { next_retired_ = next; }
+
+ private:
+  static const Dart_Port kFreePort = PortSet<PortMap::Entry>::kFreePort;
+  static const Dart_Port kDeletedPort = PortSet<PortMap::Entry>::kDeletedPort;
+
+  struct Slot {
+    std::atomic<Dart_Port> port;
+    std::atomic<MessageHandler*> handler;
+  };
+
+  intptr_t IndexOf(Dart_Port port) const {
+    // The two low bits of allocated ports are always set.
+    return static_cast<intptr_t>(static_cast<uint64_t>(port) >> 2) &
+           (capacity_ - 1);
+  }
+
+  const intptr_t capacity_;
+  intptr_t used_;  // Live entries and tombstones.
+  intptr_t live_;
+  Slot* slots_;
+  intptr_t retired_epoch_;
+  PortHandlerTable* next_retired_;
+
+  DISALLOW_COPY_AND_ASSIGN(PortHandlerTable);
+};
+
+// Readers announce themselves in the counter of the current epoch. The epoch
+// only advances once the counter of the epoch before it has drained, which is
+// the counter readers of the next epoch will use.
+//
+// Read scopes only cover lookups. Senders keep a handler they found alive by
+// counting themselves in MessageHandler::senders_ before leaving the scope.
+class PortMap::ReadScope : public ValueObject {
+ public:
+  ReadScope() {
+    for (;;) {
+      epoch_ = reader_epoch_.load();
+      readers_[epoch_ & 1].fetch_add(1);
+      // If the epoch advanced in between, a writer may already have seen our
+      // counter drained and not wait for us.
+      if (reader_epoch_.load() == epoch_) break;
+      readers_[epoch_ & 1].fetch_sub(1);
+    }
+  }
+
+  ~ReadScope() { readers_[epoch_ & 1].fetch_sub(1); }
+
+ private:
+  intptr_t epoch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadScope);
+};
+
 Mutex* PortMap::mutex_ = NULL;
 PortSet<PortMap::Entry>* PortMap::ports_ = NULL;
+std::atomic<PortHandlerTable*> PortMap::handlers_ = {nullptr};
+PortHandlerTable* PortMap::retired_tables_ = nullptr;
+std::atomic<intptr_t> PortMap::readers_[2] = {{0}, {0}};
+std::atomic<intptr_t> PortMap::reader_epoch_ = {0};
 MessageHandler* PortMap::deleted_entry_ = reinterpret_cast<MessageHandler*>(1);
 Random* PortMap::prng_ = NULL;
 
@@ -64,6 +220,88 @@ Dart_Port PortMap::AllocatePort() {
   return result;
 }
 
+MessageHandler* PortMap::LookupHandler(Dart_Port port) {
+  PortHandlerTable* table = handlers_.load(std::memory_order_acquire);
+  if (table == nullptr) {
+    // After Cleanup.
+    return nullptr;
+  }
+  return table->Lookup(port);
+}
+
+void PortMap::AddHandlerLocked(Dart_Port port, MessageHandler* handler) {
+  ASSERT(mutex_->IsOwnedByCurrentThread());
+  FreeRetiredTablesLocked();
+  PortHandlerTable* table = handlers_.load(std::memory_order_relaxed);
+  if (!table->HasRoomForInsert()) {
+    PortHandlerTable* old_table = table;
+    table = old_table->Rebuild();
+    handlers_.store(table);
+    // Readers may still search the old table.
+    old_table->set_retired_epoch(reader_epoch_.load());
+    old_table->set_next_retired(retired_tables_);
+    retired_tables_ = old_table;
+  }
+  table->Insert(port, handler);
+}
+
+void PortMap::RemoveHandlerLocked(Dart_Port port) {
+  ASSERT(mutex_->IsOwnedByCurrentThread());
+  handlers_.load(std::memory_order_relaxed)->Remove(port);
+}
+
+void PortMap::FreeRetiredTablesLocked() {
+  ASSERT(mutex_->IsOwnedByCurrentThread());
+  if (retired_tables_ == nullptr) {
+    return;
+  }
+  const intptr_t epoch = TryAdvanceEpoch();
+  // The list is sorted by descending epochs.
+  PortHandlerTable* last_kept = nullptr;
+  PortHandlerTable* table = retired_tables_;
+  while (table != nullptr && table->retired_epoch() + 2 > epoch) {
+    last_kept = table;
+    table = table->next_retired();
+  }
+  if (last_kept == nullptr) {
+    retired_tables_ = nullptr;
+  } else {
+    last_kept->set_next_retired(nullptr);
+  }
+  while (table != nullptr) {
+    PortHandlerTable* next = table->next_retired();
+    delete table;
+    table = next;
+  }
+}
+
+intptr_t PortMap::TryAdvanceEpoch() {
+  intptr_t epoch = reader_epoch_.load();
+  if (readers_[(epoch + 1) & 1].load() == 0) {
+    // Fails, and updates 'epoch', if another thread advanced it meanwhile.
+    if (reader_epoch_.compare_exchange_strong(epoch, epoch + 1)) {
+      epoch++;
+    }
+  }
+  return epoch;
+}
+
+void PortMap::WaitForReaders(intptr_t epoch) {
+  // Readers only stay in a ReadScope for a lookup.
+  while (TryAdvanceEpoch() < epoch + 2) {
+    OS::SleepMicros(1);
+  }
+}
+
+void PortMap::WaitForSenders(MessageHandler* handler, intptr_t epoch) {
+  ASSERT(!mutex_->IsOwnedByCurrentThread());
+  WaitForReaders(epoch);
+  // Senders that found the handler are counted in senders_ by now.
+  while (handler->senders_.load() != 0) {
+    OS::SleepMicros(1);
+  }
+}
+
 void PortMap::SetPortState(Dart_Port port, PortState state) {
   MutexLocker ml(mutex_);
 
@@ -107,6 +345,7 @@ Dart_Port PortMap::CreatePort(MessageHandler* handler) {
   entry.handler = handler;
   entry.state = kNewPort;
   ports_->Insert(entry);
+  AddHandlerLocked(port, handler);
 
   if (FLAG_trace_isolates) {
     OS::PrintErr(
@@ -121,6 +360,7 @@ Dart_Port PortMap::CreatePort(MessageHandler* handler) {
 
 bool PortMap::ClosePort(Dart_Port port) {
   MessageHandler* handler = NULL;
+  intptr_t epoch = 0;
   {
     MutexLocker ml(mutex_);
     auto it = ports_->TryLookup(port);
@@ -150,9 +390,15 @@ bool PortMap::ClosePort(Dart_Port port) {
     ASSERT(isolate_it != handler->ports_.end());
     isolate_it.Delete();
     handler->ports_.Rebalance();
+
+    RemoveHandlerLocked(port);
+    epoch = reader_epoch_.load();
   }
   handler->ClosePort(port);
   if (!handler->HasLivePorts() && handler->OwnedByPortMap()) {
+    // Senders that still found the port have to be done with the handler
+    // before it may be deleted.
+    WaitForSenders(handler, epoch);
     // Delete handler as soon as it isn't busy with a task.
     handler->RequestDeletion();
   }
@@ -160,6 +406,7 @@ bool PortMap::ClosePort(Dart_Port port) {
 }
 
 void PortMap::ClosePorts(MessageHandler* handler) {
+  intptr_t epoch = 0;
   {
     MutexLocker ml(mutex_);
     // The MessageHandler::ports_ is only accessed by [PortMap], it is guarded
@@ -174,27 +421,37 @@ void PortMap::ClosePorts(MessageHandler* handler) {
       if (entry.state == kLivePort) {
         handler->decrement_live_ports();
       }
+      RemoveHandlerLocked(entry.port);
       it.Delete();
       isolate_it.Delete();
     }
     ASSERT(handler->ports_.IsEmpty());
     ports_->Rebalance();
+    epoch = reader_epoch_.load();
   }
+  // The caller deletes the handler afterwards.
+  WaitForSenders(handler, epoch);
   handler->CloseAllPorts();
 }
 
 bool PortMap::PostMessage(std::unique_ptr<Message> message,
                           bool before_events) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(message->dest_port());
-  if (it == ports_->end()) {
+  MessageHandler* handler;
+  {
+    ReadScope reader;
+    handler = LookupHandler(message->dest_port());
+    if (handler != nullptr) {
+      handler->senders_.fetch_add(1);
+    }
+  }
+  if (handler == nullptr) {
     // Ownership of external data remains with the poster.
     message->DropFinalizers();
     return false;
   }
-  MessageHandler* handler = (*it).handler;
-  ASSERT(handler != nullptr);
+  // Not in the read scope, the handler may notify the embedder.
   handler->PostMessage(std::move(message), before_events);
+  handler->senders_.fetch_sub(1);
   return true;
 }
 
@@ -225,10 +482,12 @@ Isolate* PortMap::GetIsolate(Dart_Port id) {
 
 bool PortMap::IsReceiverInThisIsolateGroup(Dart_Port receiver,
                                            IsolateGroup* group) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(receiver);
-  if (it == ports_->end()) return false;
-  return (*it).handler->isolate()->group() == group;
+  ReadScope reader;
+  MessageHandler* handler = LookupHandler(receiver);
+  if (handler == nullptr) return false;
+  Isolate* isolate = handler->isolate();
+  // Native ports have no isolate.
+  return (isolate != nullptr) && (isolate->group() == group);
 }
 
 void PortMap::Init() {
@@ -243,6 +502,9 @@ void PortMap::Init() {
   if (ports_ == nullptr) {
     ports_ = new PortSet<Entry>();
   }
+  if (handlers_.load() == nullptr) {
+    handlers_.store(new PortHandlerTable(PortHandlerTable::kInitialCapacity));
+  }
 }
 
 void PortMap::Cleanup() {
@@ -254,11 +516,21 @@ void PortMap::Cleanup() {
     if (entry.state == kLivePort) {
       entry.handler->decrement_live_ports();
     }
+    handlers_.load(std::memory_order_relaxed)->Remove(entry.port);
     delete entry.handler;
     it.Delete();
   }
   ports_->Rebalance();
 
+  PortHandlerTable* table = handlers_.exchange(nullptr);
+  WaitForReaders(reader_epoch_.load());
+  delete table;
+  while (retired_tables_ != nullptr) {
+    table = retired_tables_;
+    retired_tables_ = table->next_retired();
+    delete table;
+  }
+
   delete prng_;
   prng_ = NULL;
   // TODO(bkonyi): find out why deleting map_ sometimes causes crashes.
@@ -5,6 +5,7 @@
 #ifndef RUNTIME_VM_PORT_H_
 #define RUNTIME_VM_PORT_H_
 
+#include <atomic>
 #include <memory>
 
 #include "include/dart_api.h"
@@ -20,6 +21,7 @@ class Isolate;
 class Message;
 class MessageHandler;
 class Mutex;
+class PortHandlerTable;
 class PortMapTestPeer;
 
 class PortMap : public AllStatic {
@@ -48,6 +50,9 @@ class PortMap : public AllStatic {
   // Enqueues the message in the port with id. Returns false if the port is not
   // active any longer.
   //
+  // Does not take the port map lock: the handler is found in a table which is
+  // only replaced or cleared after all concurrent senders have left it.
+  //
   // Claims ownership of 'message'.
   static bool PostMessage(std::unique_ptr<Message> message,
                           bool before_events = false);
@@ -70,6 +75,7 @@ class PortMap : public AllStatic {
   static void DebugDumpForMessageHandler(MessageHandler* handler);
 
  private:
+  friend class dart::PortHandlerTable;
   friend class dart::PortMapTestPeer;
 
   struct Entry : public PortSet<Entry>::Entry {
@@ -87,10 +93,52 @@ class PortMap : public AllStatic {
   static bool IsActivePort(Dart_Port id);
   static bool IsLivePort(Dart_Port id);
 
+  // Marks the current thread as reading handlers_ without holding mutex_.
+  class ReadScope;
+
+  // Returns the handler of 'port' or null. Must be called in a ReadScope.
+  static MessageHandler* LookupHandler(Dart_Port port);
+
+  // Adds and removes entries of handlers_, growing it if necessary. Must be
+  // called while holding mutex_.
+  static void AddHandlerLocked(Dart_Port port, MessageHandler* handler);
+  static void RemoveHandlerLocked(Dart_Port port);
+
+  // Frees the tables replaced by a rebuild once no reader can use them
+  // anymore. Never waits for readers. Must be called while holding mutex_.
+  static void FreeRetiredTablesLocked();
+
+  // Advances reader_epoch_ if no reader of the epoch before the current one is
+  // left, and returns the current epoch. Anything removed from handlers_ in
+  // epoch e is unreachable for readers once the epoch reached e + 2.
+  static intptr_t TryAdvanceEpoch();
+
+  // Waits until no reader that entered a ReadScope in 'epoch' or before is
+  // left.
+  static void WaitForReaders(intptr_t epoch);
+
+  // Waits until no sender that found 'handler' before 'epoch' still uses it,
+  // so that it may be deleted. Must be called without holding mutex_.
+  static void WaitForSenders(MessageHandler* handler, intptr_t epoch);
+
   // Lock protecting access to the port map.
   static Mutex* mutex_;
 
   static PortSet<Entry>* ports_;
+
+  // Maps ports to their handlers for lock-free lookups when sending messages.
+  // Only modified while holding mutex_.
+  static std::atomic<PortHandlerTable*> handlers_;
+
+  // Tables replaced by a rebuild that readers may still use. Only accessed
+  // while holding mutex_.
+  static PortHandlerTable* retired_tables_;
+
+  // The number of readers of handlers_ that entered a ReadScope in an even or
+  // odd reader_epoch_.
+  static std::atomic<intptr_t> readers_[2];
+  static std::atomic<intptr_t> reader_epoch_;
+
   static MessageHandler* deleted_entry_;
 
   static Random* prng_;
@@ -182,4 +182,57 @@ TEST_CASE(PortMap_PostMessageClosedPort) {
                    message_len, nullptr, Message::kNormalPriority)));
 }
 
+TEST_CASE(PortMap_PostMessageManyPorts) {
+  // Enough ports to grow the table used for lock-free lookups several times.
+  const intptr_t kNumPorts = 200;
+  PortTestMessageHandler handler;
+  Dart_Port ports[kNumPorts];
+  for (intptr_t i = 0; i < kNumPorts; i++) {
+    ports[i] = PortMap::CreatePort(&handler);
+  }
+  // Close every other port.
+  for (intptr_t i = 0; i < kNumPorts; i += 2) {
+    PortMap::ClosePort(ports[i]);
+  }
+  for (intptr_t i = 0; i < kNumPorts; i++) {
+    const bool posted = PortMap::PostMessage(
+        Message::New(ports[i], Smi::New(i), Message::kNormalPriority));
+    EXPECT_EQ(i % 2 == 1, posted);
+  }
+  EXPECT_EQ(kNumPorts / 2, handler.notify_count);
+  PortMap::ClosePorts(&handler);
+}
+
+// Closes a port when notified of a message.
+class ClosingMessageHandler : public MessageHandler {
+ public:
+  explicit ClosingMessageHandler(Dart_Port port_to_close)
+      : port_to_close_(port_to_close) {}
+
+  void MessageNotify(Message::Priority priority) {
+    PortMap::ClosePort(port_to_close_);
+  }
+
+  MessageStatus HandleMessage(std::unique_ptr<Message> message) { return kOK; }
+
+ private:
+  Dart_Port port_to_close_;
+};
+
+TEST_CASE(PortMap_ClosePortWhilePosting) {
+  PortTestMessageHandler handler;
+  Dart_Port port = PortMap::CreatePort(&handler);
+  ClosingMessageHandler closing_handler(port);
+  Dart_Port closing_port = PortMap::CreatePort(&closing_handler);
+
+  // Senders do not hold up writers of the port map while the receiver is
+  // notified.
+  EXPECT(PortMap::PostMessage(
+      Message::New(closing_port, Smi::New(1), Message::kNormalPriority)));
+  EXPECT(!PortMapTestPeer::IsActivePort(port));
+  EXPECT(!PortMap::PostMessage(
+      Message::New(port, Smi::New(2), Message::kNormalPriority)));
+  PortMap::ClosePorts(&closing_handler);
+}
+
 }  // namespace dart
@@ -4,6 +4,8 @@
 
 #include "vm/symbols.h"
 
+#include <atomic>
+
 #include "platform/unicode.h"
 #include "vm/handles.h"
 #include "vm/hash_table.h"
@@ -85,6 +87,8 @@ class StringSlice {
     hash_ = is_all() ? str.Hash() : String::Hash(str, begin_index, length);
   }
   StringPtr ToSymbol() const;
+  // Whether ToSymbol turns the string itself into the symbol.
+  bool IsSymbolInPlace() const { return is_all() && str_.IsOld(); }
   bool Equals(const String& other) const {
     ASSERT(other.HasHash());
     if (other.Hash() != hash_) {
@@ -586,6 +590,82 @@ StringPtr Symbols::FromConcatAll(
   }
 }
 
+// The isolate group's symbol table is read without holding the symbols lock.
+//
+// Writers only add symbols to the table, and store each of them after a
+// release fence which follows its initialization. A table which needs to grow
+// is copied and the copy is published with a release store, which readers
+// pair with an acquire load; the old table is not modified afterwards. A
+// reader therefore sees either an unused slot, ending its probe, or a complete
+// symbol, and a reader still probing a replaced table can at most miss symbols
+// which were added after it loaded the table. Such a miss is rechecked under
+// the lock before inserting.
+template <typename StringType>
+static void LookupSymbolLockFree(ObjectStore* object_store,
+                                 const StringType& str,
+                                 String* symbol,
+                                 Object* key,
+                                 Smi* value,
+                                 Array* data) {
+  *data = object_store->symbol_table_acquire();
+  SymbolTable table(key, value, data);
+  *symbol ^= table.GetOrNull(str);
+  table.Release();
+}
+
+// Allocates the symbol for 'str' before it is inserted into the symbol table,
+// or returns null if 'str' itself becomes the symbol, which must only happen
+// once it is known not to be in the table yet.
+template <typename StringType>
+static StringPtr AllocateSymbol(const StringType& str) {
+  return str.ToSymbol();
+}
+static StringPtr AllocateSymbol(const StringSlice& slice) {
+  return slice.IsSymbolInPlace() ? String::null() : slice.ToSymbol();
+}
+
+// Inserts 'candidate', or the symbol for 'str' if 'candidate' is null, into
+// the symbol table unless an equal symbol is already there. Must be called
+// while holding the symbols lock, with 'symbol' being null.
+template <typename StringType>
+static void InsertSymbolLocked(ObjectStore* object_store,
+                               const StringType& str,
+                               const String& candidate,
+                               String* symbol,
+                               Object* key,
+                               Smi* value,
+                               Array* data) {
+  // Readers which find the candidate must see its contents.
+  std::atomic_thread_fence(std::memory_order_release);
+  ASSERT(symbol->IsNull());
+  for (;;) {
+    *data = object_store->symbol_table_acquire();
+    const ArrayPtr original = data->raw();
+    SymbolTable table(key, value, data);
+    if (!candidate.IsNull()) {
+      *symbol ^= table.InsertOrGet(candidate);
+    } else if (!symbol->IsNull()) {
+      // A retry inserts the symbol the first attempt made or found, which is
+      // already canonical.
+      *symbol ^= table.InsertOrGet(*symbol);
+    } else {
+      *symbol ^= table.InsertNewOrGet(str);
+    }
+    *data = table.Release().raw();
+    // Growing the table allocates, which may have let a thread owning a
+    // safepoint operation replace the table without the lock (see below).
+    // Redo the insertion there, so that its symbols are not lost.
+    if (object_store->symbol_table_acquire() != original) {
+      continue;
+    }
+    if (data->raw() != original) {
+      // Readers which load the grown table must see its contents.
+      object_store->set_symbol_table_release(*data);
+    }
+    return;
+  }
+}
+
 // StringType can be StringSlice, ConcatString, or {Latin1,UTF16,UTF32}Array.
 template <typename StringType>
 StringPtr Symbols::NewSymbol(Thread* thread, const StringType& str) {
@@ -610,7 +690,10 @@ StringPtr Symbols::NewSymbol(Thread* thread, const StringType& str) {
     ObjectStore* object_store = group->object_store() == nullptr
                                     ? isolate->object_store()
                                     : group->object_store();
-    if (thread->IsAtSafepoint()) {
+    // Most common case: the symbol is available in the symbol table, which
+    // is read without taking the symbols lock.
+    LookupSymbolLockFree(object_store, str, &symbol, &key, &value, &data);
+    if (symbol.IsNull() && thread->IsAtSafepoint()) {
       // There are two cases where we can cause symbol allocation while holding
       // a safepoint:
       //    - FLAG_enable_isolate_groups in AOT due to the usage of
@@ -619,7 +702,8 @@ StringPtr Symbols::NewSymbol(Thread* thread, const StringType& str) {
       //      while building instances
       // Ideally we should get rid of both cases to avoid this unsafe usage of
       // the symbol table (we are assuming here that no other thread holds the
-      // symbols_lock).
+      // symbols_lock, or that its holder is blocked before it modifies the
+      // table, see InsertSymbolLocked).
       // TODO(https://dartbug.com/41943): Get rid of the symbol table accesses
       // within safepoint operation scope.
       RELEASE_ASSERT(group->safepoint_handler()->IsOwnedByTheThread(thread));
@@ -627,43 +711,20 @@ StringPtr Symbols::NewSymbol(Thread* thread, const StringType& str) {
 
       // Uncommon case: We are at a safepoint, all mutators are stopped and we
       // have therefore exclusive access to the symbol table.
-      data = object_store->symbol_table();
+      data = object_store->symbol_table_acquire();
       SymbolTable table(&key, &value, &data);
       symbol ^= table.InsertNewOrGet(str);
-      object_store->set_symbol_table(table.Release());
-    } else {
-      // Most common case: We are not at a safepoint and the symbol is available
-      // in the symbol table: We require only read access.
-      {
-        SafepointReadRwLocker sl(thread, group->symbols_lock());
-        data = object_store->symbol_table();
-        SymbolTable table(&key, &value, &data);
-        symbol ^= table.GetOrNull(str);
-        table.Release();
-      }
-      // Second common case: We are not at a safepoint and the symbol is not
-      // available in the symbol table: We require only exclusive access.
-      if (symbol.IsNull()) {
-        auto insert_or_get = [&]() {
-          data = object_store->symbol_table();
-          SymbolTable table(&key, &value, &data);
-          symbol ^= table.InsertNewOrGet(str);
-          object_store->set_symbol_table(table.Release());
-        };
-
-        SafepointWriteRwLocker sl(thread, group->symbols_lock());
-        if (FLAG_enable_isolate_groups || !USING_PRODUCT) {
-          // NOTE: Strictly speaking we should use a safepoint operation scope
-          // here to ensure the lock-free usage inside safepoint operations (see
-          // above) is safe. Though this would really kill the performance.
-          // TODO(https://dartbug.com/41943): Get rid of the symbol table
-          // accesses within safepoint operation scope.
-          group->RunWithStoppedMutators(insert_or_get,
-                                        /*force_heap_growth=*/true);
-        } else {
-          insert_or_get();
-        }
-      }
+      object_store->set_symbol_table_release(table.Release());
+    } else if (symbol.IsNull()) {
+      // Second common case: The symbol is not in the symbol table. It is
+      // allocated before taking the lock, so that concurrent insertions only
+      // serialize on updating the table. A candidate which loses the race
+      // against an equal symbol is dropped.
+      const String& candidate =
+          String::Handle(thread->zone(), AllocateSymbol(str));
+      SafepointWriteRwLocker sl(thread, group->symbols_lock());
+      InsertSymbolLocked(object_store, str, candidate, &symbol, &key, &value,
+                         &data);
     }
   }
   ASSERT(symbol.IsSymbol());
@@ -694,26 +755,9 @@ StringPtr Symbols::Lookup(Thread* thread, const StringType& str) {
     ObjectStore* object_store = group->object_store() == nullptr
                                     ? isolate->object_store()
                                     : group->object_store();
-    // See `Symbols::NewSymbol` for more information why we separate the two
-    // cases.
-    if (thread->IsAtSafepoint()) {
-      RELEASE_ASSERT(group->safepoint_handler()->IsOwnedByTheThread(thread));
-      // In DEBUG mode the snapshot writer also calls this method inside a
-      // safepoint.
-#if !defined(DEBUG)
-      RELEASE_ASSERT(FLAG_enable_isolate_groups || !USING_PRODUCT);
-#endif
-      data = object_store->symbol_table();
-      SymbolTable table(&key, &value, &data);
-      symbol ^= table.GetOrNull(str);
-      table.Release();
-    } else {
-      SafepointReadRwLocker sl(thread, group->symbols_lock());
-      data = object_store->symbol_table();
-      SymbolTable table(&key, &value, &data);
-      symbol ^= table.GetOrNull(str);
-      table.Release();
-    }
+    // See `Symbols::NewSymbol` for why this needs no lock, also not when
+    // called inside a safepoint operation.
+    LookupSymbolLockFree(object_store, str, &symbol, &key, &value, &data);
   }
   ASSERT(symbol.IsNull() || symbol.IsSymbol());
   ASSERT(symbol.IsNull() || symbol.HasHash());
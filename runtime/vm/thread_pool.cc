@@ -35,10 +35,18 @@ static int64_t ComputeTimeout(int64_t idle_start) {
 }
 
 ThreadPool::ThreadPool(uintptr_t max_pool_size)
-    : all_workers_dead_(false), max_pool_size_(max_pool_size) {}
+    : pending_tasks_(0),
+      global_queue_(-1),
+      num_queues_(0),
+      all_workers_dead_(false),
+      max_pool_size_(max_pool_size) {}
 
 ThreadPool::~ThreadPool() {
   Shutdown();
+  ASSERT(pending_tasks_ == 0);
+  for (intptr_t i = 0; i < num_queues_; i++) {
+    delete queues_[i];
+  }
 }
 
 void ThreadPool::Shutdown() {
@@ -117,9 +125,7 @@ void ThreadPool::MarkCurrentWorkerAsBlocked() {
       // new thread (temporarily allow exceeding the maximum pool size) to
       // handle the pending tasks.
       if (idle_workers_.IsEmpty() && pending_tasks_ > 0) {
-        new_worker = new Worker(this);
-        idle_workers_.Append(new_worker);
-        count_idle_++;
+        new_worker = NewWorkerLocked();
       }
     }
   }
@@ -149,23 +155,25 @@ void ThreadPool::WorkerLoop(Worker* worker) {
   while (true) {
     MonitorLocker ml(&pool_monitor_);
 
-    if (!tasks_.IsEmpty()) {
+    if (pending_tasks_ > 0) {
       IdleToRunningLocked(worker);
-      while (!tasks_.IsEmpty()) {
-        std::unique_ptr<Task> task(tasks_.RemoveFirst());
-        pending_tasks_--;
+      while (pending_tasks_ > 0) {
+        // Tasks are taken and run without holding the pool monitor. New tasks
+        // are only queued while holding it, so once there are no pending
+        // tasks under the monitor we are done.
         MonitorLeaveScope mls(&ml);
-        task->Run();
-        ASSERT(Isolate::Current() == nullptr);
-        task.reset();
+        std::unique_ptr<Task> task;
+        while ((task = TakeTask(worker)) != nullptr) {
+          RunTask(worker, std::move(task));
+        }
       }
       RunningToIdleLocked(worker);
     }
 
     if (running_workers_.IsEmpty()) {
-      ASSERT(tasks_.IsEmpty());
+      ASSERT(pending_tasks_ == 0);
       OnEnterIdleLocked(&ml);
-      if (!tasks_.IsEmpty()) {
+      if (pending_tasks_ > 0) {
         continue;
       }
     }
@@ -183,7 +191,7 @@ void ThreadPool::WorkerLoop(Worker* worker) {
       const auto result = ml.WaitMicros(ComputeTimeout(idle_start));
 
       // We have to drain all pending tasks.
-      if (!tasks_.IsEmpty()) break;
+      if (pending_tasks_ > 0) break;
 
       if (shutting_down_ || result == Monitor::kTimedOut) {
         done = true;
@@ -213,7 +221,7 @@ void ThreadPool::IdleToRunningLocked(Worker* worker) {
 }
 
 void ThreadPool::RunningToIdleLocked(Worker* worker) {
-  ASSERT(tasks_.IsEmpty());
+  ASSERT(pending_tasks_ == 0);
 
   ASSERT(running_workers_.ContainsForDebugging(worker));
   running_workers_.Remove(worker);
@@ -223,7 +231,7 @@ void ThreadPool::RunningToIdleLocked(Worker* worker) {
 }
 
 void ThreadPool::IdleToDeadLocked(Worker* worker) {
-  ASSERT(tasks_.IsEmpty());
+  ASSERT(pending_tasks_ == 0);
 
   ASSERT(idle_workers_.ContainsForDebugging(worker));
   idle_workers_.Remove(worker);
@@ -231,6 +239,12 @@ void ThreadPool::IdleToDeadLocked(Worker* worker) {
   count_idle_--;
   count_dead_++;
 
+  // The queue is empty and can be handed to the next new worker.
+  if (worker->queue_ != nullptr) {
+    queue_owned_[worker->queue_->index()] = false;
+    worker->queue_ = nullptr;
+  }
+
   // Notify shutdown thread that the worker thread is about to finish.
   if (shutting_down_) {
     if (running_workers_.IsEmpty() && idle_workers_.IsEmpty()) {
@@ -262,12 +276,11 @@ void ThreadPool::JoinDeadWorkersLocked(WorkerList* dead_workers_to_join) {
 ThreadPool::Worker* ThreadPool::ScheduleTaskLocked(MonitorLocker* ml,
                                                    std::unique_ptr<Task> task) {
   // Enqueue the new task.
-  tasks_.Append(task.release());
-  pending_tasks_++;
+  EnqueueTaskLocked(task.release());
   ASSERT(pending_tasks_ >= 1);
 
   // Notify existing idle worker (if available).
-  if (count_idle_ >= pending_tasks_) {
+  if (count_idle_ >= static_cast<uint64_t>(pending_tasks_)) {
     ASSERT(!idle_workers_.IsEmpty());
     ml->Notify();
     return nullptr;
@@ -283,12 +296,147 @@ ThreadPool::Worker* ThreadPool::ScheduleTaskLocked(MonitorLocker* ml,
   }
 
   // Otherwise start a new worker.
+  return NewWorkerLocked();
+}
+
+void ThreadPool::EnqueueTaskLocked(Task* task) {
+  // Counted before the task becomes visible to workers, which may take it
+  // without holding the monitor.
+  pending_tasks_++;
+
+  WorkerQueue* current_queue = nullptr;
+  if (CurrentThreadIsWorker()) {
+    current_queue =
+        static_cast<Worker*>(OSThread::Current()->owning_thread_pool_worker_)
+            ->queue_;
+  }
+  const intptr_t preferred_queue =
+      task->affinity_ != nullptr
+          ? task->affinity_->queue_index_.load(std::memory_order_relaxed)
+          : -1;
+  if (preferred_queue >= 0 &&
+      (current_queue == nullptr || current_queue->index() != preferred_queue)) {
+    queues_[preferred_queue]->Push(task);
+  } else if (current_queue != nullptr) {
+    // The task was most likely unblocked by the task running on this worker
+    // (e.g. it was sent a message), and is likely to use the data that task
+    // just touched.
+    current_queue->PushLifo(task);
+  } else {
+    global_queue_.Push(task);
+  }
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::TakeTask(Worker* worker) {
+  Task* task = nullptr;
+  if (--worker->global_poll_countdown_ == 0) {
+    worker->global_poll_countdown_ = kGlobalQueuePollInterval;
+    bool was_lifo = false;
+    task = global_queue_.Take(false, &was_lifo);
+  }
+  WorkerQueue* own_queue = worker->queue_;
+  if (task == nullptr && own_queue != nullptr) {
+    bool was_lifo = false;
+    task = own_queue->Take(worker->lifo_streak_ < kMaxLifoStreak, &was_lifo);
+    worker->lifo_streak_ = was_lifo ? worker->lifo_streak_ + 1 : 0;
+  }
+  if (task == nullptr) {
+    bool was_lifo = false;
+    task = global_queue_.Take(false, &was_lifo);
+  }
+  if (task == nullptr) {
+    // Steal from the other workers, starting at a different queue for each
+    // worker.
+    const intptr_t num_queues = num_queues_.load(std::memory_order_acquire);
+    const intptr_t start = own_queue != nullptr ? own_queue->index() + 1 : 0;
+    for (intptr_t i = 0; i < num_queues && task == nullptr; i++) {
+      WorkerQueue* queue = queues_[(start + i) % num_queues];
+      if (queue != own_queue) {
+        bool was_lifo = false;
+        task = queue->Take(false, &was_lifo);
+      }
+    }
+  }
+  if (task == nullptr) {
+    return nullptr;
+  }
+  pending_tasks_--;
+  return std::unique_ptr<Task>(task);
+}
+
+void ThreadPool::RunTask(Worker* worker, std::unique_ptr<Task> task) {
+  if (task->affinity_ != nullptr) {
+    // Recorded before running the task, which may end the lifetime of the
+    // affinity.
+    const intptr_t queue_index =
+        worker->queue_ != nullptr ? worker->queue_->index() : -1;
+    task->affinity_->queue_index_.store(queue_index,
+                                        std::memory_order_relaxed);
+  }
+  task->Run();
+  ASSERT(Isolate::Current() == nullptr);
+  task.reset();
+}
+
+ThreadPool::Worker* ThreadPool::NewWorkerLocked() {
   auto new_worker = new Worker(this);
+  AssignQueueLocked(new_worker);
   idle_workers_.Append(new_worker);
   count_idle_++;
   return new_worker;
 }
 
+void ThreadPool::AssignQueueLocked(Worker* worker) {
+  const intptr_t num_queues = num_queues_.load(std::memory_order_relaxed);
+  for (intptr_t i = 0; i < num_queues; i++) {
+    if (!queue_owned_[i]) {
+      queue_owned_[i] = true;
+      worker->queue_ = queues_[i];
+      return;
+    }
+  }
+  if (num_queues < kMaxWorkerQueues) {
+    queues_[num_queues] = new WorkerQueue(num_queues);
+    queue_owned_[num_queues] = true;
+    worker->queue_ = queues_[num_queues];
+    num_queues_.store(num_queues + 1, std::memory_order_release);
+  }
+}
+
+ThreadPool::WorkerQueue::~WorkerQueue() {
+  ASSERT(lifo_slot_ == nullptr);
+  ASSERT(tasks_.IsEmpty());
+}
+
+void ThreadPool::WorkerQueue::Push(Task* task) {
+  MutexLocker ml(&mutex_);
+  tasks_.Append(task);
+}
+
+void ThreadPool::WorkerQueue::PushLifo(Task* task) {
+  MutexLocker ml(&mutex_);
+  if (lifo_slot_ != nullptr) {
+    tasks_.Append(lifo_slot_);
+  }
+  lifo_slot_ = task;
+}
+
+ThreadPool::Task* ThreadPool::WorkerQueue::Take(bool prefer_lifo,
+                                                bool* was_lifo) {
+  MutexLocker ml(&mutex_);
+  if (lifo_slot_ != nullptr && (prefer_lifo || tasks_.IsEmpty())) {
+    Task* task = lifo_slot_;
+    lifo_slot_ = nullptr;
+    *was_lifo = true;
+    return task;
+  }
+  *was_lifo = false;
+  if (tasks_.IsEmpty()) {
+    return nullptr;
+  }
+  return tasks_.RemoveFirst();
+}
+
 ThreadPool::Worker::Worker(ThreadPool* pool)
     : pool_(pool), join_id_(OSThread::kInvalidThreadJoinId) {}
 
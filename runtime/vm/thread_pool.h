@@ -5,6 +5,7 @@
 #ifndef RUNTIME_VM_THREAD_POOL_H_
 #define RUNTIME_VM_THREAD_POOL_H_
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -19,6 +20,8 @@ class MonitorLocker;
 
 class ThreadPool {
  public:
+  class Affinity;
+
   // Subclasses of Task are able to run on a ThreadPool.
   class Task : public IntrusiveDListEntry<Task> {
    protected:
@@ -31,9 +34,29 @@ class ThreadPool {
     virtual void Run() = 0;
 
    private:
+    friend class ThreadPool;
+
+    Affinity* affinity_ = nullptr;
+
     DISALLOW_COPY_AND_ASSIGN(Task);
   };
 
+  // Remembers which worker last ran a task with this affinity. Tasks that
+  // continue the same work (e.g. handle messages of the same isolate) are
+  // queued on that worker, whose caches likely still hold their data. Other
+  // workers steal them if it is busy.
+  class Affinity {
+   public:
+    Affinity() : queue_index_(-1) {}
+
+   private:
+    friend class ThreadPool;
+
+    std::atomic<intptr_t> queue_index_;
+
+    DISALLOW_COPY_AND_ASSIGN(Affinity);
+  };
+
   explicit ThreadPool(uintptr_t max_pool_size = 0);
 
   // Prevent scheduling of new tasks, wait until all pending tasks are done
@@ -46,6 +69,15 @@ class ThreadPool {
     return RunImpl(std::unique_ptr<Task>(new T(std::forward<Args>(args)...)));
   }
 
+  // Runs a task on the thread pool, preferably on the worker that ran the last
+  // task with the same [affinity]. The affinity must outlive the task.
+  template <typename T, typename... Args>
+  bool RunWithAffinity(Affinity* affinity, Args&&... args) {
+    std::unique_ptr<Task> task(new T(std::forward<Args>(args)...));
+    task->affinity_ = affinity;
+    return RunImpl(std::move(task));
+  }
+
   // Returns `true` if the current thread is runing on the [this] thread pool.
   bool CurrentThreadIsWorker();
 
@@ -67,6 +99,37 @@ class ThreadPool {
   uint64_t workers_stopped() const { return count_dead_; }
 
  private:
+  using TaskList = IntrusiveDList<Task>;
+
+  // The tasks queued on a worker, which other workers steal from when they run
+  // out of work. Queues outlive their workers and are handed to new ones.
+  class WorkerQueue {
+   public:
+    explicit WorkerQueue(intptr_t index) : index_(index) {}
+    ~WorkerQueue();
+
+    intptr_t index() const { return index_; }
+
+    // Appends [task] to the queue.
+    void Push(Task* task);
+
+    // Puts [task] into the LIFO slot, which holds the next task to run. A task
+    // already in the slot is appended to the queue.
+    void PushLifo(Task* task);
+
+    // Takes the next task, or returns nullptr if the queue is empty. The task
+    // in the LIFO slot is only preferred if [prefer_lifo] is true.
+    Task* Take(bool prefer_lifo, bool* was_lifo);
+
+   private:
+    const intptr_t index_;
+    Mutex mutex_;
+    Task* lifo_slot_ = nullptr;
+    TaskList tasks_;
+
+    DISALLOW_COPY_AND_ASSIGN(WorkerQueue);
+  };
+
   class Worker : public IntrusiveDListEntry<Worker> {
    public:
     explicit Worker(ThreadPool* pool);
@@ -88,6 +151,14 @@ class ThreadPool {
     OSThread* os_thread_ = nullptr;
     bool is_blocked_ = false;
 
+    // The local queue of this worker. Can be null if the pool has more workers
+    // than local queues.
+    WorkerQueue* queue_ = nullptr;
+    // The number of tasks taken in a row from the LIFO slot of queue_.
+    intptr_t lifo_streak_ = 0;
+    // Counts down the tasks taken until the global queue is checked first.
+    intptr_t global_poll_countdown_ = kGlobalQueuePollInterval;
+
     DISALLOW_COPY_AND_ASSIGN(Worker);
   };
 
@@ -102,16 +173,36 @@ class ThreadPool {
   bool ShuttingDownLocked() { return shutting_down_; }
 
   // Whether new tasks are ready to be run.
-  bool TasksWaitingToRunLocked() { return !tasks_.IsEmpty(); }
+  bool TasksWaitingToRunLocked() { return pending_tasks_ > 0; }
 
  private:
-  using TaskList = IntrusiveDList<Task>;
   using WorkerList = IntrusiveDList<Worker>;
 
+  // More workers than this share the global queue.
+  static const intptr_t kMaxWorkerQueues = 64;
+
+  // How many tasks in a row a worker takes from its LIFO slot before it takes
+  // the oldest task of its queue, so that the queue does not starve.
+  static const intptr_t kMaxLifoStreak = 3;
+
+  // How many tasks a worker takes before it takes one from the global queue
+  // in preference to its own, so that tasks scheduled from outside the pool
+  // do not starve behind a busy local queue.
+  static const intptr_t kGlobalQueuePollInterval = 61;
+
   bool RunImpl(std::unique_ptr<Task> task);
   void WorkerLoop(Worker* worker);
 
   Worker* ScheduleTaskLocked(MonitorLocker* ml, std::unique_ptr<Task> task);
+  void EnqueueTaskLocked(Task* task);
+
+  // Takes the next task for [worker] from its own queue, the global queue or
+  // the queues of other workers. Does not need the pool monitor.
+  std::unique_ptr<Task> TakeTask(Worker* worker);
+  void RunTask(Worker* worker, std::unique_ptr<Task> task);
+
+  Worker* NewWorkerLocked();
+  void AssignQueueLocked(Worker* worker);
 
   void IdleToRunningLocked(Worker* worker);
   void RunningToIdleLocked(Worker* worker);
@@ -127,8 +218,20 @@ class ThreadPool {
   WorkerList running_workers_;
   WorkerList idle_workers_;
   WorkerList dead_workers_;
-  uint64_t pending_tasks_ = 0;
-  TaskList tasks_;
+
+  // The number of queued tasks which have not been taken by a worker yet.
+  // Only incremented while holding the pool monitor.
+  std::atomic<intptr_t> pending_tasks_;
+
+  // Tasks not run from a worker of this pool.
+  WorkerQueue global_queue_;
+
+  // Local queues of the workers. Only ever grows while holding the pool
+  // monitor; entries below num_queues_ can be read without it.
+  WorkerQueue* queues_[kMaxWorkerQueues];
+  std::atomic<intptr_t> num_queues_;
+  // Whether queues_[i] currently belongs to a worker.
+  bool queue_owned_[kMaxWorkerQueues];
 
   Monitor exit_monitor_;
   std::atomic<bool> all_workers_dead_;
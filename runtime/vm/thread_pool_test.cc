@@ -256,4 +256,139 @@ THREAD_POOL_UNIT_TEST_CASE(ThreadPool_RecursiveSpawn) {
   EXPECT_EQ(kTotalTasks, done);
 }
 
+class BlockedParentTask : public ThreadPool::Task {
+ public:
+  BlockedParentTask(ThreadPool* pool, Monitor* sync, bool* child_done)
+      : pool_(pool), sync_(sync), child_done_(child_done) {}
+
+  class ChildTask : public ThreadPool::Task {
+   public:
+    ChildTask(Monitor* sync, bool* done) : sync_(sync), done_(done) {}
+
+    virtual void Run() {
+      MonitorLocker ml(sync_);
+      *done_ = true;
+      ml.NotifyAll();
+    }
+
+   private:
+    Monitor* sync_;
+    bool* done_;
+  };
+
+  // The child is queued on this worker, which then blocks until another
+  // worker has stolen and run it.
+  virtual void Run() {
+    pool_->Run<ChildTask>(sync_, child_done_);
+    MonitorLocker ml(sync_);
+    while (!*child_done_) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  ThreadPool* pool_;
+  Monitor* sync_;
+  bool* child_done_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_StealFromBlockedWorker) {
+  ThreadPool thread_pool;
+  Monitor sync;
+  bool child_done = false;
+  thread_pool.Run<BlockedParentTask>(&thread_pool, &sync, &child_done);
+  {
+    MonitorLocker ml(&sync);
+    while (!child_done) {
+      ml.Wait();
+    }
+  }
+  EXPECT(child_done);
+}
+
+// Records the thread it runs on, then waits until its gate opens.
+class GatedTask : public ThreadPool::Task {
+ public:
+  GatedTask(Monitor* sync, ThreadId* ran_on, bool* started, bool* gate)
+      : sync_(sync), ran_on_(ran_on), started_(started), gate_(gate) {}
+
+  virtual void Run() {
+    MonitorLocker ml(sync_);
+    *ran_on_ = OSThread::GetCurrentThreadId();
+    *started_ = true;
+    ml.NotifyAll();
+    while (!*gate_) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  Monitor* sync_;
+  ThreadId* ran_on_;
+  bool* started_;
+  bool* gate_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_RunWithAffinity) {
+  ThreadPool thread_pool(/*max_pool_size=*/2);
+  ThreadPool::Affinity affinity;
+  Monitor sync;
+  ThreadId first_thread = OSThread::kInvalidThreadId;
+  ThreadId second_thread = OSThread::kInvalidThreadId;
+  ThreadId affine_thread = OSThread::kInvalidThreadId;
+  ThreadId other_thread = OSThread::kInvalidThreadId;
+  bool first_started = false;
+  bool second_started = false;
+  bool affine_started = false;
+  bool other_started = false;
+  bool first_gate = false;
+  bool second_gate = false;
+  bool open_gate = true;
+
+  // Keep both workers busy. The second one is the last to run a task with
+  // the affinity.
+  thread_pool.Run<GatedTask>(&sync, &first_thread, &first_started,
+                             &first_gate);
+  thread_pool.RunWithAffinity<GatedTask>(&affinity, &sync, &second_thread,
+                                         &second_started, &second_gate);
+  {
+    MonitorLocker ml(&sync);
+    while (!first_started || !second_started) {
+      ml.Wait();
+    }
+  }
+
+  // The pool may not grow, so both tasks wait. The first one is queued on the
+  // second worker, the other one in the global queue. The other task waits
+  // until the first one ran.
+  thread_pool.RunWithAffinity<GatedTask>(&affinity, &sync, &affine_thread,
+                                         &affine_started, &open_gate);
+  thread_pool.Run<GatedTask>(&sync, &other_thread, &other_started,
+                             &affine_started);
+
+  // The first worker takes the task from the global queue, although the one
+  // with the affinity was scheduled before.
+  {
+    MonitorLocker ml(&sync);
+    first_gate = true;
+    ml.NotifyAll();
+    while (!other_started) {
+      ml.Wait();
+    }
+    EXPECT(!affine_started);
+    EXPECT(OSThread::Compare(first_thread, other_thread));
+  }
+
+  // The second worker runs the task with the affinity.
+  {
+    MonitorLocker ml(&sync);
+    second_gate = true;
+    ml.NotifyAll();
+    while (!affine_started) {
+      ml.Wait();
+    }
+    EXPECT(OSThread::Compare(second_thread, affine_thread));
+  }
+}
+
 }  // namespace dart
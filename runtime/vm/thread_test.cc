@@ -911,6 +911,81 @@ ISOLATE_UNIT_TEST_CASE(HelperAllocAndGC) {
   }
 }
 
+// Adds the same symbols as the other tasks, in a different order, and looks
+// them up again.
+class SymbolsTask : public ThreadPool::Task {
+ public:
+  static const intptr_t kNumSymbols = 1000;
+
+  SymbolsTask(Isolate* isolate,
+              intptr_t id,
+              Monitor* done_monitor,
+              intptr_t* done_count)
+      : isolate_(isolate),
+        id_(id),
+        done_monitor_(done_monitor),
+        done_count_(done_count) {}
+
+  virtual void Run() {
+    Thread::EnterIsolateAsHelper(isolate_, Thread::kUnknownTask);
+    {
+      Thread* thread = Thread::Current();
+      StackZone stack_zone(thread);
+      Zone* zone = stack_zone.GetZone();
+      HANDLESCOPE(thread);
+      const String& prefix = String::Handle(zone, String::New("Concurrent"));
+      String& suffix = String::Handle(zone);
+      String& symbol = String::Handle(zone);
+      for (intptr_t i = 0; i < kNumSymbols; i++) {
+        // A different permutation of the symbols for each task.
+        const intptr_t n = (i * 7 + id_ * 101) % kNumSymbols;
+        suffix = String::NewFormatted("%" Pd, n);
+        symbol = Symbols::FromConcat(thread, prefix, suffix);
+        EXPECT(symbol.IsSymbol());
+        EXPECT(Symbols::LookupFromConcat(thread, prefix, suffix) ==
+               symbol.raw());
+      }
+    }
+    Thread::ExitIsolateAsHelper();
+    {
+      MonitorLocker ml(done_monitor_);
+      (*done_count_)++;
+      ml.Notify();
+    }
+  }
+
+ private:
+  Isolate* isolate_;
+  intptr_t id_;
+  Monitor* done_monitor_;
+  intptr_t* done_count_;
+};
+
+ISOLATE_UNIT_TEST_CASE(ConcurrentSymbols) {
+  const intptr_t kTaskCount = 8;
+  Monitor done_monitor;
+  intptr_t done_count = 0;
+  Isolate* isolate = thread->isolate();
+  intptr_t size_before = 0;
+  intptr_t capacity = 0;
+  Symbols::GetStats(isolate, &size_before, &capacity);
+  for (intptr_t i = 0; i < kTaskCount; i++) {
+    Dart::thread_pool()->Run<SymbolsTask>(isolate, i, &done_monitor,
+                                          &done_count);
+  }
+  {
+    TransitionVMToBlocked transition(thread);
+    MonitorLocker ml(&done_monitor);
+    while (done_count < kTaskCount) {
+      ml.Wait();
+    }
+  }
+  // Every symbol was added exactly once.
+  intptr_t size_after = 0;
+  Symbols::GetStats(isolate, &size_after, &capacity);
+  EXPECT_EQ(size_before + SymbolsTask::kNumSymbols, size_after);
+}
+
 class AllocateGlobsOfMemoryTask : public ThreadPool::Task {
  public:
   AllocateGlobsOfMemoryTask(Isolate* isolate, Monitor* done_monitor, bool* done)
@@ -1090,4 +1090,57 @@ ISOLATE_UNIT_TEST_CASE(Utf8Decode) {
   }
 }
 
+// Places a non-ASCII character at every position of a run of ASCII long enough
+// to cover the vector and word sized fast paths as well as the tails.
+ISOLATE_UNIT_TEST_CASE(Utf8DecodeAsciiRuns) {
+  const intptr_t kAsciiLen = 70;
+  uint8_t src[kAsciiLen + 4];
+  uint8_t latin1[kAsciiLen + 1];
+  uint16_t utf16[kAsciiLen + 2];
+  for (intptr_t pos = 0; pos <= kAsciiLen; pos++) {
+    for (intptr_t i = 0; i < kAsciiLen; i++) {
+      src[i < pos ? i : i + 2] = 'a' + (i % 26);
+    }
+    // U+00E9 is two bytes and one code unit in Latin-1 and UTF-16.
+    src[pos] = 0xC3;
+    src[pos + 1] = 0xA9;
+    const intptr_t src_len = kAsciiLen + 2;
+    Utf8::Type type;
+    EXPECT_EQ(kAsciiLen + 1, Utf8::CodeUnitCount(src, src_len, &type));
+    EXPECT_EQ(Utf8::kLatin1, type);
+    EXPECT(Utf8::IsValid(src, src_len));
+    EXPECT(Utf8::DecodeToLatin1(src, src_len, latin1, kAsciiLen + 1));
+    EXPECT(Utf8::DecodeToUTF16(src, src_len, utf16, kAsciiLen + 1));
+    for (intptr_t i = 0; i <= kAsciiLen; i++) {
+      const uint16_t expected = i == pos ? 0xE9 : 'a' + ((i - (i > pos)) % 26);
+      EXPECT_EQ(expected, latin1[i]);
+      EXPECT_EQ(expected, utf16[i]);
+    }
+    // Too little room for the output.
+    EXPECT(!Utf8::DecodeToLatin1(src, src_len, latin1, kAsciiLen));
+    EXPECT(!Utf8::DecodeToUTF16(src, src_len, utf16, kAsciiLen));
+    // A truncated sequence is invalid wherever it is.
+    src[pos] = 0xE2;
+    EXPECT(!Utf8::IsValid(src, src_len));
+    EXPECT(!Utf8::DecodeToUTF16(src, src_len, utf16, kAsciiLen + 1));
+    // U+1F600 is four bytes and two UTF-16 code units.
+    for (intptr_t i = kAsciiLen + 1; i >= pos + 2; i--) {
+      src[i + 2] = src[i];
+    }
+    src[pos] = 0xF0;
+    src[pos + 1] = 0x9F;
+    src[pos + 2] = 0x98;
+    src[pos + 3] = 0x80;
+    EXPECT_EQ(kAsciiLen + 2, Utf8::CodeUnitCount(src, src_len + 2, &type));
+    EXPECT_EQ(Utf8::kSupplementary, type);
+    EXPECT(Utf8::IsValid(src, src_len + 2));
+    EXPECT(Utf8::DecodeToUTF16(src, src_len + 2, utf16, kAsciiLen + 2));
+    EXPECT_EQ(0xD83D, utf16[pos]);
+    EXPECT_EQ(0xDE00, utf16[pos + 1]);
+    if (pos < kAsciiLen) {
+      EXPECT_EQ('a' + (pos % 26), utf16[pos + 2]);
+    }
+  }
+}
+
 }  // namespace dart
@@ -5,6 +5,7 @@
 #include "vm/zone.h"
 
 #include "platform/assert.h"
+#include "platform/atomic.h"
 #include "platform/leak_sanitizer.h"
 #include "platform/utils.h"
 #include "vm/dart_api_state.h"
@@ -12,6 +13,7 @@
 #include "vm/handles_impl.h"
 #include "vm/heap/heap.h"
 #include "vm/os.h"
+#include "vm/timeline.h"
 #include "vm/virtual_memory.h"
 
 namespace dart {
@@ -50,10 +52,44 @@ class Zone::Segment {
 // zone segments (jemalloc to the point of causing OOM), so instead of using
 // malloc to allocate segments, we allocate directly from mmap/zx_vmo_create/
 // VirtualAlloc, and cache a small number of the normal sized segments.
+//
+// Each thread first reuses the segments it freed itself (see
+// OSThread::zone_segment_cache_), which needs no locking. Only segments that
+// do not fit in the thread's cache are spilled to the shared cache below.
+// The number of segments held by all thread caches together is bounded as
+// well, so that many threads which each freed a few segments once do not
+// keep them mapped.
 static constexpr intptr_t kSegmentCacheCapacity = 16;  // 1 MB of Segments
+static constexpr intptr_t kThreadSegmentCachesCapacity = 64;  // 4 MB
 static Mutex* segment_cache_mutex = nullptr;
 static VirtualMemory* segment_cache[kSegmentCacheCapacity] = {nullptr};
 static intptr_t segment_cache_size = 0;
+static RelaxedAtomic<intptr_t> thread_segment_caches_size = 0;
+
+// With --zone_size_classes, segments larger than kSegmentSize are rounded up
+// to a power of two and cached per size, so that zones which repeatedly
+// allocate large arrays do not map and unmap fresh memory each time.
+static constexpr intptr_t kMinSizeClassLog2 = 17;  // 128 KB
+static constexpr intptr_t kMaxSizeClassLog2 = 23;  // 8 MB
+static constexpr intptr_t kNumSizeClasses =
+    kMaxSizeClassLog2 - kMinSizeClassLog2 + 1;
+static constexpr intptr_t kSizeClassCacheCapacity = 2;
+static VirtualMemory* size_class_cache[kNumSizeClasses]
+                                      [kSizeClassCacheCapacity] = {{nullptr}};
+static intptr_t size_class_cache_size[kNumSizeClasses] = {0};
+
+// Returns the index in size_class_cache for segments of 'size' bytes, or -1
+// if such segments are not cached.
+static intptr_t SizeClassIndex(intptr_t size) {
+  if (!Utils::IsPowerOfTwo(size)) {
+    return -1;
+  }
+  const intptr_t log2 = Utils::ShiftForPowerOfTwo(size);
+  if ((log2 < kMinSizeClassLog2) || (log2 > kMaxSizeClassLog2)) {
+    return -1;
+  }
+  return log2 - kMinSizeClassLog2;
+}
 
 void Zone::Init() {
   ASSERT(segment_cache_mutex == nullptr);
@@ -61,6 +97,7 @@ void Zone::Init() {
 }
 
 void Zone::Cleanup() {
+  ReleaseSegmentCache(OSThread::TryCurrent());
   {
     MutexLocker ml(segment_cache_mutex);
     ASSERT(segment_cache_size >= 0);
@@ -68,20 +105,65 @@ void Zone::Cleanup() {
     while (segment_cache_size > 0) {
       delete segment_cache[--segment_cache_size];
     }
+    for (intptr_t i = 0; i < kNumSizeClasses; i++) {
+      while (size_class_cache_size[i] > 0) {
+        delete size_class_cache[i][--size_class_cache_size[i]];
+      }
+    }
   }
   delete segment_cache_mutex;
   segment_cache_mutex = nullptr;
 }
 
+void Zone::ReleaseSegmentCache(OSThread* thread) {
+  if (thread == nullptr) {
+    return;
+  }
+  // The shared cache may already be gone when threads exit during shutdown,
+  // so the segments are returned to the OS instead.
+  while (thread->zone_segment_cache_size_ > 0) {
+    delete thread->zone_segment_cache_[--thread->zone_segment_cache_size_];
+    thread_segment_caches_size.fetch_sub(1);
+  }
+}
+
+bool Zone::ReserveThreadSegmentCacheSlot(OSThread* thread) {
+  if ((thread == nullptr) || (thread->zone_segment_cache_size_ >=
+                              OSThread::kZoneSegmentCacheCapacity)) {
+    return false;
+  }
+  if (thread_segment_caches_size.fetch_add(1) >=
+      kThreadSegmentCachesCapacity) {
+    thread_segment_caches_size.fetch_sub(1);
+    return false;
+  }
+  return true;
+}
+
 Zone::Segment* Zone::Segment::New(intptr_t size, Zone::Segment* next) {
   size = Utils::RoundUp(size, VirtualMemory::PageSize());
   VirtualMemory* memory = nullptr;
   if (size == kSegmentSize) {
+    OSThread* thread = OSThread::TryCurrent();
+    if ((thread != nullptr) && (thread->zone_segment_cache_size_ > 0)) {
+      memory = thread->zone_segment_cache_[--thread->zone_segment_cache_size_];
+      thread_segment_caches_size.fetch_sub(1);
+    } else {
+      MutexLocker ml(segment_cache_mutex);
+      ASSERT(segment_cache_size >= 0);
+      ASSERT(segment_cache_size <= kSegmentCacheCapacity);
+      if (segment_cache_size > 0) {
+        memory = segment_cache[--segment_cache_size];
+      }
+    }
+  } else if (FLAG_zone_size_classes &&
+             (size <= (static_cast<intptr_t>(1) << kMaxSizeClassLog2))) {
+    size = Utils::RoundUpToPowerOfTwo(size);
+    const intptr_t index = SizeClassIndex(size);
+    ASSERT(index >= 0);
     MutexLocker ml(segment_cache_mutex);
-    ASSERT(segment_cache_size >= 0);
-    ASSERT(segment_cache_size <= kSegmentCacheCapacity);
-    if (segment_cache_size > 0) {
-      memory = segment_cache[--segment_cache_size];
+    if (size_class_cache_size[index] > 0) {
+      memory = size_class_cache[index][--size_class_cache_size[index]];
     }
   }
   if (memory == nullptr) {
@@ -120,12 +202,28 @@ void Zone::Segment::DeleteSegmentList(Segment* head) {
     LSAN_UNREGISTER_ROOT_REGION(current, sizeof(*current));
 
     if (size == kSegmentSize) {
-      MutexLocker ml(segment_cache_mutex);
-      ASSERT(segment_cache_size >= 0);
-      ASSERT(segment_cache_size <= kSegmentCacheCapacity);
-      if (segment_cache_size < kSegmentCacheCapacity) {
-        segment_cache[segment_cache_size++] = memory;
+      OSThread* thread = OSThread::TryCurrent();
+      if (ReserveThreadSegmentCacheSlot(thread)) {
+        thread->zone_segment_cache_[thread->zone_segment_cache_size_++] =
+            memory;
         memory = nullptr;
+      } else {
+        MutexLocker ml(segment_cache_mutex);
+        ASSERT(segment_cache_size >= 0);
+        ASSERT(segment_cache_size <= kSegmentCacheCapacity);
+        if (segment_cache_size < kSegmentCacheCapacity) {
+          segment_cache[segment_cache_size++] = memory;
+          memory = nullptr;
+        }
+      }
+    } else if (FLAG_zone_size_classes) {
+      const intptr_t index = SizeClassIndex(size);
+      if (index >= 0) {
+        MutexLocker ml(segment_cache_mutex);
+        if (size_class_cache_size[index] < kSizeClassCacheCapacity) {
+          size_class_cache[index][size_class_cache_size[index]++] = memory;
+          memory = nullptr;
+        }
       }
     }
     delete memory;
@@ -197,6 +295,7 @@ void Zone::DeleteAll() {
   position_ = initial_buffer_.start();
   limit_ = initial_buffer_.end();
   small_segment_capacity_ = 0;
+  allocation_count_ = 0;
   head_ = NULL;
   large_segments_ = NULL;
   previous_ = NULL;
@@ -269,7 +368,7 @@ uword Zone::AllocateExpand(intptr_t size) {
 
   // Allocate another segment and chain it up.
   head_ = Segment::New(next_size, head_);
-  small_segment_capacity_ += next_size;
+  small_segment_capacity_ += head_->size();
 
   // Recompute 'position' and 'limit' based on the new head segment.
   uword result = Utils::RoundUp(head_->start(), kAlignment);
@@ -338,8 +437,10 @@ void Zone::DumpZoneSizes() {
   }
   OS::PrintErr("***   Zone(0x%" Px
                ") size in bytes,"
-               " Total = %" Pd " Large Segments = %" Pd "\n",
-               reinterpret_cast<intptr_t>(this), SizeInBytes(), size);
+               " Total = %" Pd " Large Segments = %" Pd
+               " Allocations = %" Pd "\n",
+               reinterpret_cast<intptr_t>(this), SizeInBytes(), size,
+               allocation_count_);
 }
 
 void Zone::VisitObjectPointers(ObjectPointerVisitor* visitor) {
@@ -391,6 +492,25 @@ StackZone::~StackZone() {
                  reinterpret_cast<intptr_t>(zone_));
   }
 
+#if defined(SUPPORT_TIMELINE)
+  // Only zones which outgrew their initial buffer are reported, to keep the
+  // number of events manageable.
+  if ((zone_->head_ != nullptr) || (zone_->large_segments_ != nullptr)) {
+    TimelineStream* stream = Timeline::GetVMStream();
+    ASSERT(stream != nullptr);
+    TimelineEvent* event = stream->StartEvent();
+    if (event != nullptr) {
+      event->Counter("Zone");
+      event->SetNumArguments(3);
+      event->FormatArgument(0, "allocations", "%" Pd,
+                            zone_->allocation_count());
+      event->FormatArgument(1, "bytes", "%" Pu, zone_->SizeInBytes());
+      event->FormatArgument(2, "capacity", "%" Pu, zone_->CapacityInBytes());
+      event->Complete();
+    }
+  }
+#endif  // defined(SUPPORT_TIMELINE)
+
   delete zone_;
 }
 
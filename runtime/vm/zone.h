@@ -67,6 +67,10 @@ class Zone {
   // Computes the amount of space used in the zone.
   uintptr_t CapacityInBytes() const;
 
+  // The number of allocations made in this zone. Not counted in PRODUCT
+  // mode.
+  intptr_t allocation_count() const { return allocation_count_; }
+
   // Structure for managing handles allocation.
   VMHandles* handles() { return &handles_; }
 
@@ -88,10 +92,16 @@ class Zone {
   static void Init();
   static void Cleanup();
 
+  // Frees the segments cached by 'thread', which must be exiting.
+  static void ReleaseSegmentCache(OSThread* thread);
+
  private:
   Zone();
   ~Zone();  // Delete all memory associated with the zone.
 
+  // Reserves room for one more segment in the cache of 'thread'.
+  static bool ReserveThreadSegmentCacheSlot(OSThread* thread);
+
   // Default initial chunk size.
   static const intptr_t kInitialChunkSize = 1 * KB;
 
@@ -158,6 +168,9 @@ class Zone {
   // Total size of all segments in [head_].
   intptr_t small_segment_capacity_ = 0;
 
+  // Number of calls to AllocUnsafe since the zone was created or emptied.
+  intptr_t allocation_count_ = 0;
+
   // The current head segment; may be NULL.
   Segment* head_;
 
@@ -214,6 +227,7 @@ inline uword Zone::AllocUnsafe(intptr_t size) {
     FATAL1("Zone::Alloc: 'size' is too large: size=%" Pd "", size);
   }
   size = Utils::RoundUp(size, kAlignment);
+  NOT_IN_PRODUCT(allocation_count_++);
 
   // Check if the requested size is available without expanding.
   uword result;
@@ -158,6 +158,25 @@ VM_UNIT_TEST_CASE(ZoneAllocated) {
   Dart_ShutdownIsolate();
 }
 
+#if !defined(PRODUCT)
+VM_UNIT_TEST_CASE(ZoneAllocationCount) {
+  TestCase::CreateTestIsolate();
+  Thread* thread = Thread::Current();
+  {
+    TransitionNativeToVM transition(thread);
+    StackZone stack_zone(thread);
+    Zone* zone = stack_zone.GetZone();
+    EXPECT_EQ(0, zone->allocation_count());
+    for (intptr_t i = 0; i < 100; i++) {
+      zone->Alloc<uint8_t>(1 * KB);
+    }
+    zone->Alloc<uint8_t>(1 * MB);
+    EXPECT_EQ(101, zone->allocation_count());
+  }
+  Dart_ShutdownIsolate();
+}
+#endif  // !defined(PRODUCT)
+
 TEST_CASE(PrintToString) {
   TransitionNativeToVM transition(Thread::Current());
   StackZone zone(Thread::Current());
@@ -242,4 +261,27 @@ ISOLATE_UNIT_TEST_CASE(StressMallocThroughZones) {
 #endif  // !defined(PRODUCT)
 }
 
+ISOLATE_UNIT_TEST_CASE(StressZoneSizeClasses) {
+  const bool saved_zone_size_classes = FLAG_zone_size_classes;
+  FLAG_zone_size_classes = true;
+#if !defined(PRODUCT)
+  int64_t start_rss = Service::CurrentRSS();
+#endif  // !defined(PRODUCT)
+
+  for (size_t i = 0; i < ((3u * GB) / (512u * KB)); i++) {
+    StackZone stack_zone(Thread::Current());
+    Zone* zone = stack_zone.GetZone();
+    for (size_t j = 0; j < ARRAY_SIZE(kSizes); j++) {
+      uint8_t* buffer = zone->Alloc<uint8_t>(kSizes[j]);
+      buffer[0] = buffer[kSizes[j] - 1] = 0;
+    }
+  }
+
+#if !defined(PRODUCT)
+  int64_t stop_rss = Service::CurrentRSS();
+  EXPECT_LT(stop_rss, start_rss + kRssSlack);
+#endif  // !defined(PRODUCT)
+  FLAG_zone_size_classes = saved_zone_size_classes;
+}
+
 }  // namespace dart
@@ -37,6 +37,10 @@ class _IOServicePorts {
 
   void _returnPort(int forRequestId) {
     final SendPort port = _usedPorts.remove(forRequestId);
+    if (port == null) {
+      // The request was submitted without a service port.
+      return;
+    }
     if (!_usedPorts.values.contains(port)) {
       _freePorts.add(port);
     }
@@ -59,12 +63,14 @@ class _IOService {
     do {
       id = _getNextId();
     } while (_messageMap.containsKey(id));
-    final SendPort servicePort = _servicePorts._getPort(id);
     _ensureInitialize();
     final Completer completer = new Completer();
     _messageMap[id] = completer;
     try {
-      servicePort.send(<dynamic>[id, _replyToPort, request, data]);
+      if (!_submit(id, _replyToPort, request, data)) {
+        final SendPort servicePort = _servicePorts._getPort(id);
+        servicePort.send(<dynamic>[id, _replyToPort, request, data]);
+      }
     } catch (error) {
       _messageMap.remove(id).complete(error);
       if (_messageMap.length == 0) {
@@ -99,4 +105,10 @@ class _IOService {
     if (_id == 0x7FFFFFFF) _id = 0;
     return _id++;
   }
+
+  // Performs the request without an IO service thread if the event handler
+  // can, e.g. through io_uring. Returns false if the request must be sent to
+  // a service port instead.
+  static bool _submit(int id, SendPort replyTo, int request, List data)
+      native "IOService_Submit";
 }
@@ -416,6 +416,9 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
   static const int normalTokenBatchSize = 8;
   static const int listeningTokenBatchSize = 2;
 
+  // Keep in sync with SocketBase::kMaxWriteVectors in socket_base.h.
+  static const int _maxWriteVectors = 16;
+
   static const Duration _retryDuration = const Duration(milliseconds: 250);
   static const Duration _retryDurationLoopback =
       const Duration(milliseconds: 25);
@@ -947,6 +950,58 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
     }
   }
 
+  // Writes the buffers in order, starting at [offset] in the first one, with
+  // a single gathering write. Returns the number of bytes written.
+  int writeList(List<List<int>> buffers, int offset) {
+    if (buffers.length == 1) {
+      return write(buffers[0], offset, buffers[0].length - offset);
+    }
+    if (isClosing || isClosed) return 0;
+    try {
+      final int count = min(buffers.length, _maxWriteVectors);
+      final nativeBuffers = <List<int>>[];
+      final starts = <int>[];
+      final lengths = <int>[];
+      int bytes = 0;
+      for (int i = 0; i < count; i++) {
+        final List<int> buffer = buffers[i];
+        // The same buffer cannot be acquired twice by the native call.
+        if (nativeBuffers.any((b) => identical(b, buffer))) break;
+        final int start = (i == 0) ? offset : 0;
+        _BufferAndStart bufferAndStart =
+            _ensureFastAndSerializableByteData(buffer, start, buffer.length);
+        nativeBuffers.add(bufferAndStart.buffer);
+        starts.add(bufferAndStart.start);
+        lengths.add(buffer.length - start);
+        bytes += buffer.length - start;
+      }
+      if (bytes == 0) return 0;
+      if (!const bool.fromEnvironment("dart.vm.product")) {
+        _SocketProfile.collectStatistic(
+            nativeGetSocketId(), _SocketProfileType.writeBytes, bytes);
+      }
+      int result = nativeWriteVectored(nativeBuffers, starts, lengths);
+      // As in write, a negative result is a forced short write.
+      if (result >= 0 && result < bytes) {
+        writeAvailable = false;
+      }
+      if (result < 0) result = -result;
+      final resourceInformation = resourceInfo;
+      assert(resourceInformation != null ||
+          isPipe ||
+          isInternal ||
+          isInternalSignal);
+      if (resourceInformation != null) {
+        resourceInformation.addWrite(result);
+      }
+      return result;
+    } catch (e) {
+      StackTrace st = StackTrace.current;
+      scheduleMicrotask(() => reportError(e, st, "Write failed"));
+      return 0;
+    }
+  }
+
   int send(List<int> buffer, int offset, int bytes, InternetAddress address,
       int port) {
     _throwOnBadPort(port);
@@ -1387,6 +1442,9 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
   Datagram? nativeRecvFrom() native "Socket_RecvFrom";
   int nativeWrite(List<int> buffer, int offset, int bytes)
       native "Socket_WriteList";
+  int nativeWriteVectored(
+      List<List<int>> buffers, List<int> starts, List<int> lengths)
+      native "Socket_WriteVectored";
   int nativeSendTo(List<int> buffer, int offset, int bytes, Uint8List address,
       int port) native "Socket_SendTo";
   nativeCreateConnect(Uint8List addr, int port, int scope_id)
@@ -1752,11 +1810,19 @@ class Socket {
 }
 
 class _SocketStreamConsumer extends StreamConsumer<List<int>> {
+  // While waiting for a write event, up to this many buffers or bytes are
+  // queued before the stream is paused. The queue is then written with a
+  // single vectored write once the socket is writable again.
+  static const int _maxQueuedBuffers = _NativeSocket._maxWriteVectors;
+  static const int _maxQueuedBytes = 64 * 1024;
+
   StreamSubscription? subscription;
   final _Socket socket;
-  int? offset;
-  List<int>? buffer;
+  int offset = 0;
+  final List<List<int>> buffers = <List<int>>[];
+  int queuedBytes = 0;
   bool paused = false;
+  bool doneWhenDrained = false;
   Completer<Socket>? streamCompleter;
 
   _SocketStreamConsumer(this.socket);
@@ -1765,13 +1831,19 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
     socket._ensureRawSocketSubscription();
     final completer = streamCompleter = new Completer<Socket>();
     if (socket._raw != null) {
+      doneWhenDrained = false;
       subscription = stream.listen((data) {
         assert(!paused);
-        assert(buffer == null);
-        buffer = data;
-        offset = 0;
+        buffers.add(data);
+        queuedBytes += data.length;
         try {
-          write();
+          if (buffers.length == 1) {
+            write();
+          } else if (buffers.length >= _maxQueuedBuffers ||
+              queuedBytes - offset >= _maxQueuedBytes) {
+            paused = true;
+            subscription!.pause();
+          }
         } catch (e) {
           socket.destroy();
           stop();
@@ -1781,7 +1853,11 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
         socket.destroy();
         done(error, stackTrace);
       }, onDone: () {
-        done();
+        if (buffers.isEmpty) {
+          done();
+        } else {
+          doneWhenDrained = true;
+        }
       }, cancelOnError: true);
     }
     return completer.future;
@@ -1795,21 +1871,29 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
   void write() {
     final sub = subscription;
     if (sub == null) return;
+    assert(buffers.isNotEmpty);
     // Write as much as possible.
-    offset =
-        offset! + socket._write(buffer!, offset!, buffer!.length - offset!);
-    if (offset! < buffer!.length) {
-      if (!paused) {
+    offset += socket._writeList(buffers, offset);
+    while (buffers.isNotEmpty && offset >= buffers.first.length) {
+      final int length = buffers.removeAt(0).length;
+      offset -= length;
+      queuedBytes -= length;
+    }
+    if (buffers.isNotEmpty) {
+      if (!paused && queuedBytes - offset >= _maxQueuedBytes) {
         paused = true;
         sub.pause();
       }
       socket._enableWriteEvent();
     } else {
-      buffer = null;
       if (paused) {
         paused = false;
         sub.resume();
       }
+      if (doneWhenDrained) {
+        doneWhenDrained = false;
+        done();
+      }
     }
   }
 
@@ -1830,7 +1914,11 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
     if (sub == null) return;
     sub.cancel();
     subscription = null;
+    buffers.clear();
+    offset = 0;
+    queuedBytes = 0;
     paused = false;
+    doneWhenDrained = false;
     socket._disableWriteEvent();
   }
 }
@@ -1967,7 +2055,7 @@ class _Socket extends Stream<Uint8List> implements Socket {
     _detachReady = new Completer();
     _sink.close();
     return _detachReady.future.then((_) {
-      assert(_consumer.buffer == null);
+      assert(_consumer.buffers.isEmpty);
       var raw = _raw;
       _raw = null;
       return [raw, _subscription];
@@ -2054,6 +2142,24 @@ class _Socket extends Stream<Uint8List> implements Socket {
     return 0;
   }
 
+  int _writeList(List<List<int>> buffers, int offset) {
+    final raw = _raw;
+    if (raw is _RawSocket) {
+      return raw._socket.writeList(buffers, offset);
+    }
+    // Secure sockets encrypt into their own buffers, so write the buffers
+    // one at a time.
+    int written = 0;
+    for (int i = 0; i < buffers.length; i++) {
+      final List<int> buffer = buffers[i];
+      final int start = (i == 0) ? offset : 0;
+      final int bytes = _write(buffer, start, buffer.length - start);
+      written += bytes;
+      if (bytes < buffer.length - start) break;
+    }
+    return written;
+  }
+
   void _enableWriteEvent() {
     _raw?.writeEventsEnabled = true;
   }
@@ -0,0 +1,164 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// VMOptions=--enable-isolate-groups
+// VMOptions=--enable-isolate-groups --no-direct-isolate-messages
+// VMOptions=--no-enable-isolate-groups
+
+// Tests that messages sent between isolates spawned from the same source are
+// equal to, but independent of, the objects that were sent, whether they are
+// copied directly on the heap or serialized.
+
+import 'dart:isolate';
+
+import "package:expect/expect.dart";
+import "package:async_helper/async_helper.dart";
+
+class Point {
+  int x;
+  int y;
+  Point next;
+  Point(this.x, this.y, [this.next]);
+}
+
+// Only holds objects the receiver can use without its own canonical tables,
+// so the message is copied directly on the heap even in JIT mode, where each
+// isolate has its own object store: lists without type arguments, values
+// computed at run time, Smis, null and booleans.
+List buildDirectMessage() {
+  final list = <dynamic>[];
+  for (int i = 0; i < 10; i++) {
+    list.add(<dynamic>[i, "d$i", i + 0.25, (1 << 40) + i, i.isEven, null]);
+  }
+  list.add(list);
+  return list;
+}
+
+void checkDirectMessage(List list) {
+  Expect.equals(11, list.length);
+  for (int i = 0; i < 10; i++) {
+    Expect.listEquals(
+        [i, "d$i", i + 0.25, (1 << 40) + i, i.isEven, null], list[i]);
+  }
+  Expect.identical(list, list[10]);
+}
+
+List<Object> buildMessages() {
+  final cyclic = <Object>[1, "two"];
+  cyclic.add(cyclic);
+  final points = new Point(1, 2, new Point(3, 4));
+  points.next.next = points;
+  final growable = <Object>[];
+  for (int i = 0; i < 100; i++) {
+    growable.add(i.isEven ? "s$i" : [i, i + 0.5, 0xffffffffff]);
+  }
+  return <Object>[
+    "Hello",
+    ["nested", [1, 2.0, true, null], <Object>[]],
+    cyclic,
+    growable,
+    points,
+    {"map": [1, 2, 3]},
+    buildDirectMessage(),
+  ];
+}
+
+void checkMessage(int index, Object message) {
+  switch (index) {
+    case 0:
+      Expect.equals("Hello", message);
+      break;
+    case 1:
+      List list = message;
+      Expect.equals(3, list.length);
+      Expect.equals("nested", list[0]);
+      Expect.listEquals([1, 2.0, true, null], list[1]);
+      Expect.equals(0, list[2].length);
+      break;
+    case 2:
+      List list = message;
+      Expect.equals(3, list.length);
+      Expect.equals(1, list[0]);
+      Expect.equals("two", list[1]);
+      Expect.identical(list, list[2]);
+      break;
+    case 3:
+      List list = message;
+      Expect.equals(100, list.length);
+      for (int i = 0; i < 100; i++) {
+        if (i.isEven) {
+          Expect.equals("s$i", list[i]);
+        } else {
+          Expect.listEquals([i, i + 0.5, 0xffffffffff], list[i]);
+        }
+      }
+      break;
+    case 4:
+      Point p = message;
+      Expect.equals(1, p.x);
+      Expect.equals(2, p.y);
+      Expect.equals(3, p.next.x);
+      Expect.equals(4, p.next.y);
+      Expect.identical(p, p.next.next);
+      break;
+    case 5:
+      Map map = message;
+      Expect.equals(1, map.length);
+      Expect.listEquals([1, 2, 3], map["map"]);
+      break;
+    case 6:
+      checkDirectMessage(message);
+      break;
+    default:
+      Expect.fail("Unexpected message $index");
+  }
+}
+
+// Changes every mutable message in place, so that the receiver would notice
+// if it shared them with the sender.
+void mutate(List<Object> messages) {
+  (messages[1] as List)[1][0] = 42;
+  (messages[2] as List)[0] = 42;
+  (messages[3] as List).clear();
+  (messages[4] as Point).next.x = 42;
+  (messages[5] as Map)["map"] = 42;
+  (messages[6] as List)[0][1] = "changed";
+}
+
+void echo(SendPort replyPort) {
+  final port = new ReceivePort();
+  replyPort.send(port.sendPort);
+  int index = 0;
+  port.listen((message) {
+    checkMessage(index++, message);
+    replyPort.send(message);
+    if (index == buildMessages().length) {
+      port.close();
+    }
+  });
+}
+
+void main() {
+  asyncStart();
+  final messages = buildMessages();
+  final port = new ReceivePort();
+  Isolate.spawn(echo, port.sendPort);
+  int index = -1;
+  port.listen((message) {
+    if (index == -1) {
+      final SendPort remote = message;
+      for (final m in messages) {
+        remote.send(m);
+      }
+      mutate(messages);
+    } else {
+      checkMessage(index, message);
+      if (index + 1 == messages.length) {
+        port.close();
+        asyncEnd();
+      }
+    }
+    index++;
+  });
+}
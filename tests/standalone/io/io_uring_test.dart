@@ -0,0 +1,96 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Test socket and file I/O with the io_uring engine, which falls back to epoll
+// where the kernel does not support it.
+//
+// VMOptions=
+// VMOptions=--io-uring
+// VMOptions=--io-uring --event-handler-threads=4
+// VMOptions=--io-uring --short_socket_read --short_socket_write
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const connectionsCount = 16;
+const messageSize = 1024 * 1024;
+
+Future<void> testEcho() async {
+  final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  server.listen((Socket connection) {
+    connection.listen(connection.add, onDone: connection.close);
+  });
+
+  final message = new List<int>.generate(messageSize, (i) => (i * 7) & 0xff);
+  final clients = <Future<void>>[];
+  for (int i = 0; i < connectionsCount; i++) {
+    clients.add(Socket.connect(server.address, server.port)
+        .then((Socket socket) async {
+      socket.add(message);
+      await socket.flush();
+      // Half-close, so that the server sees the end of the data and closes.
+      await socket.close();
+      final received = <int>[];
+      await for (final data in socket) {
+        received.addAll(data);
+      }
+      Expect.listEquals(message, received);
+    }));
+  }
+  await Future.wait(clients);
+  await server.close();
+}
+
+Future<void> testConnectRefused() async {
+  final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  final port = server.port;
+  await server.close();
+  try {
+    await Socket.connect(InternetAddress.loopbackIPv4, port);
+    Expect.fail("Connected to a closed port");
+  } on SocketException catch (_) {}
+}
+
+Future<void> testFile() async {
+  final directory = await Directory.systemTemp.createTemp('io_uring_test');
+  try {
+    final file = new File('${directory.path}/data');
+    final data = new Uint8List.fromList(
+        new List<int>.generate(3 * 65536 + 17, (i) => (i * 13) & 0xff));
+    final raf = await file.open(mode: FileMode.write);
+    await raf.writeFrom(data, 0, 1000);
+    await raf.writeFrom(data, 1000);
+    Expect.equals(data.length, await raf.position());
+    await raf.setPosition(0);
+    final first = await raf.read(1000);
+    Expect.listEquals(data.sublist(0, 1000), first);
+    final rest = new Uint8List(data.length);
+    final count = await raf.readInto(rest, 1000);
+    Expect.equals(data.length - 1000, count);
+    Expect.listEquals(data.sublist(1000), rest.sublist(1000));
+    // At the end of the file.
+    Expect.equals(0, (await raf.read(10)).length);
+    await raf.close();
+    Expect.listEquals(data, await file.readAsBytes());
+    // Errors are reported like those of the IO service.
+    final readOnly = await file.open();
+    try {
+      await readOnly.writeFrom(data);
+      Expect.fail("Wrote to a file opened for reading");
+    } on FileSystemException catch (_) {}
+    await readOnly.close();
+  } finally {
+    await directory.delete(recursive: true);
+  }
+}
+
+main() {
+  asyncStart();
+  Future.wait([testEcho(), testConnectRefused(), testFile()])
+      .then((_) => asyncEnd());
+}
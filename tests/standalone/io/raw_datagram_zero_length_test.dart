@@ -14,10 +14,15 @@ main() async {
   var address = InternetAddress.loopbackIPv4;
   var sender = await RawDatagramSocket.bind(address, 0);
   var receiver = await RawDatagramSocket.bind(address, 0);
+  var senderPort = sender.port;
 
   var sub;
   sub = receiver.listen((event) {
     if (event == RawSocketEvent.read) {
+      var datagram = receiver.receive();
+      Expect.isNotNull(datagram);
+      Expect.equals(0, datagram!.data.length);
+      Expect.equals(senderPort, datagram.port);
       Expect.isNull(receiver.receive());
     }
     receiver.close();
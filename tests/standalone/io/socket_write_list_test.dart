@@ -0,0 +1,70 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// VMOptions=
+// VMOptions=--short_socket_read
+// VMOptions=--short_socket_write
+// VMOptions=--short_socket_read --short_socket_write
+
+// Writes many differently shaped chunks to a socket so that they are queued
+// behind a full socket buffer and written together, and checks that the
+// receiver sees every byte in order.
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const int chunkCount = 2000;
+
+List<int> makeChunk(int i, Uint8List shared) {
+  switch (i % 5) {
+    case 0:
+      return new List<int>.generate(i % 7, (j) => (i + j) & 0xff);
+    case 1:
+      return new Uint8List.fromList(
+          new List<int>.generate(1000 + i % 13, (j) => (i + j) & 0xff));
+    case 2:
+      // Views on the same backing store.
+      return new Uint8List.view(shared.buffer, i % 100, 100);
+    case 3:
+      // The same buffer added repeatedly.
+      return shared;
+    default:
+      return <int>[];
+  }
+}
+
+void main() {
+  asyncStart();
+  final shared = new Uint8List.fromList(
+      new List<int>.generate(4096, (j) => (j * 7) & 0xff));
+  final expected = new BytesBuilder();
+  for (int i = 0; i < chunkCount; i++) {
+    expected.add(makeChunk(i, shared));
+  }
+  final expectedBytes = expected.takeBytes();
+
+  ServerSocket.bind(InternetAddress.loopbackIPv4, 0).then((server) {
+    server.listen((client) {
+      final received = new BytesBuilder();
+      client.listen(received.add, onDone: () {
+        Expect.listEquals(expectedBytes, received.takeBytes());
+        client.destroy();
+        server.close();
+        asyncEnd();
+      });
+    });
+    Socket.connect("127.0.0.1", server.port).then((socket) {
+      final controller = new StreamController<List<int>>(sync: true);
+      socket.addStream(controller.stream).then((_) => socket.close());
+      for (int i = 0; i < chunkCount; i++) {
+        controller.add(makeChunk(i, shared));
+      }
+      controller.close();
+    });
+  });
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Test that sockets and timers spread over several event handler threads
+// are all served.
+//
+// VMOptions=--event-handler-threads=1
+// VMOptions=--event-handler-threads=4
+// VMOptions=--event-handler-threads=4 --short_socket_read --short_socket_write
+
+import "dart:async";
+import "dart:io";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const connectionsCount = 64;
+const messageSize = 16 * 1024;
+const timersCount = 32;
+
+Future<void> testEcho() async {
+  final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  server.listen((Socket connection) {
+    connection.listen(connection.add, onDone: connection.close);
+  });
+
+  final message = new List<int>.generate(messageSize, (i) => i & 0xff);
+  final clients = <Future<void>>[];
+  for (int i = 0; i < connectionsCount; i++) {
+    clients.add(Socket.connect(server.address, server.port)
+        .then((Socket socket) async {
+      socket.add(message);
+      await socket.flush();
+      await socket.close();
+      final received = <int>[];
+      await for (final data in socket) {
+        received.addAll(data);
+      }
+      Expect.listEquals(message, received);
+    }));
+  }
+  await Future.wait(clients);
+  await server.close();
+}
+
+Future<void> testTimers() {
+  final stopwatch = new Stopwatch()..start();
+  final timers = <Future<void>>[];
+  for (int i = 0; i < timersCount; i++) {
+    final delay = new Duration(milliseconds: i * 5);
+    timers.add(new Future.delayed(delay, () {
+      Expect.isTrue(stopwatch.elapsed >= delay);
+    }));
+  }
+  return Future.wait(timers);
+}
+
+main() {
+  asyncStart();
+  Future.wait([testEcho(), testTimers()]).then((_) => asyncEnd());
+}
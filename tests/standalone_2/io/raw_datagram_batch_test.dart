@@ -0,0 +1,53 @@
+// Copyright (c) 2020, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Test that a burst of datagrams larger than one receive batch, mixing empty
+// and non-empty datagrams, is received completely and in order.
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const datagramsCount = 50;
+
+// Every fifth datagram is empty, the others carry their index.
+Uint8List createDatagram(int index) {
+  if (index % 5 == 0) return new Uint8List(0);
+  return new Uint8List(index * 37)..fillRange(0, index * 37, index);
+}
+
+main() async {
+  asyncStart();
+  var address = InternetAddress.loopbackIPv4;
+  var sender = await RawDatagramSocket.bind(address, 0);
+  var receiver = await RawDatagramSocket.bind(address, 0);
+  var senderPort = sender.port;
+
+  int received = 0;
+  receiver.listen((event) {
+    if (event != RawSocketEvent.read) return;
+    while (true) {
+      var datagram = receiver.receive();
+      if (datagram == null) break;
+      Expect.equals(senderPort, datagram.port);
+      Expect.listEquals(createDatagram(received), datagram.data);
+      received++;
+      if (received == datagramsCount) {
+        receiver.close();
+        asyncEnd();
+        return;
+      }
+    }
+  });
+
+  for (int i = 0; i < datagramsCount; i++) {
+    var data = createDatagram(i);
+    int bytes = sender.send(data, address, receiver.port);
+    Expect.equals(data.length, bytes);
+  }
+  sender.close();
+}